@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Measures base64 decoding of the tiktoken vocabulary (many short fields) and
+// of a single long buffer.
+
+#include <benchmark/benchmark.h>
+#include <pytorch/tokenizers/base64.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::string resource_path(const std::string& name) {
+  const char* env = std::getenv("RESOURCES_PATH");
+#ifdef RESOURCES_PATH
+  const std::string dir = env ? env : RESOURCES_PATH;
+#else
+  const std::string dir = env ? env : ".";
+#endif
+  return dir + "/" + name;
+}
+
+const std::string& model() {
+  static const std::string contents = [] {
+    std::ifstream file(resource_path("test_tiktoken_tokenizer.model"));
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+  }();
+  return contents;
+}
+
+std::vector<std::string_view> vocab_fields() {
+  std::vector<std::string_view> fields;
+  std::string_view data = model();
+  while (!data.empty()) {
+    const auto eol = std::min(data.find('\n'), data.size());
+    const auto line = data.substr(0, eol);
+    data.remove_prefix(std::min(eol + 1, data.size()));
+    const auto pos = line.find(' ');
+    if (pos != std::string_view::npos) {
+      fields.push_back(line.substr(0, pos));
+    }
+  }
+  return fields;
+}
+
+std::size_t total_size(const std::vector<std::string_view>& fields) {
+  std::size_t size = 0;
+  for (const auto& field : fields) {
+    size += field.size();
+  }
+  return size;
+}
+
+void BM_DecodeVocabPerField(benchmark::State& state) {
+  const auto fields = vocab_fields();
+  for (auto _ : state) {
+    for (const auto& field : fields) {
+      auto result = base64::decode(field);
+      benchmark::DoNotOptimize(result.get().data());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * total_size(fields));
+}
+
+void BM_DecodeVocabBulk(benchmark::State& state) {
+  const auto fields = vocab_fields();
+  std::string arena;
+  std::vector<std::string_view> decoded;
+  for (auto _ : state) {
+    auto error = base64::decode_many(fields, arena, decoded);
+    benchmark::DoNotOptimize(error);
+  }
+  state.SetBytesProcessed(state.iterations() * total_size(fields));
+}
+
+void BM_DecodeLong(benchmark::State& state) {
+  // Reuse vocabulary characters so the input is valid base64 of real data.
+  std::string input;
+  for (const auto& field : vocab_fields()) {
+    if (field.back() != '=') {
+      input += field;
+    }
+    if (input.size() >= static_cast<std::size_t>(state.range(0))) {
+      break;
+    }
+  }
+  input.resize(input.size() & ~std::size_t(3));
+  std::vector<char> output(base64::decoded_size(input.size()));
+  for (auto _ : state) {
+    auto result = base64::decode_to(input, output.data());
+    benchmark::DoNotOptimize(result.get());
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+BENCHMARK(BM_DecodeVocabPerField)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DecodeVocabBulk)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DecodeLong)->Arg(1 << 16);
+
+} // namespace
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Measures DfaRegex::find_all_into against Re2Regex on a pre-tokenizer
+// pattern, and on a pattern that matches nowhere in a long run of bytes that
+// could start a match, which a search that restarts at every byte makes
+// quadratic.
+
+#include <benchmark/benchmark.h>
+#include <pytorch/tokenizers/dfa_regex.h>
+#include <pytorch/tokenizers/re2_regex.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ::tokenizers::DfaRegex;
+using ::tokenizers::Error;
+using ::tokenizers::IRegex;
+using ::tokenizers::Match;
+using ::tokenizers::Re2Regex;
+
+// GPT-2's pre-tokenizer pattern without its lookahead.
+constexpr char kPattern[] =
+    "'s|'t|'re|'ve|'m|'ll|'d| ?\\p{L}+| ?\\p{N}+| ?[^\\s\\p{L}\\p{N}]+|\\s+";
+
+std::string repeat(const std::string& unit, std::size_t size) {
+  std::string result;
+  while (result.size() < size) {
+    result += unit;
+  }
+  return result;
+}
+
+const std::string& mixed_text() {
+  static const std::string contents = repeat(
+      "The quick brown fox's 42 jumps; été дом 中文 مرحبا  3.14159\n", 1 << 16);
+  return contents;
+}
+
+template <typename Regex>
+std::unique_ptr<IRegex> make_regex(const std::string& pattern) {
+  auto regex = std::make_unique<Regex>();
+  if (regex->compile(pattern) != Error::Ok) {
+    return nullptr;
+  }
+  return regex;
+}
+
+void run(
+    benchmark::State& state,
+    const std::unique_ptr<IRegex>& regex,
+    const std::string& text) {
+  if (!regex) {
+    state.SkipWithError("failed to compile the pattern");
+    return;
+  }
+  std::vector<Match> matches;
+  for (auto _ : state) {
+    regex->find_all_into(text, matches);
+    benchmark::DoNotOptimize(matches.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_DfaPreTokenizer(benchmark::State& state) {
+  static const auto regex = make_regex<DfaRegex>(kPattern);
+  run(state, regex, mixed_text());
+}
+
+void BM_Re2PreTokenizer(benchmark::State& state) {
+  static const auto regex = make_regex<Re2Regex>(kPattern);
+  run(state, regex, mixed_text());
+}
+
+void BM_DfaNoMatch(benchmark::State& state) {
+  static const auto regex = make_regex<DfaRegex>("a+b");
+  run(state, regex, std::string(state.range(0), 'a'));
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_Re2NoMatch(benchmark::State& state) {
+  static const auto regex = make_regex<Re2Regex>("a+b");
+  run(state, regex, std::string(state.range(0), 'a'));
+  state.SetComplexityN(state.range(0));
+}
+
+BENCHMARK(BM_DfaPreTokenizer)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Re2PreTokenizer)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DfaNoMatch)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 19)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Re2NoMatch)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 19)
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
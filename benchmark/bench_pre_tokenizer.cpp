@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Measures the throughput of the native pre-tokenizers, which scan for
+// character classes, against the regex that splits the same way.
+
+#include <benchmark/benchmark.h>
+#include <pytorch/tokenizers/pre_tokenizer.h>
+
+#include <memory>
+#include <string>
+
+namespace {
+
+using ::tokenizers::DigitsPreTokenizer;
+using ::tokenizers::PreTokenizedString;
+using ::tokenizers::PreTokenizer;
+using ::tokenizers::RegexPreTokenizer;
+using ::tokenizers::WhitespacePreTokenizer;
+using ::tokenizers::WhitespaceSplitPreTokenizer;
+
+std::string repeat(const std::string& unit) {
+  std::string result;
+  while (result.size() < (1 << 16)) {
+    result += unit;
+  }
+  return result;
+}
+
+const std::string& ascii_text() {
+  static const std::string contents = repeat(
+      "The quick brown fox's 42 jumps over the lazy dog; 3.14159 times.\n");
+  return contents;
+}
+
+const std::string& mixed_text() {
+  static const std::string contents =
+      repeat("The quick brown fox's 42 jumps; été дом 中文 مرحبا  3.14159\n");
+  return contents;
+}
+
+void run(
+    benchmark::State& state,
+    const PreTokenizer& pre_tokenizer,
+    const std::string& text) {
+  PreTokenizedString pieces;
+  for (auto _ : state) {
+    pieces.reset(text);
+    pre_tokenizer.pre_tokenize_spans(pieces);
+    benchmark::DoNotOptimize(pieces.ranges().data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+const std::string& text(const benchmark::State& state) {
+  return state.range(0) == 0 ? ascii_text() : mixed_text();
+}
+
+void BM_DigitsNative(benchmark::State& state) {
+  run(state, DigitsPreTokenizer(), text(state));
+}
+
+void BM_DigitsRegex(benchmark::State& state) {
+  run(state, RegexPreTokenizer(R"([^\p{N}]+|[\p{N}]+)"), text(state));
+}
+
+void BM_WhitespaceSplitNative(benchmark::State& state) {
+  run(state, WhitespaceSplitPreTokenizer(), text(state));
+}
+
+void BM_WhitespaceSplitRegex(benchmark::State& state) {
+  run(state, RegexPreTokenizer(R"(\S+)"), text(state));
+}
+
+void BM_WhitespaceNative(benchmark::State& state) {
+  run(state, WhitespacePreTokenizer(), text(state));
+}
+
+BENCHMARK(BM_DigitsNative)->ArgName("mixed")->Arg(0)->Arg(1);
+BENCHMARK(BM_DigitsRegex)->ArgName("mixed")->Arg(0)->Arg(1);
+BENCHMARK(BM_WhitespaceSplitNative)->ArgName("mixed")->Arg(0)->Arg(1);
+BENCHMARK(BM_WhitespaceSplitRegex)->ArgName("mixed")->Arg(0)->Arg(1);
+BENCHMARK(BM_WhitespaceNative)->ArgName("mixed")->Arg(0)->Arg(1);
+
+} // namespace
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Measures how Re2Regex::find_all_into scales with the number of threads that
+// share one regex, when the threads match with the one compiled RE2 object
+// and when each matches with its own copy.
+
+#include <benchmark/benchmark.h>
+#include <pytorch/tokenizers/re2_regex.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using ::tokenizers::Error;
+using ::tokenizers::Match;
+using ::tokenizers::Re2Regex;
+
+// GPT-2's pre-tokenizer pattern without its lookahead.
+constexpr char kPattern[] =
+    "'s|'t|'re|'ve|'m|'ll|'d| ?\\p{L}+| ?\\p{N}+| ?[^\\s\\p{L}\\p{N}]+|\\s+";
+
+// Mixed-script text, so that the DFA needs more than a handful of states.
+const std::string& text() {
+  static const std::string contents = [] {
+    std::string result;
+    while (result.size() < (1 << 16)) {
+      result +=
+          "The quick brown fox's 42 jumps; été дом "
+          "中文 مرحبا  3.14159\n";
+    }
+    return result;
+  }();
+  return contents;
+}
+
+std::unique_ptr<Re2Regex> make_regex(bool per_thread) {
+  Re2Regex::Options options;
+  options.per_thread = per_thread;
+  // Enough copies for the largest thread count below.
+  options.max_copies = std::max(64u, std::thread::hardware_concurrency());
+  auto regex = std::make_unique<Re2Regex>(options);
+  if (regex->compile(kPattern) != Error::Ok) {
+    return nullptr;
+  }
+  return regex;
+}
+
+const Re2Regex* shared_regex(bool per_thread) {
+  static const auto shared = make_regex(false);
+  static const auto copied = make_regex(true);
+  return per_thread ? copied.get() : shared.get();
+}
+
+void BM_Re2FindAll(benchmark::State& state) {
+  const auto* regex = shared_regex(state.range(0) != 0);
+  if (regex == nullptr) {
+    state.SkipWithError("failed to compile the pattern");
+    return;
+  }
+  std::vector<Match> matches;
+  for (auto _ : state) {
+    regex->find_all_into(text(), matches);
+    benchmark::DoNotOptimize(matches.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text().size());
+}
+
+BENCHMARK(BM_Re2FindAll)
+    ->ArgName("per_thread")
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, 64)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
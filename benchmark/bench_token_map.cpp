@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Measures random lookup throughput and dTLB misses of StringIntegerMap backed
+// by std::allocator versus HugePageAllocator on a 128k entry vocabulary.
+
+#include <benchmark/benchmark.h>
+#include <pytorch/tokenizers/base64.h>
+#include <pytorch/tokenizers/huge_page_allocator.h>
+#include <pytorch/tokenizers/string_integer_map.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using ::tokenizers::detail::HugePageAllocator;
+using ::tokenizers::detail::StringIntegerMapTypeBuilder;
+using Model = std::unordered_map<std::string, std::uint64_t>;
+
+using DefaultMap = StringIntegerMapTypeBuilder<>::Map;
+using HugePageMap = StringIntegerMapTypeBuilder<>::WithAllocator<
+    HugePageAllocator<std::uint8_t>>::Map;
+
+std::string resource_path(const std::string& name) {
+  const char* env = std::getenv("RESOURCES_PATH");
+#ifdef RESOURCES_PATH
+  const std::string dir = env ? env : RESOURCES_PATH;
+#else
+  const std::string dir = env ? env : ".";
+#endif
+  return dir + "/" + name;
+}
+
+const Model& model() {
+  static const Model model = [] {
+    Model result;
+    std::ifstream file(resource_path("test_tiktoken_tokenizer.model"));
+    for (std::string line; std::getline(file, line);) {
+      const auto pos = line.find(' ');
+      if (pos == std::string::npos) {
+        continue;
+      }
+      auto token = base64::decode({line.data(), pos});
+      if (token.ok()) {
+        result.emplace(
+            std::move(token.get()), std::stoull(line.substr(pos + 1)));
+      }
+    }
+    return result;
+  }();
+  return model;
+}
+
+/// Counts data TLB read misses for the calling thread, if the kernel allows.
+class DtlbMissCounter {
+ public:
+  DtlbMissCounter() {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  ~DtlbMissCounter() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  DtlbMissCounter(const DtlbMissCounter&) = delete;
+  DtlbMissCounter& operator=(const DtlbMissCounter&) = delete;
+
+  bool available() const {
+    return fd_ >= 0;
+  }
+
+  void start() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  std::uint64_t stop() {
+    std::uint64_t count = 0;
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+template <typename TMap>
+void BM_TokenMapLookup(benchmark::State& state) {
+  const auto& source = model();
+  if (source.empty()) {
+    state.SkipWithError("failed to load test_tiktoken_tokenizer.model");
+    return;
+  }
+  const TMap map(source);
+
+  // Pre-shuffle the probe sequence so that the access pattern is random across
+  // the whole table, as it is when encoding real text.
+  std::vector<std::pair<std::string, std::uint64_t>> probes(
+      source.begin(), source.end());
+  std::mt19937_64 rng(42);
+  std::shuffle(probes.begin(), probes.end(), rng);
+
+  DtlbMissCounter counter;
+  std::uint64_t misses = 0;
+  std::size_t lookups = 0;
+  for (auto _ : state) {
+    counter.start();
+    for (const auto& [token, rank] : probes) {
+      benchmark::DoNotOptimize(map.tryGetInteger(token));
+      benchmark::DoNotOptimize(map.tryGetString(rank));
+    }
+    misses += counter.stop();
+    lookups += probes.size() * 2;
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(lookups));
+  state.counters["vocab"] = static_cast<double>(source.size());
+  if (counter.available()) {
+    state.counters["dtlb_misses/lookup"] =
+        static_cast<double>(misses) / static_cast<double>(lookups);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_TokenMapLookup, DefaultMap)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_TokenMapLookup, HugePageMap)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
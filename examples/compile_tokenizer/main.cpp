@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+/**
+ * This tool loads a tokenizer model and writes it out as a precompiled
+ * artifact. Passing the artifact to the load() method of the same tokenizer
+ * class maps it in place, which skips parsing the model at startup.
+ */
+
+// Standard
+#include <iostream>
+#include <sstream>
+
+// Local
+#include "hf_tokenizer.h"
+#include "llama2c_tokenizer.h"
+#include "tiktoken.h"
+
+using namespace tokenizers;
+
+std::string help(char* argv[]) {
+  std::stringstream ss;
+  ss << "Usage: " << argv[0] << " <type> <model> <output artifact>"
+     << std::endl
+     << std::endl;
+  ss << "Types:\n" << std::endl;
+  ss << "* tiktoken: Tiktoken" << std::endl;
+  ss << "* hf_tokenizer: HFTokenizer" << std::endl;
+  ss << "* llama2c: Llama2cTokenizer" << std::endl;
+  return ss.str();
+}
+
+template <typename TTokenizer>
+int compile(
+    TTokenizer& tokenizer,
+    const std::string& model_path,
+    const std::string& output_path) {
+  if (tokenizer.load(model_path) != Error::Ok) {
+    std::cerr << "ERROR: Failed to load " << model_path << std::endl;
+    return 1;
+  }
+  if (tokenizer.save(output_path) != Error::Ok) {
+    std::cerr << "ERROR: Failed to write " << output_path << std::endl;
+    return 1;
+  }
+  std::cout << "Vocab Size: " << tokenizer.vocab_size() << std::endl;
+  std::cout << "BOS: " << tokenizer.bos_tok() << std::endl;
+  std::cout << "EOS: " << tokenizer.eos_tok() << std::endl;
+  std::cout << "Wrote " << output_path << std::endl;
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  // Check for the right number of CLI args
+  if (argc != 4) {
+    std::cerr << help(argv) << std::endl;
+    return 1;
+  }
+
+  // Parse CLI args
+  const std::string tokenizer_type(argv[1]);
+  const std::string model_path(argv[2]);
+  const std::string output_path(argv[3]);
+
+  if (tokenizer_type == "tiktoken") {
+    Tiktoken tokenizer;
+    return compile(tokenizer, model_path, output_path);
+  } else if (tokenizer_type == "hf_tokenizer") {
+    HFTokenizer tokenizer;
+    return compile(tokenizer, model_path, output_path);
+  } else if (tokenizer_type == "llama2c") {
+    Llama2cTokenizer tokenizer;
+    return compile(tokenizer, model_path, output_path);
+  }
+
+  std::stringstream ss;
+  ss << "ERROR: Invalid tokenizer type: " << tokenizer_type << std::endl
+     << std::endl;
+  ss << help(argv);
+  std::cerr << ss.str() << std::endl;
+  return 1;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Precompiled tokenizer artifacts.
+//
+// An artifact holds the fully loaded state of a tokenizer: token maps, merge
+// tables, special tokens, regex patterns and component configs. It is mapped
+// into memory and the token maps are used in place, so loading an artifact
+// does no text or JSON parsing of the vocabulary. Artifacts are produced by
+// the `save()` method of each tokenizer, or the compile_tokenizer tool.
+//
+// File layout, all integers in host byte order:
+//   header:   magic[8], version u32, kind u32, byte order mark u32,
+//             section count u32
+//   sections: count x {id u32, reserved u32, offset u64, size u64}
+//   data:     section payloads, each aligned to kArtifactAlignment
+#pragma once
+
+// Standard
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Local
+#include <pytorch/tokenizers/error.h>
+#include <pytorch/tokenizers/mapped_file.h>
+#include <pytorch/tokenizers/result.h>
+
+namespace tokenizers {
+namespace detail {
+
+/// Leading bytes of every artifact. The non-ASCII first byte and the line
+/// endings catch text-mode mangling, as in PNG.
+constexpr char kArtifactMagic[8] = {
+    '\x89', 'T', 'O', 'K', '\r', '\n', '\x1a', '\n'};
+
+/// Bumped on any incompatible change of the artifact layout.
+constexpr uint32_t kArtifactVersion = 1;
+
+constexpr uint32_t kArtifactByteOrderMark = 0x01020304;
+
+constexpr std::size_t kArtifactAlignment = 64;
+
+/// The tokenizer class an artifact was saved from.
+enum class ArtifactKind : uint32_t {
+  Tiktoken = 1,
+  HFTokenizer = 2,
+  Llama2cTokenizer = 3,
+};
+
+enum class ArtifactSection : uint32_t {
+  /// Integer scalars, such as vocab size and BOS/EOS ids.
+  Metadata = 1,
+  TokenMap = 2,
+  SpecialTokenMap = 3,
+  MergeRanks = 4,
+  /// Special token strings, in id order.
+  SpecialTokens = 5,
+  /// Pre-tokenization regex pattern.
+  Pattern = 6,
+  NormalizerConfig = 7,
+  PreTokenizerConfig = 8,
+  DecoderConfig = 9,
+  /// Token strings, in id order.
+  Vocab = 10,
+  VocabScores = 11,
+  /// Token ids, in byte-wise order of their strings.
+  SortedVocab = 12,
+};
+
+/**
+ * Returns true if the data starts with the artifact magic.
+ */
+bool has_artifact_magic(std::string_view data);
+
+/**
+ * Collects sections and writes them out as an artifact.
+ */
+class ArtifactWriter {
+ public:
+  explicit ArtifactWriter(ArtifactKind kind) : kind_(kind) {}
+
+  void add(ArtifactSection section, std::string data);
+
+  void add_integers(
+      ArtifactSection section,
+      const std::vector<uint64_t>& values);
+
+  void add_strings(
+      ArtifactSection section,
+      const std::vector<std::string_view>& values);
+
+  template <typename TMap>
+  void add_map(ArtifactSection section, const TMap& map) {
+    std::string data;
+    map.serialize(data);
+    add(section, std::move(data));
+  }
+
+  /// Writes the artifact to the given path.
+  /// @return Error::Ok, or Error::SaveFailure if the file cannot be written
+  Error save(const std::string& path) const;
+
+ private:
+  ArtifactKind kind_;
+  std::vector<std::pair<ArtifactSection, std::string>> sections_;
+};
+
+/**
+ * A memory mapped artifact. Views returned by its accessors, and maps restored
+ * from it, keep the mapping alive as needed.
+ */
+class ArtifactReader {
+ public:
+  /**
+   * Maps the artifact at the given path and validates its header.
+   * @return the reader, or Error::LoadFailure if the file cannot be read or is
+   * not a compatible artifact
+   */
+  static Result<ArtifactReader> open(const std::string& path);
+
+  /**
+   * Reads an artifact from a file the caller has already opened, for example
+   * to check its magic, so that the file is not opened a second time.
+   * @return the reader, or Error::LoadFailure if the file is not a compatible
+   * artifact
+   */
+  static Result<ArtifactReader> from_file(MappedFile file);
+
+  /**
+   * Reads an artifact held in memory. The data is copied once, since the
+   * maps restored from the artifact outlive the call.
+   * @return the reader, or Error::LoadFailure if the data is not a compatible
+   * artifact
+   */
+  static Result<ArtifactReader> from_buffer(std::string_view data);
+
+  ArtifactKind kind() const {
+    return kind_;
+  }
+
+  /// The payload of a section, or Error::LoadFailure if it is missing.
+  Result<std::string_view> section(ArtifactSection section) const;
+
+  /// Whether the artifact contains the given section.
+  bool has_section(ArtifactSection section) const;
+
+  Result<std::vector<uint64_t>> integers(ArtifactSection section) const;
+
+  Result<std::vector<std::string_view>> strings(ArtifactSection section) const;
+
+  /// Restores a map saved with ArtifactWriter::add_map() in place.
+  template <typename TMap>
+  Result<TMap> map(ArtifactSection section) const {
+    const auto data = TK_UNWRAP(this->section(section));
+    auto map = TMap::view(data, file_);
+    TK_CHECK_OR_RETURN_ERROR(
+        map.has_value(),
+        LoadFailure,
+        "malformed map in artifact section %u",
+        static_cast<unsigned>(section));
+    return std::move(*map);
+  }
+
+  /// The mapping itself, for holders of raw views into the artifact.
+  const std::shared_ptr<const MappedFile>& file() const {
+    return file_;
+  }
+
+ private:
+  static Result<ArtifactReader> read(
+      std::shared_ptr<const MappedFile> file,
+      const char* source);
+
+  std::shared_ptr<const MappedFile> file_;
+  ArtifactKind kind_ = ArtifactKind::Tiktoken;
+  std::vector<std::pair<ArtifactSection, std::string_view>> sections_;
+};
+
+} // namespace detail
+} // namespace tokenizers
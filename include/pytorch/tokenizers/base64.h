@@ -26,11 +26,39 @@
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "result.h"
 
+/*
+ * Decode with SIMD where available. The x86 kernels are compiled for their
+ * target with function attributes and picked at runtime, so the library does
+ * not need to be built with -mavx2. Define TK_ENABLE_SIMD_BASE64=0 to always
+ * use the scalar decoder.
+ */
+#ifndef TK_ENABLE_SIMD_BASE64
+#define TK_ENABLE_SIMD_BASE64 1
+#endif // !defined(TK_ENABLE_SIMD_BASE64)
+
+#if TK_ENABLE_SIMD_BASE64 && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TK_BASE64_SIMD_X86 1
+#define TK_BASE64_TARGET(arch) __attribute__((target(arch)))
+#else
+#define TK_BASE64_SIMD_X86 0
+#endif
+
+#if TK_ENABLE_SIMD_BASE64 && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TK_BASE64_SIMD_NEON 1
+#else
+#define TK_BASE64_SIMD_NEON 0
+#endif
+
 namespace base64 {
 
 using tokenizers::Error;
@@ -60,108 +88,268 @@ constexpr uint32_t DECODE_TABLE[] = {
     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
     255};
 
-inline Error validate(uint32_t v) {
-  if (v == 255) {
-    fprintf(stderr, "invalid char");
-    return Error::Base64DecodeFailure;
+/// Decodes one unpadded quantum of four characters into three bytes.
+/// Returns false if any of the characters is not in the base64 alphabet.
+inline bool decode_quantum(const char* input, char* output) {
+  const uint32_t a = DECODE_TABLE[static_cast<uint8_t>(input[0])];
+  const uint32_t b = DECODE_TABLE[static_cast<uint8_t>(input[1])];
+  const uint32_t c = DECODE_TABLE[static_cast<uint8_t>(input[2])];
+  const uint32_t d = DECODE_TABLE[static_cast<uint8_t>(input[3])];
+  // Valid sextets are below 64, invalid characters map to 255.
+  if ((a | b | c | d) & 0x80) {
+    return false;
   }
-  return Error::Ok;
+  const uint32_t val = (a << 18) | (b << 12) | (c << 6) | d;
+  output[0] = static_cast<char>((val >> 16) & 0xFF);
+  output[1] = static_cast<char>((val >> 8) & 0xFF);
+  output[2] = static_cast<char>(val & 0xFF);
+  return true;
 }
 
-inline Error decode(const std::string_view& input, std::string& output) {
-  TK_CHECK_OR_RETURN_ERROR(
-      input.size() == 4,
-      Base64DecodeFailure,
-      "input length must be 4, got %zu",
-      input.size());
-
-  uint32_t val = 0;
-
-  uint8_t c = input[0];
-  auto v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = v;
-
-  c = input[1];
-  v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = (val << 6) | v;
-
-  c = input[2];
-  v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = (val << 6) | v;
-
-  c = input[3];
-  v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = (val << 6) | v;
+/**
+ * A block decoder translates as many whole SIMD blocks of unpadded base64 as
+ * possible from the front of `input`, writing 3 bytes per 4 characters to
+ * `output`. It stops before the first block containing a character outside
+ * the alphabet and returns the number of characters consumed, so the scalar
+ * path can finish the input and report the error.
+ */
+using BlockDecoder =
+    std::size_t (*)(const char* input, std::size_t size, char* output);
+
+#if TK_BASE64_SIMD_X86
+
+TK_BASE64_TARGET("sse4.1")
+inline std::size_t
+decode_blocks_sse41(const char* input, std::size_t size, char* output) {
+  std::size_t consumed = 0;
+  for (; consumed + 16 <= size; consumed += 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + consumed));
+
+    // Classify each character by range. Bytes >= 0x80 compare as negative and
+    // fall outside every range.
+    const __m128i is_upper = _mm_and_si128(
+        _mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)),
+        _mm_cmplt_epi8(in, _mm_set1_epi8('Z' + 1)));
+    const __m128i is_lower = _mm_and_si128(
+        _mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(in, _mm_set1_epi8('z' + 1)));
+    const __m128i is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+    const __m128i is_plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+    const __m128i is_slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    const __m128i valid = _mm_or_si128(
+        _mm_or_si128(is_upper, is_lower),
+        _mm_or_si128(is_digit, _mm_or_si128(is_plus, is_slash)));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+      break;
+    }
 
-  output.push_back(static_cast<char>((val >> 16) & 0xFF));
-  output.push_back(static_cast<char>((val >> 8) & 0xFF));
-  output.push_back(static_cast<char>(val & 0xFF));
-  return Error::Ok;
+    // Translate characters to sextets by adding a per-class offset.
+    __m128i shift = _mm_and_si128(is_upper, _mm_set1_epi8(-'A'));
+    shift = _mm_or_si128(
+        shift, _mm_and_si128(is_lower, _mm_set1_epi8(26 - 'a')));
+    shift = _mm_or_si128(
+        shift, _mm_and_si128(is_digit, _mm_set1_epi8(52 - '0')));
+    shift = _mm_or_si128(
+        shift, _mm_and_si128(is_plus, _mm_set1_epi8(62 - '+')));
+    shift = _mm_or_si128(
+        shift, _mm_and_si128(is_slash, _mm_set1_epi8(63 - '/')));
+    const __m128i sextets = _mm_add_epi8(in, shift);
+
+    // Pack four sextets into 24 bits per 32-bit lane, then gather the three
+    // big-endian bytes of each lane into the low 12 bytes.
+    const __m128i pairs =
+        _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+    const __m128i lanes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    const __m128i bytes = _mm_shuffle_epi8(
+        lanes,
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    alignas(16) char block[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(block), bytes);
+    std::memcpy(output + consumed / 4 * 3, block, 12);
+  }
+  return consumed;
 }
 
-inline Error decode_1_padding(
-    const std::string_view& input,
-    std::string& output) {
-  TK_CHECK_OR_RETURN_ERROR(
-      input.size() == 3,
-      Base64DecodeFailure,
-      "input length must be 3, got %zu",
-      input.size());
-
-  uint32_t val = 0;
+TK_BASE64_TARGET("avx2")
+inline std::size_t
+decode_blocks_avx2(const char* input, std::size_t size, char* output) {
+  std::size_t consumed = 0;
+  for (; consumed + 32 <= size; consumed += 32) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + consumed));
+
+    const __m256i is_upper = _mm256_and_si256(
+        _mm256_cmpgt_epi8(in, _mm256_set1_epi8('A' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in));
+    const __m256i is_lower = _mm256_and_si256(
+        _mm256_cmpgt_epi8(in, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in));
+    const __m256i is_digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+    const __m256i is_plus = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('+'));
+    const __m256i is_slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+    const __m256i valid = _mm256_or_si256(
+        _mm256_or_si256(is_upper, is_lower),
+        _mm256_or_si256(is_digit, _mm256_or_si256(is_plus, is_slash)));
+    if (_mm256_movemask_epi8(valid) != -1) {
+      break;
+    }
 
-  uint8_t c = input[0];
-  auto v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = v;
+    __m256i shift = _mm256_and_si256(is_upper, _mm256_set1_epi8(-'A'));
+    shift = _mm256_or_si256(
+        shift, _mm256_and_si256(is_lower, _mm256_set1_epi8(26 - 'a')));
+    shift = _mm256_or_si256(
+        shift, _mm256_and_si256(is_digit, _mm256_set1_epi8(52 - '0')));
+    shift = _mm256_or_si256(
+        shift, _mm256_and_si256(is_plus, _mm256_set1_epi8(62 - '+')));
+    shift = _mm256_or_si256(
+        shift, _mm256_and_si256(is_slash, _mm256_set1_epi8(63 - '/')));
+    const __m256i sextets = _mm256_add_epi8(in, shift);
+
+    // Same packing as the SSE path; the shuffle works within each 128-bit
+    // half, so every half yields 12 bytes.
+    const __m256i pairs =
+        _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+    const __m256i lanes =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    const __m256i bytes = _mm256_shuffle_epi8(
+        lanes,
+        _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    alignas(32) char block[32];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(block), bytes);
+    char* out = output + consumed / 4 * 3;
+    std::memcpy(out, block, 12);
+    std::memcpy(out + 12, block + 16, 12);
+  }
+  return consumed;
+}
 
-  c = input[1];
-  v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = (val << 6) | v;
+#elif TK_BASE64_SIMD_NEON
+
+inline uint8x16_t
+decode_sextets_neon(uint8x16_t in, uint8x16_t& valid_accumulator) {
+  // (c - lo) < n as unsigned bytes is a range check for [lo, lo + n).
+  const uint8x16_t is_upper =
+      vcltq_u8(vsubq_u8(in, vdupq_n_u8('A')), vdupq_n_u8(26));
+  const uint8x16_t is_lower =
+      vcltq_u8(vsubq_u8(in, vdupq_n_u8('a')), vdupq_n_u8(26));
+  const uint8x16_t is_digit =
+      vcltq_u8(vsubq_u8(in, vdupq_n_u8('0')), vdupq_n_u8(10));
+  const uint8x16_t is_plus = vceqq_u8(in, vdupq_n_u8('+'));
+  const uint8x16_t is_slash = vceqq_u8(in, vdupq_n_u8('/'));
+  valid_accumulator = vandq_u8(
+      valid_accumulator,
+      vorrq_u8(
+          vorrq_u8(is_upper, is_lower),
+          vorrq_u8(is_digit, vorrq_u8(is_plus, is_slash))));
+
+  uint8x16_t shift =
+      vandq_u8(is_upper, vdupq_n_u8(static_cast<uint8_t>(-'A')));
+  shift = vorrq_u8(
+      shift, vandq_u8(is_lower, vdupq_n_u8(static_cast<uint8_t>(26 - 'a'))));
+  shift = vorrq_u8(
+      shift, vandq_u8(is_digit, vdupq_n_u8(static_cast<uint8_t>(52 - '0'))));
+  shift = vorrq_u8(
+      shift, vandq_u8(is_plus, vdupq_n_u8(static_cast<uint8_t>(62 - '+'))));
+  shift = vorrq_u8(
+      shift, vandq_u8(is_slash, vdupq_n_u8(static_cast<uint8_t>(63 - '/'))));
+  return vaddq_u8(in, shift);
+}
 
-  c = input[2];
-  v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = (val << 6) | v;
+inline std::size_t
+decode_blocks_neon(const char* input, std::size_t size, char* output) {
+  std::size_t consumed = 0;
+  for (; consumed + 64 <= size; consumed += 64) {
+    // De-interleave 16 quanta so that val[i] holds the i-th character of each.
+    const uint8x16x4_t in =
+        vld4q_u8(reinterpret_cast<const uint8_t*>(input + consumed));
+    uint8x16_t valid = vdupq_n_u8(0xFF);
+    const uint8x16_t a = decode_sextets_neon(in.val[0], valid);
+    const uint8x16_t b = decode_sextets_neon(in.val[1], valid);
+    const uint8x16_t c = decode_sextets_neon(in.val[2], valid);
+    const uint8x16_t d = decode_sextets_neon(in.val[3], valid);
+    if (vminvq_u8(valid) == 0) {
+      break;
+    }
 
-  output.push_back(static_cast<char>((val >> 10) & 0xFF));
-  output.push_back(static_cast<char>((val >> 2) & 0xFF));
-  return Error::Ok;
+    uint8x16x3_t out;
+    out.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+    out.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+    out.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+    vst3q_u8(reinterpret_cast<uint8_t*>(output + consumed / 4 * 3), out);
+  }
+  return consumed;
 }
 
-inline Error decode_2_padding(
-    const std::string_view& input,
-    std::string& output) {
-  TK_CHECK_OR_RETURN_ERROR(
-      input.size() == 2,
-      Base64DecodeFailure,
-      "input length must be 2, got %zu",
-      input.size());
+#endif
 
-  uint32_t val = 0;
+/// The block decoders that the running CPU supports, narrowest first. The
+/// first entry is always nullptr, which stands for the scalar path.
+inline std::vector<BlockDecoder> supported_block_decoders() {
+  std::vector<BlockDecoder> decoders = {nullptr};
+#if TK_BASE64_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.1")) {
+    decoders.push_back(decode_blocks_sse41);
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    decoders.push_back(decode_blocks_avx2);
+  }
+#elif TK_BASE64_SIMD_NEON
+  decoders.push_back(decode_blocks_neon);
+#endif
+  return decoders;
+}
 
-  uint8_t c = input[0];
-  auto v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = v;
+inline BlockDecoder& block_decoder_slot() {
+  static BlockDecoder decoder = supported_block_decoders().back();
+  return decoder;
+}
 
-  c = input[1];
-  v = DECODE_TABLE[c];
-  TK_CHECK_OK_OR_RETURN_ERROR(validate(v));
-  val = (val << 6) | v;
+/// The block decoder in use: the widest one supported by the running CPU
+/// unless overridden, or nullptr if only the scalar path is available.
+inline BlockDecoder block_decoder() {
+  return block_decoder_slot();
+}
 
-  output.push_back(static_cast<char>((val >> 4) & 0xFF));
-  return Error::Ok;
+/// Overrides the block decoder, so that tests can exercise the kernels that
+/// the CPU supports but does not pick. Returns the previous decoder. Not
+/// thread-safe with concurrent decoding.
+inline BlockDecoder set_block_decoder(BlockDecoder decoder) {
+  const BlockDecoder previous = block_decoder_slot();
+  block_decoder_slot() = decoder;
+  return previous;
 }
 
 } // namespace detail
 
-inline tokenizers::Result<std::string> decode(const std::string_view& input) {
+/// Returns an upper bound on the number of bytes decoded from `size` base64
+/// characters.
+constexpr std::size_t decoded_size(std::size_t size) {
+  return size / 4 * 3;
+}
+
+/**
+ * Decodes a base64 string into a caller-provided buffer.
+ *
+ * Whole blocks are decoded with the widest SIMD instruction set available at
+ * runtime, the remainder and the padded final quantum with the scalar table.
+ *
+ * @param input The base64 string; its length must be a multiple of 4.
+ * @param output Buffer of at least decoded_size(input.size()) bytes.
+ * @return The number of bytes written to output.
+ */
+inline Result<std::size_t> decode_to(
+    const std::string_view& input,
+    char* output) {
   TK_CHECK_OR_RETURN_ERROR(!input.empty(), Base64DecodeFailure, "empty input");
 
   // Faster than `input.size() % 4`.
@@ -171,29 +359,122 @@ inline tokenizers::Result<std::string> decode(const std::string_view& input) {
       "input length must be larger than 4 and is multiple of 4, got %zu",
       input.size());
 
-  std::string output;
-  output.reserve(input.size() / 4 * 3);
-  auto idx = 0U;
-  for (; idx < input.size() - 4; idx += 4) {
-    TK_CHECK_OK_OR_RETURN_ERROR(detail::decode(input.substr(idx, 4), output));
+  // The last quantum might contain paddings and is always decoded below.
+  const std::size_t body = input.size() - 4;
+  std::size_t idx = 0;
+  if (body >= 16) {
+    if (const auto decoder = detail::block_decoder()) {
+      idx = decoder(input.data(), body, output);
+    }
+  }
+
+  char* out = output + idx / 4 * 3;
+  for (; idx < body; idx += 4, out += 3) {
+    TK_CHECK_OR_RETURN_ERROR(
+        detail::decode_quantum(input.data() + idx, out),
+        Base64DecodeFailure,
+        "invalid char");
   }
 
-  // Last 4 bytes. Might contain paddings.
-  if (input[idx + 3] == '=') {
-    if (input[idx + 2] == '=') {
-      // Tow paddings.
-      TK_CHECK_OK_OR_RETURN_ERROR(
-          detail::decode_2_padding(input.substr(idx, 2), output));
+  const char* last = input.data() + idx;
+  if (last[3] == '=') {
+    const uint32_t a = detail::DECODE_TABLE[static_cast<uint8_t>(last[0])];
+    const uint32_t b = detail::DECODE_TABLE[static_cast<uint8_t>(last[1])];
+    if (last[2] == '=') {
+      // Two paddings.
+      TK_CHECK_OR_RETURN_ERROR(
+          ((a | b) & 0x80) == 0, Base64DecodeFailure, "invalid char");
+      *out++ = static_cast<char>(((a << 2) | (b >> 4)) & 0xFF);
     } else {
       // One padding.
-      TK_CHECK_OK_OR_RETURN_ERROR(
-          detail::decode_1_padding(input.substr(idx, 3), output));
+      const uint32_t c = detail::DECODE_TABLE[static_cast<uint8_t>(last[2])];
+      TK_CHECK_OR_RETURN_ERROR(
+          ((a | b | c) & 0x80) == 0, Base64DecodeFailure, "invalid char");
+      const uint32_t val = (a << 12) | (b << 6) | c;
+      *out++ = static_cast<char>((val >> 10) & 0xFF);
+      *out++ = static_cast<char>((val >> 2) & 0xFF);
     }
   } else {
     // No padding.
-    TK_CHECK_OK_OR_RETURN_ERROR(detail::decode(input.substr(idx, 4), output));
+    TK_CHECK_OR_RETURN_ERROR(
+        detail::decode_quantum(last, out), Base64DecodeFailure, "invalid char");
+    out += 3;
+  }
+
+  return static_cast<std::size_t>(out - output);
+}
+
+/**
+ * Decodes a base64 string and appends the result to output.
+ *
+ * On failure output is left unchanged.
+ */
+inline Error decode(const std::string_view& input, std::string& output) {
+  const auto offset = output.size();
+  output.resize(offset + decoded_size(input.size()));
+  const auto result = decode_to(input, output.data() + offset);
+  if (!result.ok()) {
+    output.resize(offset);
+    return result.error();
+  }
+  output.resize(offset + result.get());
+  return Error::Ok;
+}
+
+/**
+ * Decodes many short base64 strings, such as the tokens of a tiktoken model,
+ * into one contiguous buffer.
+ *
+ * The buffer is sized once for all inputs. On success `output` holds the
+ * decoded inputs back to back and `decoded[i]` views the bytes of
+ * `inputs[i]` within it; the views stay valid until `output` is modified.
+ *
+ * @param inputs The base64 strings to decode.
+ * @param output Receives the decoded bytes; previous contents are replaced.
+ * @param decoded Receives one view into output per input.
+ */
+inline Error decode_many(
+    const std::vector<std::string_view>& inputs,
+    std::string& output,
+    std::vector<std::string_view>& decoded) {
+  std::size_t capacity = 0;
+  for (const auto& input : inputs) {
+    capacity += decoded_size(input.size());
+  }
+  output.resize(capacity);
+
+  // Record offsets first; views are only taken once output has its final size.
+  std::vector<std::size_t> offsets;
+  offsets.reserve(inputs.size() + 1);
+  offsets.push_back(0);
+  std::size_t size = 0;
+  for (const auto& input : inputs) {
+    const auto result = decode_to(input, output.data() + size);
+    if (!result.ok()) {
+      TK_LOG(
+          Error,
+          "failed to decode base64 string: %s",
+          std::string(input).c_str());
+      output.clear();
+      return result.error();
+    }
+    size += result.get();
+    offsets.push_back(size);
   }
+  output.resize(size);
 
+  decoded.clear();
+  decoded.reserve(inputs.size());
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    decoded.emplace_back(
+        output.data() + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+  return Error::Ok;
+}
+
+inline tokenizers::Result<std::string> decode(const std::string_view& input) {
+  std::string output;
+  TK_CHECK_OK_OR_RETURN_ERROR(decode(input, output));
   return output;
 }
 } // namespace base64
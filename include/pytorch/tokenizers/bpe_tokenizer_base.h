@@ -11,6 +11,7 @@
 #pragma once
 
 // Standard
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -19,9 +20,13 @@
 #include <vector>
 
 // Local
+#include <pytorch/tokenizers/artifact.h>
 #include <pytorch/tokenizers/error.h>
+#include <pytorch/tokenizers/huge_page_allocator.h>
+#include <pytorch/tokenizers/lazy_init.h>
 #include <pytorch/tokenizers/regex.h>
 #include <pytorch/tokenizers/result.h>
+#include <pytorch/tokenizers/special_token_matcher.h>
 #include <pytorch/tokenizers/string_integer_map.h>
 #include <pytorch/tokenizers/tokenizer.h>
 
@@ -30,7 +35,10 @@
 namespace tokenizers {
 namespace detail {
 
-using TokenMap = StringIntegerMap<>;
+// Token maps for large vocabularies span several megabytes and are probed at
+// random, so they are backed by transparent huge pages where available.
+using TokenMap = StringIntegerMapTypeBuilder<>::WithAllocator<
+    HugePageAllocator<std::uint8_t>>::Map;
 
 template <typename TToken, typename TRank>
 static Result<TokenMap> build_token_map(
@@ -57,7 +65,7 @@ static Result<TokenMap> build_token_map(
       duplicate_begin == container.end(),
       ParseFailure,
       "duplicate token: %s rank: %llu",
-      duplicate_begin->first.c_str(),
+      std::string(duplicate_begin->first).c_str(),
       static_cast<unsigned long long>(duplicate_begin->second));
 
   std::sort(
@@ -76,7 +84,7 @@ static Result<TokenMap> build_token_map(
       "duplicate rank: %llu"
       " token: %s",
       static_cast<unsigned long long>(duplicate_begin->second),
-      duplicate_begin->first.c_str());
+      std::string(duplicate_begin->first).c_str());
 
   return TokenMap(container);
 };
@@ -106,51 +114,39 @@ static Result<TokenMap> build_token_map(
   return build_token_map(std::move(pairs));
 }
 
-inline Result<std::unique_ptr<IRegex>> build_special_token_regex(
-    const TokenMap& special_token_map) {
-  std::string special_pattern;
-  const std::size_t count = special_token_map.size();
-
-  for (std::size_t i = 0; i < count; ++i) {
-    const auto& [token, _] = special_token_map.getElement(i);
-    if (!special_pattern.empty()) {
-      special_pattern += "|";
-    }
-    special_pattern += re2::RE2::QuoteMeta(std::string(token));
-  }
-
-  if (special_pattern.empty()) {
-    return static_cast<std::unique_ptr<IRegex>>(nullptr);
-  }
-  return create_regex(special_pattern);
-}
-
 class BPETokenizerBase : public Tokenizer {
  public:
   Result<std::vector<uint64_t>>
   encode(const std::string& input, int8_t bos, int8_t eos) const override;
 
+  /**
+   * Encodes the input with the special token policy and BOS/EOS counts of
+   * the given options. Special tokens are matched with the matcher built on
+   * first use, whatever the policy, so no per-call setup is needed.
+   */
+  Result<std::vector<uint64_t>> encode(
+      const std::string& input,
+      const EncodeOptions& options) const;
+
   Result<std::string> decode(uint64_t prev_token, uint64_t token)
       const override;
 
+  /**
+   * The backends of the regexes that split the input into pieces, as
+   * IRegex::backend_name() reports them. They are created by load(), so this
+   * tells which ones set_regex_benchmarking() picked.
+   */
+  virtual std::vector<std::string> regex_backends() const {
+    return {};
+  }
+
  protected:
   explicit BPETokenizerBase() {}
   virtual ~BPETokenizerBase() override {}
 
-  std::pair<std::optional<std::string>, std::string>
-  split_with_allowed_special_token_(
-      const std::string& input,
-      const TokenMap& allowed_special) const;
-
-  std::pair<std::optional<std::string>, std::string>
-  split_with_allowed_special_token_(
-      const std::string& input,
-      size_t offset,
-      const TokenMap& allowed_special) const;
-
   Result<std::pair<std::vector<uint64_t>, uint64_t>> encode_with_special_token_(
       const std::string& text,
-      const TokenMap& allowed_special) const;
+      const EncodeOptions& options) const;
 
   virtual Result<std::vector<uint64_t>> byte_pair_encode_(
       const std::string& piece,
@@ -165,8 +161,34 @@ class BPETokenizerBase : public Tokenizer {
       const TokenMap& ranks,
       std::function<uint64_t(uint64_t, uint64_t)> func) const;
 
+  // Builds what only encoding needs, such as merge tables. It is called once,
+  // by the first encode() after load(), so decode-only users never pay for
+  // it. Regexes are not built here but by load(), so that an invalid pattern
+  // is reported by load() rather than by the first encode(). Overrides must
+  // call the base implementation, which builds the special token matcher.
+  virtual Error _init_encoder() const;
+
+  // Builds what only decoding needs, once, on the first decode() after load().
+  virtual Error _init_decoder() const {
+    return Error::Ok;
+  }
+
+  // Runs _init_encoder()/_init_decoder() if they have not run yet.
+  Error ensure_encoder_() const;
+  Error ensure_decoder_() const;
+
+  // Discards the lazily built state, must be called by load().
+  void reset_lazy_init_();
+
+  // Adds the token and special token maps to an artifact.
+  void save_token_maps_(ArtifactWriter& writer) const;
+
+  // Restores the token and special token maps from an artifact in place.
+  Error load_token_maps_(const ArtifactReader& reader);
+
   // Protected members that can be overloaded by other BPE tokenizers
-  std::unique_ptr<IRegex> special_token_regex_;
+  // Built by _init_encoder().
+  mutable SpecialTokenMatcher special_token_matcher_;
   std::optional<TokenMap> token_map_;
   std::optional<TokenMap> special_token_map_;
 
@@ -177,6 +199,16 @@ class BPETokenizerBase : public Tokenizer {
       uint64_t& last_piece_token_len) const = 0;
 
   virtual void _decode(const std::string& input, std::string& ret) const = 0;
+
+  // Decodes the token after BOS, which starts the text. Like the
+  // sentencepiece decoders, some decoders drop its leading space.
+  virtual void _decode_first(const std::string& input, std::string& ret)
+      const {
+    _decode(input, ret);
+  }
+
+  LazyInit encoder_init_;
+  LazyInit decoder_init_;
 };
 
 } // namespace detail
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+// Standard
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tokenizers {
+namespace detail {
+
+/**
+ * The properties of a codepoint that HF's native pre-tokenizers split on
+ */
+struct CodepointClass {
+  enum Flags : uint8_t {
+    /** White_Space, which is Rust's char::is_whitespace() and regex \s */
+    kWhitespace = 1 << 0,
+    /** Rust regex \w: Alphabetic, marks, Nd, Pc and Join_Control */
+    kWord = 1 << 1,
+    /** ASCII punctuation or the P categories, HF's is_punc() */
+    kPunctuation = 1 << 2,
+    /** The N categories, which is Rust's char::is_numeric() */
+    kNumeric = 1 << 3,
+  };
+
+  uint8_t flags;
+  /** The script, as UnicodeScripts sees it: Hiragana, Katakana and U+30FC
+   * count as Han, and the space and codepoints that are missing from its
+   * script table are kAnyScript. Other values identify a script but are
+   * otherwise arbitrary. */
+  uint8_t script;
+
+  static constexpr uint8_t kAnyScript = 0;
+
+  bool is(Flags flag) const {
+    return (flags & flag) != 0;
+  }
+};
+
+/**
+ * Two-stage lookup of CodepointClass, built once from a table of ranges that
+ * is generated to match HF tokenizers
+ */
+class CodepointTable {
+ public:
+  static const CodepointTable& get();
+
+  CodepointClass operator[](uint32_t cp) const {
+    if (cp > 0x10ffff) {
+      cp = 0xfffd;
+    }
+    return unpack(
+        values_[(static_cast<std::size_t>(blocks_[cp >> 8]) << 8) |
+                (cp & 0xff)]);
+  }
+
+  /** Decode the character at text[pos, end), which must not be empty, and
+   * return its class, storing its length */
+  CodepointClass classify(
+      const std::string& text,
+      std::size_t pos,
+      std::size_t end,
+      std::size_t& length) const {
+    const uint8_t lead = static_cast<uint8_t>(text[pos]);
+    if (lead < 0x80) {
+      // The first block holds the ASCII characters.
+      length = 1;
+      return unpack(values_[lead]);
+    }
+    return (*this)[decode_multibyte(text, pos, end, length)];
+  }
+
+  /** Decode the character at text[pos, end), which must not be empty, and
+   * store its length. Invalid UTF-8 is read one byte at a time, as U+FFFD. */
+  static uint32_t decode(
+      const std::string& text,
+      std::size_t pos,
+      std::size_t end,
+      std::size_t& length) {
+    const uint8_t lead = static_cast<uint8_t>(text[pos]);
+    if (lead < 0x80) {
+      length = 1;
+      return lead;
+    }
+    return decode_multibyte(text, pos, end, length);
+  }
+
+ private:
+  CodepointTable();
+
+  static CodepointClass unpack(uint16_t value) {
+    return {static_cast<uint8_t>(value & 0x0f),
+            static_cast<uint8_t>(value >> 4)};
+  }
+
+  static uint32_t decode_multibyte(
+      const std::string& text,
+      std::size_t pos,
+      std::size_t end,
+      std::size_t& length);
+
+  // The block of 256 values that holds each codepoint, by cp >> 8.
+  std::vector<uint16_t> blocks_;
+  // The distinct blocks, one after the other.
+  std::vector<uint16_t> values_;
+};
+
+} // namespace detail
+} // namespace tokenizers
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <pytorch/tokenizers/regex.h>
+
+namespace tokenizers {
+namespace detail {
+
+/**
+ * A DFA over bytes that are mapped to equivalence classes. State 0 is the
+ * dead state, which has no matches after it.
+ */
+struct ByteDfa {
+  // Equivalence class of every byte.
+  std::array<uint8_t, 256> byte_classes{};
+  std::size_t class_count = 0;
+  // transitions[state * class_count + class] is the next state.
+  std::vector<uint16_t> transitions;
+  // Nonzero if a match ends when a state is entered.
+  std::vector<uint8_t> accepting;
+  uint16_t start = 0;
+
+  uint16_t next(std::size_t state, char byte) const {
+    return transitions
+        [state * class_count + byte_classes[static_cast<uint8_t>(byte)]];
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief IRegex backed by a byte-level DFA that is built when the pattern is
+ * compiled.
+ *
+ * The pattern is parsed into an NFA over UTF-8 bytes, which is determinized
+ * eagerly and then minimized. Like RE2, find_all() runs an unanchored DFA with
+ * leftmost-first (Perl) semantics forward to find where a match ends, and a
+ * DFA of the reversed pattern backward to find where it starts. It returns
+ * the same matches as RE2, costs one table lookup per byte and direction, and
+ * a search that finds nothing scans the rest of the text once. The tables are
+ * compressed by mapping bytes to equivalence classes.
+ *
+ * Alternation, groups, the greedy and lazy quantifiers including bounded
+ * repeats, and the (?i) and (?s) flags are supported. Character classes are
+ * resolved with RE2's own Unicode tables, so \p{L}, \p{N}, \s and the like
+ * mean exactly what they mean to RE2. Patterns with anchors, word boundaries,
+ * lookaround or backreferences, and patterns whose DFA would exceed
+ * kMaxStates, fail to compile.
+ */
+class DfaRegex : public IRegex {
+ public:
+  /// Upper bound of DFA states, including the dead state.
+  static constexpr std::size_t kMaxStates = 1 << 15;
+
+  explicit DfaRegex() {}
+
+  /**
+   * @brief Compile the given regex pattern.
+   * @param pattern The regex pattern to compile.
+   * @return An Error object indicating success or failure of the compilation.
+   */
+  virtual Error compile(const std::string& pattern) override;
+
+  /**
+   * @brief Return all non-overlapping matches found in the input string.
+   */
+  virtual std::vector<Match> find_all(const std::string& text) const override;
+
+  /**
+   * @brief Return all non-overlapping matches in a reused vector.
+   */
+  virtual void find_all_into(
+      const std::string& text,
+      std::vector<Match>& matches) const override;
+
+  virtual const char* backend_name() const override {
+    return "dfa";
+  }
+
+  /// Number of states of the compiled forward DFA.
+  std::size_t state_count() const {
+    return forward_.accepting.size();
+  }
+
+ private:
+  // Returns the end of the leftmost-first match that starts at or after pos,
+  // or std::string::npos if there is none. Sets *later if the match starts
+  // after pos.
+  std::size_t match_end(
+      const char* data,
+      std::size_t pos,
+      std::size_t size,
+      bool* later) const;
+
+  // Returns the start of the longest match in [pos, end) that ends at end.
+  std::size_t match_start(const char* data, std::size_t pos, std::size_t end)
+      const;
+
+  // The pattern with an unanchored .*? prefix. Its accepting states tell
+  // whether the match started at the first byte.
+  detail::ByteDfa forward_;
+  // The reversed pattern, with longest match semantics.
+  detail::ByteDfa reverse_;
+  // Whether a match can start with a byte.
+  std::array<bool, 256> can_start_{};
+};
+
+} // namespace tokenizers
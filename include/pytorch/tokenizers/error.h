@@ -58,6 +58,9 @@ enum class Error : error_code_t {
 
   /// No suitable regex implementation found.
   RegexFailure = 0x09,
+
+  /// Tokenizer artifact save failure.
+  SaveFailure = 0x0A,
 };
 
 } // namespace tokenizers
@@ -182,7 +182,56 @@ class HFTokenizer : public detail::BPETokenizerBase {
    */
   Error load(const std::string& tokenizer_path) override;
 
+  /**
+   * Loads the contents of a tokenizer.json file, or an artifact written by
+   * save(), held in memory.
+   */
+  Error load_from_buffer(std::string_view data) override;
+  using Tokenizer::load_from_buffer;
+
+  /**
+   * Loads the contents of a tokenizer.json file along with those of its
+   * tokenizer_config.json, which is used to look up the BOS and EOS tokens.
+   * An empty config is treated as missing.
+   */
+  Error load_from_buffer(
+      std::string_view tokenizer_json,
+      std::string_view tokenizer_config_json);
+
+  /**
+   * Writes the loaded tokenizer to a precompiled artifact, which load() maps
+   * in place instead of parsing tokenizer.json.
+   */
+  Error save(const std::string& artifact_path) const;
+
+  /**
+   * The backends of the pre-tokenizer's regexes, in the order they split.
+   */
+  std::vector<std::string> regex_backends() const override {
+    if (!_pretokenizer) {
+      return {};
+    }
+    return _pretokenizer->regex_backends();
+  }
+
  private:
+  // Discards the loaded state before loading again.
+  void _reset();
+
+  Error _load_artifact(const detail::ArtifactReader& reader);
+
+  // Create the normalizer and pre-tokenizer, which compiles their regexes.
+  // Called by load(), so that invalid patterns are reported there.
+  Error _create_components();
+
+  // Build the special token matcher and the merge tables.
+  Error _init_encoder() const override;
+
+  // Create the decoder.
+  Error _init_decoder() const override;
+
+  Error _build_merge_ranks() const;
+
   Error _encode(
       const std::string& input,
       std::vector<uint64_t>& ret,
@@ -190,6 +239,9 @@ class HFTokenizer : public detail::BPETokenizerBase {
 
   void _decode(const std::string& input, std::string& ret) const override;
 
+  void _decode_first(const std::string& input, std::string& ret)
+      const override;
+
   Result<std::vector<uint64_t>> byte_pair_encode_(
       const std::string& piece,
       const detail::TokenMap& encoder) const override;
@@ -202,13 +254,36 @@ class HFTokenizer : public detail::BPETokenizerBase {
       const detail::TokenMap& ranks,
       std::function<uint64_t(uint64_t, uint64_t)> func) const override;
 
+  // Created from the configs below, the normalizer and pre-tokenizer by
+  // load() and the decoder on first use.
   Normalizer::Ptr _normalizer;
   PreTokenizer::Ptr _pretokenizer;
-  TokenDecoder::Ptr _decoder;
-
-  std::unique_ptr<detail::MergeMap> merge_map_;
-  std::optional<detail::TokenMap>
+  mutable TokenDecoder::Ptr _decoder;
+
+  // Serialized json configs of the components above. Empty if the component
+  // is not set.
+  std::string _normalizer_config;
+  std::string _pretokenizer_config;
+  std::string _decoder_config;
+
+  // BPE merge rules from tokenizer.json, resolved to token ids. Released once
+  // the merge tables are built from them.
+  struct MergeRule {
+    uint64_t first;
+    uint64_t second;
+    uint64_t rank;
+  };
+  mutable std::vector<MergeRule> merge_rules_;
+
+  mutable std::unique_ptr<detail::MergeMap> merge_map_;
+  mutable std::optional<detail::TokenMap>
       merge_ranks_; // Pre-computed merge ranks for BPE
+
+  // Whether the vocabulary and merges of a ByteLevel pipeline were re-keyed
+  // from the byte-level alphabet to the raw bytes it stands for, so that
+  // pieces are encoded without the byte mapping and tokens are decoded by
+  // copying them.
+  bool raw_byte_keys_ = false;
 };
 
 } // namespace tokenizers
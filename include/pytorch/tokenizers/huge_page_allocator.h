@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/*
+ * Back large tokenizer tables with transparent huge pages by default. Define
+ * TK_ENABLE_HUGE_PAGES=0 to always use the standard allocator.
+ */
+#ifndef TK_ENABLE_HUGE_PAGES
+#define TK_ENABLE_HUGE_PAGES 1
+#endif // !defined(TK_ENABLE_HUGE_PAGES)
+
+#if TK_ENABLE_HUGE_PAGES && defined(__linux__) && defined(MADV_HUGEPAGE)
+#define TK_HUGE_PAGES_SUPPORTED 1
+#else
+#define TK_HUGE_PAGES_SUPPORTED 0
+#endif
+
+namespace tokenizers {
+namespace detail {
+
+/**
+ * HugePageAllocator is a stateless allocator for large, long lived lookup
+ * tables such as token maps and merge ranks.
+ *
+ * Random lookups into multi-megabyte tables touch a different 4KiB page on
+ * nearly every probe, which thrashes the TLB. Allocations of at least
+ * kMinHugePageAllocation bytes are therefore mapped directly with mmap, aligned
+ * to a huge page boundary and advised with MADV_HUGEPAGE so the kernel can back
+ * them with transparent huge pages. Smaller allocations, and all allocations on
+ * platforms without transparent huge page support, go through std::allocator.
+ *
+ * The advice is best effort: if transparent huge pages are disabled on the
+ * host, the mapping simply stays backed by regular pages.
+ */
+template <typename T>
+class HugePageAllocator {
+ public:
+  using value_type = T;
+
+  /// Size of a transparent huge page on x86-64 and aarch64 (4KiB granule).
+  static constexpr std::size_t kHugePageSize = std::size_t(2) << 20;
+
+  /// Allocations smaller than this are not worth a dedicated mapping.
+  static constexpr std::size_t kMinHugePageAllocation = kHugePageSize;
+
+  HugePageAllocator() noexcept = default;
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+#if TK_HUGE_PAGES_SUPPORTED
+    const auto bytes = n * sizeof(T);
+    if (bytes >= kMinHugePageAllocation) {
+      return static_cast<T*>(allocate_huge(bytes));
+    }
+#endif
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, std::size_t n) noexcept {
+#if TK_HUGE_PAGES_SUPPORTED
+    const auto bytes = n * sizeof(T);
+    if (bytes >= kMinHugePageAllocation) {
+      munmap(ptr, round_up(bytes));
+      return;
+    }
+#endif
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const HugePageAllocator<U>&) const noexcept {
+    return false;
+  }
+
+ private:
+#if TK_HUGE_PAGES_SUPPORTED
+  static std::size_t round_up(std::size_t bytes) {
+    return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  }
+
+  static void* allocate_huge(std::size_t bytes) {
+    const auto size = round_up(bytes);
+
+    // mmap only guarantees base page alignment. Over-allocate by one huge page
+    // and trim both ends so that the whole range can be backed by huge pages.
+    const auto padded_size = size + kHugePageSize;
+    void* mapping = mmap(
+        nullptr,
+        padded_size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (mapping == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+
+    const auto mapping_begin = reinterpret_cast<std::uintptr_t>(mapping);
+    const auto aligned_begin =
+        (mapping_begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    const auto head = aligned_begin - mapping_begin;
+    const auto tail = padded_size - head - size;
+    if (head != 0) {
+      munmap(mapping, head);
+    }
+    if (tail != 0) {
+      munmap(reinterpret_cast<void*>(aligned_begin + size), tail);
+    }
+
+    auto* aligned = reinterpret_cast<void*>(aligned_begin);
+    (void)madvise(aligned, size, MADV_HUGEPAGE);
+    return aligned;
+  }
+#endif
+};
+
+} // namespace detail
+} // namespace tokenizers
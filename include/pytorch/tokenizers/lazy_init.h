@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include <pytorch/tokenizers/error.h>
+
+namespace tokenizers {
+namespace detail {
+
+/**
+ * LazyInit runs an initializer at most once, on first use, and remembers its
+ * result. It is thread safe, so const encode/decode methods can use it to
+ * build state that only one of them needs.
+ *
+ * Unlike a bare std::once_flag it can be reset, for tokenizers that are loaded
+ * again, and moved.
+ */
+class LazyInit {
+ public:
+  LazyInit() : state_(std::make_unique<State>()) {}
+
+  /**
+   * Runs init on the first call since construction or reset(), and returns
+   * the error it returned, then and on every later call.
+   */
+  template <typename TInit>
+  Error get(TInit&& init) const {
+    std::call_once(
+        state_->once, [&]() { state_->error = std::forward<TInit>(init)(); });
+    return state_->error;
+  }
+
+  /// Makes the next get() run its initializer again. Not thread safe.
+  void reset() {
+    state_ = std::make_unique<State>();
+  }
+
+ private:
+  struct State {
+    std::once_flag once;
+    Error error = Error::Ok;
+  };
+
+  std::unique_ptr<State> state_;
+};
+
+} // namespace detail
+} // namespace tokenizers
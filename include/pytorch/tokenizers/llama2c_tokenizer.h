@@ -7,8 +7,12 @@
  */
 // @lint-ignore-every CLANGTIDY facebook-hte-RelativeInclude
 #pragma once
+#include <pytorch/tokenizers/artifact.h>
+#include <pytorch/tokenizers/lazy_init.h>
+#include <pytorch/tokenizers/mapped_file.h>
 #include <pytorch/tokenizers/tokenizer.h>
 #include <memory>
+#include <string>
 
 namespace tokenizers {
 
@@ -21,6 +25,18 @@ class Llama2cTokenizer : public Tokenizer {
 
   Error load(const std::string& tokenizer_path) override;
 
+  /**
+   * Loads a tokenizer.bin, or an artifact written by save(), held in memory.
+   */
+  Error load_from_buffer(std::string_view data) override;
+  using Tokenizer::load_from_buffer;
+
+  /**
+   * Writes the loaded tokenizer to a precompiled artifact. Loading it maps the
+   * vocabulary in place and skips sorting it.
+   */
+  Error save(const std::string& artifact_path) const;
+
   Result<std::vector<uint64_t>>
   encode(const std::string& input, int8_t bos, int8_t eos) const override;
 
@@ -37,9 +53,20 @@ class Llama2cTokenizer : public Tokenizer {
     }
     return Error::Ok;
   }
-  std::unique_ptr<char*[]> vocab_ = nullptr;
+  Error _load_artifact(const detail::ArtifactReader& reader);
+
+  // Sorts the vocabulary for lookups, on the first encode, since decoding
+  // does not need it.
+  Error _init_encoder() const;
+
+  // Token strings, zero terminated. They point into vocab_data_ or into the
+  // mapped artifact held by artifact_.
+  std::unique_ptr<const char*[]> vocab_ = nullptr;
+  std::string vocab_data_;
+  std::shared_ptr<const detail::MappedFile> artifact_;
   std::unique_ptr<float[]> vocab_scores_ = nullptr;
-  std::unique_ptr<TokenIndex[]> sorted_vocab_ = nullptr;
+  mutable std::unique_ptr<TokenIndex[]> sorted_vocab_ = nullptr;
+  detail::LazyInit encoder_init_;
   unsigned int max_token_length_ = 0;
   unsigned char byte_pieces_[512]; // stores all single-byte strings
 };
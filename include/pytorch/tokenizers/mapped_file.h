@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TK_HAS_MMAP 1
+#else
+#define TK_HAS_MMAP 0
+#endif
+
+#include <pytorch/tokenizers/result.h>
+
+namespace tokenizers {
+namespace detail {
+
+/**
+ * MappedFile is a read-only view of a whole file.
+ *
+ * On POSIX platforms the file is mapped into memory, so opening it costs one
+ * syscall regardless of size and the pages are shared with the page cache. On
+ * other platforms the contents are read into an owned buffer.
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+
+  MappedFile(MappedFile&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        mapped_(std::exchange(other.mapped_, false)),
+        buffer_(std::move(other.buffer_)) {
+    if (!mapped_) {
+      data_ = buffer_.data();
+    }
+  }
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      reset();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      mapped_ = std::exchange(other.mapped_, false);
+      buffer_ = std::move(other.buffer_);
+      if (!mapped_) {
+        data_ = buffer_.data();
+      }
+    }
+    return *this;
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    reset();
+  }
+
+  /**
+   * Opens and maps the file at the given path.
+   *
+   * @param path The path to the file.
+   * @return The mapped file, or Error::LoadFailure if it cannot be read.
+   */
+  static Result<MappedFile> open(const std::string& path) {
+    MappedFile file;
+#if TK_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    TK_CHECK_OR_RETURN_ERROR(
+        fd >= 0, LoadFailure, "failed to open file: %s", path.c_str());
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      ::close(fd);
+      TK_LOG(Error, "failed to stat regular file: %s", path.c_str());
+      return Error::LoadFailure;
+    }
+
+    file.size_ = static_cast<std::size_t>(st.st_size);
+    if (file.size_ > 0) {
+      void* addr = mmap(nullptr, file.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        TK_LOG(Error, "failed to map file: %s", path.c_str());
+        return Error::LoadFailure;
+      }
+      file.data_ = static_cast<const char*>(addr);
+      file.mapped_ = true;
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+#else
+    std::ifstream stream(path, std::ios::binary);
+    TK_CHECK_OR_RETURN_ERROR(
+        stream, LoadFailure, "failed to open file: %s", path.c_str());
+    file.buffer_.assign(
+        std::istreambuf_iterator<char>(stream),
+        std::istreambuf_iterator<char>());
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+#endif
+    return file;
+  }
+
+  /**
+   * Holds a copy of the given bytes, for data that is already in memory but
+   * must outlive its current owner.
+   */
+  static MappedFile copy_of(std::string_view data) {
+    MappedFile file;
+    file.buffer_.assign(data.data(), data.size());
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+    return file;
+  }
+
+  std::string_view view() const {
+    return data_ ? std::string_view(data_, size_) : std::string_view();
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+ private:
+  void reset() noexcept {
+#if TK_HAS_MMAP
+    if (mapped_ && data_) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+  }
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::string buffer_;
+};
+
+} // namespace detail
+} // namespace tokenizers
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <pytorch/tokenizers/regex.h>
+
+/*
+ * create_regex() uses NativeRegex for the patterns it recognizes. Define
+ * TK_ENABLE_NATIVE_REGEX=0 to always use the regex engines.
+ */
+#ifndef TK_ENABLE_NATIVE_REGEX
+#define TK_ENABLE_NATIVE_REGEX 1
+#endif // !defined(TK_ENABLE_NATIVE_REGEX)
+
+namespace tokenizers {
+
+/**
+ * @brief Hand-written scanners for well-known pre-tokenizer patterns.
+ *
+ * The patterns of the GPT-2, cl100k / Llama 3, o200k, Qwen2 and DeepSeek V3
+ * pre-tokenizers are matched by code that follows their alternations
+ * directly, driven by a table of byte classes, instead of by a regex engine.
+ *
+ * Only ASCII text is scanned natively. Stretches of text with other bytes are
+ * passed to the regex engine that create_regex() would otherwise use, so the
+ * matches are always the same as the engine's. Those stretches are cut at
+ * positions where every pattern is known to end a match, a space that follows
+ * an ASCII letter, so mostly ASCII text stays on the fast path.
+ */
+class NativeRegex : public IRegex {
+ public:
+  enum class Pattern {
+    Gpt2,
+    // Llama 3 and cl100k, as written in tokenizer.json.
+    Cl100k,
+    // The same without the \s+(?!\S) alternative, which RE2 does not support.
+    Cl100kNoLookahead,
+    // Qwen2, which is Cl100k with single digit numbers.
+    Qwen2,
+    O200k,
+    // The main pattern of the DeepSeek V3 pre-tokenizer sequence.
+    DeepSeekV3,
+  };
+
+  explicit NativeRegex() {}
+
+  /**
+   * @brief Returns the well-known pattern that the given regex spells, or
+   * std::nullopt if it has no native scanner.
+   */
+  static std::optional<Pattern> recognize(const std::string& pattern);
+
+  /**
+   * @brief Compile the given regex pattern, which must be recognized.
+   * @param pattern The regex pattern to compile.
+   * @return An Error object indicating success or failure of the compilation.
+   */
+  virtual Error compile(const std::string& pattern) override;
+
+  /**
+   * @brief Return all non-overlapping matches found in the input string.
+   */
+  virtual std::vector<Match> find_all(const std::string& text) const override;
+
+  /**
+   * @brief Return all non-overlapping matches in a reused vector.
+   */
+  virtual void find_all_into(
+      const std::string& text,
+      std::vector<Match>& matches) const override;
+
+  virtual const char* backend_name() const override {
+    return "native";
+  }
+
+ private:
+  // Returns the end of the match at pos in the ASCII text [0, end), or pos if
+  // nothing matches there.
+  using Scanner = std::size_t (*)(const char* text, std::size_t pos,
+                                  std::size_t end);
+
+  Scanner scanner_ = nullptr;
+  // Matches the text that is not ASCII.
+  std::unique_ptr<IRegex> fallback_;
+};
+
+} // namespace tokenizers
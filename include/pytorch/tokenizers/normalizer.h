@@ -132,21 +132,34 @@ class NormalizerConfig {
 class ReplaceNormalizer : public Normalizer {
  public:
   /**
+   * A pattern that only matches a literal string, such as a "String" pattern
+   * escaped by NormalizerConfig, is searched for with memchr rather than
+   * compiled into a regex.
+   *
    * @param pattern: The pattern to search for (can be a string or regex)
    * @param content: The replacement content
    */
   explicit ReplaceNormalizer(
       const std::string& pattern,
       const std::string& content)
-      : regex_(ReplaceNormalizer::create_regex_(pattern)), content_(content) {}
+      : literal_(ReplaceNormalizer::literal_of_(pattern)),
+        regex_(
+            literal_ ? nullptr : ReplaceNormalizer::create_regex_(pattern)),
+        content_(content) {}
 
   /** Normalize with the stored pattern replacement */
   std::string normalize(const std::string& input) const override;
 
  protected:
-  static std::unique_ptr<IRegex> create_regex_(const std::string& pattern);
+  static std::shared_ptr<const IRegex> create_regex_(
+      const std::string& pattern);
+
+  /** The string that the pattern matches, if it has no regex syntax other
+   * than the escapes that IRegex::escape adds */
+  static std::optional<std::string> literal_of_(const std::string& pattern);
 
-  std::unique_ptr<IRegex> regex_;
+  const std::optional<std::string> literal_;
+  std::shared_ptr<const IRegex> regex_;
   const std::string content_;
 
 }; // end class ReplaceNormalizer
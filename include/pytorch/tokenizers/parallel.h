@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+// Helpers to run the independent stages of loading a tokenizer concurrently.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <vector>
+
+#ifndef TK_ENABLE_PARALLEL_LOAD
+#define TK_ENABLE_PARALLEL_LOAD 1
+#endif
+
+#if TK_ENABLE_PARALLEL_LOAD
+#include <thread>
+#endif
+
+#include <pytorch/tokenizers/error.h>
+
+namespace tokenizers {
+namespace detail {
+
+using Task = std::function<Error()>;
+
+/// Upper bound of threads used by load, including the calling thread.
+constexpr std::size_t kMaxLoadThreads = 8;
+
+/**
+ * Returns the number of threads to split a loading stage into, between 1 and
+ * kMaxLoadThreads.
+ */
+inline std::size_t load_concurrency() {
+#if TK_ENABLE_PARALLEL_LOAD
+  const std::size_t cores = std::thread::hardware_concurrency();
+  return std::clamp<std::size_t>(cores, 1, kMaxLoadThreads);
+#else
+  return 1;
+#endif
+}
+
+/**
+ * Runs the tasks, concurrently where enabled, and waits for all of them.
+ *
+ * At most max_workers threads, the calling thread included, take the tasks
+ * in list order from a shared index until none are left.
+ *
+ * Errors are reported deterministically: the result is the error of the first
+ * failing task in list order, no matter which task finished first, which is
+ * also what running the tasks in sequence returns. An exception escaping a
+ * task is rethrown the same way, unless an earlier task failed.
+ *
+ * @param tasks independent tasks, they must not share mutable state
+ * @param max_workers the most threads to run the tasks on
+ * @return Error::Ok if all tasks succeeded
+ */
+inline Error run_tasks(
+    const std::vector<Task>& tasks,
+    std::size_t max_workers = load_concurrency()) {
+  std::vector<Error> errors(tasks.size(), Error::Ok);
+  std::vector<std::exception_ptr> exceptions(tasks.size());
+  const auto run = [&](std::size_t index) {
+    try {
+      errors[index] = tasks[index]();
+    } catch (...) {
+      exceptions[index] = std::current_exception();
+    }
+  };
+
+#if TK_ENABLE_PARALLEL_LOAD
+  const std::size_t workers = std::min(tasks.size(), max_workers);
+  if (workers > 1) {
+    std::atomic<std::size_t> next{0};
+    const auto work = [&]() {
+      for (std::size_t index = next++; index < tasks.size(); index = next++) {
+        run(index);
+      }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t worker = 1; worker < workers; ++worker) {
+      threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  } else
+#endif
+  {
+    for (std::size_t index = 0; index < tasks.size(); ++index) {
+      run(index);
+      if (errors[index] != Error::Ok || exceptions[index]) {
+        break;
+      }
+    }
+  }
+
+  for (std::size_t index = 0; index < tasks.size(); ++index) {
+    if (exceptions[index]) {
+      std::rethrow_exception(exceptions[index]);
+    }
+    if (errors[index] != Error::Ok) {
+      return errors[index];
+    }
+  }
+  return Error::Ok;
+}
+
+/**
+ * Returns how many chunks of at least min_chunk elements to split size
+ * elements into, at most one per load thread.
+ */
+inline std::size_t chunk_count(std::size_t size, std::size_t min_chunk) {
+  const auto chunks = size / std::max<std::size_t>(1, min_chunk);
+  return std::clamp<std::size_t>(chunks, 1, load_concurrency());
+}
+
+/**
+ * Splits [0, size) into the given number of contiguous chunks and runs
+ * body(chunk, begin, end) for each of them with run_tasks(). Chunk indices
+ * follow the order of the ranges, so per-chunk results can be concatenated
+ * in order.
+ */
+inline void for_each_chunk(
+    std::size_t size,
+    std::size_t chunks,
+    const std::function<void(std::size_t, std::size_t, std::size_t)>& body) {
+  std::vector<Task> tasks;
+  tasks.reserve(chunks);
+  for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+    tasks.push_back([&body, chunk, chunks, size]() {
+      body(chunk, size * chunk / chunks, size * (chunk + 1) / chunks);
+      return Error::Ok;
+    });
+  }
+  run_tasks(tasks);
+}
+
+} // namespace detail
+} // namespace tokenizers
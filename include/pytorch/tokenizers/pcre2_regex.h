@@ -21,6 +21,10 @@ namespace tokenizers {
 
 /**
  * @brief PCRE2-based implementation of IRegex.
+ *
+ * Patterns are JIT-compiled when PCRE2 is built with JIT support. Matching
+ * uses match data and a JIT stack that belong to the calling thread, so one
+ * compiled regex can be shared by concurrent callers.
  */
 class Pcre2Regex : public IRegex {
  public:
@@ -29,6 +33,9 @@ class Pcre2Regex : public IRegex {
    */
   explicit Pcre2Regex(){};
 
+  Pcre2Regex(const Pcre2Regex&) = delete;
+  Pcre2Regex& operator=(const Pcre2Regex&) = delete;
+
   /**
    * @brief Compile the given regex pattern.
    * @param pattern The regex pattern to compile.
@@ -46,9 +53,25 @@ class Pcre2Regex : public IRegex {
    */
   virtual std::vector<Match> find_all(const std::string& text) const override;
 
+  /**
+   * @brief Return all non-overlapping matches in a reused vector.
+   */
+  virtual void find_all_into(
+      const std::string& text,
+      std::vector<Match>& matches) const override;
+
+  virtual const char* backend_name() const override {
+    return jit_ ? "pcre2-jit" : "pcre2";
+  }
+
+  /// Whether the pattern runs as JIT-compiled code.
+  bool is_jit() const {
+    return jit_;
+  }
+
  private:
-  pcre2_code* regex_;
-  pcre2_match_data* match_data_;
+  pcre2_code* regex_ = nullptr;
+  bool jit_ = false;
 };
 
 } // namespace tokenizers
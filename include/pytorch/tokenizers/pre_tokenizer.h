@@ -10,9 +10,12 @@
 #pragma once
 
 // Standard
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Third Party
@@ -26,6 +29,102 @@ namespace tokenizers {
 
 // -- Base ---------------------------------------------------------------------
 
+/**
+ * The pieces of a string that is being pre-tokenized, as byte ranges of a
+ * text buffer.
+ *
+ * The text is the input itself until a pre-tokenizer rewrites the content of
+ * the pieces, after which it is a buffer owned by this object. Buffers and
+ * ranges are reused by reset(), so pre-tokenizing many inputs with one object
+ * does not allocate once the buffers are large enough.
+ *
+ * Pre-tokenizers build the next pieces with begin_split() or begin_rewrite(),
+ * add_piece() and commit().
+ */
+class PreTokenizedString {
+ public:
+  PreTokenizedString() = default;
+  explicit PreTokenizedString(const std::string& input) {
+    reset(input);
+  }
+
+  // The text may point into this object.
+  PreTokenizedString(const PreTokenizedString&) = delete;
+  PreTokenizedString& operator=(const PreTokenizedString&) = delete;
+
+  /** Start over with the input as the only piece. The input must outlive the
+   * pieces, or the next call to reset(). */
+  void reset(const std::string& input);
+
+  /** The text that the ranges refer to */
+  const std::string& text() const {
+    return *text_;
+  }
+
+  const std::vector<Match>& ranges() const {
+    return ranges_;
+  }
+
+  std::size_t size() const {
+    return ranges_.size();
+  }
+
+  std::string_view operator[](std::size_t i) const {
+    return std::string_view(*text_).substr(
+        ranges_[i].start, ranges_[i].end - ranges_[i].start);
+  }
+
+  /** Piece i as a string, which is the text itself when the piece covers all
+   * of it, and otherwise a copy in a buffer that the next call reuses. */
+  const std::string& piece_string(std::size_t i);
+
+  /** Copy the pieces into strings of their own */
+  std::vector<std::string> to_strings() const;
+
+  /** Start the next pieces as ranges of the current text */
+  void begin_split();
+
+  /** Start the next pieces as ranges of a new text, which is written to the
+   * returned buffer */
+  std::string& begin_rewrite();
+
+  void add_piece(std::size_t start, std::size_t end) {
+    next_ranges_.push_back({start, end});
+  }
+
+  /** Replace the pieces with the ones added since begin_split() or
+   * begin_rewrite() */
+  void commit();
+
+  /** Bytes allocated for the ranges and rewritten texts, which are kept from
+   * one input to the next */
+  std::size_t capacity_bytes() const;
+
+  /** Drop the pieces, and free the memory kept for them if it is above
+   * max_bytes, so that one long input does not pin it for good */
+  void shrink(std::size_t max_bytes);
+
+ private:
+  const std::string* text_ = &empty_;
+  std::vector<Match> ranges_;
+  std::vector<Match> next_ranges_;
+  // Rewritten texts, and which of them the current and the next pieces refer
+  // to, or -1 for the input.
+  std::string buffers_[2];
+  int current_buffer_ = -1;
+  int next_buffer_ = -1;
+  std::string piece_;
+  std::string empty_;
+}; // end class PreTokenizedString
+
+/**
+ * Scratch space for PreTokenizer::split_range(), reused from call to call
+ */
+struct SplitBuffers {
+  std::string piece;
+  std::vector<Match> matches;
+};
+
 /**
  * Base class for all pre-tokenizers with a single virtual method to split the
  * input string piece
@@ -47,9 +146,88 @@ class PreTokenizer {
   virtual std::vector<std::string> pre_tokenize(
       const std::string& input) const = 0;
 
+  /** Split each of the pieces further, in place
+   *
+   * Pieces that are only split stay ranges of the same text, so a sequence of
+   * pre-tokenizers copies bytes only when one of them rewrites the content.
+   * The default implementation copies every piece through pre_tokenize().
+   */
+  virtual void pre_tokenize_spans(PreTokenizedString& pieces) const;
+
+  /** Receives sub-pieces from split_range() */
+  typedef std::function<void(std::size_t, std::size_t)> RangeCallback;
+
+  /** Whether the pre-tokenizer only splits pieces, without rewriting them,
+   * and implements split_range()
+   *
+   * SequencePreTokenizer streams each piece through consecutive
+   * pre-tokenizers like this one at a time, without storing the pieces in
+   * between.
+   */
+  virtual bool splits_only() const {
+    return false;
+  }
+
+  /** The backends of the regexes that the pre-tokenizer splits with, in
+   * order, as IRegex::backend_name() reports them */
+  virtual std::vector<std::string> regex_backends() const {
+    return {};
+  }
+
+  /** Split the piece text[start, end), calling emit with the start and end of
+   * each sub-piece in text. buffers is not used by any other split in
+   * progress. Only called if splits_only() returns true.
+   *
+   * The default implementation finds the pieces of pre_tokenize() in text,
+   * in order, so it copies each of them once.
+   */
+  virtual void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const;
+
   virtual ~PreTokenizer() = default;
 }; // end class PreTokenizer
 
+/**
+ * Base class for pre-tokenizers that only split pieces, with pre_tokenize()
+ * and pre_tokenize_spans() implemented by split_range()
+ */
+class SplitPreTokenizer : public PreTokenizer {
+ public:
+  std::vector<std::string> pre_tokenize(
+      const std::string& input) const override;
+
+  void pre_tokenize_spans(PreTokenizedString& pieces) const override;
+
+  bool splits_only() const override {
+    return true;
+  }
+}; // end class SplitPreTokenizer
+
+/**
+ * What a split does with the delimiters it finds
+ * CITE:
+ * https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/tokenizer/normalizer.rs#L82
+ */
+enum class SplitDelimiterBehavior {
+  /** Drop the delimiters */
+  Removed,
+  /** Keep each delimiter as a piece of its own */
+  Isolated,
+  /** Append a delimiter to the piece before it */
+  MergedWithPrevious,
+  /** Prepend a delimiter to the piece after it */
+  MergedWithNext,
+  /** Keep each run of delimiters as a piece of its own */
+  Contiguous,
+};
+
+/** Parse the name of a behavior, throwing std::runtime_error if unknown */
+SplitDelimiterBehavior parse_split_delimiter_behavior(const std::string& name);
+
 // -- Factory ------------------------------------------------------------------
 
 // Helper macro to standardize addition of config member fields
@@ -100,17 +278,25 @@ class PreTokenizerConfig {
   CONFIG_MEMBER(bool, individual_digits)
 
   /**
-   * Used by: ByteLevelPreTokenizer
+   * Used by: ByteLevelPreTokenizer, and MetaspacePreTokenizer in configs
+   * that predate prepend_scheme
    */
   CONFIG_MEMBER(bool, add_prefix_space)
 
+  /**
+   * Used by: ByteLevelPreTokenizer - Whether pieces are mapped to the
+   * byte-level alphabet. Not read from json: HFTokenizer clears it when its
+   * vocabulary is keyed by raw bytes.
+   */
+  CONFIG_MEMBER(bool, map_bytes)
+
   /**
    * Used by RegexPreTokenizer
    */
   CONFIG_MEMBER(bool, is_delimiter)
 
   /**
-   * Used by RegexPreTokenizer - Split behavior
+   * Used by RegexPreTokenizer, PunctuationPreTokenizer - Split behavior
    */
   CONFIG_MEMBER(std::string, behavior)
 
@@ -119,6 +305,26 @@ class PreTokenizerConfig {
    */
   CONFIG_MEMBER(bool, invert)
 
+  /**
+   * Used by: CharDelimiterSplitPreTokenizer - The delimiter character
+   */
+  CONFIG_MEMBER(std::string, delimiter)
+
+  /**
+   * Used by: MetaspacePreTokenizer - The character that replaces spaces
+   */
+  CONFIG_MEMBER(std::string, replacement)
+
+  /**
+   * Used by: MetaspacePreTokenizer - "always", "first" or "never"
+   */
+  CONFIG_MEMBER(std::string, prepend_scheme)
+
+  /**
+   * Used by: MetaspacePreTokenizer - Whether to split before replacements
+   */
+  CONFIG_MEMBER(bool, split)
+
   /**
    * Used by: SequencePreTokenizer
    */
@@ -154,7 +360,7 @@ class PreTokenizerConfig {
 //  https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/tokenizer/normalizer.rs#L82
 //  https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/tokenizer/pattern.rs#L128
 
-class RegexPreTokenizer : public PreTokenizer {
+class RegexPreTokenizer : public SplitPreTokenizer {
  public:
   /**
    * @param pattern: The regex pattern to use for token splitting
@@ -191,13 +397,21 @@ class RegexPreTokenizer : public PreTokenizer {
     }
   }
 
-  /** Pre-tokenize with the stored regex */
-  std::vector<std::string> pre_tokenize(const std::string& input) const;
+  /** Split with the stored regex */
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+
+  std::vector<std::string> regex_backends() const override;
 
  protected:
-  static std::unique_ptr<IRegex> create_regex_(const std::string& pattern);
+  static std::shared_ptr<const IRegex> create_regex_(
+      const std::string& pattern);
 
-  std::unique_ptr<IRegex> regex_;
+  std::shared_ptr<const IRegex> regex_;
   const bool is_delimiter_;
   const std::string behavior_;
 
@@ -208,14 +422,199 @@ class RegexPreTokenizer : public PreTokenizer {
 // CITE:
 // https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/digits.rs
 
-class DigitsPreTokenizer : public RegexPreTokenizer {
+class DigitsPreTokenizer : public SplitPreTokenizer {
  public:
+  /**
+   * @param individual_digits: Whether each digit is a piece of its own, or
+   *    runs of digits are kept together
+   */
   explicit DigitsPreTokenizer(bool individual_digits = false)
-      : RegexPreTokenizer(
-            individual_digits ? R"([^\p{N}]+|\p{N})"
-                              : R"([^\p{N}]+|[\p{N}]+)") {}
+      : individual_digits_(individual_digits) {}
+
+  /** Split at the \p{N} characters, which are found with the codepoint
+   * table */
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+
+ private:
+  const bool individual_digits_;
 }; // end class DigitsPreTokenizer
 
+// -- Whitespace ---------------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/whitespace.rs
+
+/**
+ * Splits like the regex \w+|[^\w\s]+, dropping the whitespace. The pieces
+ * are runs of word characters and runs of other non-whitespace characters.
+ */
+class WhitespacePreTokenizer : public SplitPreTokenizer {
+ public:
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+}; // end class WhitespacePreTokenizer
+
+/**
+ * Splits on whitespace, dropping it
+ */
+class WhitespaceSplitPreTokenizer : public SplitPreTokenizer {
+ public:
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+}; // end class WhitespaceSplitPreTokenizer
+
+// -- Punctuation --------------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/punctuation.rs
+
+class PunctuationPreTokenizer : public SplitPreTokenizer {
+ public:
+  /**
+   * @param behavior: What to do with the punctuation characters, one of
+   *    "Removed", "Isolated", "MergedWithPrevious", "MergedWithNext" and
+   *    "Contiguous"
+   */
+  explicit PunctuationPreTokenizer(const std::string& behavior = "Isolated")
+      : behavior_(parse_split_delimiter_behavior(behavior)) {}
+
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+
+ private:
+  const SplitDelimiterBehavior behavior_;
+}; // end class PunctuationPreTokenizer
+
+// -- CharDelimiterSplit -------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/delimiter.rs
+
+class CharDelimiterSplitPreTokenizer : public SplitPreTokenizer {
+ public:
+  /**
+   * @param delimiter: The character to split on, which is dropped. It must be
+   *    a single UTF-8 character, or std::runtime_error is thrown.
+   */
+  explicit CharDelimiterSplitPreTokenizer(const std::string& delimiter);
+
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+
+ private:
+  const uint32_t delimiter_;
+}; // end class CharDelimiterSplitPreTokenizer
+
+// -- UnicodeScripts -----------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/unicode_scripts/pre_tokenizer.rs
+
+/**
+ * Splits where the script changes. Spaces belong to any script, Hiragana and
+ * Katakana count as Han, and spaces before the first character of a script
+ * are dropped.
+ */
+class UnicodeScriptsPreTokenizer : public SplitPreTokenizer {
+ public:
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+}; // end class UnicodeScriptsPreTokenizer
+
+// -- BertPreTokenizer ---------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/bert.rs
+
+/**
+ * Splits on whitespace, dropping it, and isolates each punctuation character
+ */
+class BertPreTokenizer : public SplitPreTokenizer {
+ public:
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+}; // end class BertPreTokenizer
+
+// -- Metaspace ----------------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/pre_tokenizers/metaspace.rs
+
+/**
+ * Which pieces Metaspace prepends the replacement character to, when they do
+ * not start with one already
+ */
+enum class PrependScheme {
+  /** Every piece */
+  Always,
+  /** Only the piece at the start of the text */
+  First,
+  /** No piece */
+  Never,
+};
+
+/** Parse "always", "first" or "never", throwing std::runtime_error
+ * otherwise */
+PrependScheme parse_prepend_scheme(const std::string& name);
+
+class MetaspacePreTokenizer : public PreTokenizer {
+ public:
+  /**
+   * @param replacement: The character that replaces the spaces, U+2581 by
+   *    default. It must be a single UTF-8 character.
+   * @param prepend_scheme: "always", "first" or "never"
+   * @param split: Whether to split the pieces before each replacement
+   *    character
+   */
+  explicit MetaspacePreTokenizer(
+      const std::string& replacement = "\xe2\x96\x81",
+      const std::string& prepend_scheme = "always",
+      bool split = true);
+
+  /** Perform pre-tokenization */
+  std::vector<std::string> pre_tokenize(
+      const std::string& input) const override;
+
+  /** Replace the spaces, prepend the replacement and split, in one pass over
+   * each piece. A piece is at the start of the text if it starts at offset 0,
+   * which is exact unless an earlier pre-tokenizer rewrote the text. */
+  void pre_tokenize_spans(PreTokenizedString& pieces) const override;
+
+ private:
+  const std::string replacement_;
+  const PrependScheme prepend_scheme_;
+  const bool split_;
+}; // end class MetaspacePreTokenizer
+
 // -- ByteLevel ----------------------------------------------------------------
 // Used by tokenizers
 // CITE:
@@ -224,13 +623,20 @@ class DigitsPreTokenizer : public RegexPreTokenizer {
 class ByteLevelPreTokenizer : public PreTokenizer {
  public:
   /**
+   * The pattern is compiled once, through the shared regex cache, and the
+   * bytes of each piece are mapped to their characters with a table.
+   *
    * @param add_prefix_space: Whether to add a leading space to the first word
    * @param pattern: A user-supplied regex to use for token splitting. If not
    *    provided, it use the standard GPT2 pattern.
+   * @param map_bytes: Whether to map the bytes of the pieces to the
+   *    byte-level alphabet, or to leave them as they are for a vocabulary
+   *    keyed by raw bytes.
    */
   ByteLevelPreTokenizer(
       bool add_prefix_space = true,
-      const std::string& pattern = "");
+      const std::string& pattern = "",
+      bool map_bytes = true);
   explicit ByteLevelPreTokenizer(const std::string& pattern)
       : ByteLevelPreTokenizer(true, pattern) {}
 
@@ -238,9 +644,29 @@ class ByteLevelPreTokenizer : public PreTokenizer {
   std::vector<std::string> pre_tokenize(
       const std::string& input) const override;
 
+  void pre_tokenize_spans(PreTokenizedString& pieces) const override;
+
+  /** Without a prefix space or the byte mapping, pieces are only split */
+  bool splits_only() const override {
+    return !map_bytes_ && !add_prefix_space_;
+  }
+
+  void split_range(
+      const std::string& text,
+      std::size_t start,
+      std::size_t end,
+      SplitBuffers& buffers,
+      const RangeCallback& emit) const override;
+
+  std::vector<std::string> regex_backends() const override {
+    return {regex_->backend_name()};
+  }
+
  private:
   const std::string pattern_;
   const bool add_prefix_space_;
+  const bool map_bytes_;
+  std::shared_ptr<const IRegex> regex_;
 
 }; // end class ByteLevelPreTokenizer
 
@@ -260,6 +686,12 @@ class SequencePreTokenizer : public PreTokenizer {
   std::vector<std::string> pre_tokenize(
       const std::string& input) const override;
 
+  /** Run the pre-tokenizers in order. Consecutive ones that only split are
+   * fused: each piece goes through all of them before the next piece. */
+  void pre_tokenize_spans(PreTokenizedString& pieces) const override;
+
+  std::vector<std::string> regex_backends() const override;
+
  private:
   const std::vector<PreTokenizer::Ptr> pre_tokenizers_;
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <pytorch/tokenizers/re2_regex.h>
+#include <pytorch/tokenizers/regex.h>
+
+namespace tokenizers {
+
+/**
+ * @brief RE2-based IRegex for patterns that end in the \s+(?!\S) idiom.
+ *
+ * Pre-tokenizer patterns like GPT-2's end in \s+(?!\S)|\s+, so that a run of
+ * whitespace leaves its last character to the word that follows it. RE2 has
+ * no lookahead, so the pattern is matched as P|\s+, where P is everything
+ * before the idiom, and a whitespace match that P does not account for is
+ * shortened by one character when it is followed by other text. The
+ * \s+(?!\S) alternative may also come last on its own, in which case a single
+ * whitespace character followed by other text does not match.
+ *
+ * The pattern is otherwise read with the meaning PCRE2 gives it, which is
+ * what patterns with lookahead used before: \s and \d are the Unicode
+ * classes. Patterns that use any other lookaround, or syntax that RE2 reads
+ * differently such as \w, \b, \v or $, fail to compile.
+ *
+ * Both regexes are Re2Regex objects, so Re2Regex::Options such as per_thread
+ * and max_mem apply to them as to any other RE2 regex.
+ */
+class Re2LookaheadRegex : public IRegex {
+ public:
+  /**
+   * @brief Construct with the default options of Re2Regex.
+   */
+  explicit Re2LookaheadRegex()
+      : Re2LookaheadRegex(Re2Regex::default_options()) {}
+
+  /**
+   * @brief Construct with the given options for the RE2 regexes.
+   */
+  explicit Re2LookaheadRegex(const Re2Regex::Options& options)
+      : options_(options) {}
+
+  /**
+   * @brief Compile the given regex pattern.
+   * @param pattern The regex pattern to compile.
+   * @return An Error object indicating success or failure of the compilation.
+   */
+  virtual Error compile(const std::string& pattern) override;
+
+  /**
+   * @brief Return all non-overlapping matches found in the input string.
+   */
+  virtual std::vector<Match> find_all(const std::string& text) const override;
+
+  /**
+   * @brief Return all non-overlapping matches in a reused vector.
+   */
+  virtual void find_all_into(
+      const std::string& text,
+      std::vector<Match>& matches) const override;
+
+  virtual const char* backend_name() const override {
+    return "re2-lookahead";
+  }
+
+  /**
+   * @brief Returns the pattern with the PCRE2 meaning of \s, \S, \d and \D
+   * spelled out for RE2, or std::nullopt if it uses syntax that the two
+   * read differently.
+   */
+  static std::optional<std::string> translate(const std::string& pattern);
+
+ private:
+  Re2Regex::Options options_;
+  // P|\s+, translated.
+  std::unique_ptr<Re2Regex> regex_;
+  // P on its own, or nullptr if the pattern is only the idiom.
+  std::unique_ptr<Re2Regex> prefix_;
+  // Whether \s+ follows \s+(?!\S) as the last alternative.
+  bool whitespace_fallback_ = false;
+};
+
+} // namespace tokenizers
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -19,13 +22,43 @@ namespace tokenizers {
 
 /**
  * @brief RE2-based implementation of IRegex.
+ *
+ * RE2 is thread-safe, but the DFA states it builds while matching are cached
+ * in the RE2 object behind a lock, so threads that share one object contend
+ * on that lock and evict each other's states. With Options::per_thread set,
+ * each thread matches with its own copy of the compiled regex instead.
  */
 class Re2Regex : public IRegex {
  public:
+  struct Options {
+    /// Memory budget of each compiled copy in bytes, most of which goes to
+    /// the DFA cache, or 0 for RE2's default of 8 MiB.
+    int64_t max_mem = 0;
+    /// Whether each thread matches with its own copy of the regex.
+    bool per_thread = false;
+    /// Upper bound of copies when per_thread is set, or 0 for one per
+    /// hardware thread. Threads are given copies in turn, so only threads
+    /// beyond this bound share one.
+    std::size_t max_copies = 0;
+    /// Whether a pattern that RE2 rejects is logged as an error, rather than
+    /// only reported by compile() to a caller with another backend to try.
+    bool log_errors = true;
+  };
+
+  /**
+   * @brief Construct a RE2 regex with the default options.
+   */
+  explicit Re2Regex() : Re2Regex(default_options()) {}
+
   /**
-   * @brief Construct a RE2 regex.
+   * @brief Construct a RE2 regex with the given options.
    */
-  explicit Re2Regex() {}
+  explicit Re2Regex(const Options& options) : options_(options) {}
+
+  ~Re2Regex() override;
+
+  Re2Regex(const Re2Regex&) = delete;
+  Re2Regex& operator=(const Re2Regex&) = delete;
 
   /**
    * @brief compile the given regex pattern.
@@ -39,8 +72,41 @@ class Re2Regex : public IRegex {
    */
   virtual std::vector<Match> find_all(const std::string& text) const override;
 
+  /**
+   * @brief Return all non-overlapping matches in a reused vector.
+   */
+  virtual void find_all_into(
+      const std::string& text,
+      std::vector<Match>& matches) const override;
+
+  virtual const char* backend_name() const override {
+    return "re2";
+  }
+
+  /**
+   * @brief Set the options of the Re2Regex objects that are constructed
+   * without any, including the ones create_regex() makes.
+   */
+  static void set_default_options(const Options& options);
+
+  static Options default_options();
+
+  /**
+   * @brief Return the compiled regex that the calling thread matches with,
+   * which is a copy of its own with Options::per_thread. Must only be called
+   * after compile() succeeded.
+   */
+  const re2::RE2& thread_regex() const;
+
  private:
+  // Frees the per-thread copies.
+  void clear_copies();
+
+  Options options_;
   std::unique_ptr<re2::RE2> regex_;
+  // Per-thread copies, compiled when a thread first needs one.
+  std::unique_ptr<std::atomic<re2::RE2*>[]> copies_;
+  std::size_t copy_count_ = 0;
 };
 
 } // namespace tokenizers
@@ -43,6 +43,26 @@ class IRegex {
    */
   virtual std::vector<Match> find_all(const std::string& text) const = 0;
 
+  /**
+   * @brief Find all non-overlapping matches in the input string, replacing
+   * the contents of matches. Reusing the vector across calls saves allocating
+   * a new one for every input.
+   *
+   * @param text The input string to search.
+   * @param matches Receives the matches in order.
+   */
+  virtual void find_all_into(
+      const std::string& text,
+      std::vector<Match>& matches) const;
+
+  /**
+   * @brief Name of the engine that matches the pattern, for logging and
+   * inspecting the backend that create_regex() picked.
+   */
+  virtual const char* backend_name() const {
+    return "custom";
+  }
+
   /**
    * @brief Escape special regex characters in a string to treat it as literal.
    *
@@ -65,6 +85,50 @@ using FallbackRegexFn = Result<std::unique_ptr<IRegex>> (*)(const std::string&);
  */
 Result<std::unique_ptr<IRegex>> create_regex(const std::string& pattern);
 
+/**
+ * @brief Makes create_regex() pick the fastest backend for each pattern
+ * instead of the first one that compiles, as create_fastest_regex() does.
+ *
+ * This multiplies the time it takes to create a regex, so it is off by
+ * default. Enable it before loading tokenizers.
+ *
+ * @param enabled Whether to benchmark the backends.
+ * @param sample The text to time them on, or empty for a built-in sample.
+ */
+void set_regex_benchmarking(bool enabled, const std::string& sample = "");
+
+/**
+ * @brief Creates the regex backend that matches the sample text fastest.
+ *
+ * Every backend that compiles the pattern is timed on the sample. Backends
+ * whose matches on it differ from those of the default choice of
+ * create_regex() are skipped. The pick is logged, and backend_name() tells
+ * which one it is.
+ *
+ * @param pattern The regex pattern to compile.
+ * @param sample The text to time the backends on, or empty for a built-in
+ * sample of mostly ASCII prose and code with some non-ASCII text.
+ */
+Result<std::unique_ptr<IRegex>> create_fastest_regex(
+    const std::string& pattern,
+    const std::string& sample = "");
+
+/**
+ * @brief Returns the regex for a pattern from a process-wide cache, creating
+ * it with create_regex() on first use.
+ *
+ * Holders of the same pattern share one compiled regex, which is released
+ * with its last holder, so tokenizers that split with the same pattern
+ * compile it once and hold one copy of its programs. Regexes created with
+ * another fallback, benchmarking setting or default Re2Regex options are not
+ * shared.
+ *
+ * @param pattern The regex pattern to compile.
+ * @return A shared pointer to an IRegex-compatible object.
+ */
+Result<std::shared_ptr<const IRegex>> get_shared_regex(
+    const std::string& pattern);
+
 bool register_override_fallback_regex(FallbackRegexFn fn);
 
 FallbackRegexFn get_fallback_regex();
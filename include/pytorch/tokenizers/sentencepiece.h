@@ -23,6 +23,12 @@ class SPTokenizer : public Tokenizer {
 
   Error load(const std::string& tokenizer_path) override;
 
+  /**
+   * Loads a serialized sentencepiece model proto held in memory.
+   */
+  Error load_from_buffer(std::string_view data) override;
+  using Tokenizer::load_from_buffer;
+
   Result<std::vector<uint64_t>>
   encode(const std::string& input, int8_t bos, int8_t eos) const override;
 
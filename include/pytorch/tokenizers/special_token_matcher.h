@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#pragma once
+
+// Standard
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tokenizers {
+namespace detail {
+
+/**
+ * SpecialTokenMatcher finds special tokens in text in a single forward pass.
+ *
+ * The tokens are stored in a byte trie. Positions that may start a token are
+ * found with a prefilter on the first byte of the tokens, which uses memchr
+ * when the tokens share their first byte and a SIMD nibble lookup otherwise,
+ * so text without special tokens is skipped at memory speed. Each candidate
+ * is then verified by walking the trie.
+ *
+ * Matches are leftmost-longest: the match starting first wins, and of the
+ * tokens starting there the longest one.
+ */
+class SpecialTokenMatcher {
+ public:
+  struct Match {
+    std::size_t start;
+    std::size_t end;
+    uint64_t id;
+  };
+
+  SpecialTokenMatcher() = default;
+
+  /**
+   * @param tokens special tokens and their ids, empty tokens are ignored
+   */
+  explicit SpecialTokenMatcher(
+      const std::vector<std::pair<std::string_view, uint64_t>>& tokens);
+
+  /// Whether there are no tokens, in which case nothing ever matches.
+  bool empty() const {
+    return nodes_.size() <= 1;
+  }
+
+  /**
+   * Returns the leftmost-longest token in text that starts at or after the
+   * given offset, or std::nullopt if there is none.
+   */
+  std::optional<Match> find(std::string_view text, std::size_t offset = 0)
+      const {
+    return find_if(text, offset, [](uint64_t) { return true; });
+  }
+
+  /**
+   * Like find(), but only tokens whose id satisfies accept(id) match, as if
+   * the matcher held those tokens alone. A rejected token does not hide the
+   * accepted ones that overlap it.
+   */
+  template <typename Accept>
+  std::optional<Match>
+  find_if(std::string_view text, std::size_t offset, const Accept& accept)
+      const {
+    if (empty()) {
+      return std::nullopt;
+    }
+    while (offset < text.size()) {
+      offset = next_candidate(text, offset);
+      if (offset == text.size()) {
+        break;
+      }
+      if (auto match = match_at(text, offset, accept)) {
+        return match;
+      }
+      ++offset;
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * Makes every matcher use the scalar prefilter even where SIMD is
+   * available, so that tests can cover it. Returns the previous setting.
+   */
+  static bool force_scalar_prefilter(bool force);
+
+ private:
+  struct Node {
+    uint32_t edges_begin = 0;
+    uint32_t edges_end = 0;
+    std::optional<uint64_t> id;
+  };
+
+  // Returns the first position at or after offset whose byte starts a token,
+  // or text.size().
+  std::size_t next_candidate(std::string_view text, std::size_t offset) const;
+
+  // Returns the longest accepted token starting at the given position.
+  template <typename Accept>
+  std::optional<Match>
+  match_at(std::string_view text, std::size_t start, const Accept& accept)
+      const {
+    std::optional<Match> match;
+    uint32_t node = root_children_[static_cast<uint8_t>(text[start])];
+    std::size_t pos = start + 1;
+    while (node != 0) {
+      if (nodes_[node].id && accept(*nodes_[node].id)) {
+        match = Match{start, pos, *nodes_[node].id};
+      }
+      if (pos == text.size()) {
+        break;
+      }
+      const auto begin = edge_bytes_.begin() + nodes_[node].edges_begin;
+      const auto end = edge_bytes_.begin() + nodes_[node].edges_end;
+      const auto byte = static_cast<uint8_t>(text[pos]);
+      const auto it = std::lower_bound(begin, end, byte);
+      if (it == end || *it != byte) {
+        break;
+      }
+      node = edge_targets_[it - edge_bytes_.begin()];
+      ++pos;
+    }
+    return match;
+  }
+
+  // Node 0 is the root. The children of a node are the edges in
+  // [edges_begin, edges_end), sorted by byte.
+  std::vector<Node> nodes_;
+  std::vector<uint8_t> edge_bytes_;
+  std::vector<uint32_t> edge_targets_;
+
+  // The children of the root, indexed by byte, 0 if there is none.
+  std::array<uint32_t, 256> root_children_{};
+
+  // Prefilter state. A byte b may start a token if
+  // (low_nibbles_[b & 0xf] & high_nibbles_[b >> 4]) != 0, which can also hold
+  // for some bytes that do not; the trie walk rejects those.
+  std::vector<uint8_t> first_bytes_;
+  std::array<uint8_t, 16> low_nibbles_{};
+  std::array<uint8_t, 16> high_nibbles_{};
+};
+
+} // namespace detail
+} // namespace tokenizers
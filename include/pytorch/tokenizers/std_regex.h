@@ -37,6 +37,10 @@ class StdRegex : public IRegex {
    */
   virtual std::vector<Match> find_all(const std::string& text) const override;
 
+  virtual const char* backend_name() const override {
+    return "std::regex";
+  }
+
  private:
   std::regex regex_;
 };
@@ -25,6 +25,74 @@
 namespace tokenizers {
 namespace detail {
 
+/**
+ * Byte storage for StringIntegerMap. The bytes are either owned, while the map
+ * is being built, or viewed in place in memory kept alive by an owner, such as
+ * a memory mapped tokenizer artifact.
+ */
+template <typename TAllocator>
+class StringIntegerMapBuffer {
+ public:
+  StringIntegerMapBuffer() = default;
+
+  StringIntegerMapBuffer(const StringIntegerMapBuffer& other)
+      : owned_(other.owned_),
+        owner_(other.owner_),
+        data_(other.viewed_ ? other.data_ : owned_.data()),
+        size_(other.size_),
+        viewed_(other.viewed_) {}
+
+  StringIntegerMapBuffer(StringIntegerMapBuffer&& other) noexcept
+      : owned_(std::move(other.owned_)),
+        owner_(std::move(other.owner_)),
+        data_(other.viewed_ ? other.data_ : owned_.data()),
+        size_(other.size_),
+        viewed_(other.viewed_) {}
+
+  StringIntegerMapBuffer& operator=(const StringIntegerMapBuffer&) = delete;
+  StringIntegerMapBuffer& operator=(StringIntegerMapBuffer&&) = delete;
+
+  void resize(std::size_t size) {
+    owned_.resize(size);
+    owner_.reset();
+    data_ = owned_.data();
+    size_ = size;
+    viewed_ = false;
+  }
+
+  void view(
+      const std::uint8_t* data,
+      std::size_t size,
+      std::shared_ptr<const void> owner) {
+    owned_.clear();
+    owner_ = std::move(owner);
+    data_ = data;
+    size_ = size;
+    viewed_ = true;
+  }
+
+  /// Mutable access, only valid while the buffer is owned.
+  std::uint8_t* data() {
+    assert(!viewed_);
+    return owned_.data();
+  }
+
+  const std::uint8_t* data() const {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+ private:
+  std::vector<std::uint8_t, TAllocator> owned_;
+  std::shared_ptr<const void> owner_;
+  const std::uint8_t* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool viewed_ = false;
+};
+
 /**
  * StringIntegerMap is an immutable bidirectional map between strings and 64 bit
  * unsigned integers. The element data is stored in a contiguous array and is
@@ -102,8 +170,42 @@ class StringIntegerMap {
       std::size_t index) const;
 
   /// @}
+  /// @name Serialization
+  /// @{
+
+  /**
+   * Appends the binary representation of the map to the given string. The map
+   * can be restored from it with view() without being rebuilt.
+   * @param output string to append to
+   */
+  void serialize(std::string& output) const;
+
+  /**
+   * Restores a map written by serialize(), using the bytes in place. If the
+   * bytes were written with different hash functions, for example by a build
+   * using another standard library, the map is rebuilt from its elements
+   * instead.
+   * @param data bytes written by serialize()
+   * @param owner keeps data alive for as long as the map or a copy of it
+   * @return the map, or std::nullopt if the data is malformed
+   */
+  static std::optional<StringIntegerMap> view(
+      std::string_view data,
+      std::shared_ptr<const void> owner,
+      TStringHash string_hasher = TStringHash(),
+      TIntegerHash integer_hasher = TIntegerHash());
+
+  /// @}
 
  private:
+  StringIntegerMap(TStringHash string_hasher, TIntegerHash integer_hasher)
+      : string_hasher_(string_hasher), integer_hasher_(integer_hasher) {}
+
+  /// Fingerprints of the hash functions, used to detect serialized maps that
+  /// were bucketed with different hash functions.
+  std::uint64_t getStringHashFingerprint() const;
+  std::uint64_t getIntegerHashFingerprint() const;
+
   template <typename TLogical>
   class VariableSizedInteger {
    public:
@@ -118,6 +220,17 @@ class StringIntegerMap {
       mask_ = (TLogical(1) << (byte_count_ * 8)) - TLogical(1);
     }
 
+    static std::optional<VariableSizedInteger> fromByteCount(
+        std::size_t byte_count) {
+      if (byte_count >= sizeof(TLogical)) {
+        return std::nullopt;
+      }
+      VariableSizedInteger result;
+      result.byte_count_ = byte_count;
+      result.mask_ = (TLogical(1) << (byte_count * 8)) - TLogical(1);
+      return result;
+    }
+
     std::size_t getByteCount() const {
       return byte_count_;
     }
@@ -152,6 +265,10 @@ class StringIntegerMap {
 
   static std::uint8_t getSmallHash(std::size_t hash);
 
+  /// Checks that the buckets and elements of a viewed map stay within its
+  /// buffers, so that lookups on malformed data cannot read out of bounds.
+  bool isWellFormed() const;
+
   /// Get the string data and string small hash stored in the element buffer at
   /// the The hasher used for strings.
   const TStringHash string_hasher_ = {};
@@ -160,7 +277,7 @@ class StringIntegerMap {
   const TIntegerHash integer_hasher_ = {};
 
   /// String bucket references.
-  std::vector<std::uint8_t, TAllocator> integer_bucket_data_;
+  StringIntegerMapBuffer<TAllocator> integer_bucket_data_;
 
   /// Integer bucket elements.
   /// Laid out as:
@@ -169,10 +286,10 @@ class StringIntegerMap {
   ///   std::size_t string_size; - Physically using string_size_ bytes
   ///   std::size_t string_offset; - Physically using string_offset_ bytes
   /// }
-  std::vector<std::uint8_t, TAllocator> integer_element_data_;
+  StringIntegerMapBuffer<TAllocator> integer_element_data_;
 
   /// String bucket references.
-  std::vector<std::uint8_t, TAllocator> string_bucket_data_;
+  StringIntegerMapBuffer<TAllocator> string_bucket_data_;
 
   /// String bucket elements.
   /// Laid out as:
@@ -182,7 +299,7 @@ class StringIntegerMap {
   ///   std::uint8_t small_hash; - Using std::uint8_t bytes.
   ///   char string[string_size]; - String data, not zero terminated.
   /// }
-  std::vector<std::uint8_t, TAllocator> string_element_data_;
+  StringIntegerMapBuffer<TAllocator> string_element_data_;
 
   /// Number of hash buckets to use.
   std::size_t bucket_count_ = 0;
@@ -563,16 +680,16 @@ StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::getElement(
   const auto string_size_size = string_size_.getByteCount();
   const auto element_size =
       integer_size + string_offset_size + string_size_size;
-  const auto* element_data = &integer_element_data_[index * element_size];
+  const auto* element_data =
+      integer_element_data_.data() + (index * element_size);
 
   const auto integer = integer_.read(element_data);
   element_data += integer_size;
   const auto string_size = string_size_.read(element_data);
   element_data += string_size_size;
   const auto string_offset = string_offset_.read(element_data);
-  const auto* string_data =
-      &string_element_data_
-          [string_offset + integer_size + string_size_size + 1];
+  const auto* string_data = string_element_data_.data() + string_offset +
+      integer_size + string_size_size + 1;
 
   return std::make_pair(
       std::string_view(reinterpret_cast<const char*>(string_data), string_size),
@@ -601,6 +718,236 @@ StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::getSmallHash(
   return static_cast<std::uint8_t>(hash >> shift);
 }
 
+template <typename TStringHash, typename TIntegerHash, typename TAllocator>
+bool StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::isWellFormed()
+    const {
+  const auto offset_size = element_offset_.getByteCount();
+  const auto integer_size = integer_.getByteCount();
+  const auto string_size_size = string_size_.getByteCount();
+  const auto string_header_size = integer_size + string_size_size + 1;
+  const auto integer_element_size =
+      integer_size + string_offset_.getByteCount() + string_size_size;
+  // Both element buffers end in padding for the unaligned reads.
+  const auto string_data_size =
+      string_element_data_.size() - sizeof(std::uint64_t);
+  const auto integer_data_size =
+      integer_element_data_.size() - sizeof(std::uint64_t);
+
+  //
+  // Walk the string elements in order. Each must fit in the buffer, and the
+  // string buckets, terminal one included, must start on element boundaries
+  // in order.
+  //
+
+  const auto* string_elements = string_element_data_.data();
+  std::size_t bucket_idx = 0;
+  std::size_t offset = 0;
+  for (std::size_t index = 0;; ++index) {
+    while (bucket_idx <= bucket_count_ &&
+           element_offset_.read(
+               string_bucket_data_.data() + (bucket_idx * offset_size)) ==
+               offset) {
+      ++bucket_idx;
+    }
+    if (index == size_) {
+      break;
+    }
+    if (string_data_size - offset < string_header_size) {
+      return false;
+    }
+    const auto length =
+        string_size_.read(string_elements + offset + integer_size);
+    if (length > string_data_size - offset - string_header_size) {
+      return false;
+    }
+    offset += string_header_size + length;
+  }
+  if (bucket_idx != bucket_count_ + 1 || offset != string_data_size) {
+    return false;
+  }
+
+  //
+  // The integer elements have a fixed size, so their buckets only need to be
+  // ordered multiples of it. Each must refer to a whole string element.
+  //
+
+  std::size_t previous = 0;
+  for (bucket_idx = 0; bucket_idx <= bucket_count_; ++bucket_idx) {
+    const auto bucket_offset = element_offset_.read(
+        integer_bucket_data_.data() + (bucket_idx * offset_size));
+    if (bucket_offset < previous || bucket_offset > integer_data_size ||
+        (integer_element_size != 0 &&
+         bucket_offset % integer_element_size != 0)) {
+      return false;
+    }
+    previous = bucket_offset;
+  }
+  if (previous != integer_data_size) {
+    return false;
+  }
+
+  const auto* integer_element = integer_element_data_.data();
+  for (std::size_t index = 0; index < size_; ++index) {
+    const auto length = string_size_.read(integer_element + integer_size);
+    const auto string_offset =
+        string_offset_.read(integer_element + integer_size + string_size_size);
+    if (string_offset > string_data_size ||
+        string_data_size - string_offset < string_header_size ||
+        length > string_data_size - string_offset - string_header_size) {
+      return false;
+    }
+    integer_element += integer_element_size;
+  }
+  return true;
+}
+
+template <typename TStringHash, typename TIntegerHash, typename TAllocator>
+std::uint64_t StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::
+    getStringHashFingerprint() const {
+  std::uint64_t fingerprint = 0;
+  for (const std::string_view probe :
+       {"", "a", "tokenizers", "\xe2\x96\x81"}) {
+    fingerprint = (fingerprint * 31) ^ string_hasher_(probe);
+  }
+  return fingerprint;
+}
+
+template <typename TStringHash, typename TIntegerHash, typename TAllocator>
+std::uint64_t StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::
+    getIntegerHashFingerprint() const {
+  std::uint64_t fingerprint = 0;
+  for (const std::uint64_t probe :
+       {std::uint64_t(0),
+        std::uint64_t(1),
+        std::uint64_t(0x9e3779b97f4a7c15)}) {
+    fingerprint = (fingerprint * 31) ^ integer_hasher_(probe);
+  }
+  return fingerprint;
+}
+
+//
+// Serialized layout, all integers are 64 bit in host byte order:
+//   string hash fingerprint, integer hash fingerprint,
+//   bucket count, size,
+//   element offset, string offset, string size and integer byte counts,
+//   sizes of the four buffers,
+// followed by the integer buckets, integer elements, string buckets and
+// string elements, each padded to 8 bytes.
+//
+
+template <typename TStringHash, typename TIntegerHash, typename TAllocator>
+void StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::serialize(
+    std::string& output) const {
+  const StringIntegerMapBuffer<TAllocator>* buffers[] = {
+      &integer_bucket_data_,
+      &integer_element_data_,
+      &string_bucket_data_,
+      &string_element_data_};
+  const std::uint64_t header[] = {
+      getStringHashFingerprint(),
+      getIntegerHashFingerprint(),
+      bucket_count_,
+      size_,
+      element_offset_.getByteCount(),
+      string_offset_.getByteCount(),
+      string_size_.getByteCount(),
+      integer_.getByteCount(),
+      buffers[0]->size(),
+      buffers[1]->size(),
+      buffers[2]->size(),
+      buffers[3]->size()};
+  output.append(reinterpret_cast<const char*>(header), sizeof(header));
+  for (const auto* buffer : buffers) {
+    output.append(
+        reinterpret_cast<const char*>(buffer->data()), buffer->size());
+    output.append((8 - (buffer->size() % 8)) % 8, '\0');
+  }
+}
+
+template <typename TStringHash, typename TIntegerHash, typename TAllocator>
+std::optional<StringIntegerMap<TStringHash, TIntegerHash, TAllocator>>
+StringIntegerMap<TStringHash, TIntegerHash, TAllocator>::view(
+    std::string_view data,
+    std::shared_ptr<const void> owner,
+    TStringHash string_hasher,
+    TIntegerHash integer_hasher) {
+  std::uint64_t header[12];
+  if (data.size() < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(header, data.data(), sizeof(header));
+  data.remove_prefix(sizeof(header));
+
+  StringIntegerMap map(string_hasher, integer_hasher);
+  map.bucket_count_ = header[2];
+  map.size_ = header[3];
+  const auto element_offset =
+      VariableSizedInteger<std::size_t>::fromByteCount(header[4]);
+  const auto string_offset =
+      VariableSizedInteger<std::size_t>::fromByteCount(header[5]);
+  const auto string_size =
+      VariableSizedInteger<std::size_t>::fromByteCount(header[6]);
+  const auto integer =
+      VariableSizedInteger<std::uint64_t>::fromByteCount(header[7]);
+  // Every element takes at least one byte, which also bounds the sizes below.
+  if (!element_offset || !string_offset || !string_size || !integer ||
+      map.bucket_count_ != map.size_ || map.size_ > data.size()) {
+    return std::nullopt;
+  }
+  map.element_offset_ = *element_offset;
+  map.string_offset_ = *string_offset;
+  map.string_size_ = *string_size;
+  map.integer_ = *integer;
+
+  // Check the buffer sizes against the layout the constructor produces. The
+  // contents are checked once the buffers are in place.
+  const auto bucket_data_size =
+      ((map.bucket_count_ + 1) * map.element_offset_.getByteCount()) +
+      sizeof(std::uint64_t);
+  const auto integer_element_data_size = (integer->getByteCount() +
+                                          string_offset->getByteCount() +
+                                          string_size->getByteCount()) *
+          map.size_ +
+      sizeof(std::uint64_t);
+  if (header[8] != bucket_data_size || header[9] != integer_element_data_size ||
+      header[10] != bucket_data_size || header[11] < sizeof(std::uint64_t)) {
+    return std::nullopt;
+  }
+
+  StringIntegerMapBuffer<TAllocator>* buffers[] = {
+      &map.integer_bucket_data_,
+      &map.integer_element_data_,
+      &map.string_bucket_data_,
+      &map.string_element_data_};
+  for (std::size_t i = 0; i < 4; ++i) {
+    const auto size = header[8 + i];
+    const auto padded_size = size + ((8 - (size % 8)) % 8);
+    if (data.size() < padded_size) {
+      return std::nullopt;
+    }
+    buffers[i]->view(
+        reinterpret_cast<const std::uint8_t*>(data.data()), size, owner);
+    data.remove_prefix(padded_size);
+  }
+  if (!map.isWellFormed()) {
+    return std::nullopt;
+  }
+
+  if (header[0] != map.getStringHashFingerprint() ||
+      header[1] != map.getIntegerHashFingerprint()) {
+    // The buckets were laid out with different hash functions; walk the
+    // elements, which do not depend on them, and rebuild.
+    std::vector<std::pair<std::string_view, std::uint64_t>> elements;
+    elements.reserve(map.size());
+    for (std::size_t index = 0; index < map.size(); ++index) {
+      elements.push_back(map.getElement(index));
+    }
+    return StringIntegerMap(elements, string_hasher, integer_hasher);
+  }
+
+  return map;
+}
+
 template <
     typename TStringHash = std::hash<std::string_view>,
     typename TIntegerHash = std::hash<std::uint64_t>,
@@ -83,8 +83,31 @@ class Tiktoken : public detail::BPETokenizerBase {
         _bos_token_index(kBOSTokenIndex),
         _eos_token_index(kEOSTokenIndex){};
 
+  /**
+   * Loads a tiktoken model file, or an artifact written by save().
+   */
   Error load(const std::string& tokenizer_path) override;
 
+  /**
+   * Loads a tiktoken model, or an artifact written by save(), held in memory.
+   * The model is decoded in place.
+   */
+  Error load_from_buffer(std::string_view data) override;
+  using Tokenizer::load_from_buffer;
+
+  /**
+   * Writes the loaded tokenizer to a precompiled artifact. Loading the
+   * artifact maps the token maps in place instead of decoding the model.
+   */
+  Error save(const std::string& artifact_path) const;
+
+  std::vector<std::string> regex_backends() const override {
+    if (!_regex) {
+      return {};
+    }
+    return {_regex->backend_name()};
+  }
+
  private:
   static inline std::unique_ptr<std::vector<std::string>>
   _get_default_special_tokens() {
@@ -112,8 +135,7 @@ class Tiktoken : public detail::BPETokenizerBase {
   }
 
   static inline std::string _get_default_patern() {
-    // Removed negative lookahead \s+(?!\S) since it's not supported by RE2.
-    return R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+)";
+    return R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)";
   }
 
   Error _encode(
@@ -125,12 +147,15 @@ class Tiktoken : public detail::BPETokenizerBase {
 
   detail::TokenMap _build_special_token_map(ssize_t num_base_tokens) const;
 
+  Error _load_artifact(const detail::ArtifactReader& reader);
+
   std::string _pattern;
   std::unique_ptr<std::vector<std::string>> _special_tokens;
   size_t _bos_token_index;
   size_t _eos_token_index;
 
-  std::unique_ptr<IRegex> _regex;
+  // Compiled by load().
+  std::shared_ptr<const IRegex> _regex;
 };
 
 } // namespace tokenizers
@@ -47,6 +47,19 @@ class TokenDecoder {
    */
   virtual std::string decode(const std::string& token) const = 0;
 
+  /** Decode the token at the start of the text
+   *
+   * Decoders that treat the start of the text differently, like Metaspace,
+   * override this. The default implementation is decode().
+   *
+   * @param token: The pre-decoding token string
+   *
+   * @returns decoded: The decoded token string
+   */
+  virtual std::string decode_first(const std::string& token) const {
+    return decode(token);
+  }
+
   // virtual destructor
   virtual ~TokenDecoder() = default;
 
@@ -69,6 +82,10 @@ class TokenDecoderConfig {
   std::string replace_pattern;
   std::string replace_content;
 
+  // Parameters for Metaspace decoder. The replacement is U+2581.
+  std::string metaspace_replacement = "\xe2\x96\x81";
+  std::string metaspace_prepend_scheme = "always";
+
   // Parameters for Sequence decoder
   std::vector<nlohmann::json> sequence_decoders;
 
@@ -136,6 +153,33 @@ class FuseTokenDecoder : public TokenDecoder {
 
 }; // end class FuseTokenDecoder
 
+// -- Metaspace ----------------------------------------------------------------
+// Used by tokenizers
+// CITE:
+// https://github.com/huggingface/tokenizers/blob/main/tokenizers/src/decoders/mod.rs
+
+class MetaspaceTokenDecoder : public TokenDecoder {
+ public:
+  /**
+   * @param replacement: The character that replaced the spaces
+   * @param prepend_scheme: The scheme of the pre-tokenizer. Unless it is
+   *    "never", the replacement characters of the first token are dropped
+   *    instead of turned back into spaces.
+   */
+  explicit MetaspaceTokenDecoder(
+      const std::string& replacement = "\xe2\x96\x81",
+      const std::string& prepend_scheme = "always");
+
+  /** Turn each replacement character back into a space */
+  std::string decode(const std::string& token) const override;
+
+  std::string decode_first(const std::string& token) const override;
+
+ private:
+  const std::string replacement_;
+  const bool strip_first_;
+}; // end class MetaspaceTokenDecoder
+
 // -- Sequence -----------------------------------------------------------------
 // Applies a sequence of decoders in order
 
@@ -143,6 +187,7 @@ class SequenceTokenDecoder : public TokenDecoder {
  public:
   explicit SequenceTokenDecoder(std::vector<TokenDecoder::Ptr> decoders);
   std::string decode(const std::string& token) const override;
+  std::string decode_first(const std::string& token) const override;
 
  private:
   std::vector<TokenDecoder::Ptr> decoders_;
@@ -16,8 +16,17 @@
 #include <pytorch/tokenizers/error.h>
 #include <pytorch/tokenizers/result.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#if __has_include(<version>)
+#include <version>
+#endif
+#ifdef __cpp_lib_span
+#include <cstddef>
+#include <span>
+#endif
+
 namespace tokenizers {
 
 struct TokenIndex {
@@ -25,6 +34,49 @@ struct TokenIndex {
   int32_t id;
 };
 
+/**
+ * Per-call options for encoding with BPE tokenizers.
+ */
+struct EncodeOptions {
+  /// How special tokens that appear in the input are treated.
+  enum class SpecialTokens {
+    /// Every special token is encoded as its id.
+    All,
+    /// Special tokens are encoded as ordinary text, without scanning the
+    /// input for them. Use this for untrusted text that must never produce
+    /// control tokens.
+    None,
+    /// Only the special tokens in allowed_special are encoded as their ids.
+    Allowed,
+  };
+
+  SpecialTokens special_tokens = SpecialTokens::All;
+
+  /// With SpecialTokens::Allowed, the ids of the special tokens to recognize,
+  /// as a bitset indexed by token id.
+  std::vector<bool> allowed_special;
+
+  /// With SpecialTokens::Allowed, fail with Error::EncodeFailure when the
+  /// input contains a special token that is not allowed, instead of encoding
+  /// it as ordinary text.
+  bool reject_disallowed = false;
+
+  /// The number of BOS tokens to prepend and EOS tokens to append.
+  int8_t bos = 0;
+  int8_t eos = 0;
+
+  /// Allows the special token with the given id, switching to
+  /// SpecialTokens::Allowed.
+  EncodeOptions& allow_special(uint64_t id) {
+    if (id >= allowed_special.size()) {
+      allowed_special.resize(id + 1);
+    }
+    allowed_special[id] = true;
+    special_tokens = SpecialTokens::Allowed;
+    return *this;
+  }
+};
+
 class Tokenizer {
  public:
   explicit Tokenizer() {}
@@ -32,6 +84,29 @@ class Tokenizer {
 
   virtual Error load(const std::string& tokenizer_path) = 0;
 
+  /**
+   * Load the tokenizer from the contents of a tokenizer file held in memory,
+   * such as one embedded in a model archive, without going through the
+   * filesystem. Accepts the same formats as load() does for a single file.
+   *
+   * The data only needs to stay alive for the duration of the call.
+   *
+   * @param data The contents of the tokenizer file
+   * @return Error::Ok on success
+   */
+  virtual Error load_from_buffer(std::string_view data) {
+    (void)data;
+    TK_LOG(Error, "this tokenizer cannot be loaded from a buffer");
+    return Error::LoadFailure;
+  }
+
+#ifdef __cpp_lib_span
+  Error load_from_buffer(std::span<const std::byte> data) {
+    return load_from_buffer(std::string_view(
+        reinterpret_cast<const char*>(data.data()), data.size()));
+  }
+#endif
+
   /**
    * Encode the input string into a vector of token IDs.
    *
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <pytorch/tokenizers/artifact.h>
+
+// Standard
+#include <cstring>
+#include <fstream>
+
+namespace tokenizers {
+namespace detail {
+
+namespace {
+
+struct ArtifactHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint32_t byte_order_mark;
+  uint32_t section_count;
+};
+
+struct ArtifactSectionEntry {
+  uint32_t id;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+};
+
+static_assert(sizeof(ArtifactHeader) == 24, "unexpected header padding");
+static_assert(sizeof(ArtifactSectionEntry) == 24, "unexpected entry padding");
+
+std::size_t align_up(std::size_t size) {
+  return (size + kArtifactAlignment - 1) & ~(kArtifactAlignment - 1);
+}
+
+} // namespace
+
+bool has_artifact_magic(std::string_view data) {
+  return data.size() >= sizeof(kArtifactMagic) &&
+      std::memcmp(data.data(), kArtifactMagic, sizeof(kArtifactMagic)) == 0;
+}
+
+// -------------------------ArtifactWriter-------------------------------------
+
+void ArtifactWriter::add(ArtifactSection section, std::string data) {
+  sections_.emplace_back(section, std::move(data));
+}
+
+void ArtifactWriter::add_integers(
+    ArtifactSection section,
+    const std::vector<uint64_t>& values) {
+  std::string data(values.size() * sizeof(uint64_t), '\0');
+  if (!values.empty()) {
+    std::memcpy(data.data(), values.data(), data.size());
+  }
+  add(section, std::move(data));
+}
+
+void ArtifactWriter::add_strings(
+    ArtifactSection section,
+    const std::vector<std::string_view>& values) {
+  // Count, then (offset, size) pairs relative to the end of the table, then
+  // the concatenated bytes.
+  std::vector<uint64_t> table;
+  table.reserve(1 + (values.size() * 2));
+  table.push_back(values.size());
+  uint64_t offset = 0;
+  for (const auto& value : values) {
+    table.push_back(offset);
+    table.push_back(value.size());
+    offset += value.size();
+  }
+  std::string data(table.size() * sizeof(uint64_t), '\0');
+  std::memcpy(data.data(), table.data(), data.size());
+  data.reserve(data.size() + offset);
+  for (const auto& value : values) {
+    data.append(value);
+  }
+  add(section, std::move(data));
+}
+
+Error ArtifactWriter::save(const std::string& path) const {
+  ArtifactHeader header{};
+  std::memcpy(header.magic, kArtifactMagic, sizeof(header.magic));
+  header.version = kArtifactVersion;
+  header.kind = static_cast<uint32_t>(kind_);
+  header.byte_order_mark = kArtifactByteOrderMark;
+  header.section_count = static_cast<uint32_t>(sections_.size());
+
+  std::vector<ArtifactSectionEntry> entries;
+  entries.reserve(sections_.size());
+  std::size_t offset = align_up(
+      sizeof(ArtifactHeader) +
+      (sections_.size() * sizeof(ArtifactSectionEntry)));
+  for (const auto& [id, data] : sections_) {
+    entries.push_back({static_cast<uint32_t>(id), 0, offset, data.size()});
+    offset = align_up(offset + data.size());
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  TK_CHECK_OR_RETURN_ERROR(
+      file,
+      SaveFailure,
+      "failed to open artifact for writing: %s",
+      path.c_str());
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(
+      reinterpret_cast<const char*>(entries.data()),
+      entries.size() * sizeof(ArtifactSectionEntry));
+  std::size_t written =
+      sizeof(header) + (entries.size() * sizeof(ArtifactSectionEntry));
+  const std::string padding(kArtifactAlignment, '\0');
+  for (std::size_t i = 0; i < sections_.size(); ++i) {
+    file.write(padding.data(), entries[i].offset - written);
+    file.write(sections_[i].second.data(), sections_[i].second.size());
+    written = entries[i].offset + sections_[i].second.size();
+  }
+  file.flush();
+  TK_CHECK_OR_RETURN_ERROR(
+      file, SaveFailure, "failed to write artifact: %s", path.c_str());
+  return Error::Ok;
+}
+
+// -------------------------ArtifactReader-------------------------------------
+
+Result<ArtifactReader> ArtifactReader::open(const std::string& path) {
+  return read(
+      std::make_shared<const MappedFile>(TK_UNWRAP(MappedFile::open(path))),
+      path.c_str());
+}
+
+Result<ArtifactReader> ArtifactReader::from_file(MappedFile file) {
+  return read(std::make_shared<const MappedFile>(std::move(file)), "<file>");
+}
+
+Result<ArtifactReader> ArtifactReader::from_buffer(std::string_view data) {
+  return read(
+      std::make_shared<const MappedFile>(MappedFile::copy_of(data)),
+      "<buffer>");
+}
+
+Result<ArtifactReader> ArtifactReader::read(
+    std::shared_ptr<const MappedFile> file,
+    const char* source) {
+  // The views below point into the file, so it must not move from here on.
+  const auto contents = file->view();
+
+  ArtifactHeader header;
+  TK_CHECK_OR_RETURN_ERROR(
+      contents.size() >= sizeof(header),
+      LoadFailure,
+      "artifact is truncated: %s",
+      source);
+  std::memcpy(&header, contents.data(), sizeof(header));
+  TK_CHECK_OR_RETURN_ERROR(
+      std::memcmp(header.magic, kArtifactMagic, sizeof(header.magic)) == 0,
+      LoadFailure,
+      "not a tokenizer artifact: %s",
+      source);
+  TK_CHECK_OR_RETURN_ERROR(
+      header.version == kArtifactVersion,
+      LoadFailure,
+      "unsupported artifact version %u, expected %u: %s",
+      header.version,
+      kArtifactVersion,
+      source);
+  TK_CHECK_OR_RETURN_ERROR(
+      header.byte_order_mark == kArtifactByteOrderMark,
+      LoadFailure,
+      "artifact was written with a different byte order: %s",
+      source);
+
+  const std::size_t table_size =
+      static_cast<std::size_t>(header.section_count) *
+      sizeof(ArtifactSectionEntry);
+  TK_CHECK_OR_RETURN_ERROR(
+      contents.size() - sizeof(header) >= table_size,
+      LoadFailure,
+      "artifact section table is truncated: %s",
+      source);
+
+  ArtifactReader reader;
+  reader.kind_ = static_cast<ArtifactKind>(header.kind);
+  reader.sections_.reserve(header.section_count);
+  for (uint32_t i = 0; i < header.section_count; ++i) {
+    ArtifactSectionEntry entry;
+    std::memcpy(
+        &entry,
+        contents.data() + sizeof(header) + (i * sizeof(entry)),
+        sizeof(entry));
+    TK_CHECK_OR_RETURN_ERROR(
+        entry.offset <= contents.size() &&
+            entry.size <= contents.size() - entry.offset,
+        LoadFailure,
+        "artifact section %u is out of bounds: %s",
+        entry.id,
+        source);
+    reader.sections_.emplace_back(
+        static_cast<ArtifactSection>(entry.id),
+        contents.substr(entry.offset, entry.size));
+  }
+  reader.file_ = std::move(file);
+  return reader;
+}
+
+bool ArtifactReader::has_section(ArtifactSection section) const {
+  for (const auto& [id, data] : sections_) {
+    if (id == section) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Result<std::string_view> ArtifactReader::section(
+    ArtifactSection section) const {
+  for (const auto& [id, data] : sections_) {
+    if (id == section) {
+      return data;
+    }
+  }
+  TK_LOG(
+      Error,
+      "artifact is missing section %u",
+      static_cast<unsigned>(section));
+  return Error::LoadFailure;
+}
+
+Result<std::vector<uint64_t>> ArtifactReader::integers(
+    ArtifactSection section) const {
+  const auto data = TK_UNWRAP(this->section(section));
+  TK_CHECK_OR_RETURN_ERROR(
+      data.size() % sizeof(uint64_t) == 0,
+      LoadFailure,
+      "malformed integers in artifact section %u",
+      static_cast<unsigned>(section));
+  std::vector<uint64_t> values(data.size() / sizeof(uint64_t));
+  if (!values.empty()) {
+    std::memcpy(values.data(), data.data(), data.size());
+  }
+  return values;
+}
+
+Result<std::vector<std::string_view>> ArtifactReader::strings(
+    ArtifactSection section) const {
+  auto data = TK_UNWRAP(this->section(section));
+  uint64_t count = 0;
+  TK_CHECK_OR_RETURN_ERROR(
+      data.size() >= sizeof(count),
+      LoadFailure,
+      "malformed strings in artifact section %u",
+      static_cast<unsigned>(section));
+  std::memcpy(&count, data.data(), sizeof(count));
+  TK_CHECK_OR_RETURN_ERROR(
+      count <= (data.size() - sizeof(count)) / (2 * sizeof(uint64_t)),
+      LoadFailure,
+      "malformed strings in artifact section %u",
+      static_cast<unsigned>(section));
+  const auto table_size = (1 + (count * 2)) * sizeof(uint64_t);
+  const auto* table = data.data();
+  const auto bytes = data.substr(table_size);
+
+  std::vector<std::string_view> values;
+  values.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t entry[2];
+    std::memcpy(
+        entry, table + ((1 + (i * 2)) * sizeof(uint64_t)), sizeof(entry));
+    TK_CHECK_OR_RETURN_ERROR(
+        entry[0] <= bytes.size() && entry[1] <= bytes.size() - entry[0],
+        LoadFailure,
+        "malformed strings in artifact section %u",
+        static_cast<unsigned>(section));
+    values.push_back(bytes.substr(entry[0], entry[1]));
+  }
+  return values;
+}
+
+} // namespace detail
+} // namespace tokenizers
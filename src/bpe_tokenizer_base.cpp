@@ -131,56 +131,52 @@ std::vector<uint64_t> BPETokenizerBase::_byte_pair_merge(
   return out;
 }
 
-std::pair<std::optional<std::string>, std::string>
-BPETokenizerBase::split_with_allowed_special_token_(
-    const std::string& input,
-    size_t offset,
-    const TokenMap& allowed_special) const {
-  if (!special_token_regex_) {
-    return std::make_pair(std::nullopt, input.substr(offset));
-  }
-
-  auto matches = special_token_regex_->find_all(input.substr(offset));
-
-  for (const auto& m : matches) {
-    std::string matched_text = input.substr(offset + m.start, m.end - m.start);
-    if (allowed_special.tryGetInteger(matched_text).has_value()) {
-      return {matched_text, input.substr(offset, m.start)};
-    }
-  }
-
-  return {std::nullopt, input.substr(offset)};
-}
-
 Result<std::pair<std::vector<uint64_t>, uint64_t>>
 BPETokenizerBase::encode_with_special_token_(
     const std::string& text,
-    const TokenMap& allowed_special) const {
+    const EncodeOptions& options) const {
+  using SpecialTokens = EncodeOptions::SpecialTokens;
   std::vector<uint64_t> tokens;
   uint64_t last_piece_token_len = 0;
-  size_t offset = 0;
-
-  while (offset < text.size()) {
-    auto [special, sub_input] =
-        split_with_allowed_special_token_(text, offset, allowed_special);
+  if (options.special_tokens == SpecialTokens::None) {
+    TK_CHECK_OK_OR_RETURN_ERROR(_encode(text, tokens, last_piece_token_len));
+    return std::make_pair(tokens, last_piece_token_len);
+  }
 
-    TK_CHECK_OK_OR_RETURN_ERROR(
-        _encode(sub_input, tokens, last_piece_token_len));
-    offset += sub_input.size();
-
-    if (special) {
-      const auto result = special_token_map_->tryGetInteger(*special);
-      if (!result) {
-        TK_LOG(Error, "unknown special token: %s\n", special->c_str());
-        return Error::EncodeFailure;
-      }
+  const auto is_allowed = [&options](uint64_t id) {
+    return options.special_tokens == SpecialTokens::All ||
+        (id < options.allowed_special.size() && options.allowed_special[id]);
+  };
+  if (options.special_tokens == SpecialTokens::Allowed &&
+      options.reject_disallowed) {
+    const auto disallowed = special_token_matcher_.find_if(
+        text, 0, [&is_allowed](uint64_t id) { return !is_allowed(id); });
+    TK_CHECK_OR_RETURN_ERROR(
+        !disallowed,
+        EncodeFailure,
+        "disallowed special token %" PRIu64 " in input",
+        disallowed->id);
+  }
 
-      tokens.push_back(*result);
-      last_piece_token_len = 0;
-      offset += special->size(); // advance past the matched token
-    } else {
-      break;
+  // Only the allowed tokens are matched, so a disallowed token, which is
+  // encoded as ordinary text, does not hide an allowed one it overlaps.
+  size_t offset = 0;
+  auto match = special_token_matcher_.find_if(text, offset, is_allowed);
+  for (; match;
+       match = special_token_matcher_.find_if(text, match->end, is_allowed)) {
+    if (match->start > offset) {
+      TK_CHECK_OK_OR_RETURN_ERROR(_encode(
+          text.substr(offset, match->start - offset),
+          tokens,
+          last_piece_token_len));
     }
+    tokens.push_back(match->id);
+    last_piece_token_len = 0;
+    offset = match->end;
+  }
+  if (offset < text.size()) {
+    TK_CHECK_OK_OR_RETURN_ERROR(
+        _encode(text.substr(offset), tokens, last_piece_token_len));
   }
 
   return std::make_pair(tokens, last_piece_token_len);
@@ -213,6 +209,56 @@ Result<std::vector<uint64_t>> BPETokenizerBase::byte_pair_encode_(
       });
 }
 
+void BPETokenizerBase::save_token_maps_(ArtifactWriter& writer) const {
+  writer.add_map(ArtifactSection::TokenMap, *token_map_);
+  writer.add_map(ArtifactSection::SpecialTokenMap, *special_token_map_);
+}
+
+Error BPETokenizerBase::load_token_maps_(const ArtifactReader& reader) {
+  token_map_.emplace(
+      TK_UNWRAP(reader.map<TokenMap>(ArtifactSection::TokenMap)));
+  special_token_map_.emplace(
+      TK_UNWRAP(reader.map<TokenMap>(ArtifactSection::SpecialTokenMap)));
+  return Error::Ok;
+}
+
+Error BPETokenizerBase::_init_encoder() const {
+  std::vector<std::pair<std::string_view, uint64_t>> special_tokens;
+  special_tokens.reserve(special_token_map_->size());
+  for (std::size_t i = 0; i < special_token_map_->size(); ++i) {
+    special_tokens.push_back(special_token_map_->getElement(i));
+  }
+  special_token_matcher_ = SpecialTokenMatcher(special_tokens);
+  return Error::Ok;
+}
+
+Error BPETokenizerBase::ensure_encoder_() const {
+  return encoder_init_.get([this]() {
+    try {
+      return _init_encoder();
+    } catch (const std::exception& e) {
+      TK_LOG(Error, "failed to set up encoding: %s", e.what());
+      return Error::LoadFailure;
+    }
+  });
+}
+
+Error BPETokenizerBase::ensure_decoder_() const {
+  return decoder_init_.get([this]() {
+    try {
+      return _init_decoder();
+    } catch (const std::exception& e) {
+      TK_LOG(Error, "failed to set up decoding: %s", e.what());
+      return Error::LoadFailure;
+    }
+  });
+}
+
+void BPETokenizerBase::reset_lazy_init_() {
+  encoder_init_.reset();
+  decoder_init_.reset();
+}
+
 // ---- protected end ----------------------------------------------------------
 // ---- public start -----------------------------------------------------------
 
@@ -220,15 +266,24 @@ Result<std::vector<uint64_t>> BPETokenizerBase::encode(
     const std::string& text,
     int8_t bos,
     int8_t eos) const {
+  EncodeOptions options;
+  options.bos = bos;
+  options.eos = eos;
+  return encode(text, options);
+}
+
+Result<std::vector<uint64_t>> BPETokenizerBase::encode(
+    const std::string& text,
+    const EncodeOptions& options) const {
   if (!initialized_) {
     return Error::Uninitialized;
   }
-  auto res =
-      TK_UNWRAP(encode_with_special_token_(text, *special_token_map_)).first;
-  for (auto i = 0; i < bos; ++i) {
+  TK_CHECK_OK_OR_RETURN_ERROR(ensure_encoder_());
+  auto res = TK_UNWRAP(encode_with_special_token_(text, options)).first;
+  for (auto i = 0; i < options.bos; ++i) {
     res.insert(res.begin(), bos_tok_);
   }
-  for (auto i = 0; i < eos; ++i) {
+  for (auto i = 0; i < options.eos; ++i) {
     res.push_back(eos_tok_);
   }
   return Result<std::vector<uint64_t>>(std::move(res));
@@ -236,10 +291,10 @@ Result<std::vector<uint64_t>> BPETokenizerBase::encode(
 
 Result<std::string> BPETokenizerBase::decode(uint64_t prev, uint64_t cur)
     const {
-  (void)prev;
   if (!initialized_) {
     return Error::Uninitialized;
   }
+  TK_CHECK_OK_OR_RETURN_ERROR(ensure_decoder_());
   std::string ret;
 
   std::string_view token_bytes;
@@ -255,7 +310,11 @@ Result<std::string> BPETokenizerBase::decode(uint64_t prev, uint64_t cur)
   } else {
     token_bytes = *result;
   }
-  _decode(std::string(token_bytes), ret);
+  if (prev == bos_tok_) {
+    _decode_first(std::string(token_bytes), ret);
+  } else {
+    _decode(std::string(token_bytes), ret);
+  }
 
   return ret;
 }
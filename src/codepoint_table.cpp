@@ -0,0 +1,576 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <pytorch/tokenizers/codepoint_table.h>
+
+// Standard
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace tokenizers {
+namespace detail {
+
+namespace {
+
+struct Run {
+  uint32_t start;
+  uint16_t value;
+};
+
+// Every codepoint from start up to the start of the next run has the same
+// value, which is CodepointClass::flags | CodepointClass::script << 4, with
+// script ids in order of first appearance.
+//
+// Generated by probing the pre-tokenizers of HF tokenizers 0.23.3 with every
+// codepoint, rather than from one version of the Unicode character database:
+// \w and the Rust char methods follow the Unicode version of its toolchain,
+// punctuation follows the older unicode_categories crate, and UnicodeScripts
+// has a script table of its own. To regenerate it, and the sample that
+// test_pre_tokenizer.cpp checks it against, run
+//   python tools/gen_codepoint_table.py --table src/codepoint_table.cpp \
+//       --sample test/resources/hf_codepoint_sample.txt
+// with the tokenizers version to match installed.
+// clang-format off
+constexpr Run kRuns[] = {
+    {0x0, 0x10}, {0x9, 0x11}, {0xe, 0x10}, {0x20, 0x1}, {0x21, 0x14},
+    {0x30, 0x1a}, {0x3a, 0x14}, {0x41, 0x22}, {0x5b, 0x14}, {0x5f, 0x16},
+    {0x60, 0x14}, {0x61, 0x22}, {0x7b, 0x14}, {0x7f, 0x10}, {0x85, 0x11},
+    {0x86, 0x10}, {0xa0, 0x11}, {0xa1, 0x14}, {0xa2, 0x10}, {0xa7, 0x14},
+    {0xa8, 0x10}, {0xaa, 0x22}, {0xab, 0x14}, {0xac, 0x10}, {0xb2, 0x18},
+    {0xb4, 0x10}, {0xb5, 0x12}, {0xb6, 0x14}, {0xb8, 0x10}, {0xb9, 0x18},
+    {0xba, 0x22}, {0xbb, 0x14}, {0xbc, 0x18}, {0xbf, 0x14}, {0xc0, 0x22},
+    {0xd7, 0x10}, {0xd8, 0x22}, {0xf7, 0x10}, {0xf8, 0x22}, {0x2b9, 0x12},
+    {0x2c2, 0x10}, {0x2c6, 0x12}, {0x2d2, 0x10}, {0x2e0, 0x22}, {0x2e5, 0x10},
+    {0x2ea, 0x30}, {0x2ec, 0x12}, {0x2ed, 0x10}, {0x2ee, 0x12}, {0x2ef, 0x10},
+    {0x300, 0x42}, {0x370, 0x52}, {0x374, 0x12}, {0x375, 0x50}, {0x376, 0x52},
+    {0x378, 0x0}, {0x37a, 0x52}, {0x37e, 0x14}, {0x37f, 0x52}, {0x380, 0x0},
+    {0x384, 0x50}, {0x385, 0x10}, {0x386, 0x52}, {0x387, 0x14}, {0x388, 0x52},
+    {0x38b, 0x0}, {0x38c, 0x52}, {0x38d, 0x0}, {0x38e, 0x52}, {0x3a2, 0x0},
+    {0x3a3, 0x52}, {0x3e2, 0x62}, {0x3f0, 0x52}, {0x3f6, 0x50}, {0x3f7, 0x52},
+    {0x400, 0x72}, {0x482, 0x70}, {0x483, 0x72}, {0x485, 0x42}, {0x487, 0x72},
+    {0x530, 0x0}, {0x531, 0x82}, {0x557, 0x0}, {0x559, 0x82}, {0x55a, 0x84},
+    {0x560, 0x2}, {0x561, 0x82}, {0x588, 0x2}, {0x589, 0x14}, {0x58a, 0x84},
+    {0x58b, 0x0}, {0x58d, 0x80}, {0x590, 0x0}, {0x591, 0x92}, {0x5be, 0x94},
+    {0x5bf, 0x92}, {0x5c0, 0x94}, {0x5c1, 0x92}, {0x5c3, 0x94}, {0x5c4, 0x92},
+    {0x5c6, 0x94}, {0x5c7, 0x92}, {0x5c8, 0x0}, {0x5d0, 0x92}, {0x5eb, 0x0},
+    {0x5ef, 0x2}, {0x5f0, 0x92}, {0x5f3, 0x94}, {0x5f5, 0x0}, {0x600, 0xa0},
+    {0x605, 0x10}, {0x606, 0xa0}, {0x609, 0xa4}, {0x60b, 0xa0}, {0x60c, 0x14},
+    {0x60d, 0xa4}, {0x60e, 0xa0}, {0x610, 0xa2}, {0x61b, 0x14}, {0x61c, 0x10},
+    {0x61d, 0x0}, {0x61e, 0xa4}, {0x61f, 0x14}, {0x620, 0xa2}, {0x640, 0x12},
+    {0x641, 0xa2}, {0x64b, 0x42}, {0x656, 0xa2}, {0x660, 0xaa}, {0x66a, 0xa4},
+    {0x66e, 0xa2}, {0x670, 0x42}, {0x671, 0xa2}, {0x6d4, 0xa4}, {0x6d5, 0xa2},
+    {0x6dd, 0x10}, {0x6de, 0xa0}, {0x6df, 0xa2}, {0x6e9, 0xa0}, {0x6ea, 0xa2},
+    {0x6f0, 0xaa}, {0x6fa, 0xa2}, {0x6fd, 0xa0}, {0x6ff, 0xa2}, {0x700, 0xb4},
+    {0x70e, 0x0}, {0x70f, 0xb0}, {0x710, 0xb2}, {0x74b, 0x0}, {0x74d, 0xb2},
+    {0x750, 0xa2}, {0x780, 0xc2}, {0x7b2, 0x0}, {0x7c0, 0xda}, {0x7ca, 0xd2},
+    {0x7f6, 0xd0}, {0x7f7, 0xd4}, {0x7fa, 0xd2}, {0x7fb, 0x0}, {0x7fd, 0x2},
+    {0x7fe, 0x0}, {0x800, 0xe2}, {0x82e, 0x0}, {0x830, 0xe4}, {0x83f, 0x0},
+    {0x840, 0xf2}, {0x85c, 0x0}, {0x85e, 0xf4}, {0x85f, 0x0}, {0x860, 0x2},
+    {0x86b, 0x0}, {0x870, 0x2}, {0x888, 0x0}, {0x889, 0x2}, {0x88f, 0x0},
+    {0x897, 0x2}, {0x8a0, 0xa2}, {0x8b5, 0x2}, {0x8b6, 0xa2}, {0x8be, 0x2},
+    {0x8d4, 0xa2}, {0x8e2, 0x10}, {0x8e3, 0xa2}, {0x900, 0x102}, {0x951, 0x42},
+    {0x953, 0x102}, {0x964, 0x14}, {0x966, 0x10a}, {0x970, 0x104}, {0x971, 0x102},
+    {0x980, 0x112}, {0x984, 0x0}, {0x985, 0x112}, {0x98d, 0x0}, {0x98f, 0x112},
+    {0x991, 0x0}, {0x993, 0x112}, {0x9a9, 0x0}, {0x9aa, 0x112}, {0x9b1, 0x0},
+    {0x9b2, 0x112}, {0x9b3, 0x0}, {0x9b6, 0x112}, {0x9ba, 0x0}, {0x9bc, 0x112},
+    {0x9c5, 0x0}, {0x9c7, 0x112}, {0x9c9, 0x0}, {0x9cb, 0x112}, {0x9cf, 0x0},
+    {0x9d7, 0x112}, {0x9d8, 0x0}, {0x9dc, 0x112}, {0x9de, 0x0}, {0x9df, 0x112},
+    {0x9e4, 0x0}, {0x9e6, 0x11a}, {0x9f0, 0x112}, {0x9f2, 0x110}, {0x9f4, 0x118},
+    {0x9fa, 0x110}, {0x9fc, 0x2}, {0x9fd, 0x0}, {0x9fe, 0x2}, {0x9ff, 0x0},
+    {0xa01, 0x122}, {0xa04, 0x0}, {0xa05, 0x122}, {0xa0b, 0x0}, {0xa0f, 0x122},
+    {0xa11, 0x0}, {0xa13, 0x122}, {0xa29, 0x0}, {0xa2a, 0x122}, {0xa31, 0x0},
+    {0xa32, 0x122}, {0xa34, 0x0}, {0xa35, 0x122}, {0xa37, 0x0}, {0xa38, 0x122},
+    {0xa3a, 0x0}, {0xa3c, 0x122}, {0xa3d, 0x0}, {0xa3e, 0x122}, {0xa43, 0x0},
+    {0xa47, 0x122}, {0xa49, 0x0}, {0xa4b, 0x122}, {0xa4e, 0x0}, {0xa51, 0x122},
+    {0xa52, 0x0}, {0xa59, 0x122}, {0xa5d, 0x0}, {0xa5e, 0x122}, {0xa5f, 0x0},
+    {0xa66, 0x12a}, {0xa70, 0x122}, {0xa76, 0x0}, {0xa81, 0x132}, {0xa84, 0x0},
+    {0xa85, 0x132}, {0xa8e, 0x0}, {0xa8f, 0x132}, {0xa92, 0x0}, {0xa93, 0x132},
+    {0xaa9, 0x0}, {0xaaa, 0x132}, {0xab1, 0x0}, {0xab2, 0x132}, {0xab4, 0x0},
+    {0xab5, 0x132}, {0xaba, 0x0}, {0xabc, 0x132}, {0xac6, 0x0}, {0xac7, 0x132},
+    {0xaca, 0x0}, {0xacb, 0x132}, {0xace, 0x0}, {0xad0, 0x132}, {0xad1, 0x0},
+    {0xae0, 0x132}, {0xae4, 0x0}, {0xae6, 0x13a}, {0xaf0, 0x134}, {0xaf1, 0x130},
+    {0xaf2, 0x0}, {0xaf9, 0x132}, {0xafa, 0x2}, {0xb00, 0x0}, {0xb01, 0x142},
+    {0xb04, 0x0}, {0xb05, 0x142}, {0xb0d, 0x0}, {0xb0f, 0x142}, {0xb11, 0x0},
+    {0xb13, 0x142}, {0xb29, 0x0}, {0xb2a, 0x142}, {0xb31, 0x0}, {0xb32, 0x142},
+    {0xb34, 0x0}, {0xb35, 0x142}, {0xb3a, 0x0}, {0xb3c, 0x142}, {0xb45, 0x0},
+    {0xb47, 0x142}, {0xb49, 0x0}, {0xb4b, 0x142}, {0xb4e, 0x0}, {0xb55, 0x2},
+    {0xb56, 0x142}, {0xb58, 0x0}, {0xb5c, 0x142}, {0xb5e, 0x0}, {0xb5f, 0x142},
+    {0xb64, 0x0}, {0xb66, 0x14a}, {0xb70, 0x140}, {0xb71, 0x142}, {0xb72, 0x148},
+    {0xb78, 0x0}, {0xb82, 0x152}, {0xb84, 0x0}, {0xb85, 0x152}, {0xb8b, 0x0},
+    {0xb8e, 0x152}, {0xb91, 0x0}, {0xb92, 0x152}, {0xb96, 0x0}, {0xb99, 0x152},
+    {0xb9b, 0x0}, {0xb9c, 0x152}, {0xb9d, 0x0}, {0xb9e, 0x152}, {0xba0, 0x0},
+    {0xba3, 0x152}, {0xba5, 0x0}, {0xba8, 0x152}, {0xbab, 0x0}, {0xbae, 0x152},
+    {0xbba, 0x0}, {0xbbe, 0x152}, {0xbc3, 0x0}, {0xbc6, 0x152}, {0xbc9, 0x0},
+    {0xbca, 0x152}, {0xbce, 0x0}, {0xbd0, 0x152}, {0xbd1, 0x0}, {0xbd7, 0x152},
+    {0xbd8, 0x0}, {0xbe6, 0x15a}, {0xbf0, 0x158}, {0xbf3, 0x150}, {0xbfb, 0x0},
+    {0xc00, 0x162}, {0xc04, 0x2}, {0xc05, 0x162}, {0xc0d, 0x0}, {0xc0e, 0x162},
+    {0xc11, 0x0}, {0xc12, 0x162}, {0xc29, 0x0}, {0xc2a, 0x162}, {0xc3a, 0x0},
+    {0xc3c, 0x2}, {0xc3d, 0x162}, {0xc45, 0x0}, {0xc46, 0x162}, {0xc49, 0x0},
+    {0xc4a, 0x162}, {0xc4e, 0x0}, {0xc55, 0x162}, {0xc57, 0x0}, {0xc58, 0x162},
+    {0xc5b, 0x0}, {0xc5d, 0x2}, {0xc5e, 0x0}, {0xc60, 0x162}, {0xc64, 0x0},
+    {0xc66, 0x16a}, {0xc70, 0x0}, {0xc78, 0x168}, {0xc7f, 0x160}, {0xc80, 0x172},
+    {0xc84, 0x0}, {0xc85, 0x172}, {0xc8d, 0x0}, {0xc8e, 0x172}, {0xc91, 0x0},
+    {0xc92, 0x172}, {0xca9, 0x0}, {0xcaa, 0x172}, {0xcb4, 0x0}, {0xcb5, 0x172},
+    {0xcba, 0x0}, {0xcbc, 0x172}, {0xcc5, 0x0}, {0xcc6, 0x172}, {0xcc9, 0x0},
+    {0xcca, 0x172}, {0xcce, 0x0}, {0xcd5, 0x172}, {0xcd7, 0x0}, {0xcdd, 0x2},
+    {0xcde, 0x172}, {0xcdf, 0x0}, {0xce0, 0x172}, {0xce4, 0x0}, {0xce6, 0x17a},
+    {0xcf0, 0x0}, {0xcf1, 0x172}, {0xcf3, 0x2}, {0xcf4, 0x0}, {0xd00, 0x2},
+    {0xd01, 0x182}, {0xd04, 0x2}, {0xd05, 0x182}, {0xd0d, 0x0}, {0xd0e, 0x182},
+    {0xd11, 0x0}, {0xd12, 0x182}, {0xd3b, 0x2}, {0xd3d, 0x182}, {0xd45, 0x0},
+    {0xd46, 0x182}, {0xd49, 0x0}, {0xd4a, 0x182}, {0xd4f, 0x180}, {0xd50, 0x0},
+    {0xd54, 0x182}, {0xd58, 0x188}, {0xd5f, 0x182}, {0xd64, 0x0}, {0xd66, 0x18a},
+    {0xd70, 0x188}, {0xd79, 0x180}, {0xd7a, 0x182}, {0xd80, 0x0}, {0xd81, 0x2},
+    {0xd82, 0x192}, {0xd84, 0x0}, {0xd85, 0x192}, {0xd97, 0x0}, {0xd9a, 0x192},
+    {0xdb2, 0x0}, {0xdb3, 0x192}, {0xdbc, 0x0}, {0xdbd, 0x192}, {0xdbe, 0x0},
+    {0xdc0, 0x192}, {0xdc7, 0x0}, {0xdca, 0x192}, {0xdcb, 0x0}, {0xdcf, 0x192},
+    {0xdd5, 0x0}, {0xdd6, 0x192}, {0xdd7, 0x0}, {0xdd8, 0x192}, {0xde0, 0x0},
+    {0xde6, 0x19a}, {0xdf0, 0x0}, {0xdf2, 0x192}, {0xdf4, 0x194}, {0xdf5, 0x0},
+    {0xe01, 0x1a2}, {0xe3b, 0x0}, {0xe3f, 0x10}, {0xe40, 0x1a2}, {0xe4f, 0x1a4},
+    {0xe50, 0x1aa}, {0xe5a, 0x1a4}, {0xe5c, 0x0}, {0xe81, 0x1b2}, {0xe83, 0x0},
+    {0xe84, 0x1b2}, {0xe85, 0x0}, {0xe86, 0x2}, {0xe87, 0x1b2}, {0xe89, 0x2},
+    {0xe8a, 0x1b2}, {0xe8b, 0x0}, {0xe8c, 0x2}, {0xe8d, 0x1b2}, {0xe8e, 0x2},
+    {0xe94, 0x1b2}, {0xe98, 0x2}, {0xe99, 0x1b2}, {0xea0, 0x2}, {0xea1, 0x1b2},
+    {0xea4, 0x0}, {0xea5, 0x1b2}, {0xea6, 0x0}, {0xea7, 0x1b2}, {0xea8, 0x2},
+    {0xeaa, 0x1b2}, {0xeac, 0x2}, {0xead, 0x1b2}, {0xeba, 0x2}, {0xebb, 0x1b2},
+    {0xebe, 0x0}, {0xec0, 0x1b2}, {0xec5, 0x0}, {0xec6, 0x1b2}, {0xec7, 0x0},
+    {0xec8, 0x1b2}, {0xece, 0x2}, {0xecf, 0x0}, {0xed0, 0x1ba}, {0xeda, 0x0},
+    {0xedc, 0x1b2}, {0xee0, 0x0}, {0xf00, 0x1c2}, {0xf01, 0x1c0}, {0xf04, 0x1c4},
+    {0xf13, 0x1c0}, {0xf14, 0x1c4}, {0xf15, 0x1c0}, {0xf18, 0x1c2}, {0xf1a, 0x1c0},
+    {0xf20, 0x1ca}, {0xf2a, 0x1c8}, {0xf34, 0x1c0}, {0xf35, 0x1c2}, {0xf36, 0x1c0},
+    {0xf37, 0x1c2}, {0xf38, 0x1c0}, {0xf39, 0x1c2}, {0xf3a, 0x1c4}, {0xf3e, 0x1c2},
+    {0xf48, 0x0}, {0xf49, 0x1c2}, {0xf6d, 0x0}, {0xf71, 0x1c2}, {0xf85, 0x1c4},
+    {0xf86, 0x1c2}, {0xf98, 0x0}, {0xf99, 0x1c2}, {0xfbd, 0x0}, {0xfbe, 0x1c0},
+    {0xfc6, 0x1c2}, {0xfc7, 0x1c0}, {0xfcd, 0x0}, {0xfce, 0x1c0}, {0xfd0, 0x1c4},
+    {0xfd5, 0x10}, {0xfd9, 0x1c4}, {0xfdb, 0x0}, {0x1000, 0x1d2}, {0x1040, 0x1da},
+    {0x104a, 0x1d4}, {0x1050, 0x1d2}, {0x1090, 0x1da}, {0x109a, 0x1d2}, {0x109e, 0x1d0},
+    {0x10a0, 0x1e2}, {0x10c6, 0x0}, {0x10c7, 0x1e2}, {0x10c8, 0x0}, {0x10cd, 0x1e2},
+    {0x10ce, 0x0}, {0x10d0, 0x1e2}, {0x10fb, 0x14}, {0x10fc, 0x1e2}, {0x1100, 0x1f2},
+    {0x1200, 0x202}, {0x1249, 0x0}, {0x124a, 0x202}, {0x124e, 0x0}, {0x1250, 0x202},
+    {0x1257, 0x0}, {0x1258, 0x202}, {0x1259, 0x0}, {0x125a, 0x202}, {0x125e, 0x0},
+    {0x1260, 0x202}, {0x1289, 0x0}, {0x128a, 0x202}, {0x128e, 0x0}, {0x1290, 0x202},
+    {0x12b1, 0x0}, {0x12b2, 0x202}, {0x12b6, 0x0}, {0x12b8, 0x202}, {0x12bf, 0x0},
+    {0x12c0, 0x202}, {0x12c1, 0x0}, {0x12c2, 0x202}, {0x12c6, 0x0}, {0x12c8, 0x202},
+    {0x12d7, 0x0}, {0x12d8, 0x202}, {0x1311, 0x0}, {0x1312, 0x202}, {0x1316, 0x0},
+    {0x1318, 0x202}, {0x135b, 0x0}, {0x135d, 0x202}, {0x1360, 0x204}, {0x1369, 0x208},
+    {0x137d, 0x0}, {0x1380, 0x202}, {0x1390, 0x200}, {0x139a, 0x0}, {0x13a0, 0x212},
+    {0x13f6, 0x0}, {0x13f8, 0x212}, {0x13fe, 0x0}, {0x1400, 0x224}, {0x1401, 0x222},
+    {0x166d, 0x224}, {0x166f, 0x222}, {0x1680, 0x231}, {0x1681, 0x232}, {0x169b, 0x234},
+    {0x169d, 0x0}, {0x16a0, 0x242}, {0x16eb, 0x14}, {0x16ee, 0x24a}, {0x16f1, 0x242},
+    {0x16f9, 0x0}, {0x1700, 0x252}, {0x170d, 0x2}, {0x170e, 0x252}, {0x1715, 0x2},
+    {0x1716, 0x0}, {0x171f, 0x2}, {0x1720, 0x262}, {0x1735, 0x14}, {0x1737, 0x0},
+    {0x1740, 0x272}, {0x1754, 0x0}, {0x1760, 0x282}, {0x176d, 0x0}, {0x176e, 0x282},
+    {0x1771, 0x0}, {0x1772, 0x282}, {0x1774, 0x0}, {0x1780, 0x292}, {0x17d4, 0x294},
+    {0x17d7, 0x292}, {0x17d8, 0x294}, {0x17db, 0x290}, {0x17dc, 0x292}, {0x17de, 0x0},
+    {0x17e0, 0x29a}, {0x17ea, 0x0}, {0x17f0, 0x298}, {0x17fa, 0x0}, {0x1800, 0x2a4},
+    {0x1802, 0x14}, {0x1804, 0x2a4}, {0x1805, 0x14}, {0x1806, 0x2a4}, {0x180b, 0x2a2},
+    {0x180e, 0x2a0}, {0x180f, 0x2}, {0x1810, 0x2aa}, {0x181a, 0x0}, {0x1820, 0x2a2},
+    {0x1878, 0x2}, {0x1879, 0x0}, {0x1880, 0x2a2}, {0x18ab, 0x0}, {0x18b0, 0x222},
+    {0x18f6, 0x0}, {0x1900, 0x2b2}, {0x191f, 0x0}, {0x1920, 0x2b2}, {0x192c, 0x0},
+    {0x1930, 0x2b2}, {0x193c, 0x0}, {0x1940, 0x2b0}, {0x1941, 0x0}, {0x1944, 0x2b4},
+    {0x1946, 0x2ba}, {0x1950, 0x2c2}, {0x196e, 0x0}, {0x1970, 0x2c2}, {0x1975, 0x0},
+    {0x1980, 0x2d2}, {0x19ac, 0x0}, {0x19b0, 0x2d2}, {0x19ca, 0x0}, {0x19d0, 0x2da},
+    {0x19da, 0x2d8}, {0x19db, 0x0}, {0x19de, 0x2d0}, {0x19e0, 0x290}, {0x1a00, 0x2e2},
+    {0x1a1c, 0x0}, {0x1a1e, 0x2e4}, {0x1a20, 0x2f2}, {0x1a5f, 0x0}, {0x1a60, 0x2f2},
+    {0x1a7d, 0x0}, {0x1a7f, 0x2f2}, {0x1a80, 0x2fa}, {0x1a8a, 0x0}, {0x1a90, 0x2fa},
+    {0x1a9a, 0x0}, {0x1aa0, 0x2f4}, {0x1aa7, 0x2f2}, {0x1aa8, 0x2f4}, {0x1aae, 0x0},
+    {0x1ab0, 0x42}, {0x1abf, 0x2}, {0x1acf, 0x0}, {0x1b00, 0x302}, {0x1b4c, 0x2},
+    {0x1b4d, 0x0}, {0x1b50, 0x30a}, {0x1b5a, 0x304}, {0x1b61, 0x300}, {0x1b6b, 0x302},
+    {0x1b74, 0x300}, {0x1b7d, 0x0}, {0x1b80, 0x312}, {0x1bb0, 0x31a}, {0x1bba, 0x312},
+    {0x1bc0, 0x322}, {0x1bf4, 0x0}, {0x1bfc, 0x324}, {0x1c00, 0x332}, {0x1c38, 0x0},
+    {0x1c3b, 0x334}, {0x1c40, 0x33a}, {0x1c4a, 0x0}, {0x1c4d, 0x332}, {0x1c50, 0x34a},
+    {0x1c5a, 0x342}, {0x1c7e, 0x344}, {0x1c80, 0x72}, {0x1c89, 0x2}, {0x1c8b, 0x0},
+    {0x1c90, 0x2}, {0x1cbb, 0x0}, {0x1cbd, 0x2}, {0x1cc0, 0x314}, {0x1cc8, 0x0},
+    {0x1cd0, 0x42}, {0x1cd3, 0x14}, {0x1cd4, 0x42}, {0x1ce1, 0x12}, {0x1ce2, 0x42},
+    {0x1ce9, 0x12}, {0x1ced, 0x42}, {0x1cee, 0x12}, {0x1cf4, 0x42}, {0x1cf5, 0x12},
+    {0x1cf7, 0x2}, {0x1cf8, 0x42}, {0x1cfa, 0x2}, {0x1cfb, 0x0}, {0x1d00, 0x22},
+    {0x1d26, 0x52}, {0x1d2b, 0x72}, {0x1d2c, 0x22}, {0x1d5d, 0x52}, {0x1d62, 0x22},
+    {0x1d66, 0x52}, {0x1d6b, 0x22}, {0x1d78, 0x72}, {0x1d79, 0x22}, {0x1dbf, 0x52},
+    {0x1dc0, 0x42}, {0x1df6, 0x2}, {0x1dfb, 0x42}, {0x1e00, 0x22}, {0x1f00, 0x52},
+    {0x1f16, 0x0}, {0x1f18, 0x52}, {0x1f1e, 0x0}, {0x1f20, 0x52}, {0x1f46, 0x0},
+    {0x1f48, 0x52}, {0x1f4e, 0x0}, {0x1f50, 0x52}, {0x1f58, 0x0}, {0x1f59, 0x52},
+    {0x1f5a, 0x0}, {0x1f5b, 0x52}, {0x1f5c, 0x0}, {0x1f5d, 0x52}, {0x1f5e, 0x0},
+    {0x1f5f, 0x52}, {0x1f7e, 0x0}, {0x1f80, 0x52}, {0x1fb5, 0x0}, {0x1fb6, 0x52},
+    {0x1fbd, 0x50}, {0x1fbe, 0x52}, {0x1fbf, 0x50}, {0x1fc2, 0x52}, {0x1fc5, 0x0},
+    {0x1fc6, 0x52}, {0x1fcd, 0x50}, {0x1fd0, 0x52}, {0x1fd4, 0x0}, {0x1fd6, 0x52},
+    {0x1fdc, 0x0}, {0x1fdd, 0x50}, {0x1fe0, 0x52}, {0x1fed, 0x50}, {0x1ff0, 0x0},
+    {0x1ff2, 0x52}, {0x1ff5, 0x0}, {0x1ff6, 0x52}, {0x1ffd, 0x50}, {0x1fff, 0x0},
+    {0x2000, 0x11}, {0x200b, 0x10}, {0x200c, 0x42}, {0x200e, 0x10}, {0x2010, 0x14},
+    {0x2028, 0x11}, {0x202a, 0x10}, {0x202f, 0x11}, {0x2030, 0x14}, {0x203f, 0x16},
+    {0x2041, 0x14}, {0x2044, 0x10}, {0x2045, 0x14}, {0x2052, 0x10}, {0x2053, 0x14},
+    {0x2054, 0x16}, {0x2055, 0x14}, {0x205f, 0x11}, {0x2060, 0x10}, {0x2065, 0x0},
+    {0x2066, 0x10}, {0x2070, 0x18}, {0x2071, 0x22}, {0x2072, 0x0}, {0x2074, 0x18},
+    {0x207a, 0x10}, {0x207d, 0x14}, {0x207f, 0x22}, {0x2080, 0x18}, {0x208a, 0x10},
+    {0x208d, 0x14}, {0x208f, 0x0}, {0x2090, 0x22}, {0x209d, 0x0}, {0x20a0, 0x10},
+    {0x20bf, 0x0}, {0x20d0, 0x42}, {0x20f1, 0x0}, {0x2100, 0x10}, {0x2102, 0x12},
+    {0x2103, 0x10}, {0x2107, 0x12}, {0x2108, 0x10}, {0x210a, 0x12}, {0x2114, 0x10},
+    {0x2115, 0x12}, {0x2116, 0x10}, {0x2119, 0x12}, {0x211e, 0x10}, {0x2124, 0x12},
+    {0x2125, 0x10}, {0x2126, 0x52}, {0x2127, 0x10}, {0x2128, 0x12}, {0x2129, 0x10},
+    {0x212a, 0x22}, {0x212c, 0x12}, {0x212e, 0x10}, {0x212f, 0x12}, {0x2132, 0x22},
+    {0x2133, 0x12}, {0x213a, 0x10}, {0x213c, 0x12}, {0x2140, 0x10}, {0x2145, 0x12},
+    {0x214a, 0x10}, {0x214e, 0x22}, {0x214f, 0x10}, {0x2150, 0x18}, {0x2160, 0x2a},
+    {0x2183, 0x22}, {0x2185, 0x2a}, {0x2189, 0x18}, {0x218a, 0x10}, {0x218c, 0x0},
+    {0x2190, 0x10}, {0x2308, 0x14}, {0x230c, 0x10}, {0x2329, 0x14}, {0x232b, 0x10},
+    {0x23ff, 0x0}, {0x2400, 0x10}, {0x2427, 0x0}, {0x2440, 0x10}, {0x244b, 0x0},
+    {0x2460, 0x18}, {0x249c, 0x10}, {0x24b6, 0x12}, {0x24ea, 0x18}, {0x2500, 0x10},
+    {0x2768, 0x14}, {0x2776, 0x18}, {0x2794, 0x10}, {0x27c5, 0x14}, {0x27c7, 0x10},
+    {0x27e6, 0x14}, {0x27f0, 0x10}, {0x2800, 0x350}, {0x2900, 0x10}, {0x2983, 0x14},
+    {0x2999, 0x10}, {0x29d8, 0x14}, {0x29dc, 0x10}, {0x29fc, 0x14}, {0x29fe, 0x10},
+    {0x2b74, 0x0}, {0x2b76, 0x10}, {0x2b96, 0x0}, {0x2b98, 0x10}, {0x2bba, 0x0},
+    {0x2bbd, 0x10}, {0x2bc9, 0x0}, {0x2bca, 0x10}, {0x2bd2, 0x0}, {0x2bec, 0x10},
+    {0x2bf0, 0x0}, {0x2c00, 0x362}, {0x2c2f, 0x2}, {0x2c30, 0x362}, {0x2c5f, 0x2},
+    {0x2c60, 0x22}, {0x2c80, 0x62}, {0x2ce5, 0x60}, {0x2ceb, 0x62}, {0x2cf4, 0x0},
+    {0x2cf9, 0x64}, {0x2cfd, 0x68}, {0x2cfe, 0x64}, {0x2d00, 0x1e2}, {0x2d26, 0x0},
+    {0x2d27, 0x1e2}, {0x2d28, 0x0}, {0x2d2d, 0x1e2}, {0x2d2e, 0x0}, {0x2d30, 0x372},
+    {0x2d68, 0x0}, {0x2d6f, 0x372}, {0x2d70, 0x374}, {0x2d71, 0x0}, {0x2d7f, 0x372},
+    {0x2d80, 0x202}, {0x2d97, 0x0}, {0x2da0, 0x202}, {0x2da7, 0x0}, {0x2da8, 0x202},
+    {0x2daf, 0x0}, {0x2db0, 0x202}, {0x2db7, 0x0}, {0x2db8, 0x202}, {0x2dbf, 0x0},
+    {0x2dc0, 0x202}, {0x2dc7, 0x0}, {0x2dc8, 0x202}, {0x2dcf, 0x0}, {0x2dd0, 0x202},
+    {0x2dd7, 0x0}, {0x2dd8, 0x202}, {0x2ddf, 0x0}, {0x2de0, 0x72}, {0x2e00, 0x14},
+    {0x2e2f, 0x12}, {0x2e30, 0x14}, {0x2e43, 0x10}, {0x2e45, 0x0}, {0x2e80, 0x380},
+    {0x2e9a, 0x0}, {0x2e9b, 0x380}, {0x2ef4, 0x0}, {0x2f00, 0x380}, {0x2fd6, 0x0},
+    {0x2ff0, 0x10}, {0x2ffc, 0x0}, {0x3000, 0x11}, {0x3001, 0x14}, {0x3004, 0x10},
+    {0x3005, 0x382}, {0x3006, 0x12}, {0x3007, 0x38a}, {0x3008, 0x14}, {0x3012, 0x10},
+    {0x3014, 0x14}, {0x3020, 0x10}, {0x3021, 0x38a}, {0x302a, 0x42}, {0x302e, 0x1f2},
+    {0x3030, 0x14}, {0x3031, 0x12}, {0x3036, 0x10}, {0x3038, 0x38a}, {0x303b, 0x382},
+    {0x303c, 0x12}, {0x303d, 0x14}, {0x303e, 0x10}, {0x3040, 0x0}, {0x3041, 0x382},
+    {0x3097, 0x0}, {0x3099, 0x42}, {0x309b, 0x10}, {0x309d, 0x382}, {0x30a0, 0x14},
+    {0x30a1, 0x382}, {0x30fb, 0x14}, {0x30fc, 0x382}, {0x3100, 0x0}, {0x3105, 0x32},
+    {0x312e, 0x2}, {0x3130, 0x0}, {0x3131, 0x1f2}, {0x318f, 0x0}, {0x3190, 0x10},
+    {0x3192, 0x18}, {0x3196, 0x10}, {0x31a0, 0x32}, {0x31bb, 0x2}, {0x31c0, 0x10},
+    {0x31e4, 0x0}, {0x31f0, 0x382}, {0x3200, 0x1f0}, {0x321f, 0x0}, {0x3220, 0x18},
+    {0x322a, 0x10}, {0x3248, 0x18}, {0x3250, 0x10}, {0x3251, 0x18}, {0x3260, 0x1f0},
+    {0x327f, 0x10}, {0x3280, 0x18}, {0x328a, 0x10}, {0x32b1, 0x18}, {0x32c0, 0x10},
+    {0x32d0, 0x380}, {0x32ff, 0x0}, {0x3300, 0x380}, {0x3358, 0x10}, {0x3400, 0x382},
+    {0x4db6, 0x2}, {0x4dc0, 0x10}, {0x4e00, 0x382}, {0x9fd6, 0x2}, {0xa000, 0x392},
+    {0xa48d, 0x0}, {0xa490, 0x390}, {0xa4c7, 0x0}, {0xa4d0, 0x3a2}, {0xa4fe, 0x3a4},
+    {0xa500, 0x3b2}, {0xa60d, 0x3b4}, {0xa610, 0x3b2}, {0xa620, 0x3ba}, {0xa62a, 0x3b2},
+    {0xa62c, 0x0}, {0xa640, 0x72}, {0xa673, 0x74}, {0xa674, 0x72}, {0xa67e, 0x74},
+    {0xa67f, 0x72}, {0xa6a0, 0x3c2}, {0xa6e6, 0x3ca}, {0xa6f0, 0x3c2}, {0xa6f2, 0x3c4},
+    {0xa6f8, 0x0}, {0xa700, 0x10}, {0xa717, 0x12}, {0xa720, 0x10}, {0xa722, 0x22},
+    {0xa788, 0x12}, {0xa789, 0x10}, {0xa78b, 0x22}, {0xa7af, 0x2}, {0xa7b0, 0x22},
+    {0xa7b8, 0x2}, {0xa7ce, 0x0}, {0xa7d0, 0x2}, {0xa7d2, 0x0}, {0xa7d3, 0x2},
+    {0xa7d4, 0x0}, {0xa7d5, 0x2}, {0xa7dd, 0x0}, {0xa7f2, 0x2}, {0xa7f7, 0x22},
+    {0xa800, 0x3d2}, {0xa828, 0x3d0}, {0xa82c, 0x2}, {0xa82d, 0x0}, {0xa830, 0x18},
+    {0xa836, 0x10}, {0xa83a, 0x0}, {0xa840, 0x3e2}, {0xa874, 0x3e4}, {0xa878, 0x0},
+    {0xa880, 0x3f2}, {0xa8c6, 0x0}, {0xa8ce, 0x3f4}, {0xa8d0, 0x3fa}, {0xa8da, 0x0},
+    {0xa8e0, 0x102}, {0xa8f8, 0x104}, {0xa8fb, 0x102}, {0xa8fc, 0x104}, {0xa8fd, 0x102},
+    {0xa8fe, 0x2}, {0xa900, 0x40a}, {0xa90a, 0x402}, {0xa92e, 0x14}, {0xa92f, 0x404},
+    {0xa930, 0x412}, {0xa954, 0x0}, {0xa95f, 0x414}, {0xa960, 0x1f2}, {0xa97d, 0x0},
+    {0xa980, 0x422}, {0xa9c1, 0x424}, {0xa9ce, 0x0}, {0xa9cf, 0x12}, {0xa9d0, 0x42a},
+    {0xa9da, 0x0}, {0xa9de, 0x424}, {0xa9e0, 0x1d2}, {0xa9f0, 0x1da}, {0xa9fa, 0x1d2},
+    {0xa9ff, 0x0}, {0xaa00, 0x432}, {0xaa37, 0x0}, {0xaa40, 0x432}, {0xaa4e, 0x0},
+    {0xaa50, 0x43a}, {0xaa5a, 0x0}, {0xaa5c, 0x434}, {0xaa60, 0x1d2}, {0xaa77, 0x1d0},
+    {0xaa7a, 0x1d2}, {0xaa80, 0x442}, {0xaac3, 0x0}, {0xaadb, 0x442}, {0xaade, 0x444},
+    {0xaae0, 0x452}, {0xaaf0, 0x454}, {0xaaf2, 0x452}, {0xaaf7, 0x0}, {0xab01, 0x202},
+    {0xab07, 0x0}, {0xab09, 0x202}, {0xab0f, 0x0}, {0xab11, 0x202}, {0xab17, 0x0},
+    {0xab20, 0x202}, {0xab27, 0x0}, {0xab28, 0x202}, {0xab2f, 0x0}, {0xab30, 0x22},
+    {0xab5b, 0x10}, {0xab5c, 0x22}, {0xab65, 0x52}, {0xab66, 0x2}, {0xab6a, 0x0},
+    {0xab70, 0x212}, {0xabc0, 0x452}, {0xabeb, 0x454}, {0xabec, 0x452}, {0xabee, 0x0},
+    {0xabf0, 0x45a}, {0xabfa, 0x0}, {0xac00, 0x1f2}, {0xd7a4, 0x0}, {0xd7b0, 0x1f2},
+    {0xd7c7, 0x0}, {0xd7cb, 0x1f2}, {0xd7fc, 0x0}, {0xf900, 0x382}, {0xfa6e, 0x0},
+    {0xfa70, 0x382}, {0xfada, 0x0}, {0xfb00, 0x22}, {0xfb07, 0x0}, {0xfb13, 0x82},
+    {0xfb18, 0x0}, {0xfb1d, 0x92}, {0xfb29, 0x90}, {0xfb2a, 0x92}, {0xfb37, 0x0},
+    {0xfb38, 0x92}, {0xfb3d, 0x0}, {0xfb3e, 0x92}, {0xfb3f, 0x0}, {0xfb40, 0x92},
+    {0xfb42, 0x0}, {0xfb43, 0x92}, {0xfb45, 0x0}, {0xfb46, 0x92}, {0xfb50, 0xa2},
+    {0xfbb2, 0xa0}, {0xfbc2, 0x0}, {0xfbd3, 0xa2}, {0xfd3e, 0x14}, {0xfd40, 0x0},
+    {0xfd50, 0xa2}, {0xfd90, 0x0}, {0xfd92, 0xa2}, {0xfdc8, 0x0}, {0xfdf0, 0xa2},
+    {0xfdfc, 0xa0}, {0xfdfe, 0x0}, {0xfe00, 0x42}, {0xfe10, 0x14}, {0xfe1a, 0x0},
+    {0xfe20, 0x42}, {0xfe2e, 0x72}, {0xfe30, 0x14}, {0xfe33, 0x16}, {0xfe35, 0x14},
+    {0xfe4d, 0x16}, {0xfe50, 0x14}, {0xfe53, 0x0}, {0xfe54, 0x14}, {0xfe62, 0x10},
+    {0xfe63, 0x14}, {0xfe64, 0x10}, {0xfe67, 0x0}, {0xfe68, 0x14}, {0xfe69, 0x10},
+    {0xfe6a, 0x14}, {0xfe6c, 0x0}, {0xfe70, 0xa2}, {0xfe75, 0x0}, {0xfe76, 0xa2},
+    {0xfefd, 0x0}, {0xfeff, 0x10}, {0xff00, 0x0}, {0xff01, 0x14}, {0xff04, 0x10},
+    {0xff05, 0x14}, {0xff0b, 0x10}, {0xff0c, 0x14}, {0xff10, 0x1a}, {0xff1a, 0x14},
+    {0xff1c, 0x10}, {0xff1f, 0x14}, {0xff21, 0x22}, {0xff3b, 0x14}, {0xff3e, 0x10},
+    {0xff3f, 0x16}, {0xff40, 0x10}, {0xff41, 0x22}, {0xff5b, 0x14}, {0xff5c, 0x10},
+    {0xff5d, 0x14}, {0xff5e, 0x10}, {0xff5f, 0x14}, {0xff66, 0x382}, {0xff70, 0x12},
+    {0xff71, 0x382}, {0xff9e, 0x12}, {0xffa0, 0x1f2}, {0xffbf, 0x0}, {0xffc2, 0x1f2},
+    {0xffc8, 0x0}, {0xffca, 0x1f2}, {0xffd0, 0x0}, {0xffd2, 0x1f2}, {0xffd8, 0x0},
+    {0xffda, 0x1f2}, {0xffdd, 0x0}, {0xffe0, 0x10}, {0xffe7, 0x0}, {0xffe8, 0x10},
+    {0xffef, 0x0}, {0xfff9, 0x10}, {0xfffe, 0x0}, {0x10000, 0x462}, {0x1000c, 0x0},
+    {0x1000d, 0x462}, {0x10027, 0x0}, {0x10028, 0x462}, {0x1003b, 0x0}, {0x1003c, 0x462},
+    {0x1003e, 0x0}, {0x1003f, 0x462}, {0x1004e, 0x0}, {0x10050, 0x462}, {0x1005e, 0x0},
+    {0x10080, 0x462}, {0x100fb, 0x0}, {0x10100, 0x14}, {0x10103, 0x0}, {0x10107, 0x18},
+    {0x10134, 0x0}, {0x10137, 0x10}, {0x10140, 0x5a}, {0x10175, 0x58}, {0x10179, 0x50},
+    {0x1018a, 0x58}, {0x1018c, 0x50}, {0x1018f, 0x0}, {0x10190, 0x10}, {0x1019c, 0x0},
+    {0x101a0, 0x50}, {0x101a1, 0x0}, {0x101d0, 0x10}, {0x101fd, 0x42}, {0x101fe, 0x0},
+    {0x10280, 0x472}, {0x1029d, 0x0}, {0x102a0, 0x482}, {0x102d1, 0x0}, {0x102e0, 0x42},
+    {0x102e1, 0x18}, {0x102fc, 0x0}, {0x10300, 0x492}, {0x10320, 0x498}, {0x10324, 0x0},
+    {0x1032d, 0x2}, {0x10330, 0x4a2}, {0x10341, 0x4aa}, {0x10342, 0x4a2}, {0x1034a, 0x4aa},
+    {0x1034b, 0x0}, {0x10350, 0x4b2}, {0x1037b, 0x0}, {0x10380, 0x4c2}, {0x1039e, 0x0},
+    {0x1039f, 0x4c4}, {0x103a0, 0x4d2}, {0x103c4, 0x0}, {0x103c8, 0x4d2}, {0x103d0, 0x4d4},
+    {0x103d1, 0x4da}, {0x103d6, 0x0}, {0x10400, 0x4e2}, {0x10450, 0x4f2}, {0x10480, 0x502},
+    {0x1049e, 0x0}, {0x104a0, 0x50a}, {0x104aa, 0x0}, {0x104b0, 0x512}, {0x104d4, 0x0},
+    {0x104d8, 0x512}, {0x104fc, 0x0}, {0x10500, 0x522}, {0x10528, 0x0}, {0x10530, 0x532},
+    {0x10564, 0x0}, {0x1056f, 0x534}, {0x10570, 0x2}, {0x1057b, 0x0}, {0x1057c, 0x2},
+    {0x1058b, 0x0}, {0x1058c, 0x2}, {0x10593, 0x0}, {0x10594, 0x2}, {0x10596, 0x0},
+    {0x10597, 0x2}, {0x105a2, 0x0}, {0x105a3, 0x2}, {0x105b2, 0x0}, {0x105b3, 0x2},
+    {0x105ba, 0x0}, {0x105bb, 0x2}, {0x105bd, 0x0}, {0x105c0, 0x2}, {0x105f4, 0x0},
+    {0x10600, 0x542}, {0x10737, 0x0}, {0x10740, 0x542}, {0x10756, 0x0}, {0x10760, 0x542},
+    {0x10768, 0x0}, {0x10780, 0x2}, {0x10786, 0x0}, {0x10787, 0x2}, {0x107b1, 0x0},
+    {0x107b2, 0x2}, {0x107bb, 0x0}, {0x10800, 0x552}, {0x10806, 0x0}, {0x10808, 0x552},
+    {0x10809, 0x0}, {0x1080a, 0x552}, {0x10836, 0x0}, {0x10837, 0x552}, {0x10839, 0x0},
+    {0x1083c, 0x552}, {0x1083d, 0x0}, {0x1083f, 0x552}, {0x10840, 0x562}, {0x10856, 0x0},
+    {0x10857, 0x564}, {0x10858, 0x568}, {0x10860, 0x572}, {0x10877, 0x570}, {0x10879, 0x578},
+    {0x10880, 0x582}, {0x1089f, 0x0}, {0x108a7, 0x588}, {0x108b0, 0x0}, {0x108e0, 0x592},
+    {0x108f3, 0x0}, {0x108f4, 0x592}, {0x108f6, 0x0}, {0x108fb, 0x598}, {0x10900, 0x5a2},
+    {0x10916, 0x5a8}, {0x1091c, 0x0}, {0x1091f, 0x5a4}, {0x10920, 0x5b2}, {0x1093a, 0x0},
+    {0x1093f, 0x5b4}, {0x10940, 0x0}, {0x10980, 0x5c2}, {0x109a0, 0x5d2}, {0x109b8, 0x0},
+    {0x109bc, 0x5d8}, {0x109be, 0x5d2}, {0x109c0, 0x5d8}, {0x109d0, 0x0}, {0x109d2, 0x5d8},
+    {0x10a00, 0x5e2}, {0x10a04, 0x0}, {0x10a05, 0x5e2}, {0x10a07, 0x0}, {0x10a0c, 0x5e2},
+    {0x10a14, 0x0}, {0x10a15, 0x5e2}, {0x10a18, 0x0}, {0x10a19, 0x5e2}, {0x10a34, 0x2},
+    {0x10a36, 0x0}, {0x10a38, 0x5e2}, {0x10a3b, 0x0}, {0x10a3f, 0x5e2}, {0x10a40, 0x5e8},
+    {0x10a48, 0x8}, {0x10a49, 0x0}, {0x10a50, 0x5e4}, {0x10a59, 0x0}, {0x10a60, 0x5f2},
+    {0x10a7d, 0x5f8}, {0x10a7f, 0x5f4}, {0x10a80, 0x602}, {0x10a9d, 0x608}, {0x10aa0, 0x0},
+    {0x10ac0, 0x612}, {0x10ac8, 0x610}, {0x10ac9, 0x612}, {0x10ae7, 0x0}, {0x10aeb, 0x618},
+    {0x10af0, 0x614}, {0x10af7, 0x0}, {0x10b00, 0x622}, {0x10b36, 0x0}, {0x10b39, 0x624},
+    {0x10b40, 0x632}, {0x10b56, 0x0}, {0x10b58, 0x638}, {0x10b60, 0x642}, {0x10b73, 0x0},
+    {0x10b78, 0x648}, {0x10b80, 0x652}, {0x10b92, 0x0}, {0x10b99, 0x654}, {0x10b9d, 0x0},
+    {0x10ba9, 0x658}, {0x10bb0, 0x0}, {0x10c00, 0x662}, {0x10c49, 0x0}, {0x10c80, 0x672},
+    {0x10cb3, 0x0}, {0x10cc0, 0x672}, {0x10cf3, 0x0}, {0x10cfa, 0x678}, {0x10d00, 0x2},
+    {0x10d28, 0x0}, {0x10d30, 0xa}, {0x10d3a, 0x0}, {0x10d40, 0xa}, {0x10d4a, 0x2},
+    {0x10d66, 0x0}, {0x10d69, 0x2}, {0x10d6e, 0x0}, {0x10d6f, 0x2}, {0x10d86, 0x0},
+    {0x10e60, 0xa8}, {0x10e7f, 0x0}, {0x10e80, 0x2}, {0x10eaa, 0x0}, {0x10eab, 0x2},
+    {0x10ead, 0x0}, {0x10eb0, 0x2}, {0x10eb2, 0x0}, {0x10ec2, 0x2}, {0x10ec5, 0x0},
+    {0x10efc, 0x2}, {0x10f1d, 0x8}, {0x10f27, 0x2}, {0x10f28, 0x0}, {0x10f30, 0x2},
+    {0x10f51, 0x8}, {0x10f55, 0x0}, {0x10f70, 0x2}, {0x10f86, 0x0}, {0x10fb0, 0x2},
+    {0x10fc5, 0x8}, {0x10fcc, 0x0}, {0x10fe0, 0x2}, {0x10ff7, 0x0}, {0x11000, 0x682},
+    {0x11047, 0x684}, {0x1104e, 0x0}, {0x11052, 0x688}, {0x11066, 0x68a}, {0x11070, 0x2},
+    {0x11076, 0x0}, {0x1107f, 0x682}, {0x11080, 0x692}, {0x110bb, 0x694}, {0x110bd, 0x690},
+    {0x110be, 0x694}, {0x110c2, 0x2}, {0x110c3, 0x0}, {0x110d0, 0x6a2}, {0x110e9, 0x0},
+    {0x110f0, 0x6aa}, {0x110fa, 0x0}, {0x11100, 0x6b2}, {0x11135, 0x0}, {0x11136, 0x6ba},
+    {0x11140, 0x6b4}, {0x11144, 0x2}, {0x11148, 0x0}, {0x11150, 0x6c2}, {0x11174, 0x6c4},
+    {0x11176, 0x6c2}, {0x11177, 0x0}, {0x11180, 0x6d2}, {0x111c5, 0x6d4}, {0x111c9, 0x6d6},
+    {0x111ca, 0x6d2}, {0x111cd, 0x6d4}, {0x111ce, 0x2}, {0x111d0, 0x6da}, {0x111da, 0x6d2},
+    {0x111db, 0x6d4}, {0x111dc, 0x6d2}, {0x111dd, 0x6d4}, {0x111e0, 0x0}, {0x111e1, 0x198},
+    {0x111f5, 0x0}, {0x11200, 0x6e2}, {0x11212, 0x0}, {0x11213, 0x6e2}, {0x11238, 0x6e4},
+    {0x1123e, 0x6e2}, {0x1123f, 0x2}, {0x11242, 0x0}, {0x11280, 0x6f2}, {0x11287, 0x0},
+    {0x11288, 0x6f2}, {0x11289, 0x0}, {0x1128a, 0x6f2}, {0x1128e, 0x0}, {0x1128f, 0x6f2},
+    {0x1129e, 0x0}, {0x1129f, 0x6f2}, {0x112a9, 0x6f4}, {0x112aa, 0x0}, {0x112b0, 0x702},
+    {0x112eb, 0x0}, {0x112f0, 0x70a}, {0x112fa, 0x0}, {0x11300, 0x712}, {0x11304, 0x0},
+    {0x11305, 0x712}, {0x1130d, 0x0}, {0x1130f, 0x712}, {0x11311, 0x0}, {0x11313, 0x712},
+    {0x11329, 0x0}, {0x1132a, 0x712}, {0x11331, 0x0}, {0x11332, 0x712}, {0x11334, 0x0},
+    {0x11335, 0x712}, {0x1133a, 0x0}, {0x1133b, 0x2}, {0x1133c, 0x712}, {0x11345, 0x0},
+    {0x11347, 0x712}, {0x11349, 0x0}, {0x1134b, 0x712}, {0x1134e, 0x0}, {0x11350, 0x712},
+    {0x11351, 0x0}, {0x11357, 0x712}, {0x11358, 0x0}, {0x1135d, 0x712}, {0x11364, 0x0},
+    {0x11366, 0x712}, {0x1136d, 0x0}, {0x11370, 0x712}, {0x11375, 0x0}, {0x11380, 0x2},
+    {0x1138a, 0x0}, {0x1138b, 0x2}, {0x1138c, 0x0}, {0x1138e, 0x2}, {0x1138f, 0x0},
+    {0x11390, 0x2}, {0x113b6, 0x0}, {0x113b7, 0x2}, {0x113c1, 0x0}, {0x113c2, 0x2},
+    {0x113c3, 0x0}, {0x113c5, 0x2}, {0x113c6, 0x0}, {0x113c7, 0x2}, {0x113cb, 0x0},
+    {0x113cc, 0x2}, {0x113d4, 0x0}, {0x113e1, 0x2}, {0x113e3, 0x0}, {0x11400, 0x722},
+    {0x1144b, 0x720}, {0x11450, 0x72a}, {0x1145a, 0x0}, {0x1145b, 0x720}, {0x1145c, 0x0},
+    {0x1145d, 0x720}, {0x1145e, 0x2}, {0x11462, 0x0}, {0x11480, 0x732}, {0x114c6, 0x734},
+    {0x114c7, 0x732}, {0x114c8, 0x0}, {0x114d0, 0x73a}, {0x114da, 0x0}, {0x11580, 0x742},
+    {0x115b6, 0x0}, {0x115b8, 0x742}, {0x115c1, 0x744}, {0x115d8, 0x742}, {0x115de, 0x0},
+    {0x11600, 0x752}, {0x11641, 0x754}, {0x11644, 0x752}, {0x11645, 0x0}, {0x11650, 0x75a},
+    {0x1165a, 0x0}, {0x11660, 0x2a0}, {0x1166d, 0x0}, {0x11680, 0x762}, {0x116b8, 0x2},
+    {0x116b9, 0x0}, {0x116c0, 0x76a}, {0x116ca, 0x0}, {0x116d0, 0xa}, {0x116e4, 0x0},
+    {0x11700, 0x772}, {0x1171a, 0x2}, {0x1171b, 0x0}, {0x1171d, 0x772}, {0x1172c, 0x0},
+    {0x11730, 0x77a}, {0x1173a, 0x778}, {0x1173c, 0x774}, {0x1173f, 0x770}, {0x11740, 0x2},
+    {0x11747, 0x0}, {0x11800, 0x2}, {0x1183b, 0x0}, {0x118a0, 0x782}, {0x118e0, 0x78a},
+    {0x118ea, 0x788}, {0x118f3, 0x0}, {0x118ff, 0x782}, {0x11900, 0x2}, {0x11907, 0x0},
+    {0x11909, 0x2}, {0x1190a, 0x0}, {0x1190c, 0x2}, {0x11914, 0x0}, {0x11915, 0x2},
+    {0x11917, 0x0}, {0x11918, 0x2}, {0x11936, 0x0}, {0x11937, 0x2}, {0x11939, 0x0},
+    {0x1193b, 0x2}, {0x11944, 0x0}, {0x11950, 0xa}, {0x1195a, 0x0}, {0x119a0, 0x2},
+    {0x119a8, 0x0}, {0x119aa, 0x2}, {0x119d8, 0x0}, {0x119da, 0x2}, {0x119e2, 0x0},
+    {0x119e3, 0x2}, {0x119e5, 0x0}, {0x11a00, 0x2}, {0x11a3f, 0x0}, {0x11a47, 0x2},
+    {0x11a48, 0x0}, {0x11a50, 0x2}, {0x11a9a, 0x0}, {0x11a9d, 0x2}, {0x11a9e, 0x0},
+    {0x11ab0, 0x2}, {0x11ac0, 0x792}, {0x11af9, 0x0}, {0x11bc0, 0x2}, {0x11be1, 0x0},
+    {0x11bf0, 0xa}, {0x11bfa, 0x0}, {0x11c00, 0x7a2}, {0x11c09, 0x0}, {0x11c0a, 0x7a2},
+    {0x11c37, 0x0}, {0x11c38, 0x7a2}, {0x11c41, 0x7a0}, {0x11c46, 0x0}, {0x11c50, 0x7aa},
+    {0x11c5a, 0x7a8}, {0x11c6d, 0x0}, {0x11c70, 0x7b0}, {0x11c72, 0x7b2}, {0x11c90, 0x0},
+    {0x11c92, 0x7b2}, {0x11ca8, 0x0}, {0x11ca9, 0x7b2}, {0x11cb7, 0x0}, {0x11d00, 0x2},
+    {0x11d07, 0x0}, {0x11d08, 0x2}, {0x11d0a, 0x0}, {0x11d0b, 0x2}, {0x11d37, 0x0},
+    {0x11d3a, 0x2}, {0x11d3b, 0x0}, {0x11d3c, 0x2}, {0x11d3e, 0x0}, {0x11d3f, 0x2},
+    {0x11d48, 0x0}, {0x11d50, 0xa}, {0x11d5a, 0x0}, {0x11d60, 0x2}, {0x11d66, 0x0},
+    {0x11d67, 0x2}, {0x11d69, 0x0}, {0x11d6a, 0x2}, {0x11d8f, 0x0}, {0x11d90, 0x2},
+    {0x11d92, 0x0}, {0x11d93, 0x2}, {0x11d99, 0x0}, {0x11da0, 0xa}, {0x11daa, 0x0},
+    {0x11de0, 0x8}, {0x11dea, 0x0}, {0x11ee0, 0x2}, {0x11ef7, 0x0}, {0x11f00, 0x2},
+    {0x11f11, 0x0}, {0x11f12, 0x2}, {0x11f3b, 0x0}, {0x11f3e, 0x2}, {0x11f43, 0x0},
+    {0x11f50, 0xa}, {0x11f5a, 0x2}, {0x11f5b, 0x0}, {0x11fb0, 0x2}, {0x11fb1, 0x0},
+    {0x11fc0, 0x8}, {0x11fd5, 0x0}, {0x12000, 0x7c2}, {0x1239a, 0x0}, {0x12400, 0x7ca},
+    {0x1246f, 0x0}, {0x12470, 0x7c4}, {0x12475, 0x0}, {0x12480, 0x7c2}, {0x12544, 0x0},
+    {0x12f90, 0x2}, {0x12ff1, 0x0}, {0x13000, 0x7d2}, {0x1342f, 0x2}, {0x13430, 0x0},
+    {0x13440, 0x2}, {0x13456, 0x0}, {0x13460, 0x2}, {0x143fb, 0x0}, {0x14400, 0x7e2},
+    {0x14647, 0x0}, {0x16100, 0x2}, {0x16130, 0xa}, {0x1613a, 0x0}, {0x16800, 0x3c2},
+    {0x16a39, 0x0}, {0x16a40, 0x7f2}, {0x16a5f, 0x0}, {0x16a60, 0x7fa}, {0x16a6a, 0x0},
+    {0x16a6e, 0x7f4}, {0x16a70, 0x2}, {0x16abf, 0x0}, {0x16ac0, 0xa}, {0x16aca, 0x0},
+    {0x16ad0, 0x802}, {0x16aee, 0x0}, {0x16af0, 0x802}, {0x16af5, 0x804}, {0x16af6, 0x0},
+    {0x16b00, 0x812}, {0x16b37, 0x814}, {0x16b3c, 0x810}, {0x16b40, 0x812}, {0x16b44, 0x814},
+    {0x16b45, 0x810}, {0x16b46, 0x0}, {0x16b50, 0x81a}, {0x16b5a, 0x0}, {0x16b5b, 0x818},
+    {0x16b62, 0x0}, {0x16b63, 0x812}, {0x16b78, 0x0}, {0x16b7d, 0x812}, {0x16b90, 0x0},
+    {0x16d40, 0x2}, {0x16d6d, 0x0}, {0x16d70, 0xa}, {0x16d7a, 0x0}, {0x16e40, 0x2},
+    {0x16e80, 0x8}, {0x16e97, 0x0}, {0x16f00, 0x822}, {0x16f45, 0x2}, {0x16f4b, 0x0},
+    {0x16f4f, 0x2}, {0x16f50, 0x822}, {0x16f7f, 0x2}, {0x16f88, 0x0}, {0x16f8f, 0x822},
+    {0x16fa0, 0x0}, {0x16fe0, 0x832}, {0x16fe1, 0x2}, {0x16fe2, 0x0}, {0x16fe3, 0x2},
+    {0x16fe5, 0x0}, {0x16ff0, 0x2}, {0x16ff2, 0x0}, {0x16ff4, 0x8}, {0x16ff7, 0x0},
+    {0x17000, 0x832}, {0x187ed, 0x2}, {0x187f8, 0x0}, {0x18800, 0x832}, {0x18af3, 0x2},
+    {0x18cd6, 0x0}, {0x18cff, 0x2}, {0x18d09, 0x0}, {0x1aff0, 0x2}, {0x1aff4, 0x0},
+    {0x1aff5, 0x2}, {0x1affc, 0x0}, {0x1affd, 0x2}, {0x1afff, 0x0}, {0x1b000, 0x382},
+    {0x1b002, 0x2}, {0x1b123, 0x0}, {0x1b132, 0x2}, {0x1b133, 0x0}, {0x1b150, 0x2},
+    {0x1b153, 0x0}, {0x1b155, 0x2}, {0x1b156, 0x0}, {0x1b164, 0x2}, {0x1b168, 0x0},
+    {0x1b170, 0x2}, {0x1b2fc, 0x0}, {0x1bc00, 0x842}, {0x1bc6b, 0x0}, {0x1bc70, 0x842},
+    {0x1bc7d, 0x0}, {0x1bc80, 0x842}, {0x1bc89, 0x0}, {0x1bc90, 0x842}, {0x1bc9a, 0x0},
+    {0x1bc9c, 0x840}, {0x1bc9d, 0x842}, {0x1bc9f, 0x844}, {0x1bca0, 0x10}, {0x1bca4, 0x0},
+    {0x1ccf0, 0xa}, {0x1ccfa, 0x0}, {0x1cf00, 0x2}, {0x1cf2e, 0x0}, {0x1cf30, 0x2},
+    {0x1cf47, 0x0}, {0x1d000, 0x10}, {0x1d0f6, 0x0}, {0x1d100, 0x10}, {0x1d127, 0x0},
+    {0x1d129, 0x10}, {0x1d165, 0x12}, {0x1d167, 0x42}, {0x1d16a, 0x10}, {0x1d16d, 0x12},
+    {0x1d173, 0x10}, {0x1d17b, 0x42}, {0x1d183, 0x10}, {0x1d185, 0x42}, {0x1d18c, 0x10},
+    {0x1d1aa, 0x42}, {0x1d1ae, 0x10}, {0x1d1e9, 0x0}, {0x1d200, 0x50}, {0x1d242, 0x52},
+    {0x1d245, 0x50}, {0x1d246, 0x0}, {0x1d2c0, 0x8}, {0x1d2d4, 0x0}, {0x1d2e0, 0x8},
+    {0x1d2f4, 0x0}, {0x1d300, 0x10}, {0x1d357, 0x0}, {0x1d360, 0x18}, {0x1d372, 0x8},
+    {0x1d379, 0x0}, {0x1d400, 0x12}, {0x1d455, 0x0}, {0x1d456, 0x12}, {0x1d49d, 0x0},
+    {0x1d49e, 0x12}, {0x1d4a0, 0x0}, {0x1d4a2, 0x12}, {0x1d4a3, 0x0}, {0x1d4a5, 0x12},
+    {0x1d4a7, 0x0}, {0x1d4a9, 0x12}, {0x1d4ad, 0x0}, {0x1d4ae, 0x12}, {0x1d4ba, 0x0},
+    {0x1d4bb, 0x12}, {0x1d4bc, 0x0}, {0x1d4bd, 0x12}, {0x1d4c4, 0x0}, {0x1d4c5, 0x12},
+    {0x1d506, 0x0}, {0x1d507, 0x12}, {0x1d50b, 0x0}, {0x1d50d, 0x12}, {0x1d515, 0x0},
+    {0x1d516, 0x12}, {0x1d51d, 0x0}, {0x1d51e, 0x12}, {0x1d53a, 0x0}, {0x1d53b, 0x12},
+    {0x1d53f, 0x0}, {0x1d540, 0x12}, {0x1d545, 0x0}, {0x1d546, 0x12}, {0x1d547, 0x0},
+    {0x1d54a, 0x12}, {0x1d551, 0x0}, {0x1d552, 0x12}, {0x1d6a6, 0x0}, {0x1d6a8, 0x12},
+    {0x1d6c1, 0x10}, {0x1d6c2, 0x12}, {0x1d6db, 0x10}, {0x1d6dc, 0x12}, {0x1d6fb, 0x10},
+    {0x1d6fc, 0x12}, {0x1d715, 0x10}, {0x1d716, 0x12}, {0x1d735, 0x10}, {0x1d736, 0x12},
+    {0x1d74f, 0x10}, {0x1d750, 0x12}, {0x1d76f, 0x10}, {0x1d770, 0x12}, {0x1d789, 0x10},
+    {0x1d78a, 0x12}, {0x1d7a9, 0x10}, {0x1d7aa, 0x12}, {0x1d7c3, 0x10}, {0x1d7c4, 0x12},
+    {0x1d7cc, 0x0}, {0x1d7ce, 0x1a}, {0x1d800, 0x850}, {0x1da00, 0x852}, {0x1da37, 0x850},
+    {0x1da3b, 0x852}, {0x1da6d, 0x850}, {0x1da75, 0x852}, {0x1da76, 0x850}, {0x1da84, 0x852},
+    {0x1da85, 0x850}, {0x1da87, 0x854}, {0x1da8c, 0x0}, {0x1da9b, 0x852}, {0x1daa0, 0x0},
+    {0x1daa1, 0x852}, {0x1dab0, 0x0}, {0x1df00, 0x2}, {0x1df1f, 0x0}, {0x1df25, 0x2},
+    {0x1df2b, 0x0}, {0x1e000, 0x362}, {0x1e007, 0x0}, {0x1e008, 0x362}, {0x1e019, 0x0},
+    {0x1e01b, 0x362}, {0x1e022, 0x0}, {0x1e023, 0x362}, {0x1e025, 0x0}, {0x1e026, 0x362},
+    {0x1e02b, 0x0}, {0x1e030, 0x2}, {0x1e06e, 0x0}, {0x1e08f, 0x2}, {0x1e090, 0x0},
+    {0x1e100, 0x2}, {0x1e12d, 0x0}, {0x1e130, 0x2}, {0x1e13e, 0x0}, {0x1e140, 0xa},
+    {0x1e14a, 0x0}, {0x1e14e, 0x2}, {0x1e14f, 0x0}, {0x1e290, 0x2}, {0x1e2af, 0x0},
+    {0x1e2c0, 0x2}, {0x1e2f0, 0xa}, {0x1e2fa, 0x0}, {0x1e4d0, 0x2}, {0x1e4f0, 0xa},
+    {0x1e4fa, 0x0}, {0x1e5d0, 0x2}, {0x1e5f1, 0xa}, {0x1e5fb, 0x0}, {0x1e7e0, 0x2},
+    {0x1e7e7, 0x0}, {0x1e7e8, 0x2}, {0x1e7ec, 0x0}, {0x1e7ed, 0x2}, {0x1e7ef, 0x0},
+    {0x1e7f0, 0x2}, {0x1e7ff, 0x0}, {0x1e800, 0x862}, {0x1e8c5, 0x0}, {0x1e8c7, 0x868},
+    {0x1e8d0, 0x862}, {0x1e8d7, 0x0}, {0x1e900, 0x872}, {0x1e94b, 0x2}, {0x1e94c, 0x0},
+    {0x1e950, 0x87a}, {0x1e95a, 0x0}, {0x1e95e, 0x870}, {0x1e960, 0x0}, {0x1ec71, 0x8},
+    {0x1ecac, 0x0}, {0x1ecad, 0x8}, {0x1ecb0, 0x0}, {0x1ecb1, 0x8}, {0x1ecb5, 0x0},
+    {0x1ed01, 0x8}, {0x1ed2e, 0x0}, {0x1ed2f, 0x8}, {0x1ed3e, 0x0}, {0x1ee00, 0xa2},
+    {0x1ee04, 0x0}, {0x1ee05, 0xa2}, {0x1ee20, 0x0}, {0x1ee21, 0xa2}, {0x1ee23, 0x0},
+    {0x1ee24, 0xa2}, {0x1ee25, 0x0}, {0x1ee27, 0xa2}, {0x1ee28, 0x0}, {0x1ee29, 0xa2},
+    {0x1ee33, 0x0}, {0x1ee34, 0xa2}, {0x1ee38, 0x0}, {0x1ee39, 0xa2}, {0x1ee3a, 0x0},
+    {0x1ee3b, 0xa2}, {0x1ee3c, 0x0}, {0x1ee42, 0xa2}, {0x1ee43, 0x0}, {0x1ee47, 0xa2},
+    {0x1ee48, 0x0}, {0x1ee49, 0xa2}, {0x1ee4a, 0x0}, {0x1ee4b, 0xa2}, {0x1ee4c, 0x0},
+    {0x1ee4d, 0xa2}, {0x1ee50, 0x0}, {0x1ee51, 0xa2}, {0x1ee53, 0x0}, {0x1ee54, 0xa2},
+    {0x1ee55, 0x0}, {0x1ee57, 0xa2}, {0x1ee58, 0x0}, {0x1ee59, 0xa2}, {0x1ee5a, 0x0},
+    {0x1ee5b, 0xa2}, {0x1ee5c, 0x0}, {0x1ee5d, 0xa2}, {0x1ee5e, 0x0}, {0x1ee5f, 0xa2},
+    {0x1ee60, 0x0}, {0x1ee61, 0xa2}, {0x1ee63, 0x0}, {0x1ee64, 0xa2}, {0x1ee65, 0x0},
+    {0x1ee67, 0xa2}, {0x1ee6b, 0x0}, {0x1ee6c, 0xa2}, {0x1ee73, 0x0}, {0x1ee74, 0xa2},
+    {0x1ee78, 0x0}, {0x1ee79, 0xa2}, {0x1ee7d, 0x0}, {0x1ee7e, 0xa2}, {0x1ee7f, 0x0},
+    {0x1ee80, 0xa2}, {0x1ee8a, 0x0}, {0x1ee8b, 0xa2}, {0x1ee9c, 0x0}, {0x1eea1, 0xa2},
+    {0x1eea4, 0x0}, {0x1eea5, 0xa2}, {0x1eeaa, 0x0}, {0x1eeab, 0xa2}, {0x1eebc, 0x0},
+    {0x1eef0, 0xa0}, {0x1eef2, 0x0}, {0x1f000, 0x10}, {0x1f02c, 0x0}, {0x1f030, 0x10},
+    {0x1f094, 0x0}, {0x1f0a0, 0x10}, {0x1f0af, 0x0}, {0x1f0b1, 0x10}, {0x1f0c0, 0x0},
+    {0x1f0c1, 0x10}, {0x1f0d0, 0x0}, {0x1f0d1, 0x10}, {0x1f0f6, 0x0}, {0x1f100, 0x18},
+    {0x1f10d, 0x0}, {0x1f110, 0x10}, {0x1f12f, 0x0}, {0x1f130, 0x12}, {0x1f14a, 0x10},
+    {0x1f150, 0x12}, {0x1f16a, 0x10}, {0x1f16c, 0x0}, {0x1f170, 0x12}, {0x1f18a, 0x10},
+    {0x1f1ad, 0x0}, {0x1f1e6, 0x10}, {0x1f200, 0x380}, {0x1f201, 0x10}, {0x1f203, 0x0},
+    {0x1f210, 0x10}, {0x1f23c, 0x0}, {0x1f240, 0x10}, {0x1f249, 0x0}, {0x1f250, 0x10},
+    {0x1f252, 0x0}, {0x1f300, 0x10}, {0x1f6d3, 0x0}, {0x1f6e0, 0x10}, {0x1f6ed, 0x0},
+    {0x1f6f0, 0x10}, {0x1f6f7, 0x0}, {0x1f700, 0x10}, {0x1f774, 0x0}, {0x1f780, 0x10},
+    {0x1f7d5, 0x0}, {0x1f800, 0x10}, {0x1f80c, 0x0}, {0x1f810, 0x10}, {0x1f848, 0x0},
+    {0x1f850, 0x10}, {0x1f85a, 0x0}, {0x1f860, 0x10}, {0x1f888, 0x0}, {0x1f890, 0x10},
+    {0x1f8ae, 0x0}, {0x1f910, 0x10}, {0x1f91f, 0x0}, {0x1f920, 0x10}, {0x1f928, 0x0},
+    {0x1f930, 0x10}, {0x1f931, 0x0}, {0x1f933, 0x10}, {0x1f93f, 0x0}, {0x1f940, 0x10},
+    {0x1f94c, 0x0}, {0x1f950, 0x10}, {0x1f95f, 0x0}, {0x1f980, 0x10}, {0x1f992, 0x0},
+    {0x1f9c0, 0x10}, {0x1f9c1, 0x0}, {0x1fbf0, 0xa}, {0x1fbfa, 0x0}, {0x20000, 0x382},
+    {0x2a6d7, 0x2}, {0x2a6e0, 0x0}, {0x2a700, 0x382}, {0x2b735, 0x2}, {0x2b73a, 0x0},
+    {0x2b740, 0x382}, {0x2b81e, 0x0}, {0x2b820, 0x382}, {0x2cea2, 0x0}, {0x2ceb0, 0x2},
+    {0x2ebe1, 0x0}, {0x2ebf0, 0x2}, {0x2ee5e, 0x0}, {0x2f800, 0x382}, {0x2fa1e, 0x0},
+    {0x30000, 0x2}, {0x3134b, 0x0}, {0x31350, 0x2}, {0x323b0, 0x0}, {0xe0001, 0x10},
+    {0xe0002, 0x0}, {0xe0020, 0x10}, {0xe0080, 0x0}, {0xe0100, 0x42}, {0xe01f0, 0x0},
+};
+// clang-format on
+
+} // namespace
+
+const CodepointTable& CodepointTable::get() {
+  static const CodepointTable table;
+  return table;
+}
+
+CodepointTable::CodepointTable() {
+  constexpr uint32_t kBlocks = 0x110000 >> 8;
+  blocks_.resize(kBlocks);
+  std::vector<uint16_t> block(256);
+  std::map<std::vector<uint16_t>, uint16_t> indices;
+  const Run* run = std::begin(kRuns);
+  for (uint32_t b = 0; b < kBlocks; ++b) {
+    const uint32_t block_end = (b + 1) << 8;
+    for (uint32_t cp = b << 8; cp < block_end;) {
+      while (run + 1 != std::end(kRuns) && run[1].start <= cp) {
+        ++run;
+      }
+      const uint32_t run_end =
+          run + 1 != std::end(kRuns) ? run[1].start : 0x110000;
+      const uint32_t fill_end = std::min(run_end, block_end);
+      std::fill(
+          block.begin() + (cp & 0xff),
+          block.begin() + (fill_end - (b << 8)),
+          run->value);
+      cp = fill_end;
+    }
+    // Blocks that repeat an earlier one share its values.
+    auto it = indices.find(block);
+    if (it == indices.end()) {
+      it = indices.emplace(block, indices.size()).first;
+      values_.insert(values_.end(), block.begin(), block.end());
+    }
+    blocks_[b] = it->second;
+  }
+}
+
+uint32_t CodepointTable::decode_multibyte(
+    const std::string& text,
+    std::size_t pos,
+    std::size_t end,
+    std::size_t& length) {
+  constexpr uint32_t kReplacement = 0xfffd;
+  const uint8_t lead = static_cast<uint8_t>(text[pos]);
+  length = 1;
+  std::size_t size = 0;
+  uint32_t cp = 0;
+  uint32_t min = 0;
+  if ((lead & 0xe0) == 0xc0) {
+    size = 2;
+    cp = lead & 0x1f;
+    min = 0x80;
+  } else if ((lead & 0xf0) == 0xe0) {
+    size = 3;
+    cp = lead & 0x0f;
+    min = 0x800;
+  } else if ((lead & 0xf8) == 0xf0) {
+    size = 4;
+    cp = lead & 0x07;
+    min = 0x10000;
+  } else {
+    return kReplacement;
+  }
+  if (size > end - pos) {
+    return kReplacement;
+  }
+  for (std::size_t i = 1; i < size; ++i) {
+    const uint8_t byte = static_cast<uint8_t>(text[pos + i]);
+    if ((byte & 0xc0) != 0x80) {
+      return kReplacement;
+    }
+    cp = (cp << 6) | (byte & 0x3f);
+  }
+  if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+    return kReplacement;
+  }
+  length = size;
+  return cp;
+}
+
+} // namespace detail
+} // namespace tokenizers
@@ -0,0 +1,1317 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <pytorch/tokenizers/dfa_regex.h>
+
+// Standard
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// Third Party
+#include <re2/re2.h>
+
+namespace tokenizers {
+
+namespace {
+
+// Inclusive codepoint ranges.
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+constexpr uint32_t kMaxCodepoint = 0x10ffff;
+constexpr int kMaxRepeat = 1000;
+constexpr int kMaxNesting = 256;
+constexpr std::size_t kMaxNfaStates = 1 << 20;
+
+// Values of accepting forward DFA states, by whether the match started at
+// the first byte of the search.
+constexpr uint8_t kMatch = 1;
+constexpr uint8_t kLaterMatch = 2;
+
+// Codepoint sets //////////////////////////////////////////////////////////////
+
+// Sorts the ranges and merges the ones that overlap or touch.
+Ranges normalized(Ranges ranges) {
+  std::sort(ranges.begin(), ranges.end());
+  Ranges result;
+  for (const auto& range : ranges) {
+    if (!result.empty() && range.first <= result.back().second + 1) {
+      result.back().second = std::max(result.back().second, range.second);
+    } else {
+      result.push_back(range);
+    }
+  }
+  return result;
+}
+
+Ranges complement(const Ranges& ranges) {
+  Ranges result;
+  uint32_t next = 0;
+  for (const auto& [lo, hi] : normalized(ranges)) {
+    if (lo > next) {
+      result.emplace_back(next, lo - 1);
+    }
+    next = hi + 1;
+  }
+  if (next <= kMaxCodepoint) {
+    result.emplace_back(next, kMaxCodepoint);
+  }
+  return result;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xc0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xe0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  } else {
+    out += static_cast<char>(0xf0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  }
+}
+
+// Decodes the UTF-8 character at data, which must be valid, and returns its
+// length in bytes.
+std::size_t decode_utf8(const char* data, uint32_t* cp) {
+  const auto byte = [&](std::size_t i) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(data[i]));
+  };
+  if (byte(0) < 0x80) {
+    *cp = byte(0);
+    return 1;
+  }
+  if (byte(0) < 0xe0) {
+    *cp = ((byte(0) & 0x1f) << 6) | (byte(1) & 0x3f);
+    return 2;
+  }
+  if (byte(0) < 0xf0) {
+    *cp = ((byte(0) & 0x0f) << 12) | ((byte(1) & 0x3f) << 6) | (byte(2) & 0x3f);
+    return 3;
+  }
+  *cp = ((byte(0) & 0x07) << 18) | ((byte(1) & 0x3f) << 12) |
+      ((byte(2) & 0x3f) << 6) | (byte(3) & 0x3f);
+  return 4;
+}
+
+// The codepoints in [lo, hi] in increasing order, encoded as UTF-8. This is
+// built for every probe rather than kept, since all of them take 4 MB.
+std::string codepoint_text(uint32_t lo, uint32_t hi) {
+  std::string result;
+  for (uint32_t cp = lo; cp <= hi; ++cp) {
+    if (cp < 0xd800 || cp > 0xdfff) {
+      append_utf8(result, cp);
+    }
+  }
+  return result;
+}
+
+// Returns the codepoints of the UTF-8 text in [begin, end) as a range.
+std::pair<uint32_t, uint32_t>
+text_range(const std::string& text, std::size_t begin, std::size_t end) {
+  std::size_t last = end - 1;
+  while ((static_cast<uint8_t>(text[last]) & 0xc0) == 0x80) {
+    --last;
+  }
+  uint32_t first_cp = 0;
+  uint32_t last_cp = 0;
+  decode_utf8(text.data() + begin, &first_cp);
+  decode_utf8(text.data() + last, &last_cp);
+  return {first_cp, last_cp};
+}
+
+// Appends the ranges of the codepoints in [lo, hi] that the regex for a class
+// matches, given the regex for its complement. The runs of the two tile the
+// codepoints, so anchored matches of one and then the other find them all in
+// a single pass.
+void probe_runs(
+    const re2::RE2& re,
+    const re2::RE2& complement_re,
+    uint32_t lo,
+    uint32_t hi,
+    Ranges& ranges) {
+  const std::string text = codepoint_text(lo, hi);
+  re2::StringPiece input(text);
+  while (!input.empty()) {
+    const std::size_t begin = input.data() - text.data();
+    if (re2::RE2::Consume(&input, re)) {
+      ranges.push_back(text_range(text, begin, input.data() - text.data()));
+    } else if (!re2::RE2::Consume(&input, complement_re)) {
+      break;
+    }
+  }
+}
+
+// Returns the codepoints of \p{name} according to RE2, by running it over the
+// codepoints. Only the planes with assigned characters are scanned, except
+// for the other (C) categories, which include private use and unassigned
+// codepoints.
+Result<Ranges> unicode_class(const std::string& name) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, Ranges> cache;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = cache.find(name);
+    if (it != cache.end()) {
+      return it->second;
+    }
+  }
+
+  Ranges ranges;
+  if (name == "Any") {
+    ranges.emplace_back(0, kMaxCodepoint);
+  } else {
+    const re2::RE2 re("\\p{" + name + "}+", re2::RE2::Quiet);
+    const re2::RE2 complement_re("\\P{" + name + "}+", re2::RE2::Quiet);
+    if (!re.ok() || !complement_re.ok()) {
+      TK_LOG(Info, "Unknown Unicode class %s", name.c_str());
+      return Error::RegexFailure;
+    }
+    if (name[0] == 'C') {
+      probe_runs(re, complement_re, 0, kMaxCodepoint, ranges);
+    } else {
+      probe_runs(re, complement_re, 0, 0x3ffff, ranges);
+      probe_runs(re, complement_re, 0xe0000, 0xeffff, ranges);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  cache.emplace(name, ranges);
+  return ranges;
+}
+
+// Returns the codepoints that a single character regex matches according to
+// RE2. This scans all codepoints with submatches, which is slow, so it is
+// only used for the case folding of non-ASCII characters and classes.
+Result<Ranges> probe_class(const std::string& regex) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, Ranges> cache;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = cache.find(regex);
+    if (it != cache.end()) {
+      return it->second;
+    }
+  }
+
+  const re2::RE2 re("(?:" + regex + ")+", re2::RE2::Quiet);
+  if (!re.ok()) {
+    TK_LOG(Info, "Invalid character class %s", regex.c_str());
+    return Error::RegexFailure;
+  }
+  const std::string text = codepoint_text(0, kMaxCodepoint);
+  Ranges ranges;
+  re2::StringPiece match;
+  std::size_t pos = 0;
+  while (pos < text.size() &&
+         re.Match(text, pos, text.size(), re2::RE2::UNANCHORED, &match, 1) &&
+         !match.empty()) {
+    const std::size_t start = match.data() - text.data();
+    const std::size_t end = start + match.size();
+    ranges.push_back(text_range(text, start, end));
+    pos = end;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  cache.emplace(regex, ranges);
+  return ranges;
+}
+
+// The ASCII classes of RE2.
+const Ranges kDigits = {{'0', '9'}};
+const Ranges kSpaces = {{'\t', '\n'}, {'\f', '\r'}, {' ', ' '}};
+const Ranges kWordCharacters = {{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}};
+
+const std::map<std::string, Ranges>& posix_classes() {
+  static const std::map<std::string, Ranges> classes = {
+      {"alnum", {{'0', '9'}, {'A', 'Z'}, {'a', 'z'}}},
+      {"alpha", {{'A', 'Z'}, {'a', 'z'}}},
+      {"ascii", {{0, 0x7f}}},
+      {"blank", {{'\t', '\t'}, {' ', ' '}}},
+      {"cntrl", {{0, 0x1f}, {0x7f, 0x7f}}},
+      {"digit", kDigits},
+      {"graph", {{'!', '~'}}},
+      {"lower", {{'a', 'z'}}},
+      {"print", {{' ', '~'}}},
+      {"punct", {{'!', '/'}, {':', '@'}, {'[', '`'}, {'{', '~'}}},
+      {"space", {{'\t', '\r'}, {' ', ' '}}},
+      {"upper", {{'A', 'Z'}}},
+      {"word", kWordCharacters},
+      {"xdigit", {{'0', '9'}, {'A', 'F'}, {'a', 'f'}}},
+  };
+  return classes;
+}
+
+// Pattern parsing /////////////////////////////////////////////////////////////
+
+struct Node {
+  enum class Kind { Empty, Class, Concat, Alternate, Repeat };
+
+  Kind kind = Kind::Empty;
+  // Class
+  Ranges ranges;
+  // Concat, Alternate, and the repeated node of Repeat
+  std::vector<std::unique_ptr<Node>> children;
+  // Repeat, max is -1 if unbounded
+  int min = 0;
+  int max = 0;
+  bool greedy = true;
+};
+
+class Parser {
+ public:
+  explicit Parser(const std::string& pattern) : pattern_(pattern) {}
+
+  Result<std::unique_ptr<Node>> parse() {
+    Flags flags;
+    auto node = TK_UNWRAP(parse_alternation(flags, 0));
+    if (pos_ != pattern_.size()) {
+      return unsupported("an unmatched )");
+    }
+    return node;
+  }
+
+ private:
+  struct Flags {
+    bool ignore_case = false;
+    bool dot_all = false;
+  };
+
+  Error unsupported(const char* what) const {
+    TK_LOG(
+        Info,
+        "DFA regex does not support %s at offset %zu of %s",
+        what,
+        pos_,
+        pattern_.c_str());
+    return Error::RegexFailure;
+  }
+
+  bool at(char c) const {
+    return pos_ < pattern_.size() && pattern_[pos_] == c;
+  }
+
+  bool consume(const char* prefix) {
+    const std::size_t length = std::char_traits<char>::length(prefix);
+    if (pattern_.compare(pos_, length, prefix) == 0) {
+      pos_ += length;
+      return true;
+    }
+    return false;
+  }
+
+  Result<std::unique_ptr<Node>> parse_alternation(Flags flags, int depth) {
+    if (depth > kMaxNesting) {
+      return unsupported("this much nesting");
+    }
+    std::vector<std::unique_ptr<Node>> alternatives;
+    while (true) {
+      alternatives.push_back(TK_UNWRAP(parse_concatenation(flags, depth)));
+      if (!at('|')) {
+        break;
+      }
+      ++pos_;
+    }
+    if (alternatives.size() == 1) {
+      return std::move(alternatives[0]);
+    }
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::Alternate;
+    node->children = std::move(alternatives);
+    return node;
+  }
+
+  // Flags set by (?i) and the like last until the end of the enclosing group,
+  // so they are shared by the alternatives that follow.
+  Result<std::unique_ptr<Node>> parse_concatenation(Flags& flags, int depth) {
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::Concat;
+    while (pos_ < pattern_.size() && !at('|') && !at(')')) {
+      auto atom = TK_UNWRAP(parse_atom(flags, depth));
+      if (!atom) {
+        // A flag group like (?i), which cannot be repeated.
+        if (at('*') || at('+') || at('?')) {
+          return unsupported("a repeated flag group");
+        }
+        continue;
+      }
+      node->children.push_back(TK_UNWRAP(parse_repeats(std::move(atom))));
+    }
+    if (node->children.size() == 1) {
+      return std::move(node->children[0]);
+    }
+    return node;
+  }
+
+  Result<std::unique_ptr<Node>> parse_repeats(std::unique_ptr<Node> atom) {
+    bool repeated = false;
+    while (pos_ < pattern_.size()) {
+      int min = 0;
+      int max = 0;
+      if (consume("*")) {
+        max = -1;
+      } else if (consume("+")) {
+        min = 1;
+        max = -1;
+      } else if (consume("?")) {
+        max = 1;
+      } else if (!parse_braces(&min, &max)) {
+        break;
+      }
+      if (repeated) {
+        return unsupported("a repeated repetition");
+      }
+      repeated = true;
+      auto node = std::make_unique<Node>();
+      node->kind = Node::Kind::Repeat;
+      node->min = min;
+      node->max = max;
+      node->greedy = !consume("?");
+      node->children.push_back(std::move(atom));
+      atom = std::move(node);
+    }
+    return atom;
+  }
+
+  // Parses {n}, {n,} or {n,m}. Anything else is not a repetition, and the
+  // brace is a literal.
+  bool parse_braces(int* min, int* max) {
+    if (!at('{')) {
+      return false;
+    }
+    std::size_t pos = pos_ + 1;
+    const auto number = [&](int* value) {
+      const std::size_t start = pos;
+      *value = 0;
+      while (pos < pattern_.size() && pattern_[pos] >= '0' &&
+             pattern_[pos] <= '9' && pos - start < 5) {
+        *value = *value * 10 + (pattern_[pos++] - '0');
+      }
+      return pos > start;
+    };
+    if (!number(min)) {
+      return false;
+    }
+    *max = *min;
+    if (pos < pattern_.size() && pattern_[pos] == ',') {
+      ++pos;
+      if (pos < pattern_.size() && pattern_[pos] == '}') {
+        *max = -1;
+      } else if (!number(max)) {
+        return false;
+      }
+    }
+    if (pos >= pattern_.size() || pattern_[pos] != '}' || *min > kMaxRepeat ||
+        *max > kMaxRepeat || (*max != -1 && *max < *min)) {
+      return false;
+    }
+    pos_ = pos + 1;
+    return true;
+  }
+
+  // Returns nullptr for a group that only sets flags.
+  Result<std::unique_ptr<Node>> parse_atom(Flags& flags, int depth) {
+    const std::size_t start = pos_;
+    switch (pattern_[pos_]) {
+      case '(':
+        return parse_group(flags, depth);
+      case '[': {
+        auto ranges = TK_UNWRAP(parse_class());
+        return class_node(TK_UNWRAP(fold(std::move(ranges), start, flags)));
+      }
+      case '\\': {
+        auto ranges = TK_UNWRAP(parse_escape(nullptr));
+        return class_node(TK_UNWRAP(fold(std::move(ranges), start, flags)));
+      }
+      case '.':
+        ++pos_;
+        return class_node(
+            flags.dot_all ? Ranges{{0, kMaxCodepoint}}
+                          : complement({{'\n', '\n'}}));
+      case '^':
+      case '$':
+        return unsupported("anchors");
+      case '*':
+      case '+':
+      case '?':
+        return unsupported("a repetition of nothing");
+      default: {
+        const uint32_t cp = TK_UNWRAP(parse_literal());
+        return class_node(TK_UNWRAP(fold({{cp, cp}}, start, flags)));
+      }
+    }
+  }
+
+  Result<std::unique_ptr<Node>> parse_group(Flags& flags, int depth) {
+    ++pos_;
+    Flags group_flags = flags;
+    if (consume("?")) {
+      if (at('=') || at('!') || consume("<=") || consume("<!")) {
+        return unsupported("lookaround");
+      }
+      if (consume("P<") || consume("<")) {
+        // Named capture, which is a plain group here.
+        while (pos_ < pattern_.size() && pattern_[pos_] != '>') {
+          ++pos_;
+        }
+        if (!consume(">")) {
+          return unsupported("an unterminated group name");
+        }
+      } else {
+        bool negated = false;
+        while (pos_ < pattern_.size() && !at(':') && !at(')')) {
+          const char flag = pattern_[pos_];
+          if (flag == '-' && !negated) {
+            negated = true;
+          } else if (flag == 'i') {
+            group_flags.ignore_case = !negated;
+          } else if (flag == 's') {
+            group_flags.dot_all = !negated;
+          } else if (flag != 'm') {
+            // m only changes anchors, which are not supported anyway.
+            return unsupported("this flag");
+          }
+          ++pos_;
+        }
+        if (consume(")")) {
+          flags = group_flags;
+          return std::unique_ptr<Node>();
+        }
+        if (!consume(":")) {
+          return unsupported("an unterminated group");
+        }
+      }
+    }
+    auto node = TK_UNWRAP(parse_alternation(group_flags, depth + 1));
+    if (!consume(")")) {
+      return unsupported("an unterminated group");
+    }
+    return node;
+  }
+
+  // Parses a character, which may be multibyte.
+  Result<uint32_t> parse_literal() {
+    uint32_t cp = 0;
+    const std::size_t length = decode_utf8(pattern_.data() + pos_, &cp);
+    if (pos_ + length > pattern_.size()) {
+      return unsupported("invalid UTF-8");
+    }
+    pos_ += length;
+    return cp;
+  }
+
+  // Parses the escape sequence at pos_. Sets *literal to whether it stands
+  // for a single character.
+  Result<Ranges> parse_escape(bool* literal) {
+    ++pos_;
+    if (pos_ >= pattern_.size()) {
+      return unsupported("a trailing backslash");
+    }
+    if (literal) {
+      *literal = false;
+    }
+    const char c = pattern_[pos_++];
+    switch (c) {
+      case 'd':
+        return kDigits;
+      case 'D':
+        return complement(kDigits);
+      case 's':
+        return kSpaces;
+      case 'S':
+        return complement(kSpaces);
+      case 'w':
+        return kWordCharacters;
+      case 'W':
+        return complement(kWordCharacters);
+      case 'p':
+      case 'P': {
+        std::string name;
+        if (consume("{")) {
+          const std::size_t end = pattern_.find('}', pos_);
+          if (end == std::string::npos) {
+            return unsupported("an unterminated Unicode class");
+          }
+          name = pattern_.substr(pos_, end - pos_);
+          pos_ = end + 1;
+        } else if (pos_ < pattern_.size()) {
+          name = pattern_.substr(pos_++, 1);
+        }
+        bool negated = c == 'P';
+        if (!name.empty() && name[0] == '^') {
+          negated = !negated;
+          name.erase(0, 1);
+        }
+        if (name.empty()) {
+          return unsupported("an empty Unicode class");
+        }
+        const auto ranges = TK_UNWRAP(unicode_class(name));
+        return negated ? complement(ranges) : ranges;
+      }
+      default:
+        break;
+    }
+
+    if (literal) {
+      *literal = true;
+    }
+    uint32_t cp = 0;
+    switch (c) {
+      case 'a':
+        cp = '\a';
+        break;
+      case 'f':
+        cp = '\f';
+        break;
+      case 'n':
+        cp = '\n';
+        break;
+      case 'r':
+        cp = '\r';
+        break;
+      case 't':
+        cp = '\t';
+        break;
+      case 'v':
+        cp = '\v';
+        break;
+      case 'x':
+        cp = TK_UNWRAP(parse_hex());
+        break;
+      default:
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+            (c >= 'A' && c <= 'Z')) {
+          return unsupported("this escape");
+        }
+        --pos_;
+        cp = TK_UNWRAP(parse_literal());
+    }
+    return Ranges{{cp, cp}};
+  }
+
+  // Parses the digits of \xHH or \x{H...}.
+  Result<uint32_t> parse_hex() {
+    const bool braced = consume("{");
+    uint32_t cp = 0;
+    std::size_t digits = 0;
+    while (pos_ < pattern_.size() && (braced || digits < 2)) {
+      const char c = pattern_[pos_];
+      uint32_t value = 0;
+      if (c >= '0' && c <= '9') {
+        value = c - '0';
+      } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+        value = (c | 0x20) - 'a' + 10;
+      } else {
+        break;
+      }
+      cp = cp * 16 + value;
+      ++digits;
+      ++pos_;
+      if (cp > kMaxCodepoint) {
+        return unsupported("a codepoint out of range");
+      }
+    }
+    if (digits == 0 || (!braced && digits != 2) || (braced && !consume("}"))) {
+      return unsupported("a malformed \\x escape");
+    }
+    return cp;
+  }
+
+  Result<Ranges> parse_class() {
+    ++pos_;
+    const bool negated = consume("^");
+    Ranges ranges;
+    bool first = true;
+    while (pos_ < pattern_.size() && (first || !at(']'))) {
+      first = false;
+      if (consume("[:")) {
+        const std::size_t end = pattern_.find(":]", pos_);
+        if (end == std::string::npos) {
+          return unsupported("an unterminated character class");
+        }
+        std::string name = pattern_.substr(pos_, end - pos_);
+        pos_ = end + 2;
+        const bool negated_posix = !name.empty() && name[0] == '^';
+        if (negated_posix) {
+          name.erase(0, 1);
+        }
+        const auto it = posix_classes().find(name);
+        if (it == posix_classes().end()) {
+          return unsupported("this POSIX class");
+        }
+        const auto posix =
+            negated_posix ? complement(it->second) : it->second;
+        ranges.insert(ranges.end(), posix.begin(), posix.end());
+        continue;
+      }
+      bool literal = true;
+      auto item = TK_UNWRAP(parse_class_item(&literal));
+      if (literal && at('-') && pos_ + 1 < pattern_.size() &&
+          pattern_[pos_ + 1] != ']') {
+        ++pos_;
+        bool hi_literal = true;
+        const auto hi = TK_UNWRAP(parse_class_item(&hi_literal));
+        if (!hi_literal || hi[0].first < item[0].first) {
+          return unsupported("this character range");
+        }
+        item[0].second = hi[0].first;
+      }
+      ranges.insert(ranges.end(), item.begin(), item.end());
+    }
+    if (!consume("]")) {
+      return unsupported("an unterminated character class");
+    }
+    return negated ? complement(ranges) : normalized(std::move(ranges));
+  }
+
+  // Parses a character or an escape in a character class.
+  Result<Ranges> parse_class_item(bool* literal) {
+    if (at('\\')) {
+      return parse_escape(literal);
+    }
+    *literal = true;
+    const uint32_t cp = TK_UNWRAP(parse_literal());
+    return Ranges{{cp, cp}};
+  }
+
+  // Applies case folding to the characters of the atom that starts at start
+  // and ends at pos_. The simple case folding of ASCII is applied here, RE2
+  // is asked about anything else.
+  Result<Ranges> fold(Ranges ranges, std::size_t start, const Flags& flags) {
+    if (!flags.ignore_case) {
+      return ranges;
+    }
+    if (!ranges.empty() && ranges.back().second >= 0x80) {
+      return probe_class(
+          "(?i:" + pattern_.substr(start, pos_ - start) + ")");
+    }
+    Ranges folded = ranges;
+    for (const auto& [lo, hi] : ranges) {
+      for (uint32_t c = lo; c <= hi; ++c) {
+        const uint32_t lower = c | 0x20;
+        if (lower < 'a' || lower > 'z') {
+          continue;
+        }
+        folded.emplace_back(lower, lower);
+        folded.emplace_back(lower - 0x20, lower - 0x20);
+        // The Kelvin sign and the long s fold to ASCII letters.
+        if (lower == 'k') {
+          folded.emplace_back(0x212a, 0x212a);
+        } else if (lower == 's') {
+          folded.emplace_back(0x17f, 0x17f);
+        }
+      }
+    }
+    return normalized(std::move(folded));
+  }
+
+  static std::unique_ptr<Node> class_node(Ranges ranges) {
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::Class;
+    node->ranges = std::move(ranges);
+    return node;
+  }
+
+  const std::string& pattern_;
+  std::size_t pos_ = 0;
+};
+
+// NFA construction ////////////////////////////////////////////////////////////
+
+struct NfaState {
+  enum class Kind : uint8_t { Bytes, Split, Match };
+
+  Kind kind = Kind::Match;
+  // Bytes
+  uint8_t lo = 0;
+  uint8_t hi = 0;
+  // Bytes, and the preferred branch of Split
+  uint32_t out = 0;
+  // Split
+  uint32_t out1 = 0;
+  // Match, the value of the accepting DFA states that it is reached in
+  uint8_t accept = kMatch;
+};
+
+using ByteRanges = std::vector<std::pair<uint8_t, uint8_t>>;
+
+// Appends the byte range sequences that encode the codepoints in [lo, hi] as
+// UTF-8. Every sequence matches exactly the encodings of a subrange.
+void utf8_sequences(uint32_t lo, uint32_t hi, std::vector<ByteRanges>& out) {
+  if (lo > hi) {
+    return;
+  }
+  // Surrogates have no encoding.
+  if (lo <= 0xdfff && hi >= 0xd800) {
+    if (lo < 0xd800) {
+      utf8_sequences(lo, 0xd7ff, out);
+    }
+    if (hi > 0xdfff) {
+      utf8_sequences(0xe000, hi, out);
+    }
+    return;
+  }
+  // Split by encoded length.
+  for (const uint32_t limit : {0x7fu, 0x7ffu, 0xffffu}) {
+    if (lo <= limit && hi > limit) {
+      utf8_sequences(lo, limit, out);
+      utf8_sequences(limit + 1, hi, out);
+      return;
+    }
+  }
+  // Split until the continuation bytes of the two ends cover full ranges.
+  for (int i = 1; i < 4; ++i) {
+    const uint32_t mask = (1u << (6 * i)) - 1;
+    if ((lo & ~mask) != (hi & ~mask)) {
+      if ((lo & mask) != 0) {
+        utf8_sequences(lo, lo | mask, out);
+        utf8_sequences((lo | mask) + 1, hi, out);
+        return;
+      }
+      if ((hi & mask) != mask) {
+        utf8_sequences(lo, (hi & ~mask) - 1, out);
+        utf8_sequences(hi & ~mask, hi, out);
+        return;
+      }
+    }
+  }
+  std::string first;
+  std::string last;
+  append_utf8(first, lo);
+  append_utf8(last, hi);
+  ByteRanges sequence;
+  for (std::size_t i = 0; i < first.size(); ++i) {
+    sequence.emplace_back(
+        static_cast<uint8_t>(first[i]), static_cast<uint8_t>(last[i]));
+  }
+  out.push_back(std::move(sequence));
+}
+
+class NfaBuilder {
+ public:
+  // The match state is state 0. A reverse NFA matches the reversed bytes of
+  // what the pattern matches.
+  explicit NfaBuilder(bool reverse) : reverse_(reverse), states_(1) {}
+
+  // Returns the start of an NFA for the pattern that continues at the match
+  // state given.
+  Result<uint32_t> build(const Node& root, uint32_t match = 0) {
+    const auto start = compile(root, match);
+    if (states_.size() > kMaxNfaStates) {
+      TK_LOG(Info, "DFA regex pattern is too large");
+      return Error::RegexFailure;
+    }
+    return start;
+  }
+
+  uint32_t add_match(uint8_t accept) {
+    NfaState state;
+    state.kind = NfaState::Kind::Match;
+    state.accept = accept;
+    return add(state);
+  }
+
+  // Returns a start from which the NFA at first begins at the first byte and
+  // the one at later at any byte after it, with a lower priority the later
+  // it begins, like a .*? prefix.
+  uint32_t unanchored(uint32_t first, uint32_t later) {
+    const uint32_t loop = add_split(later, 0);
+    states_[loop].out1 = add_any_byte(loop);
+    return add_split(first, add_any_byte(loop));
+  }
+
+  std::vector<NfaState> release() {
+    return std::move(states_);
+  }
+
+ private:
+  uint32_t add(const NfaState& state) {
+    states_.push_back(state);
+    return static_cast<uint32_t>(states_.size() - 1);
+  }
+
+  uint32_t add_split(uint32_t out, uint32_t out1) {
+    NfaState state;
+    state.kind = NfaState::Kind::Split;
+    state.out = out;
+    state.out1 = out1;
+    return add(state);
+  }
+
+  uint32_t add_any_byte(uint32_t out) {
+    NfaState state;
+    state.kind = NfaState::Kind::Bytes;
+    state.lo = 0;
+    state.hi = 0xff;
+    state.out = out;
+    return add(state);
+  }
+
+  // Returns the start of an NFA for node that continues at next.
+  uint32_t compile(const Node& node, uint32_t next) {
+    if (states_.size() > kMaxNfaStates) {
+      return next;
+    }
+    switch (node.kind) {
+      case Node::Kind::Empty:
+        return next;
+      case Node::Kind::Class:
+        return compile_class(node.ranges, next);
+      case Node::Kind::Concat:
+        if (reverse_) {
+          for (const auto& child : node.children) {
+            next = compile(*child, next);
+          }
+          return next;
+        }
+        for (auto it = node.children.rbegin(); it != node.children.rend();
+             ++it) {
+          next = compile(**it, next);
+        }
+        return next;
+      case Node::Kind::Alternate: {
+        uint32_t start = compile(*node.children.back(), next);
+        for (std::size_t i = node.children.size() - 1; i-- > 0;) {
+          start = add_split(compile(*node.children[i], next), start);
+        }
+        return start;
+      }
+      case Node::Kind::Repeat:
+        return compile_repeat(node, next);
+    }
+    return next;
+  }
+
+  uint32_t compile_repeat(const Node& node, uint32_t next) {
+    const Node& child = *node.children[0];
+    uint32_t start = next;
+    if (node.max == -1) {
+      // The loop state refers to the body, which refers back to it.
+      const uint32_t loop = add_split(0, 0);
+      const uint32_t body = compile(child, loop);
+      states_[loop].out = node.greedy ? body : next;
+      states_[loop].out1 = node.greedy ? next : body;
+      start = loop;
+    } else {
+      for (int i = node.min; i < node.max; ++i) {
+        const uint32_t body = compile(child, start);
+        start = node.greedy ? add_split(body, next) : add_split(next, body);
+      }
+    }
+    for (int i = 0; i < node.min; ++i) {
+      start = compile(child, start);
+    }
+    return start;
+  }
+
+  // Compiles a character class into a trie of byte ranges whose identical
+  // subtries are shared.
+  uint32_t compile_class(const Ranges& ranges, uint32_t next) {
+    std::vector<ByteRanges> sequences;
+    for (const auto& [lo, hi] : ranges) {
+      utf8_sequences(lo, std::min(hi, kMaxCodepoint), sequences);
+    }
+    if (reverse_) {
+      for (auto& sequence : sequences) {
+        std::reverse(sequence.begin(), sequence.end());
+      }
+    }
+    if (sequences.empty()) {
+      // Matches nothing.
+      NfaState state;
+      state.kind = NfaState::Kind::Bytes;
+      state.lo = 1;
+      state.hi = 0;
+      return add(state);
+    }
+
+    // Prefix trie of the sequences. Child -1 is the end of the class.
+    struct TrieNode {
+      std::vector<std::tuple<uint8_t, uint8_t, int>> edges;
+    };
+    std::vector<TrieNode> trie(1);
+    for (const auto& sequence : sequences) {
+      int node = 0;
+      for (std::size_t i = 0; i < sequence.size(); ++i) {
+        const bool last = i + 1 == sequence.size();
+        auto& edges = trie[node].edges;
+        if (!last && !edges.empty() &&
+            std::get<0>(edges.back()) == sequence[i].first &&
+            std::get<1>(edges.back()) == sequence[i].second &&
+            std::get<2>(edges.back()) != -1) {
+          node = std::get<2>(edges.back());
+          continue;
+        }
+        const int child = last ? -1 : static_cast<int>(trie.size());
+        edges.emplace_back(sequence[i].first, sequence[i].second, child);
+        if (!last) {
+          trie.emplace_back();
+        }
+        node = child;
+      }
+    }
+
+    // Emit children before their parents, sharing identical nodes.
+    std::map<std::vector<uint32_t>, uint32_t> emitted;
+    std::vector<uint32_t> starts(trie.size());
+    for (std::size_t i = trie.size(); i-- > 0;) {
+      std::vector<uint32_t> key;
+      for (const auto& [lo, hi, child] : trie[i].edges) {
+        key.push_back(lo);
+        key.push_back(hi);
+        key.push_back(child == -1 ? next : starts[child]);
+      }
+      const auto it = emitted.find(key);
+      if (it != emitted.end()) {
+        starts[i] = it->second;
+        continue;
+      }
+      uint32_t start = 0;
+      for (std::size_t j = key.size(); j >= 3; j -= 3) {
+        NfaState state;
+        state.kind = NfaState::Kind::Bytes;
+        state.lo = static_cast<uint8_t>(key[j - 3]);
+        state.hi = static_cast<uint8_t>(key[j - 2]);
+        state.out = key[j - 1];
+        const uint32_t edge = add(state);
+        start = j == key.size() ? edge : add_split(edge, start);
+      }
+      starts[i] = start;
+      emitted.emplace(std::move(key), start);
+    }
+    return starts[0];
+  }
+
+  const bool reverse_;
+  std::vector<NfaState> states_;
+};
+
+// Determinization /////////////////////////////////////////////////////////////
+
+class DfaBuilder {
+ public:
+  // With longest match semantics, threads have no priority and reaching the
+  // match state cuts off none of them.
+  DfaBuilder(std::vector<NfaState> nfa, bool longest)
+      : nfa_(std::move(nfa)), marks_(nfa_.size(), 0), longest_(longest) {}
+
+  // Follows the empty transitions from the starts in priority order. Returns
+  // the byte states reached, and the accept value of the match state that
+  // was reached first, if any, which cuts off all lower priority threads.
+  std::pair<std::vector<uint32_t>, uint8_t> closure(
+      const std::vector<uint32_t>& starts) {
+    ++generation_;
+    std::vector<uint32_t> threads;
+    std::vector<uint32_t> stack;
+    uint8_t matched = 0;
+    for (const uint32_t start : starts) {
+      stack.push_back(start);
+      while (!stack.empty()) {
+        const uint32_t id = stack.back();
+        stack.pop_back();
+        if (marks_[id] == generation_) {
+          continue;
+        }
+        marks_[id] = generation_;
+        const NfaState& state = nfa_[id];
+        switch (state.kind) {
+          case NfaState::Kind::Bytes:
+            if (state.lo <= state.hi) {
+              threads.push_back(id);
+            }
+            break;
+          case NfaState::Kind::Split:
+            stack.push_back(state.out1);
+            stack.push_back(state.out);
+            break;
+          case NfaState::Kind::Match:
+            if (!longest_) {
+              return {std::move(threads), state.accept};
+            }
+            matched = state.accept;
+            break;
+        }
+      }
+    }
+    if (longest_) {
+      // Sets of threads in any order are the same state.
+      std::sort(threads.begin(), threads.end());
+    }
+    return {std::move(threads), matched};
+  }
+
+  const std::vector<NfaState>& nfa() const {
+    return nfa_;
+  }
+
+ private:
+  std::vector<NfaState> nfa_;
+  std::vector<uint32_t> marks_;
+  uint32_t generation_ = 0;
+  const bool longest_;
+};
+
+// Merges the states that cannot be told apart by any input.
+void minimize(detail::ByteDfa& dfa) {
+  // Moore's algorithm: states start out split by their accept value, and
+  // blocks are split by the blocks of their successors until none changes.
+  const std::size_t state_count = dfa.accepting.size();
+  const std::size_t class_count = dfa.class_count;
+  std::vector<uint32_t> blocks(state_count);
+  for (std::size_t state = 0; state < state_count; ++state) {
+    blocks[state] = dfa.accepting[state];
+  }
+  std::size_t block_count = 0;
+  while (true) {
+    // Numbering blocks in order of first appearance keeps the dead state
+    // in block 0.
+    std::map<std::vector<uint32_t>, uint32_t> signatures;
+    std::vector<uint32_t> refined(state_count);
+    std::vector<uint32_t> signature(class_count + 1);
+    for (std::size_t state = 0; state < state_count; ++state) {
+      signature[0] = blocks[state];
+      for (std::size_t c = 0; c < class_count; ++c) {
+        signature[c + 1] = blocks[dfa.transitions[state * class_count + c]];
+      }
+      refined[state] =
+          signatures
+              .emplace(signature, static_cast<uint32_t>(signatures.size()))
+              .first->second;
+    }
+    blocks = std::move(refined);
+    if (signatures.size() == block_count) {
+      break;
+    }
+    block_count = signatures.size();
+  }
+
+  std::vector<uint16_t> transitions(block_count * class_count);
+  std::vector<uint8_t> accepting(block_count);
+  for (std::size_t state = 0; state < state_count; ++state) {
+    const uint32_t block = blocks[state];
+    accepting[block] = dfa.accepting[state];
+    for (std::size_t c = 0; c < class_count; ++c) {
+      transitions[block * class_count + c] = static_cast<uint16_t>(
+          blocks[dfa.transitions[state * class_count + c]]);
+    }
+  }
+  dfa.start = static_cast<uint16_t>(blocks[dfa.start]);
+  dfa.transitions = std::move(transitions);
+  dfa.accepting = std::move(accepting);
+}
+
+// Builds the minimal DFA of the NFA from nfa_start.
+Result<detail::ByteDfa> determinize(DfaBuilder& builder, uint32_t nfa_start) {
+  const auto& nfa = builder.nfa();
+  detail::ByteDfa dfa;
+
+  // Bytes that no byte range tells apart share a class.
+  std::array<bool, 257> boundaries{};
+  boundaries[0] = true;
+  for (const auto& state : nfa) {
+    if (state.kind == NfaState::Kind::Bytes && state.lo <= state.hi) {
+      boundaries[state.lo] = true;
+      boundaries[state.hi + 1] = true;
+    }
+  }
+  std::size_t classes = 0;
+  for (std::size_t byte = 0; byte < 256; ++byte) {
+    classes += boundaries[byte];
+    dfa.byte_classes[byte] = static_cast<uint8_t>(classes - 1);
+  }
+  dfa.class_count = classes;
+
+  // A DFA state is the ordered list of NFA threads and the accept value of
+  // the match that ends on entering it, if any. State 0 is the dead state.
+  std::map<std::pair<std::vector<uint32_t>, uint8_t>, uint16_t> ids;
+  std::vector<const std::vector<uint32_t>*> threads;
+  const auto intern =
+      [&](std::pair<std::vector<uint32_t>, uint8_t> key) -> Result<uint16_t> {
+    const auto it = ids.find(key);
+    if (it != ids.end()) {
+      return it->second;
+    }
+    if (dfa.accepting.size() >= DfaRegex::kMaxStates) {
+      TK_LOG(
+          Info, "DFA regex needs more than %zu states", DfaRegex::kMaxStates);
+      return Error::RegexFailure;
+    }
+    const auto id = static_cast<uint16_t>(dfa.accepting.size());
+    dfa.accepting.push_back(key.second);
+    dfa.transitions.resize(dfa.transitions.size() + dfa.class_count, 0);
+    const auto inserted = ids.emplace(std::move(key), id).first;
+    threads.push_back(&inserted->first.first);
+    return id;
+  };
+  TK_UNWRAP(intern({{}, 0}));
+  dfa.start = TK_UNWRAP(intern(builder.closure({nfa_start})));
+
+  // States often share target lists, whose closures are the same.
+  std::map<std::vector<uint32_t>, uint16_t> closures;
+  std::vector<std::vector<uint32_t>> targets(dfa.class_count);
+  for (std::size_t state = 1; state < dfa.accepting.size(); ++state) {
+    for (auto& target : targets) {
+      target.clear();
+    }
+    for (const uint32_t thread : *threads[state]) {
+      const NfaState& byte_state = nfa[thread];
+      for (std::size_t c = dfa.byte_classes[byte_state.lo];
+           c <= dfa.byte_classes[byte_state.hi];
+           ++c) {
+        targets[c].push_back(byte_state.out);
+      }
+    }
+    for (std::size_t c = 0; c < dfa.class_count; ++c) {
+      if (targets[c].empty()) {
+        continue;
+      }
+      auto it = closures.find(targets[c]);
+      if (it == closures.end()) {
+        const uint16_t next = TK_UNWRAP(intern(builder.closure(targets[c])));
+        it = closures.emplace(targets[c], next).first;
+      }
+      dfa.transitions[state * dfa.class_count + c] = it->second;
+    }
+  }
+  minimize(dfa);
+  return dfa;
+}
+
+// Builds the minimal DFA that searches for the pattern, and the bytes that
+// can start a match. A match that starts at the first byte is found by one
+// copy of the pattern and ends in kMatch states, a later one by another copy
+// and ends in kLaterMatch states.
+Result<detail::ByteDfa> build_forward_dfa(
+    const Node& root,
+    std::array<bool, 256>& can_start) {
+  NfaBuilder nfa_builder(/*reverse=*/false);
+  const uint32_t first = TK_UNWRAP(nfa_builder.build(root));
+  const uint32_t later =
+      TK_UNWRAP(nfa_builder.build(root, nfa_builder.add_match(kLaterMatch)));
+  const uint32_t start = nfa_builder.unanchored(first, later);
+  DfaBuilder builder(nfa_builder.release(), /*longest=*/false);
+
+  const auto [threads, matched] = builder.closure({first});
+  can_start.fill(matched != 0);
+  for (const uint32_t thread : threads) {
+    const NfaState& state = builder.nfa()[thread];
+    std::fill(&can_start[state.lo], &can_start[state.hi] + 1, true);
+  }
+  return determinize(builder, start);
+}
+
+// Builds the minimal DFA of the reversed pattern, with longest match
+// semantics.
+Result<detail::ByteDfa> build_reverse_dfa(const Node& root) {
+  NfaBuilder nfa_builder(/*reverse=*/true);
+  const uint32_t start = TK_UNWRAP(nfa_builder.build(root));
+  DfaBuilder builder(nfa_builder.release(), /*longest=*/true);
+  return determinize(builder, start);
+}
+
+} // namespace
+
+Error DfaRegex::compile(const std::string& pattern) {
+  const auto root = TK_UNWRAP(Parser(pattern).parse());
+  std::array<bool, 256> can_start{};
+  auto forward = TK_UNWRAP(build_forward_dfa(*root, can_start));
+  auto reverse = TK_UNWRAP(build_reverse_dfa(*root));
+  forward_ = std::move(forward);
+  reverse_ = std::move(reverse);
+  can_start_ = can_start;
+  return Error::Ok;
+}
+
+std::size_t DfaRegex::match_end(
+    const char* data,
+    std::size_t pos,
+    std::size_t size,
+    bool* later) const {
+  const uint8_t* accepting = forward_.accepting.data();
+  std::size_t state = forward_.start;
+  std::size_t end = accepting[state] ? pos : std::string::npos;
+  *later = accepting[state] == kLaterMatch;
+  for (; pos < size; ++pos) {
+    state = forward_.next(state, data[pos]);
+    if (state == 0) {
+      break;
+    }
+    if (accepting[state]) {
+      end = pos + 1;
+      *later = accepting[state] == kLaterMatch;
+    }
+  }
+  return end;
+}
+
+std::size_t DfaRegex::match_start(
+    const char* data,
+    std::size_t pos,
+    std::size_t end) const {
+  const uint8_t* accepting = reverse_.accepting.data();
+  std::size_t state = reverse_.start;
+  std::size_t start = end;
+  for (std::size_t i = end; i > pos; --i) {
+    state = reverse_.next(state, data[i - 1]);
+    if (state == 0) {
+      break;
+    }
+    if (accepting[state]) {
+      start = i - 1;
+    }
+  }
+  return start;
+}
+
+std::vector<Match> DfaRegex::find_all(const std::string& text) const {
+  std::vector<Match> result;
+  find_all_into(text, result);
+  return result;
+}
+
+void DfaRegex::find_all_into(
+    const std::string& text,
+    std::vector<Match>& result) const {
+  result.clear();
+  if (forward_.accepting.empty()) {
+    TK_LOG(Error, "Regex is not compiled or invalid, run compile() first");
+    return;
+  }
+  const char* data = text.data();
+  const std::size_t size = text.size();
+  std::size_t pos = 0;
+  while (pos < size) {
+    if (!can_start_[static_cast<uint8_t>(data[pos])]) {
+      ++pos;
+      continue;
+    }
+    // The forward DFA finds where the leftmost match ends. If there is none,
+    // there is none in the rest of the text either.
+    bool later = false;
+    const std::size_t end = match_end(data, pos, size, &later);
+    if (end == std::string::npos) {
+      break;
+    }
+    const std::size_t start = later ? match_start(data, pos + 1, end) : pos;
+    result.push_back({start, end});
+    // Move past empty matches to avoid an infinite loop.
+    pos = end > start ? end : start + 1;
+  }
+}
+
+} // namespace tokenizers
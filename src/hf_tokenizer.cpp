@@ -7,31 +7,421 @@
  */
 // @lint-ignore-every LICENSELINT
 
+#include <pytorch/tokenizers/artifact.h>
 #include <pytorch/tokenizers/hf_tokenizer.h>
+#include <pytorch/tokenizers/mapped_file.h>
+#include <pytorch/tokenizers/parallel.h>
 
 // Standard
 #include <algorithm>
 #include <cinttypes>
 #include <filesystem>
 #include <fstream>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 // Third Party
 #include <nlohmann/json.hpp>
+#include <unicode.h>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 namespace tokenizers {
 
-// -------------------------private method end-------------------------------
+// ------------------------------Util start------------------------------------
+namespace {
+
+// Below this many merge rules per thread, resolving them is not worth
+// splitting across threads.
+constexpr size_t kMinMergeRulesPerThread = 16384;
+
+// Each thread keeps the memory of its pre-tokenized pieces for the next
+// encode(), up to this many bytes.
+constexpr size_t kMaxKeptPiecesBytes = 1 << 20;
+
+// Whether the pre-tokenizer only splits the text before a final ByteLevel
+// stage maps it to the byte-level alphabet, so that a vocabulary keyed by raw
+// bytes matches its pieces without the mapping.
+bool ends_in_byte_level(const PreTokenizerConfig& config) {
+  if (config.type == "ByteLevel") {
+    return true;
+  }
+  if (config.type != "Sequence" || !config.pretokenizers ||
+      config.pretokenizers->empty()) {
+    return false;
+  }
+  const auto& stages = *config.pretokenizers;
+  for (size_t i = 0; i + 1 < stages.size(); ++i) {
+    if (stages[i].type != "Split" && stages[i].type != "Digits") {
+      return false;
+    }
+  }
+  return stages.back().type == "ByteLevel";
+}
+
+// Turns off the byte mapping of the final ByteLevel stage.
+void skip_byte_mapping(PreTokenizerConfig& config) {
+  if (config.type == "Sequence") {
+    skip_byte_mapping(config.pretokenizers->back());
+  } else {
+    config.set_map_bytes(false);
+  }
+}
+
+// Converts a token in the byte-level alphabet to the bytes it stands for.
+// Returns false if the token has other characters.
+bool byte_level_to_bytes(std::string_view token, std::string& bytes) {
+  // The byte that each character of the alphabet stands for, or -1.
+  static const std::vector<int> byte_of = [] {
+    std::vector<int> result;
+    for (int byte = 0; byte < 256; ++byte) {
+      const auto utf8 = unicode_byte_to_utf8(static_cast<uint8_t>(byte));
+      size_t offset = 0;
+      const uint32_t cp = unicode_cpt_from_utf8(utf8, offset);
+      if (cp >= result.size()) {
+        result.resize(cp + 1, -1);
+      }
+      result[cp] = byte;
+    }
+    return result;
+  }();
+  bytes.clear();
+  for (size_t pos = 0; pos < token.size();) {
+    const uint8_t lead = static_cast<uint8_t>(token[pos]);
+    uint32_t cp = lead;
+    size_t length = 1;
+    if (lead >= 0x80) {
+      // The alphabet has no characters beyond U+07FF.
+      if ((lead & 0xe0) != 0xc0 || pos + 1 >= token.size() ||
+          (static_cast<uint8_t>(token[pos + 1]) & 0xc0) != 0x80) {
+        return false;
+      }
+      cp = ((lead & 0x1f) << 6) | (static_cast<uint8_t>(token[pos + 1]) & 0x3f);
+      length = 2;
+    }
+    if (cp >= byte_of.size() || byte_of[cp] < 0) {
+      return false;
+    }
+    bytes += static_cast<char>(byte_of[cp]);
+    pos += length;
+  }
+  return true;
+}
+
+// Returns the token map re-keyed from the byte-level alphabet to raw bytes,
+// or std::nullopt if some token is not in the alphabet.
+std::optional<detail::TokenMap> byte_level_to_raw_bytes(
+    const detail::TokenMap& token_map) {
+  std::vector<std::pair<std::string, uint64_t>> pairs;
+  pairs.reserve(token_map.size());
+  std::string bytes;
+  for (size_t i = 0; i < token_map.size(); ++i) {
+    const auto [token, id] = token_map.getElement(i);
+    if (!byte_level_to_bytes(token, bytes)) {
+      return std::nullopt;
+    }
+    pairs.emplace_back(bytes, id);
+  }
+  auto result = detail::build_token_map(std::move(pairs));
+  if (!result.ok()) {
+    return std::nullopt;
+  }
+  return std::move(result.get());
+}
+
+/**
+ * SAX handler for tokenizer.json.
+ *
+ * Everything except the BPE vocabulary and merges is built into a regular json
+ * DOM, since the normalizer, pre-tokenizer and decoder configs are small and
+ * are parsed from json. The entries of /model/vocab and /model/merges, which
+ * make up almost all of a large tokenizer.json, are streamed into a single
+ * string arena instead, so no json value or std::string is created per
+ * entry.
+ */
+class TokenizerJsonSax {
+ public:
+  using number_integer_t = json::number_integer_t;
+  using number_unsigned_t = json::number_unsigned_t;
+  using number_float_t = json::number_float_t;
+  using string_t = json::string_t;
+  using binary_t = json::binary_t;
+
+  /// Everything except /model/vocab and /model/merges.
+  json document;
+
+  bool has_vocab = false;
+  bool has_merges = false;
+  std::string error;
+
+  /// Resolves the streamed vocabulary into views of the arena. Only valid
+  /// once parsing has finished.
+  std::vector<std::pair<std::string_view, uint64_t>> vocab() const {
+    std::vector<std::pair<std::string_view, uint64_t>> result;
+    result.reserve(vocab_.size());
+    for (const auto& entry : vocab_) {
+      result.emplace_back(view(entry.token), entry.id);
+    }
+    return result;
+  }
+
+  /// Resolves the streamed merges into views of the arena. Only valid once
+  /// parsing has finished.
+  std::vector<std::pair<std::string_view, std::string_view>> merges() const {
+    std::vector<std::pair<std::string_view, std::string_view>> result;
+    result.reserve(merges_.size());
+    for (const auto& [first, second] : merges_) {
+      result.emplace_back(view(first), view(second));
+    }
+    return result;
+  }
+
+  bool null() {
+    return in_document() ? add_value(nullptr) : fail("unexpected null");
+  }
+
+  bool boolean(bool value) {
+    return in_document() ? add_value(value) : fail("unexpected boolean");
+  }
+
+  bool number_integer(number_integer_t value) {
+    if (stream_ == Stream::Vocab && value >= 0) {
+      return add_vocab_id(static_cast<uint64_t>(value));
+    }
+    return in_document() ? add_value(value) : fail("unexpected integer");
+  }
+
+  bool number_unsigned(number_unsigned_t value) {
+    if (stream_ == Stream::Vocab) {
+      return add_vocab_id(value);
+    }
+    return in_document() ? add_value(value) : fail("unexpected integer");
+  }
+
+  bool number_float(number_float_t value, const string_t& /*unused*/) {
+    return in_document() ? add_value(value) : fail("unexpected number");
+  }
+
+  bool string(string_t& value) {
+    if (stream_ == Stream::Merges) {
+      return add_merge_string(value);
+    }
+    return in_document() ? add_value(value) : fail("unexpected string");
+  }
+
+  bool binary(binary_t& value) {
+    return in_document() ? add_value(std::move(value))
+                         : fail("unexpected binary value");
+  }
+
+  bool start_object(std::size_t /*elements*/) {
+    if (pending_ == Stream::Vocab) {
+      pending_ = Stream::None;
+      stream_ = Stream::Vocab;
+      has_vocab = true;
+      return true;
+    }
+    if (pending_ != Stream::None || stream_ != Stream::None) {
+      return fail("unexpected object");
+    }
+    return push(json::value_t::object);
+  }
+
+  bool key(string_t& value) {
+    if (stream_ == Stream::Vocab) {
+      pending_token_ = append(value);
+      return true;
+    }
+    if (stream_ != Stream::None) {
+      return fail("unexpected key");
+    }
+    // Intercept /model/vocab and /model/merges before a DOM entry is made.
+    if (stack_.size() == 2 && model_key_ && stack_[1]->is_object() &&
+        (value == "vocab" || value == "merges")) {
+      pending_ = value == "vocab" ? Stream::Vocab : Stream::Merges;
+      return true;
+    }
+    if (stack_.size() == 1) {
+      model_key_ = value == "model";
+    }
+    object_element_ = &(*stack_.back())[value];
+    return true;
+  }
+
+  bool end_object() {
+    if (stream_ == Stream::Vocab) {
+      stream_ = Stream::None;
+      return true;
+    }
+    if (stream_ != Stream::None) {
+      return fail("unexpected end of object");
+    }
+    stack_.pop_back();
+    return true;
+  }
+
+  bool start_array(std::size_t /*elements*/) {
+    if (pending_ == Stream::Merges) {
+      pending_ = Stream::None;
+      stream_ = Stream::Merges;
+      has_merges = true;
+      return true;
+    }
+    if (stream_ == Stream::Merges && !in_merge_pair_) {
+      // Newer tokenizer.json files store each merge as ["first", "second"].
+      in_merge_pair_ = true;
+      merge_parts_ = 0;
+      return true;
+    }
+    if (pending_ != Stream::None || stream_ != Stream::None) {
+      return fail("unexpected array");
+    }
+    return push(json::value_t::array);
+  }
+
+  bool end_array() {
+    if (stream_ == Stream::Merges) {
+      if (in_merge_pair_) {
+        in_merge_pair_ = false;
+        // Malformed merges are skipped, as before.
+        if (merge_parts_ == 2) {
+          merges_.emplace_back(merge_first_, merge_second_);
+        }
+      } else {
+        stream_ = Stream::None;
+      }
+      return true;
+    }
+    if (stream_ != Stream::None) {
+      return fail("unexpected end of array");
+    }
+    stack_.pop_back();
+    return true;
+  }
+
+  bool parse_error(
+      std::size_t /*position*/,
+      const std::string& /*last_token*/,
+      const nlohmann::detail::exception& ex) {
+    return fail(ex.what());
+  }
+
+ private:
+  enum class Stream { None, Vocab, Merges };
+
+  struct Span {
+    std::size_t begin = 0;
+    std::size_t size = 0;
+  };
+
+  struct VocabEntry {
+    Span token;
+    uint64_t id;
+  };
+
+  /// Whether the current value belongs in the json document.
+  bool in_document() const {
+    return stream_ == Stream::None && pending_ == Stream::None;
+  }
+
+  bool fail(const std::string& message) {
+    if (error.empty()) {
+      error = message;
+    }
+    return false;
+  }
+
+  Span append(std::string_view value) {
+    const Span span{arena_.size(), value.size()};
+    arena_.append(value);
+    return span;
+  }
+
+  std::string_view view(const Span& span) const {
+    return std::string_view(arena_).substr(span.begin, span.size);
+  }
+
+  bool add_vocab_id(uint64_t id) {
+    vocab_.push_back({pending_token_, id});
+    return true;
+  }
+
+  bool add_merge_string(std::string_view value) {
+    if (in_merge_pair_) {
+      if (merge_parts_ == 0) {
+        merge_first_ = append(value);
+      } else if (merge_parts_ == 1) {
+        merge_second_ = append(value);
+      }
+      ++merge_parts_;
+      return true;
+    }
+    // Older tokenizer.json files store each merge as "first second".
+    const auto pos = value.find(' ');
+    if (pos != std::string_view::npos &&
+        value.find(' ', pos + 1) == std::string_view::npos) {
+      const auto first = append(value.substr(0, pos));
+      const auto second = append(value.substr(pos + 1));
+      merges_.emplace_back(first, second);
+    }
+    return true;
+  }
+
+  template <typename Value>
+  json* insert(Value&& value) {
+    if (stack_.empty()) {
+      document = json(std::forward<Value>(value));
+      return &document;
+    }
+    if (stack_.back()->is_array()) {
+      stack_.back()->emplace_back(std::forward<Value>(value));
+      return &stack_.back()->back();
+    }
+    *object_element_ = json(std::forward<Value>(value));
+    return object_element_;
+  }
+
+  template <typename Value>
+  bool add_value(Value&& value) {
+    insert(std::forward<Value>(value));
+    return true;
+  }
+
+  bool push(json::value_t type) {
+    stack_.push_back(insert(type));
+    return true;
+  }
+
+  std::vector<json*> stack_;
+  json* object_element_ = nullptr;
+  bool model_key_ = false;
+
+  Stream pending_ = Stream::None;
+  Stream stream_ = Stream::None;
+
+  std::string arena_;
+  Span pending_token_;
+  std::vector<VocabEntry> vocab_;
+
+  bool in_merge_pair_ = false;
+  std::size_t merge_parts_ = 0;
+  Span merge_first_;
+  Span merge_second_;
+  std::vector<std::pair<Span, Span>> merges_;
+};
+
+} // namespace
+// ------------------------------Util end------------------------------------
 // -------------------------public method start-------------------------------
 
 Error HFTokenizer::load(const std::string& path) {
   // If this is a directory, look for tokenizer.json and tokenizer_config.json
   std::string model_json = path;
-  std::string model_config_json = "";
+  std::string model_config_contents;
   if (fs::is_directory(path)) {
     const fs::path root(path);
     model_json = root / "tokenizer.json";
@@ -41,208 +431,275 @@ Error HFTokenizer::load(const std::string& path) {
     }
     const auto model_config_json_path = root / "tokenizer_config.json";
     if (fs::exists(model_config_json_path)) {
-      model_config_json = model_config_json_path;
+      std::ifstream config_file(model_config_json_path);
+      if (!config_file) {
+        TK_LOG(Error, "failed to open encoder file: %s", path.c_str());
+        return Error::LoadFailure;
+      }
+      model_config_contents.assign(
+          std::istreambuf_iterator<char>(config_file),
+          std::istreambuf_iterator<char>());
     }
   }
 
-  // Load the tokenizer.json file
-  std::ifstream file(model_json);
-  if (!file) {
+  // Stream the tokenizer.json file
+  auto file = detail::MappedFile::open(model_json);
+  if (!file.ok()) {
     TK_LOG(Info, "failed to open encoder file: %s", path.c_str());
     return Error::LoadFailure;
   }
-  std::string contents(
-      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-  json parsed_json;
-  try {
-    parsed_json = json::parse(contents);
-  } catch (const json::exception& e) {
-    TK_LOG(Error, "Error parsing json file: %s", e.what());
-    return Error::LoadFailure;
+  if (detail::has_artifact_magic(file.get().view())) {
+    _reset();
+    return _load_artifact(
+        TK_UNWRAP(detail::ArtifactReader::from_file(std::move(file.get()))));
   }
+  return load_from_buffer(file.get().view(), model_config_contents);
+}
 
-  // Parse the special tokens
-  try {
-    std::vector<std::pair<std::string, std::uint64_t>> special_token_pairs;
-    const auto& special_tokens = parsed_json.at("added_tokens");
-    auto special_token_map = TK_UNWRAP(detail::build_token_map(
-        special_tokens,
-        [](const auto& it) -> std::string { return it.at("content"); },
-        [](const auto& it) -> std::uint64_t { return it.at("id"); }));
-
-    // Create special token regex to help later with encoding.
-    special_token_regex_ =
-        TK_UNWRAP(detail::build_special_token_regex(special_token_map));
-
-    // Store for future use.
-    special_token_map_.emplace(std::move(special_token_map));
-  } catch (const json::out_of_range& e) {
-    TK_LOG(Info, "Could not parse special tokens: %s", e.what());
-    return Error::LoadFailure;
+Error HFTokenizer::load_from_buffer(std::string_view data) {
+  return load_from_buffer(data, std::string_view());
+}
+
+Error HFTokenizer::load_from_buffer(
+    std::string_view tokenizer_json,
+    std::string_view tokenizer_config_json) {
+  _reset();
+  if (detail::has_artifact_magic(tokenizer_json)) {
+    return _load_artifact(
+        TK_UNWRAP(detail::ArtifactReader::from_buffer(tokenizer_json)));
   }
 
-  // Parse the standard tokens
+  TokenizerJsonSax sax;
+  bool parsed = false;
   try {
-    std::vector<std::pair<std::string, std::uint64_t>> token_pairs;
-    const auto& vocab = parsed_json.at("/model/vocab"_json_pointer);
-    for (const auto& entry : vocab.items()) {
-      const std::string token = entry.key();
-      const uint64_t token_id = entry.value();
-      // Skip adding special tokens to the standard encoder/decoder
-      if (!special_token_map_->tryGetString(token_id)) {
-        token_pairs.emplace_back(token, token_id);
-      }
-    }
-
-    auto token_map = TK_UNWRAP(detail::build_token_map(std::move(token_pairs)));
-    token_map_.emplace(std::move(token_map));
-  } catch (const json::out_of_range& e) {
-    TK_LOG(Info, "Could not parse tokens: %s", e.what());
+    parsed =
+        json::sax_parse(tokenizer_json.begin(), tokenizer_json.end(), &sax);
+  } catch (const json::exception& e) {
+    sax.error = e.what();
+  }
+  if (!parsed) {
+    TK_LOG(Error, "Error parsing json file: %s", sax.error.c_str());
     return Error::LoadFailure;
   }
+  const json& parsed_json = sax.document;
 
-  // Set the vocab size to include special tokens
-  vocab_size_ = token_map_->size() + special_token_map_->size();
+  // Once the json is parsed, the special tokens, the standard tokens, the
+  // component configs and tokenizer_config.json are independent, so they are
+  // loaded concurrently. Errors are reported in the order of the tasks, no
+  // matter which one fails first.
+  std::optional<detail::TokenMap> special_token_map;
+  std::optional<detail::TokenMap> token_map;
+  std::optional<std::pair<std::string, std::string>> config_bos_eos;
+  std::string normalizer_config;
+  std::string pretokenizer_config;
+  std::string decoder_config;
+  bool byte_level = false;
+  TK_CHECK_OK_OR_RETURN_ERROR(detail::run_tasks({
+      // Parse the special tokens
+      [&]() -> Error {
+        try {
+          const auto& special_tokens = parsed_json.at("added_tokens");
+          special_token_map.emplace(TK_UNWRAP(detail::build_token_map(
+              special_tokens,
+              [](const auto& it) -> std::string { return it.at("content"); },
+              [](const auto& it) -> std::uint64_t { return it.at("id"); })));
+        } catch (const json::out_of_range& e) {
+          TK_LOG(Info, "Could not parse special tokens: %s", e.what());
+          return Error::LoadFailure;
+        }
+        return Error::Ok;
+      },
 
-  // Set up the normalizer (optional)
-  try {
-    TK_LOG(Info, "Setting up normalizer...");
-    const auto& normalizer_json = parsed_json.at("normalizer");
-    if (!normalizer_json.is_null()) {
-      _normalizer = NormalizerConfig().parse_json(normalizer_json).create();
-      TK_LOG(Info, "Normalizer set up");
-    } else {
-      TK_LOG(Info, "Normalizer field is null, skipping");
-    }
-  } catch (const json::out_of_range& e) {
-    // No "Normalizer" field found
-    TK_LOG(
-        Info,
-        "No 'Normalizer' field found in json, out of range error: %s",
-        e.what());
-  }
+      // Parse the standard tokens
+      [&]() -> Error {
+        if (!sax.has_vocab) {
+          TK_LOG(Info, "Could not parse tokens: no /model/vocab object");
+          return Error::LoadFailure;
+        }
+        // Skip adding special tokens to the standard encoder/decoder. Their
+        // ids are read from the json, as the special token map is built
+        // concurrently; if they are malformed, that task reports it.
+        std::unordered_set<uint64_t> special_ids;
+        try {
+          for (const auto& token : parsed_json.at("added_tokens")) {
+            special_ids.insert(token.at("id").get<uint64_t>());
+          }
+        } catch (const json::exception&) {
+          return Error::LoadFailure;
+        }
+        auto token_pairs = sax.vocab();
+        token_pairs.erase(
+            std::remove_if(
+                token_pairs.begin(),
+                token_pairs.end(),
+                [&special_ids](const auto& pair) {
+                  return special_ids.count(pair.second) > 0;
+                }),
+            token_pairs.end());
+        token_map.emplace(
+            TK_UNWRAP(detail::build_token_map(std::move(token_pairs))));
+        return Error::Ok;
+      },
 
-  // Set up the pre-tokenizer
-  try {
-    TK_LOG(Info, "Setting up pretokenizer...");
-    _pretokenizer = PreTokenizerConfig()
-                        .parse_json(parsed_json.at("pre_tokenizer"))
-                        .create();
-    TK_LOG(Info, "Pretokenizer set up");
-  } catch (const json::out_of_range& e) {
-    TK_LOG(Info, "Could not parse pre_tokenizer: %s", e.what());
-    return Error::LoadFailure;
-  }
+      // Validate the normalizer, pre-tokenizer and decoder configs. The
+      // normalizer and pre-tokenizer are created once the vocab is known to
+      // be byte-level or not, and the decoder by _init_decoder().
+      [&]() -> Error {
+        try {
+          const auto& normalizer_json = parsed_json.at("normalizer");
+          if (!normalizer_json.is_null()) {
+            NormalizerConfig().parse_json(normalizer_json);
+            normalizer_config = normalizer_json.dump();
+          } else {
+            TK_LOG(Info, "Normalizer field is null, skipping");
+          }
+        } catch (const json::out_of_range& e) {
+          // No "Normalizer" field found
+          TK_LOG(
+              Info,
+              "No 'Normalizer' field found in json, out of range error: %s",
+              e.what());
+        }
 
-  // Set up the decoder (optional)
-  try {
-    _decoder =
-        TokenDecoderConfig().parse_json(parsed_json.at("decoder")).create();
-  } catch (const json::out_of_range& e) {
-    // No decoder specified
-  }
+        bool byte_level_pre_tokenizer = false;
+        try {
+          const auto& pretokenizer_json = parsed_json.at("pre_tokenizer");
+          byte_level_pre_tokenizer = ends_in_byte_level(
+              PreTokenizerConfig().parse_json(pretokenizer_json));
+          pretokenizer_config = pretokenizer_json.dump();
+        } catch (const json::out_of_range& e) {
+          TK_LOG(Info, "Could not parse pre_tokenizer: %s", e.what());
+          return Error::LoadFailure;
+        }
 
-  // Parse the BPE merges
-  try {
-    TK_LOG(Info, "Loading BPE merges...");
-    const auto& merges = parsed_json.at("/model/merges"_json_pointer);
-    std::vector<std::pair<std::string, std::string>> merge_pairs;
-
-    for (const auto& merge : merges) {
-      if (merge.size() == 2) {
-        std::string first = merge[0];
-        std::string second = merge[1];
-        merge_pairs.emplace_back(first, second);
-      }
-    }
+        // The decoder is optional
+        try {
+          const auto& decoder_json = parsed_json.at("decoder");
+          const auto decoder = TokenDecoderConfig().parse_json(decoder_json);
+          decoder_config = decoder_json.dump();
+          byte_level = byte_level_pre_tokenizer && decoder.type == "ByteLevel";
+        } catch (const json::out_of_range& e) {
+          // No decoder specified
+        }
+        return Error::Ok;
+      },
 
-    // Build merge map: (token_id_1, token_id_2) -> (rank, merged_token_id)
-    merge_map_ = std::make_unique<detail::MergeMap>();
-    for (size_t i = 0; i < merge_pairs.size(); ++i) {
-      const auto& [first, second] = merge_pairs[i];
+      // The BPE merges are resolved below, once the vocab is built
+      [&]() -> Error {
+        if (!sax.has_merges) {
+          TK_LOG(Error, "Could not parse merges: no /model/merges array");
+          return Error::LoadFailure;
+        }
+        return Error::Ok;
+      },
 
-      // Get token IDs for the merge pair
-      auto first_id = token_map_->tryGetInteger(first);
-      auto second_id = token_map_->tryGetInteger(second);
+      // If a tokenizer config file is found, parse it to look up the eos/bos
+      // tokens
+      [&]() -> Error {
+        if (tokenizer_config_json.empty()) {
+          return Error::Ok;
+        }
+        json parsed_config_json;
+        try {
+          parsed_config_json = json::parse(
+              tokenizer_config_json.begin(), tokenizer_config_json.end());
+        } catch (const json::exception& e) {
+          TK_LOG(
+              Error, "Error parsing model config json json file: %s", e.what());
+          return Error::LoadFailure;
+        }
 
-      if (first_id && second_id) {
-        // Create merged token string
-        std::string merged = first + second;
-        auto merged_id = token_map_->tryGetInteger(merged);
+        // Pull out the token strings
+        try {
+          const std::string bos_token =
+              parsed_config_json.contains("bos_token") &&
+                  !parsed_config_json["bos_token"].is_null()
+              ? parsed_config_json["bos_token"].get<std::string>()
+              : "";
 
-        if (merged_id) {
-          // Store merge rule: (first_id, second_id) -> (rank, merged_id)
-          merge_map_->emplace(
-              std::make_pair(*first_id, *second_id),
-              std::make_pair(static_cast<uint32_t>(i), *merged_id));
+          const std::string eos_token =
+              parsed_config_json.contains("eos_token") &&
+                  !parsed_config_json["eos_token"].is_null()
+              ? parsed_config_json["eos_token"].get<std::string>()
+              : "";
+          config_bos_eos.emplace(bos_token, eos_token);
+        } catch (const json::out_of_range& e) {
+          TK_LOG(
+              Error, "Could not eos/bos from tokenizer config: %s", e.what());
+          return Error::LoadFailure;
         }
-      }
-    }
+        return Error::Ok;
+      },
+  }));
+  special_token_map_.emplace(std::move(*special_token_map));
+  token_map_.emplace(std::move(*token_map));
+  _normalizer_config = std::move(normalizer_config);
+  _pretokenizer_config = std::move(pretokenizer_config);
+  _decoder_config = std::move(decoder_config);
 
-    TK_LOG(
-        Info,
-        "Loaded %" PRId64 " BPE merge rules",
-        static_cast<int64_t>(merge_map_->size()));
+  // Set the vocab size to include special tokens
+  vocab_size_ = token_map_->size() + special_token_map_->size();
 
-    // Pre-compute merge ranks for efficient BPE encoding
-    auto merge_ranks =
-        TK_UNWRAP(detail::build_merge_ranks_map(*merge_map_, *token_map_));
+  // Parse the BPE merges. Only resolve the merge rules to token ids here, in
+  // chunks across threads; the merge tables are built from them by
+  // _init_encoder().
+  TK_LOG(Info, "Loading BPE merges...");
+  {
+    const auto merge_pairs = sax.merges();
+    const auto chunks =
+        detail::chunk_count(merge_pairs.size(), kMinMergeRulesPerThread);
+    std::vector<std::vector<MergeRule>> chunk_rules(chunks);
+    detail::for_each_chunk(
+        merge_pairs.size(),
+        chunks,
+        [&](size_t chunk, size_t begin, size_t end) {
+          auto& rules = chunk_rules[chunk];
+          rules.reserve(end - begin);
+          for (size_t i = begin; i < end; ++i) {
+            const auto& [first, second] = merge_pairs[i];
+            const auto first_id = token_map_->tryGetInteger(first);
+            const auto second_id = token_map_->tryGetInteger(second);
+            if (first_id && second_id) {
+              rules.push_back({*first_id, *second_id, i});
+            }
+          }
+        });
+    for (const auto& rules : chunk_rules) {
+      merge_rules_.insert(merge_rules_.end(), rules.begin(), rules.end());
+    }
     TK_LOG(
         Info,
-        "Built merge ranks map with %" PRId64 " entries",
-        static_cast<int64_t>(merge_ranks.size()));
-    merge_ranks_.emplace(std::move(merge_ranks));
-  } catch (const json::out_of_range& e) {
-    TK_LOG(Error, "Could not parse merges: %s", e.what());
-    return Error::LoadFailure;
+        "Loaded %" PRId64 " BPE merge rules",
+        static_cast<int64_t>(merge_rules_.size()));
   }
 
-  // If a tokenizer config file is found, parse it to look up the eos/bos tokens
-  if (!model_config_json.empty()) {
-    // Load it and parse it as json
-    std::ifstream config_file(model_config_json);
-    if (!config_file) {
-      TK_LOG(Error, "failed to open encoder file: %s", path.c_str());
-      return Error::LoadFailure;
+  // When the pipeline is ByteLevel only, re-key the vocabulary to the raw
+  // bytes that its characters stand for. The merge rules refer to token ids,
+  // so they are re-keyed along with it.
+  if (byte_level) {
+    auto raw_token_map = byte_level_to_raw_bytes(*token_map_);
+    if (raw_token_map) {
+      token_map_.emplace(std::move(*raw_token_map));
+      raw_byte_keys_ = true;
+    } else {
+      TK_LOG(Info, "Vocab is not all byte-level, keeping the byte mapping");
     }
-    std::string config_contents(
-        (std::istreambuf_iterator<char>(config_file)),
-        std::istreambuf_iterator<char>());
-    json parsed_config_json;
-    try {
-      parsed_config_json = json::parse(config_contents);
-    } catch (const json::exception& e) {
-      TK_LOG(Error, "Error parsing model config json json file: %s", e.what());
+  }
+
+  if (config_bos_eos) {
+    const auto& [bos_token, eos_token] = *config_bos_eos;
+    const auto bos_res = special_token_map_->tryGetInteger(bos_token);
+    const auto eos_res = special_token_map_->tryGetInteger(eos_token);
+    if (!bos_res) {
+      TK_LOG(Error, "BOS token %s not in special tokens", bos_token.c_str());
       return Error::LoadFailure;
     }
-
-    // Pull out the token strings
-    try {
-      const std::string bos_token = parsed_config_json.contains("bos_token") &&
-              !parsed_config_json["bos_token"].is_null()
-          ? parsed_config_json["bos_token"].get<std::string>()
-          : "";
-
-      const std::string eos_token = parsed_config_json.contains("eos_token") &&
-              !parsed_config_json["eos_token"].is_null()
-          ? parsed_config_json["eos_token"].get<std::string>()
-          : "";
-      const auto bos_res = special_token_map_->tryGetInteger(bos_token);
-      const auto eos_res = special_token_map_->tryGetInteger(eos_token);
-      if (!bos_res) {
-        TK_LOG(Error, "BOS token %s not in special tokens", bos_token.c_str());
-        return Error::LoadFailure;
-      }
-      if (!eos_res) {
-        TK_LOG(Error, "EOS token %s not in special tokens", eos_token.c_str());
-        return Error::LoadFailure;
-      }
-      bos_tok_ = *bos_res;
-      eos_tok_ = *eos_res;
-    } catch (const json::out_of_range& e) {
-      TK_LOG(Error, "Could not eos/bos from tokenizer config: %s", e.what());
+    if (!eos_res) {
+      TK_LOG(Error, "EOS token %s not in special tokens", eos_token.c_str());
       return Error::LoadFailure;
     }
+    bos_tok_ = *bos_res;
+    eos_tok_ = *eos_res;
   }
 
   // Otherwise, make an educated guess with the following logic:
@@ -304,20 +761,181 @@ Error HFTokenizer::load(const std::string& path) {
     }
   }
 
+  // Compile the regexes of the components here rather than on first use, so
+  // that an invalid pattern fails load().
+  TK_CHECK_OK_OR_RETURN_ERROR(_create_components());
+
   // Mark initialized once everything is done
   initialized_ = true;
 
   return Error::Ok;
 }
+
+Error HFTokenizer::save(const std::string& path) const {
+  TK_CHECK_OR_RETURN_ERROR(
+      initialized_, Uninitialized, "cannot save an unloaded tokenizer");
+  TK_CHECK_OK_OR_RETURN_ERROR(ensure_encoder_());
+  detail::ArtifactWriter writer(detail::ArtifactKind::HFTokenizer);
+  save_token_maps_(writer);
+  writer.add_map(detail::ArtifactSection::MergeRanks, *merge_ranks_);
+  if (!_normalizer_config.empty()) {
+    writer.add(detail::ArtifactSection::NormalizerConfig, _normalizer_config);
+  }
+  writer.add(detail::ArtifactSection::PreTokenizerConfig, _pretokenizer_config);
+  if (!_decoder_config.empty()) {
+    writer.add(detail::ArtifactSection::DecoderConfig, _decoder_config);
+  }
+  writer.add_integers(
+      detail::ArtifactSection::Metadata,
+      {bos_tok_, eos_tok_, raw_byte_keys_ ? 1u : 0u});
+  return writer.save(path);
+}
 // -------------------------public method end-----------------------------------
 // -------------------------private method start--------------------------------
 
+Error HFTokenizer::_create_components() {
+  try {
+    if (!_normalizer_config.empty()) {
+      _normalizer = NormalizerConfig()
+                        .parse_json(json::parse(_normalizer_config))
+                        .create();
+    }
+    PreTokenizerConfig config;
+    config.parse_json(json::parse(_pretokenizer_config));
+    if (raw_byte_keys_) {
+      skip_byte_mapping(config);
+    }
+    _pretokenizer = config.create();
+  } catch (const std::exception& e) {
+    TK_LOG(
+        Error,
+        "failed to create the normalizer or pre-tokenizer: %s",
+        e.what());
+    return Error::LoadFailure;
+  }
+  return Error::Ok;
+}
+
+Error HFTokenizer::_init_encoder() const {
+  // The special token matcher and the merge tables are independent, so they
+  // are built concurrently.
+  return detail::run_tasks({
+      [this]() { return BPETokenizerBase::_init_encoder(); },
+      [this]() { return _build_merge_ranks(); },
+  });
+}
+
+Error HFTokenizer::_build_merge_ranks() const {
+  // Artifacts carry the merge ranks, otherwise build them from the rules.
+  if (merge_ranks_) {
+    return Error::Ok;
+  }
+
+  // Build merge map: (token_id_1, token_id_2) -> (rank, merged_token_id)
+  merge_map_ = std::make_unique<detail::MergeMap>();
+  std::string merged;
+  for (const auto& rule : merge_rules_) {
+    merged.assign(*token_map_->tryGetString(rule.first))
+        .append(*token_map_->tryGetString(rule.second));
+    const auto merged_id = token_map_->tryGetInteger(merged);
+    if (merged_id) {
+      // Store merge rule: (first_id, second_id) -> (rank, merged_id)
+      merge_map_->emplace(
+          std::make_pair(rule.first, rule.second),
+          std::make_pair(static_cast<uint32_t>(rule.rank), *merged_id));
+    }
+  }
+  merge_rules_.clear();
+  merge_rules_.shrink_to_fit();
+
+  // Pre-compute merge ranks for efficient BPE encoding
+  auto merge_ranks =
+      TK_UNWRAP(detail::build_merge_ranks_map(*merge_map_, *token_map_));
+  TK_LOG(
+      Info,
+      "Built merge ranks map with %" PRId64 " entries",
+      static_cast<int64_t>(merge_ranks.size()));
+  merge_ranks_.emplace(std::move(merge_ranks));
+  return Error::Ok;
+}
+
+Error HFTokenizer::_init_decoder() const {
+  // Tokens keyed by raw bytes decode to themselves.
+  if (!_decoder_config.empty() && !raw_byte_keys_) {
+    _decoder = TokenDecoderConfig()
+                   .parse_json(json::parse(_decoder_config))
+                   .create();
+  }
+  return Error::Ok;
+}
+
+void HFTokenizer::_reset() {
+  // A failed load leaves the tokenizer unloaded, rather than half replaced.
+  initialized_ = false;
+  vocab_size_ = 0;
+  bos_tok_ = 0;
+  eos_tok_ = 0;
+  reset_lazy_init_();
+  token_map_.reset();
+  special_token_map_.reset();
+  _normalizer.reset();
+  _pretokenizer.reset();
+  _decoder.reset();
+  _normalizer_config.clear();
+  _pretokenizer_config.clear();
+  _decoder_config.clear();
+  merge_rules_.clear();
+  merge_map_.reset();
+  merge_ranks_.reset();
+  raw_byte_keys_ = false;
+}
+
+Error HFTokenizer::_load_artifact(const detail::ArtifactReader& reader) {
+  using detail::ArtifactSection;
+  TK_CHECK_OR_RETURN_ERROR(
+      reader.kind() == detail::ArtifactKind::HFTokenizer,
+      LoadFailure,
+      "not a HuggingFace tokenizer artifact");
+  TK_CHECK_OK_OR_RETURN_ERROR(load_token_maps_(reader));
+  merge_ranks_.emplace(
+      TK_UNWRAP(reader.map<detail::TokenMap>(ArtifactSection::MergeRanks)));
+  vocab_size_ = token_map_->size() + special_token_map_->size();
+
+  // The component configs are small, so they are stored as json rather than
+  // given a binary format of their own.
+  if (reader.has_section(ArtifactSection::NormalizerConfig)) {
+    _normalizer_config = std::string(
+        TK_UNWRAP(reader.section(ArtifactSection::NormalizerConfig)));
+  }
+  _pretokenizer_config = std::string(
+      TK_UNWRAP(reader.section(ArtifactSection::PreTokenizerConfig)));
+  if (reader.has_section(ArtifactSection::DecoderConfig)) {
+    _decoder_config =
+        std::string(TK_UNWRAP(reader.section(ArtifactSection::DecoderConfig)));
+  }
+
+  const auto metadata = TK_UNWRAP(reader.integers(ArtifactSection::Metadata));
+  TK_CHECK_OR_RETURN_ERROR(
+      metadata.size() >= 2,
+      LoadFailure,
+      "invalid HuggingFace tokenizer artifact metadata");
+  bos_tok_ = metadata[0];
+  eos_tok_ = metadata[1];
+  // Artifacts written before the vocab could be re-keyed have no flag.
+  raw_byte_keys_ = metadata.size() >= 3 && metadata[2] != 0;
+
+  TK_CHECK_OK_OR_RETURN_ERROR(_create_components());
+  initialized_ = true;
+  return Error::Ok;
+}
+
 Error HFTokenizer::_encode(
     const std::string& input,
     std::vector<uint64_t>& ret,
     uint64_t& last_piece_token_len) const {
   // Apply normalization first if normalizer is available
-  std::string normalized_input = input;
+  const std::string* text = &input;
+  std::string normalized_input;
   if (_normalizer) {
     normalized_input = _normalizer->normalize(input);
     TK_LOG(
@@ -325,9 +943,19 @@ Error HFTokenizer::_encode(
         "normalized input: '%s' -> '%s'",
         input.c_str(),
         normalized_input.c_str());
+    text = &normalized_input;
   }
 
-  for (const auto& piece : _pretokenizer->pre_tokenize(normalized_input)) {
+  // The pieces are ranges of the text, so they are only copied for the words
+  // that need merging. Each thread reuses one PreTokenizedString, so the
+  // ranges and rewritten texts keep their capacity from call to call. Past
+  // kMaxKeptPiecesBytes it is freed after the call, so that a single long
+  // input does not stay pinned on every thread that encoded one.
+  thread_local PreTokenizedString pieces;
+  pieces.reset(*text);
+  _pretokenizer->pre_tokenize_spans(pieces);
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    const std::string_view piece = pieces[i];
     // Check if the entire word is already a token to skip merging.
     const auto result = token_map_->tryGetInteger(piece);
     if (result) {
@@ -335,11 +963,16 @@ Error HFTokenizer::_encode(
       ret.push_back(*result);
       continue;
     }
-    auto tokens = TK_UNWRAP(byte_pair_encode_(piece, *token_map_));
+    auto tokens = byte_pair_encode_(std::string(piece), *token_map_);
+    if (!tokens.ok()) {
+      pieces.shrink(kMaxKeptPiecesBytes);
+      return tokens.error();
+    }
 
-    last_piece_token_len = tokens.size();
-    ret.insert(ret.end(), tokens.begin(), tokens.end());
+    last_piece_token_len = tokens.get().size();
+    ret.insert(ret.end(), tokens.get().begin(), tokens.get().end());
   }
+  pieces.shrink(kMaxKeptPiecesBytes);
   return Error::Ok;
 }
 
@@ -351,6 +984,15 @@ void HFTokenizer::_decode(const std::string& input, std::string& ret) const {
   }
 }
 
+void HFTokenizer::_decode_first(const std::string& input, std::string& ret)
+    const {
+  if (_decoder) {
+    ret += _decoder->decode_first(input);
+  } else {
+    ret += input;
+  }
+}
+
 Result<std::vector<uint64_t>> HFTokenizer::byte_pair_encode_(
     const std::string& piece,
     const detail::TokenMap& token_map) const {
@@ -406,7 +1048,10 @@ std::vector<uint64_t> HFTokenizer::_byte_pair_merge(
 
     // Determine UTF-8 character length
     unsigned char byte = static_cast<unsigned char>(piece[i]);
-    if ((byte & 0x80) == 0) {
+    if (raw_byte_keys_) {
+      // Each byte stood for a character of the byte-level alphabet.
+      char_len = 1;
+    } else if ((byte & 0x80) == 0) {
       // ASCII character (0xxxxxxx)
       char_len = 1;
     } else if ((byte & 0xE0) == 0xC0) {
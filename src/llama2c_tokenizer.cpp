@@ -6,8 +6,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 // @lint-ignore-every CLANGTIDY facebook-hte-RelativeInclude
+#include <pytorch/tokenizers/artifact.h>
 #include <pytorch/tokenizers/llama2c_tokenizer.h>
 #include <cstring>
+#include <vector>
 
 namespace tokenizers {
 
@@ -44,14 +46,40 @@ Error Llama2cTokenizer::load(const std::string& tokenizer_path) {
     return Error::Ok;
   }
   // read in the file
-  FILE* file = fopen(tokenizer_path.c_str(), "rb");
-  if (!file) {
+  auto file = detail::MappedFile::open(tokenizer_path);
+  if (!file.ok()) {
     TK_LOG(Error, "couldn't load %s", tokenizer_path.c_str());
     return Error::LoadFailure;
   }
+  if (detail::has_artifact_magic(file.get().view())) {
+    return _load_artifact(
+        TK_UNWRAP(detail::ArtifactReader::from_file(std::move(file.get()))));
+  }
+  return load_from_buffer(file.get().view());
+}
+
+Error Llama2cTokenizer::load_from_buffer(std::string_view data) {
+  if (initialized_) {
+    TK_LOG(Info, "Tokenizer already initialized");
+    return Error::Ok;
+  }
+  if (detail::has_artifact_magic(data)) {
+    return _load_artifact(TK_UNWRAP(detail::ArtifactReader::from_buffer(data)));
+  }
+  // Reads size bytes at the cursor, returns false at the end of the data.
+  size_t cursor = 0;
+  const auto read = [&data, &cursor](void* out, size_t size) {
+    if (size > data.size() - cursor) {
+      return false;
+    }
+    memcpy(out, data.data() + cursor, size);
+    cursor += size;
+    return true;
+  };
+
   int32_t metadata[4];
   for (int i = 0; i < 4; i++) {
-    if (fread(metadata + i, sizeof(int32_t), 1, file) != 1) {
+    if (!read(metadata + i, sizeof(int32_t))) {
       TK_LOG(
           Error,
           "Failed to read the metadata at position %d, the tokenizer file is not valid!",
@@ -69,27 +97,28 @@ Error Llama2cTokenizer::load(const std::string& tokenizer_path) {
   max_token_length_ = metadata[3];
 
   // allocate space for the vocabulary
-  vocab_ = std::make_unique<char*[]>(vocab_size_);
+  vocab_ = std::make_unique<const char*[]>(vocab_size_);
   vocab_scores_ = std::make_unique<float[]>(vocab_size_);
-  sorted_vocab_ = std::make_unique<TokenIndex[]>(vocab_size_);
 
-  // read in the vocabulary
+  // read in the vocabulary. The strings are stored back to back in
+  // vocab_data_, and vocab_ is pointed into it once it stops growing.
+  vocab_data_.clear();
+  vocab_data_.reserve(data.size() - cursor);
+  std::vector<size_t> offsets(vocab_size_);
   for (int i = 0; i < vocab_size_; i++) {
-    if (fread(vocab_scores_.get() + i, sizeof(float), 1, file) != 1) {
+    offsets[i] = vocab_data_.size();
+    if (!read(vocab_scores_.get() + i, sizeof(float))) {
       // This is allowed, we just pad the rest of the vocab with <pad> strings
-      std::string padding = "<pad>";
-      vocab_[i] = new char[padding.length() + 1];
-      strcpy(vocab_[i], padding.c_str());
-      vocab_[i][padding.length()] = '\0';
+      vocab_data_.append("<pad>");
+      vocab_data_.push_back('\0');
       continue;
     }
     int32_t len;
-    if (fread(&len, sizeof(int32_t), 1, file) != 1) {
+    if (!read(&len, sizeof(int32_t))) {
       TK_LOG(Error, "Failed to read the length of the word at index %d", i);
       return Error::ParseFailure;
     }
-    vocab_[i] = new char[len + 1];
-    if (fread(vocab_[i], len, 1, file) != 1) {
+    if (len < 0 || static_cast<size_t>(len) > data.size() - cursor) {
       TK_LOG(
           Error,
           "Failed to read the word, total length %d, index %d\n",
@@ -97,26 +126,124 @@ Error Llama2cTokenizer::load(const std::string& tokenizer_path) {
           i);
       return Error::ParseFailure;
     }
-    vocab_[i][len] = '\0'; // add the string terminating token
+    vocab_data_.append(data.substr(cursor, len));
+    vocab_data_.push_back('\0'); // add the string terminating token
+    cursor += len;
   }
-  fclose(file);
 
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    vocab_[i] = vocab_data_.data() + offsets[i];
+  }
+
+  initialized_ = true;
+  return Error::Ok;
+}
+
+Error Llama2cTokenizer::_init_encoder() const {
+  if (sorted_vocab_) {
+    // Loaded in sorted order from an artifact.
+    return Error::Ok;
+  }
+  sorted_vocab_ = std::make_unique<TokenIndex[]>(vocab_size_);
   for (int32_t i = 0; i < vocab_size_; i++) {
     sorted_vocab_[i].str = vocab_[i];
     sorted_vocab_[i].id = i;
   }
   qsort(sorted_vocab_.get(), vocab_size_, sizeof(TokenIndex), compare_tokens);
+  return Error::Ok;
+}
+
+Error Llama2cTokenizer::_load_artifact(const detail::ArtifactReader& reader) {
+  using detail::ArtifactSection;
+  TK_CHECK_OR_RETURN_ERROR(
+      reader.kind() == detail::ArtifactKind::Llama2cTokenizer,
+      LoadFailure,
+      "not a llama2.c tokenizer artifact");
+
+  const auto metadata = TK_UNWRAP(reader.integers(ArtifactSection::Metadata));
+  const auto vocab = TK_UNWRAP(reader.strings(ArtifactSection::Vocab));
+  const auto scores = TK_UNWRAP(reader.section(ArtifactSection::VocabScores));
+  const auto sorted = TK_UNWRAP(reader.section(ArtifactSection::SortedVocab));
+  TK_CHECK_OR_RETURN_ERROR(
+      metadata.size() >= 4 && metadata[0] == vocab.size() &&
+          scores.size() == vocab.size() * sizeof(float) &&
+          sorted.size() == vocab.size() * sizeof(int32_t),
+      LoadFailure,
+      "invalid llama2.c tokenizer artifact");
+
+  vocab_size_ = static_cast<int32_t>(metadata[0]);
+  bos_tok_ = metadata[1];
+  eos_tok_ = metadata[2];
+  max_token_length_ = static_cast<unsigned int>(metadata[3]);
+
+  // The strings are saved with their terminators, so they are used in place.
+  vocab_ = std::make_unique<const char*[]>(vocab_size_);
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    TK_CHECK_OR_RETURN_ERROR(
+        !vocab[i].empty() && vocab[i].back() == '\0',
+        LoadFailure,
+        "unterminated token %d in artifact",
+        i);
+    vocab_[i] = vocab[i].data();
+  }
+  vocab_scores_ = std::make_unique<float[]>(vocab_size_);
+  memcpy(vocab_scores_.get(), scores.data(), scores.size());
+
+  // The sort order is saved too, so there is nothing to sort.
+  sorted_vocab_ = std::make_unique<TokenIndex[]>(vocab_size_);
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    int32_t id;
+    memcpy(&id, sorted.data() + i * sizeof(int32_t), sizeof(int32_t));
+    TK_CHECK_OR_RETURN_ERROR(
+        id >= 0 && id < vocab_size_,
+        LoadFailure,
+        "invalid sorted token %d in artifact",
+        id);
+    sorted_vocab_[i].str = vocab_[id];
+    sorted_vocab_[i].id = id;
+  }
 
+  vocab_data_.clear();
+  artifact_ = reader.file();
   initialized_ = true;
   return Error::Ok;
 }
 
-Llama2cTokenizer::~Llama2cTokenizer() {
-  for (int i = 0; i < vocab_size_; i++) {
-    delete[] vocab_[i];
+Error Llama2cTokenizer::save(const std::string& artifact_path) const {
+  TK_CHECK_OR_RETURN_ERROR(
+      initialized_, Uninitialized, "cannot save an unloaded tokenizer");
+  TK_CHECK_OK_OR_RETURN_ERROR(
+      encoder_init_.get([this]() { return _init_encoder(); }));
+  using detail::ArtifactSection;
+  detail::ArtifactWriter writer(detail::ArtifactKind::Llama2cTokenizer);
+  writer.add_integers(
+      ArtifactSection::Metadata,
+      {static_cast<uint64_t>(vocab_size_),
+       bos_tok_,
+       eos_tok_,
+       max_token_length_});
+
+  std::vector<std::string_view> vocab(vocab_size_);
+  std::string sorted(vocab_size_ * sizeof(int32_t), '\0');
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    vocab[i] = std::string_view(vocab_[i], strlen(vocab_[i]) + 1);
+    memcpy(
+        sorted.data() + i * sizeof(int32_t),
+        &sorted_vocab_[i].id,
+        sizeof(int32_t));
   }
+  writer.add_strings(ArtifactSection::Vocab, vocab);
+  writer.add(
+      ArtifactSection::VocabScores,
+      std::string(
+          reinterpret_cast<const char*>(vocab_scores_.get()),
+          vocab_size_ * sizeof(float)));
+  writer.add(ArtifactSection::SortedVocab, std::move(sorted));
+  return writer.save(artifact_path);
 }
 
+Llama2cTokenizer::~Llama2cTokenizer() {}
+
 /**
  * @brief Decode a token into string.
  *
@@ -173,6 +300,8 @@ Result<std::vector<uint64_t>> Llama2cTokenizer::encode(
     TK_LOG(Error, "Tokenizer not initialized");
     return Error::Uninitialized;
   }
+  TK_CHECK_OK_OR_RETURN_ERROR(
+      encoder_init_.get([this]() { return _init_encoder(); }));
   // encode the string text (input) into an upper-bound preallocated tokens[]
   // array bos != 0 means prepend the BOS token (=1), eos != 0 means append the
   // EOS token (=2)
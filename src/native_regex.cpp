@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <pytorch/tokenizers/native_regex.h>
+
+// Standard
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// Local
+#include <pytorch/tokenizers/re2_lookahead_regex.h>
+#include <pytorch/tokenizers/re2_regex.h>
+
+namespace tokenizers {
+
+namespace {
+
+// Byte classes. Only ASCII bytes other than \v are scanned natively, \v is
+// \s for PCRE2 but not for RE2.
+enum : uint8_t {
+  kLetter = 1 << 0,
+  kUpper = 1 << 1,
+  kLower = 1 << 2,
+  kDigit = 1 << 3,
+  // \s
+  kSpace = 1 << 4,
+  kNewline = 1 << 5,
+  // \p{P} and \p{S}
+  kPunct = 1 << 6,
+  // [^\s\p{L}\p{N}]
+  kOther = 1 << 7,
+};
+
+constexpr std::array<uint8_t, 256> make_classes() {
+  std::array<uint8_t, 256> classes{};
+  for (int c = 0; c < 0x80; ++c) {
+    uint8_t value = 0;
+    if (c >= 'A' && c <= 'Z') {
+      value = kLetter | kUpper;
+    } else if (c >= 'a' && c <= 'z') {
+      value = kLetter | kLower;
+    } else if (c >= '0' && c <= '9') {
+      value = kDigit;
+    } else if (c == '\r' || c == '\n') {
+      value = kSpace | kNewline;
+    } else if (c == ' ' || c == '\t' || c == '\f') {
+      value = kSpace;
+    } else if (c > ' ' && c < 0x7f) {
+      value = kPunct | kOther;
+    } else {
+      value = kOther;
+    }
+    classes[c] = value;
+  }
+  return classes;
+}
+
+constexpr std::array<uint8_t, 256> kClasses = make_classes();
+
+inline uint8_t class_at(const char* text, std::size_t pos) {
+  return kClasses[static_cast<uint8_t>(text[pos])];
+}
+
+inline bool is_slow(char c) {
+  return static_cast<uint8_t>(c) >= 0x80 || c == '\v';
+}
+
+// Returns the end of the run of bytes in [pos, end) with any of the classes.
+inline std::size_t skip(
+    const char* text,
+    std::size_t pos,
+    std::size_t end,
+    uint8_t classes) {
+  while (pos < end && (class_at(text, pos) & classes)) {
+    ++pos;
+  }
+  return pos;
+}
+
+// Returns the length of 's|'t|'re|'ve|'m|'ll|'d at pos, or 0.
+template <bool IgnoreCase>
+std::size_t contraction(const char* text, std::size_t pos, std::size_t end) {
+  if (pos + 1 >= end || text[pos] != '\'') {
+    return 0;
+  }
+  const auto lower = [](char c) {
+    return IgnoreCase && c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+  };
+  const char first = lower(text[pos + 1]);
+  if (first == 's' || first == 't' || first == 'm' || first == 'd') {
+    return 2;
+  }
+  if (pos + 2 < end) {
+    const char second = lower(text[pos + 2]);
+    if (((first == 'r' || first == 'v') && second == 'e') ||
+        (first == 'l' && second == 'l')) {
+      return 3;
+    }
+  }
+  return 0;
+}
+
+// Matches the whitespace alternatives at pos, which holds \s:
+// \s*[\r\n]+ if NewlineRun, then \s+(?!\S) if Lookahead, then \s+.
+template <bool NewlineRun, bool Lookahead>
+std::size_t whitespace(const char* text, std::size_t pos, std::size_t end) {
+  const std::size_t run_end = skip(text, pos, end, kSpace);
+  if (NewlineRun) {
+    for (std::size_t i = run_end; i > pos; --i) {
+      if (class_at(text, i - 1) & kNewline) {
+        return i;
+      }
+    }
+  }
+  if (Lookahead && run_end < end && run_end - pos > 1) {
+    return run_end - 1;
+  }
+  return run_end;
+}
+
+// 's|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+
+std::size_t scan_gpt2(const char* text, std::size_t pos, std::size_t end) {
+  if (const auto length = contraction<false>(text, pos, end)) {
+    return pos + length;
+  }
+  std::size_t start = pos;
+  if (text[pos] == ' ' && pos + 1 < end &&
+      !(class_at(text, pos + 1) & kSpace)) {
+    ++start;
+  }
+  const uint8_t c = class_at(text, start);
+  for (const uint8_t run : {kLetter, kDigit, kOther}) {
+    if (c & run) {
+      return skip(text, start + 1, end, run);
+    }
+  }
+  return whitespace<false, true>(text, pos, end);
+}
+
+// (?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,MaxDigits}|
+//  ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+
+// where the \s+(?!\S) alternative is only there if Lookahead.
+template <std::size_t MaxDigits, bool Lookahead>
+std::size_t scan_cl100k(const char* text, std::size_t pos, std::size_t end) {
+  if (const auto length = contraction<true>(text, pos, end)) {
+    return pos + length;
+  }
+  const uint8_t c = class_at(text, pos);
+  if (c & kLetter) {
+    return skip(text, pos + 1, end, kLetter);
+  }
+  if (!(c & (kNewline | kDigit)) && pos + 1 < end &&
+      (class_at(text, pos + 1) & kLetter)) {
+    return skip(text, pos + 2, end, kLetter);
+  }
+  if (c & kDigit) {
+    return skip(text, pos + 1, std::min(end, pos + MaxDigits), kDigit);
+  }
+  std::size_t start = pos;
+  if (text[pos] == ' ' && pos + 1 < end && (class_at(text, pos + 1) & kOther)) {
+    ++start;
+  }
+  if (class_at(text, start) & kOther) {
+    return skip(text, skip(text, start + 1, end, kOther), end, kNewline);
+  }
+  return whitespace<true, Lookahead>(text, pos, end);
+}
+
+// [^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+
+// (?i:'s|'t|'re|'ve|'m|'ll|'d)?|[^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}
+// \p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*(?i:'s|'t|'re|'ve|'m|'ll|'d)?|\p{N}{1,3}|
+//  ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+(?!\S)|\s+
+std::size_t scan_o200k(const char* text, std::size_t pos, std::size_t end) {
+  const uint8_t c = class_at(text, pos);
+  std::size_t start = pos;
+  if (!(c & (kLetter | kNewline | kDigit)) && pos + 1 < end) {
+    ++start;
+  }
+  if (class_at(text, start) & kLetter) {
+    // An uppercase run then a lowercase run, or only the uppercase run.
+    const std::size_t upper_end = skip(text, start, end, kUpper);
+    const std::size_t word_end = skip(text, upper_end, end, kLower);
+    return word_end + contraction<true>(text, word_end, end);
+  }
+  if (c & kDigit) {
+    return skip(text, pos + 1, std::min(end, pos + 3), kDigit);
+  }
+  start = pos;
+  if (text[pos] == ' ' && pos + 1 < end && (class_at(text, pos + 1) & kOther)) {
+    ++start;
+  }
+  if (class_at(text, start) & kOther) {
+    std::size_t match_end = skip(text, start + 1, end, kOther);
+    while (match_end < end &&
+           ((class_at(text, match_end) & kNewline) || text[match_end] == '/')) {
+      ++match_end;
+    }
+    return match_end;
+  }
+  return whitespace<true, true>(text, pos, end);
+}
+
+// [!"#$%&'()*+,\-./:;<=>?@\[\\\]^_`{|}~][A-Za-z]+|
+// [^\r\n\p{L}\p{P}\p{S}]?[\p{L}\p{M}]+| ?[\p{P}\p{S}]+[\r\n]*|\s*[\r\n]+|
+// \s+(?!\S)|\s+
+std::size_t scan_deepseek_v3(
+    const char* text,
+    std::size_t pos,
+    std::size_t end) {
+  const uint8_t c = class_at(text, pos);
+  if (c & kLetter) {
+    return skip(text, pos + 1, end, kLetter);
+  }
+  if (!(c & kNewline) && pos + 1 < end && (class_at(text, pos + 1) & kLetter)) {
+    return skip(text, pos + 2, end, kLetter);
+  }
+  std::size_t start = pos;
+  if (text[pos] == ' ' && pos + 1 < end && (class_at(text, pos + 1) & kPunct)) {
+    ++start;
+  }
+  if (class_at(text, start) & kPunct) {
+    return skip(text, skip(text, start + 1, end, kPunct), end, kNewline);
+  }
+  if (c & kSpace) {
+    return whitespace<true, true>(text, pos, end);
+  }
+  // Digits and control characters are not matched.
+  return pos;
+}
+
+// Returns the position of the first byte in [pos, end) that is not scanned
+// natively, or end.
+std::size_t find_slow(const char* text, std::size_t pos, std::size_t end) {
+  constexpr uint64_t kOnes = 0x0101010101010101ull;
+  constexpr uint64_t kHighBits = 0x8080808080808080ull;
+  constexpr uint64_t kVerticalTabs = kOnes * '\v';
+  for (; pos + 8 <= end; pos += 8) {
+    uint64_t word;
+    std::memcpy(&word, text + pos, sizeof(word));
+    const uint64_t tabs = word ^ kVerticalTabs;
+    if ((word | ((tabs - kOnes) & ~tabs)) & kHighBits) {
+      break;
+    }
+  }
+  while (pos < end && !is_slow(text[pos])) {
+    ++pos;
+  }
+  return pos;
+}
+
+// A position after an ASCII letter that holds a space. All the patterns end a
+// match there, and what they match after it does not depend on the text
+// before it.
+inline bool is_cut(const char* text, std::size_t pos) {
+  return text[pos] == ' ' && (class_at(text, pos - 1) & kLetter);
+}
+
+struct KnownPattern {
+  NativeRegex::Pattern pattern;
+  const char* regex;
+};
+
+constexpr KnownPattern kKnownPatterns[] = {
+    {NativeRegex::Pattern::Gpt2,
+     R"('s|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+)"},
+    {NativeRegex::Pattern::Cl100k,
+     R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)"},
+    {NativeRegex::Pattern::Cl100kNoLookahead,
+     R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+)"},
+    {NativeRegex::Pattern::Qwen2,
+     R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)"},
+    {NativeRegex::Pattern::O200k,
+     R"([^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+(?i:'s|'t|'re|'ve|'m|'ll|'d)?|[^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*(?i:'s|'t|'re|'ve|'m|'ll|'d)?|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+(?!\S)|\s+)"},
+    {NativeRegex::Pattern::DeepSeekV3,
+     R"([!"#$%&'()*+,\-./:;<=>?@\[\\\]^_`{|}~][A-Za-z]+|[^\r\n\p{L}\p{P}\p{S}]?[\p{L}\p{M}]+| ?[\p{P}\p{S}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)"},
+};
+
+} // namespace
+
+std::optional<NativeRegex::Pattern> NativeRegex::recognize(
+    const std::string& pattern) {
+  // tokenizer.json files spell \r and \n in character classes either escaped
+  // or as the characters themselves.
+  std::string normalized;
+  normalized.reserve(pattern.size());
+  for (const char c : pattern) {
+    if (c == '\r') {
+      normalized += "\\r";
+    } else if (c == '\n') {
+      normalized += "\\n";
+    } else {
+      normalized += c;
+    }
+  }
+  for (const auto& known : kKnownPatterns) {
+    if (normalized == known.regex) {
+      return known.pattern;
+    }
+  }
+  return std::nullopt;
+}
+
+Error NativeRegex::compile(const std::string& pattern) {
+  const auto kind = recognize(pattern);
+  if (!kind) {
+    TK_LOG(Error, "No native scanner for regex: %s", pattern.c_str());
+    return Error::RegexFailure;
+  }
+  switch (*kind) {
+    case Pattern::Gpt2:
+      scanner_ = scan_gpt2;
+      break;
+    case Pattern::Cl100k:
+      scanner_ = scan_cl100k<3, true>;
+      break;
+    case Pattern::Cl100kNoLookahead:
+      scanner_ = scan_cl100k<3, false>;
+      break;
+    case Pattern::Qwen2:
+      scanner_ = scan_cl100k<1, true>;
+      break;
+    case Pattern::O200k:
+      scanner_ = scan_o200k;
+      break;
+    case Pattern::DeepSeekV3:
+      scanner_ = scan_deepseek_v3;
+      break;
+  }
+
+  // The same engine create_regex() uses for the pattern: RE2, RE2 with the
+  // lookahead emulated, or the registered fallback.
+  auto lookahead = std::make_unique<Re2LookaheadRegex>();
+  if (pattern.find("(?!") == std::string::npos) {
+    auto re2 = std::make_unique<Re2Regex>();
+    TK_CHECK_OK_OR_RETURN_ERROR(re2->compile(pattern));
+    fallback_ = std::move(re2);
+  } else if (lookahead->compile(pattern) == Error::Ok) {
+    fallback_ = std::move(lookahead);
+  } else {
+    auto fallback = get_fallback_regex()(pattern);
+    TK_CHECK_OK_OR_RETURN_ERROR(fallback.error());
+    fallback_ = std::move(fallback.get());
+  }
+  return Error::Ok;
+}
+
+std::vector<Match> NativeRegex::find_all(const std::string& text) const {
+  std::vector<Match> result;
+  find_all_into(text, result);
+  return result;
+}
+
+void NativeRegex::find_all_into(
+    const std::string& text,
+    std::vector<Match>& result) const {
+  result.clear();
+  if (!scanner_ || !fallback_) {
+    TK_LOG(Error, "Regex is not compiled or invalid, run compile() first");
+    return;
+  }
+  const char* data = text.data();
+  const std::size_t size = text.size();
+  result.reserve(size / 4);
+  std::vector<Match> fallback_matches;
+
+  const auto scan = [&](std::size_t pos, std::size_t end) {
+    while (pos < end) {
+      const std::size_t match_end = scanner_(data, pos, end);
+      if (match_end == pos) {
+        ++pos;
+        continue;
+      }
+      result.push_back({pos, match_end});
+      pos = match_end;
+    }
+  };
+
+  std::size_t pos = 0;
+  while (pos < size) {
+    const std::size_t slow = find_slow(data, pos, size);
+    if (slow == size) {
+      scan(pos, size);
+      break;
+    }
+    // Hand the text between the cuts around the slow byte to the fallback.
+    std::size_t begin = slow;
+    while (begin > pos && !is_cut(data, begin)) {
+      --begin;
+    }
+    std::size_t end = slow + 1;
+    while (end < size && !is_cut(data, end)) {
+      end = std::find(data + end + 1, data + size, ' ') - data;
+    }
+    scan(pos, begin);
+    fallback_->find_all_into(
+        text.substr(begin, end - begin), fallback_matches);
+    for (const auto& match : fallback_matches) {
+      result.push_back({begin + match.start, begin + match.end});
+    }
+    pos = end;
+  }
+}
+
+} // namespace tokenizers
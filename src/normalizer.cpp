@@ -15,6 +15,7 @@
 
 // Standard
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <utility>
 
@@ -95,25 +96,88 @@ NormalizerConfig& NormalizerConfig::parse_json(const json& json_config) {
 
 // ReplaceNormalizer ///////////////////////////////////////////////////////////
 
-std::unique_ptr<IRegex> ReplaceNormalizer::create_regex_(
+std::shared_ptr<const IRegex> ReplaceNormalizer::create_regex_(
     const std::string& pattern) {
   assert(!pattern.empty());
-  return TK_UNWRAP_THROW(create_regex(pattern));
+  return TK_UNWRAP_THROW(get_shared_regex(pattern));
+}
+
+std::optional<std::string> ReplaceNormalizer::literal_of_(
+    const std::string& pattern) {
+  // The characters that IRegex::escape escapes.
+  constexpr char kSpecial[] = "\\^$.|?*+()[]{}";
+  std::string literal;
+  literal.reserve(pattern.size());
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    char c = pattern[i];
+    if (c == '\\') {
+      if (i + 1 == pattern.size() ||
+          std::strchr(kSpecial, pattern[i + 1]) == nullptr) {
+        // An escape such as \s or \d that stands for more than itself.
+        return std::nullopt;
+      }
+      c = pattern[++i];
+    } else if (std::strchr(kSpecial, c) != nullptr) {
+      return std::nullopt;
+    }
+    literal += c;
+  }
+  if (literal.empty()) {
+    return std::nullopt;
+  }
+  return literal;
 }
 
 std::string ReplaceNormalizer::normalize(const std::string& input) const {
-  if (!regex_)
+  if (!literal_ && !regex_)
     return input;
 
-  std::string result = input;
-  auto matches = regex_->find_all(result);
-
-  // Process matches in reverse order to avoid offset issues
-  for (auto it = matches.rbegin(); it != matches.rend(); ++it) {
-    const auto& match = *it;
-    result.replace(match.start, match.end - match.start, content_);
+  // Copy the text between matches and the replacements into the result in one
+  // pass, rather than splicing each replacement into a copy of the input.
+  const char* const data = input.data();
+  const std::size_t size = input.size();
+  std::string result;
+  std::size_t copied = 0;
+  const auto replace = [&](std::size_t start, std::size_t end) {
+    result.append(data + copied, start - copied);
+    result.append(content_);
+    copied = end;
+  };
+
+  if (literal_) {
+    // memchr finds the candidates for the first byte, which is vectorized in
+    // the common C libraries, and memcmp checks the rest.
+    const char* const needle = literal_->data();
+    const std::size_t length = literal_->size();
+    result.reserve(size);
+    std::size_t pos = 0;
+    while (size - pos >= length) {
+      const void* found =
+          std::memchr(data + pos, needle[0], size - pos - length + 1);
+      if (found == nullptr) {
+        break;
+      }
+      const std::size_t start = static_cast<const char*>(found) - data;
+      if (std::memcmp(data + start + 1, needle + 1, length - 1) == 0) {
+        replace(start, start + length);
+        pos = start + length;
+      } else {
+        pos = start + 1;
+      }
+    }
+  } else {
+    const auto matches = regex_->find_all(input);
+    std::size_t matched = 0;
+    for (const auto& match : matches) {
+      matched += match.end - match.start;
+    }
+    result.reserve(size - matched + matches.size() * content_.size());
+    for (const auto& match : matches) {
+      replace(match.start, match.end);
+    }
   }
 
+  result.append(data + copied, size - copied);
   return result;
 }
 
@@ -6,7 +6,6 @@
  * LICENSE file in the root directory of this source tree.
  */
 
-#include <iostream>
 #include <vector>
 
 #include <pytorch/tokenizers/pcre2_regex.h>
@@ -17,6 +16,10 @@ Error Pcre2Regex::compile(const std::string& pattern) {
   int error_code;
   PCRE2_SIZE error_offset;
 
+  if (regex_) {
+    pcre2_code_free(regex_);
+  }
+
   // Compile the pattern
   regex_ = pcre2_compile(
       reinterpret_cast<PCRE2_SPTR>(pattern.c_str()),
@@ -37,39 +40,92 @@ Error Pcre2Regex::compile(const std::string& pattern) {
     return Error::RegexFailure;
   }
 
-  // Create match data
-  match_data_ = pcre2_match_data_create_from_pattern(regex_, nullptr);
-  if (match_data_ == nullptr) {
-    pcre2_code_free(regex_);
-    regex_ = nullptr;
-    TK_LOG(Error, "Failed to create PCRE2 match data");
-    return Error::RegexFailure;
-  }
+  // Matching falls back to the interpreter if PCRE2 has no JIT support.
+  jit_ = pcre2_jit_compile(regex_, PCRE2_JIT_COMPLETE) == 0;
 
   return Error::Ok;
 }
 
 Pcre2Regex::~Pcre2Regex() {
-  if (match_data_) {
-    pcre2_match_data_free(match_data_);
-  }
   if (regex_) {
     pcre2_code_free(regex_);
   }
 }
 
+namespace {
+
+// The per-thread state of pcre2_match(). Only the overall match is read, so
+// a single ovector pair serves every pattern.
+class ThreadMatchState {
+ public:
+  ThreadMatchState()
+      : match_data_(pcre2_match_data_create(1, nullptr)),
+        context_(pcre2_match_context_create(nullptr)),
+        jit_stack_(
+            pcre2_jit_stack_create(kJitStackStart, kJitStackMax, nullptr)) {
+    if (context_ && jit_stack_) {
+      pcre2_jit_stack_assign(context_, nullptr, jit_stack_);
+    }
+  }
+
+  ~ThreadMatchState() {
+    pcre2_jit_stack_free(jit_stack_);
+    pcre2_match_context_free(context_);
+    pcre2_match_data_free(match_data_);
+  }
+
+  ThreadMatchState(const ThreadMatchState&) = delete;
+  ThreadMatchState& operator=(const ThreadMatchState&) = delete;
+
+  pcre2_match_data* match_data() const {
+    return match_data_;
+  }
+
+  pcre2_match_context* context() const {
+    return context_;
+  }
+
+ private:
+  // The default JIT stack lives on the machine stack and is 32 KB, which long
+  // runs of whitespace under \s+(?!\S) can exhaust.
+  static constexpr PCRE2_SIZE kJitStackStart = 32 * 1024;
+  static constexpr PCRE2_SIZE kJitStackMax = 8 * 1024 * 1024;
+
+  pcre2_match_data* match_data_;
+  pcre2_match_context* context_;
+  pcre2_jit_stack* jit_stack_;
+};
+
+} // namespace
+
 std::vector<Match> Pcre2Regex::find_all(const std::string& text) const {
   std::vector<Match> result;
+  find_all_into(text, result);
+  return result;
+}
 
-  if (!regex_ || !match_data_) {
+void Pcre2Regex::find_all_into(
+    const std::string& text,
+    std::vector<Match>& result) const {
+  result.clear();
+  if (!regex_) {
     TK_LOG(Error, "Regex is not compiled or invalid, run compile() first");
-    return result;
+    return;
+  }
+
+  thread_local ThreadMatchState state;
+  if (!state.match_data()) {
+    TK_LOG(Error, "Failed to create PCRE2 match data");
+    return;
   }
 
-  PCRE2_SIZE* ovector;
   PCRE2_SPTR subject = reinterpret_cast<PCRE2_SPTR>(text.c_str());
   PCRE2_SIZE subject_length = text.length();
   PCRE2_SIZE offset = 0;
+  // PCRE2 validates the whole subject on every call unless told otherwise,
+  // which makes matching quadratic. Validating it on the first call is
+  // enough.
+  uint32_t options = 0;
 
   while (offset < subject_length) {
     int rc = pcre2_match(
@@ -77,23 +133,23 @@ std::vector<Match> Pcre2Regex::find_all(const std::string& text) const {
         subject,
         subject_length,
         offset,
-        0, // Default options
-        match_data_,
-        nullptr);
+        options,
+        state.match_data(),
+        state.context());
+    options = PCRE2_NO_UTF_CHECK;
 
+    // rc == 0 means that the capture groups did not fit in the match data,
+    // which still holds the overall match.
     if (rc < 0) {
-      if (rc == PCRE2_ERROR_NOMATCH) {
-        break; // No more matches
-      } else {
-        // Error occurred
+      if (rc != PCRE2_ERROR_NOMATCH) {
         PCRE2_UCHAR error_buffer[256];
         pcre2_get_error_message(rc, error_buffer, sizeof(error_buffer));
-        std::cerr << "PCRE2 matching error: " << error_buffer << std::endl;
-        break;
+        TK_LOG(Error, "PCRE2 matching error: %s", error_buffer);
       }
+      break;
     }
 
-    ovector = pcre2_get_ovector_pointer(match_data_);
+    const PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(state.match_data());
 
     // Add the match to the result
     result.push_back({ovector[0], ovector[1]});
@@ -104,11 +160,11 @@ std::vector<Match> Pcre2Regex::find_all(const std::string& text) const {
     // If the match was empty, move forward by one character to avoid infinite
     // loop
     if (ovector[0] == ovector[1]) {
-      offset++;
+      do {
+        ++offset;
+      } while (offset < subject_length && (subject[offset] & 0xc0) == 0x80);
     }
   }
-
-  return result;
 }
 
 } // namespace tokenizers
@@ -8,11 +8,15 @@
 // @lint-ignore-every LICENSELINT
 
 // Local
+#include <pytorch/tokenizers/codepoint_table.h>
 #include <pytorch/tokenizers/pre_tokenizer.h>
 #include <unicode.h>
 
 // Standard
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include <iterator>
 #include <utility>
 
@@ -23,6 +27,159 @@ using json = nlohmann::json;
 
 namespace tokenizers {
 
+// PreTokenizedString ////////////////////////////////////////////////////////
+
+void PreTokenizedString::reset(const std::string& input) {
+  text_ = &input;
+  ranges_.assign(1, {0, input.size()});
+  next_ranges_.clear();
+  current_buffer_ = -1;
+  next_buffer_ = -1;
+}
+
+const std::string& PreTokenizedString::piece_string(std::size_t i) {
+  const Match& range = ranges_[i];
+  if (range.start == 0 && range.end == text_->size()) {
+    return *text_;
+  }
+  piece_.assign(*text_, range.start, range.end - range.start);
+  return piece_;
+}
+
+std::vector<std::string> PreTokenizedString::to_strings() const {
+  std::vector<std::string> result;
+  result.reserve(ranges_.size());
+  for (std::size_t i = 0; i < ranges_.size(); ++i) {
+    result.emplace_back((*this)[i]);
+  }
+  return result;
+}
+
+void PreTokenizedString::begin_split() {
+  next_ranges_.clear();
+  next_buffer_ = -1;
+}
+
+std::string& PreTokenizedString::begin_rewrite() {
+  next_ranges_.clear();
+  next_buffer_ = current_buffer_ == 0 ? 1 : 0;
+  buffers_[next_buffer_].clear();
+  return buffers_[next_buffer_];
+}
+
+void PreTokenizedString::commit() {
+  ranges_.swap(next_ranges_);
+  next_ranges_.clear();
+  if (next_buffer_ >= 0) {
+    text_ = &buffers_[next_buffer_];
+    current_buffer_ = next_buffer_;
+    next_buffer_ = -1;
+  }
+}
+
+std::size_t PreTokenizedString::capacity_bytes() const {
+  return (ranges_.capacity() + next_ranges_.capacity()) * sizeof(Match) +
+      buffers_[0].capacity() + buffers_[1].capacity() + piece_.capacity();
+}
+
+void PreTokenizedString::shrink(std::size_t max_bytes) {
+  const bool release = capacity_bytes() > max_bytes;
+  text_ = &empty_;
+  current_buffer_ = -1;
+  next_buffer_ = -1;
+  if (release) {
+    std::vector<Match>().swap(ranges_);
+    std::vector<Match>().swap(next_ranges_);
+    std::string().swap(buffers_[0]);
+    std::string().swap(buffers_[1]);
+    std::string().swap(piece_);
+  } else {
+    ranges_.clear();
+    next_ranges_.clear();
+  }
+}
+
+// PreTokenizer ////////////////////////////////////////////////////////////////
+
+void PreTokenizer::pre_tokenize_spans(PreTokenizedString& pieces) const {
+  std::string& text = pieces.begin_rewrite();
+  for (std::size_t i = 0; i < pieces.size(); ++i) {
+    for (const auto& subpiece : pre_tokenize(pieces.piece_string(i))) {
+      const std::size_t start = text.size();
+      text += subpiece;
+      pieces.add_piece(start, text.size());
+    }
+  }
+  pieces.commit();
+}
+
+void PreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& buffers,
+    const RangeCallback& emit) const {
+  buffers.piece.assign(text, start, end - start);
+  size_t offset = 0;
+  for (const auto& subpiece : pre_tokenize(buffers.piece)) {
+    const size_t found = buffers.piece.find(subpiece, offset);
+    if (found == std::string::npos) {
+      // splits_only() promised pieces of the input, in order. Keep the rest
+      // of the text as one piece rather than dropping it from the encoding.
+      TK_LOG(
+          Error,
+          "splits_only() pre-tokenizer returned a piece that does not follow "
+          "the previous one in its input");
+      if (offset < buffers.piece.size()) {
+        emit(start + offset, end);
+      }
+      return;
+    }
+    offset = found + subpiece.size();
+    emit(start + found, start + offset);
+  }
+}
+
+// SplitPreTokenizer ///////////////////////////////////////////////////////////
+
+std::vector<std::string> SplitPreTokenizer::pre_tokenize(
+    const std::string& input) const {
+  PreTokenizedString pieces(input);
+  pre_tokenize_spans(pieces);
+  return pieces.to_strings();
+}
+
+void SplitPreTokenizer::pre_tokenize_spans(PreTokenizedString& pieces) const {
+  pieces.begin_split();
+  SplitBuffers buffers;
+  const RangeCallback add = [&pieces](size_t start, size_t end) {
+    pieces.add_piece(start, end);
+  };
+  for (const auto& range : pieces.ranges()) {
+    split_range(pieces.text(), range.start, range.end, buffers, add);
+  }
+  pieces.commit();
+}
+
+SplitDelimiterBehavior parse_split_delimiter_behavior(const std::string& name) {
+  if (name == "Removed") {
+    return SplitDelimiterBehavior::Removed;
+  }
+  if (name == "Isolated") {
+    return SplitDelimiterBehavior::Isolated;
+  }
+  if (name == "MergedWithPrevious") {
+    return SplitDelimiterBehavior::MergedWithPrevious;
+  }
+  if (name == "MergedWithNext") {
+    return SplitDelimiterBehavior::MergedWithNext;
+  }
+  if (name == "Contiguous") {
+    return SplitDelimiterBehavior::Contiguous;
+  }
+  throw std::runtime_error("Unsupported behavior: " + name);
+}
+
 // PreTokenizerConfig //////////////////////////////////////////////////////////
 
 PreTokenizerConfig::PreTokenizerConfig(std::string type)
@@ -63,18 +220,47 @@ PreTokenizer::Ptr PreTokenizerConfig::create() const {
     }
     return PreTokenizer::Ptr(new DigitsPreTokenizer());
   }
-  if (type == "ByteLevel") {
-    if (add_prefix_space && pattern) {
-      return PreTokenizer::Ptr(
-          new ByteLevelPreTokenizer(*add_prefix_space, *pattern));
-    }
-    if (add_prefix_space) {
-      return PreTokenizer::Ptr(new ByteLevelPreTokenizer(*add_prefix_space));
+  if (type == "Whitespace") {
+    return PreTokenizer::Ptr(new WhitespacePreTokenizer());
+  }
+  if (type == "WhitespaceSplit") {
+    return PreTokenizer::Ptr(new WhitespaceSplitPreTokenizer());
+  }
+  if (type == "Punctuation") {
+    return PreTokenizer::Ptr(
+        new PunctuationPreTokenizer(behavior ? *behavior : "Isolated"));
+  }
+  if (type == "CharDelimiterSplit") {
+    if (!delimiter) {
+      throw std::runtime_error(
+          "Missing delimiter for PreTokenizer of type CharDelimiterSplit");
     }
-    if (pattern) {
-      return PreTokenizer::Ptr(new ByteLevelPreTokenizer(*pattern));
+    return PreTokenizer::Ptr(new CharDelimiterSplitPreTokenizer(*delimiter));
+  }
+  if (type == "UnicodeScripts") {
+    return PreTokenizer::Ptr(new UnicodeScriptsPreTokenizer());
+  }
+  if (type == "BertPreTokenizer") {
+    return PreTokenizer::Ptr(new BertPreTokenizer());
+  }
+  if (type == "Metaspace") {
+    // Configs from before prepend_scheme have add_prefix_space instead.
+    std::string scheme = "always";
+    if (prepend_scheme) {
+      scheme = *prepend_scheme;
+    } else if (add_prefix_space && !*add_prefix_space) {
+      scheme = "never";
     }
-    return PreTokenizer::Ptr(new ByteLevelPreTokenizer());
+    return PreTokenizer::Ptr(new MetaspacePreTokenizer(
+        replacement ? *replacement : "\xe2\x96\x81",
+        scheme,
+        split ? *split : true));
+  }
+  if (type == "ByteLevel") {
+    return PreTokenizer::Ptr(new ByteLevelPreTokenizer(
+        add_prefix_space ? *add_prefix_space : true,
+        pattern ? *pattern : "",
+        map_bytes ? *map_bytes : true));
   }
   if (type == "Sequence") {
     if (!pretokenizers or pretokenizers->empty()) {
@@ -124,6 +310,34 @@ PreTokenizerConfig& PreTokenizerConfig::parse_json(const json& json_config) {
       individual_digits = json_config.at("individual_digits");
     } catch (json::out_of_range&) {
     }
+  } else if (
+      type == "Whitespace" || type == "WhitespaceSplit" ||
+      type == "UnicodeScripts" || type == "BertPreTokenizer") {
+    // No parameters
+  } else if (type == "Punctuation") {
+    try {
+      behavior = json_config.at("behavior");
+    } catch (json::out_of_range&) {
+    }
+  } else if (type == "CharDelimiterSplit") {
+    delimiter = json_config.at("delimiter");
+  } else if (type == "Metaspace") {
+    try {
+      replacement = json_config.at("replacement");
+    } catch (json::out_of_range&) {
+    }
+    try {
+      prepend_scheme = json_config.at("prepend_scheme");
+    } catch (json::out_of_range&) {
+    }
+    try {
+      add_prefix_space = json_config.at("add_prefix_space");
+    } catch (json::out_of_range&) {
+    }
+    try {
+      split = json_config.at("split");
+    } catch (json::out_of_range&) {
+    }
   } else if (type == "ByteLevel") {
     try {
       add_prefix_space = json_config.at("add_prefix_space");
@@ -143,101 +357,440 @@ PreTokenizerConfig& PreTokenizerConfig::parse_json(const json& json_config) {
 
 // RegexPreTokenizer ///////////////////////////////////////////////////////////
 
-std::unique_ptr<IRegex> RegexPreTokenizer::create_regex_(
+std::shared_ptr<const IRegex> RegexPreTokenizer::create_regex_(
     const std::string& pattern) {
   assert(!pattern.empty());
-  return TK_UNWRAP_THROW(create_regex(pattern));
+  return TK_UNWRAP_THROW(get_shared_regex(pattern));
 }
 
-std::vector<std::string> RegexPreTokenizer::pre_tokenize(
-    const std::string& input) const {
-  if (!regex_)
+std::vector<std::string> RegexPreTokenizer::regex_backends() const {
+  if (!regex_) {
     return {};
+  }
+  return {regex_->backend_name()};
+}
 
-  std::vector<std::string> results;
-  auto matches = regex_->find_all(input);
-
+void RegexPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& buffers,
+    const RangeCallback& emit) const {
+  if (!regex_) {
+    return;
+  }
+  // The regex needs the piece as a string of its own, unless it is the whole
+  // text.
+  const std::string* piece = &text;
+  if (start != 0 || end != text.size()) {
+    buffers.piece.assign(text, start, end - start);
+    piece = &buffers.piece;
+  }
+  const std::string& input = *piece;
+  const auto add = [&emit, start](size_t piece_start, size_t piece_end) {
+    emit(start + piece_start, start + piece_end);
+  };
+  auto& matches = buffers.matches;
+  regex_->find_all_into(input, matches);
   if (!is_delimiter_) {
     // Original behavior: return the matches themselves
     for (const auto& match : matches) {
-      results.push_back(input.substr(match.start, match.end - match.start));
+      add(match.start, match.end);
     }
-  } else {
-    // Delimiter behavior
-    if (matches.empty()) {
-      // No matches found, return the entire input
-      results.push_back(input);
-      return results;
-    }
-
-    if (behavior_ == "MergedWithPrevious") {
-      // MergedWithPrevious: Include delimiter with previous token
-      // Example: "the-final--countdown" with delimiter "-"
-      // -> ["the-", "final-", "-", "countdown"]
-      size_t last_end = 0;
-
-      for (size_t i = 0; i < matches.size(); ++i) {
-        const auto& match = matches[i];
-
-        // Add text before the match plus the delimiter
-        if (match.start > last_end) {
-          std::string token = input.substr(last_end, match.end - last_end);
-          results.push_back(token);
-        } else {
-          // Only delimiter, no preceding text
-          std::string delimiter =
-              input.substr(match.start, match.end - match.start);
-          results.push_back(delimiter);
+    return;
+  }
+  // Delimiter behavior
+  if (matches.empty()) {
+    // No matches found, return the entire input
+    add(0, input.size());
+    return;
+  }
+  if (behavior_ == "MergedWithPrevious") {
+    // MergedWithPrevious: Include delimiter with previous token
+    // Example: "the-final--countdown" with delimiter "-"
+    // -> ["the-", "final-", "-", "countdown"]
+    size_t last_end = 0;
+    for (const auto& match : matches) {
+      // Add text before the match plus the delimiter, or only the delimiter
+      // if there is no preceding text
+      add(match.start > last_end ? last_end : match.start, match.end);
+      last_end = match.end;
+    }
+    // Add remaining text after the last match (if any)
+    if (last_end < input.length()) {
+      add(last_end, input.length());
+    }
+  } else if (behavior_ == "Isolated") {
+    // Isolated: Keep delimiters as separate tokens
+    // Example: "the-final--countdown" with delimiter "-"
+    // -> ["the", "-", "final", "-", "-", "countdown"]
+    size_t last_end = 0;
+    for (const auto& match : matches) {
+      // Add text before the match (if any)
+      if (match.start > last_end) {
+        add(last_end, match.start);
+      }
+      // Add the delimiter itself as a separate token
+      add(match.start, match.end);
+      last_end = match.end;
+    }
+    // Add remaining text after the last match (if any)
+    if (last_end < input.length()) {
+      add(last_end, input.length());
+    }
+  } else if (behavior_ == "Removed" || behavior_.empty()) {
+    // Default delimiter behavior (split on delimiters, remove delimiters)
+    size_t last_end = 0;
+    for (const auto& match : matches) {
+      // Add text before the match (if any)
+      if (match.start > last_end) {
+        add(last_end, match.start);
+      }
+      last_end = match.end;
+    }
+    // Add remaining text after the last match (if any)
+    if (last_end < input.length()) {
+      add(last_end, input.length());
+    }
+  }
+}
+
+// Native splitters ///////////////////////////////////////////////////////////
+
+namespace {
+
+using detail::CodepointClass;
+using detail::CodepointTable;
+
+// What split_runs() does with a character: drop it, make it a piece of its
+// own, or join it to the characters next to it that have the same role.
+enum class CharRole : uint8_t { Drop, Isolate, JoinA, JoinB };
+
+// Splits text[start, end) into pieces by the role that classify gives the
+// CodepointClass of each character, calling add with the start and end of
+// each piece and the role of its characters.
+template <typename TClassify, typename TAdd>
+void split_runs(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    TClassify classify,
+    TAdd add) {
+  const CodepointTable& table = CodepointTable::get();
+  size_t run_start = start;
+  CharRole run_role = CharRole::Drop;
+  size_t length = 0;
+  for (size_t pos = start; pos < end; pos += length) {
+    const CharRole role = classify(table.classify(text, pos, end, length));
+    if (role == run_role && role != CharRole::Isolate) {
+      continue;
+    }
+    if (run_role != CharRole::Drop && pos > run_start) {
+      add(run_start, pos, run_role);
+    }
+    run_start = pos;
+    run_role = role;
+  }
+  if (run_role != CharRole::Drop && end > run_start) {
+    add(run_start, end, run_role);
+  }
+}
+
+template <typename TClassify>
+void split_runs(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    TClassify classify,
+    const PreTokenizer::RangeCallback& emit) {
+  split_runs(
+      text, start, end, classify, [&emit](size_t s, size_t e, CharRole) {
+        emit(s, e);
+      });
+}
+
+// The role of a delimiter for the behaviors that split_runs() handles on its
+// own. MergedWithPrevious and MergedWithNext isolate it, and merge after.
+CharRole delimiter_role(SplitDelimiterBehavior behavior) {
+  switch (behavior) {
+    case SplitDelimiterBehavior::Removed:
+      return CharRole::Drop;
+    case SplitDelimiterBehavior::Contiguous:
+      return CharRole::JoinB;
+    default:
+      return CharRole::Isolate;
+  }
+}
+
+// Returns the codepoint of a string of one UTF-8 character.
+uint32_t single_codepoint(const std::string& str) {
+  size_t length = 0;
+  if (!str.empty()) {
+    const uint32_t cp = CodepointTable::decode(str, 0, str.size(), length);
+    if (length == str.size()) {
+      return cp;
+    }
+  }
+  throw std::runtime_error("Expected a single character: " + str);
+}
+
+} // namespace
+
+void DigitsPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  const CharRole digit_role =
+      individual_digits_ ? CharRole::Isolate : CharRole::JoinB;
+  split_runs(
+      text,
+      start,
+      end,
+      [digit_role](CodepointClass c) {
+        return c.is(CodepointClass::kNumeric) ? digit_role : CharRole::JoinA;
+      },
+      emit);
+}
+
+void WhitespacePreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  split_runs(
+      text,
+      start,
+      end,
+      [](CodepointClass c) {
+        return c.is(CodepointClass::kWord) ? CharRole::JoinA
+            : c.is(CodepointClass::kWhitespace) ? CharRole::Drop
+                                                 : CharRole::JoinB;
+      },
+      emit);
+}
+
+void WhitespaceSplitPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  split_runs(
+      text,
+      start,
+      end,
+      [](CodepointClass c) {
+        return c.is(CodepointClass::kWhitespace) ? CharRole::Drop
+                                                 : CharRole::JoinA;
+      },
+      emit);
+}
+
+void PunctuationPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  const CharRole punctuation_role = delimiter_role(behavior_);
+  const auto classify = [punctuation_role](CodepointClass c) {
+    return c.is(CodepointClass::kPunctuation) ? punctuation_role
+                                              : CharRole::JoinA;
+  };
+  if (behavior_ != SplitDelimiterBehavior::MergedWithPrevious &&
+      behavior_ != SplitDelimiterBehavior::MergedWithNext) {
+    split_runs(text, start, end, classify, emit);
+    return;
+  }
+
+  // Hold each piece back until the next one shows whether they merge. A
+  // delimiter merges with the piece before or after it, unless that piece is
+  // a delimiter too.
+  const bool with_previous =
+      behavior_ == SplitDelimiterBehavior::MergedWithPrevious;
+  bool held = false;
+  bool held_delimiter = false;
+  size_t held_start = 0;
+  size_t held_end = 0;
+  split_runs(
+      text, start, end, classify, [&](size_t s, size_t e, CharRole role) {
+        const bool delimiter = role == CharRole::Isolate;
+        if (held) {
+          if (with_previous ? delimiter && !held_delimiter
+                            : !delimiter && held_delimiter) {
+            held_end = e;
+            held_delimiter = delimiter;
+            return;
+          }
+          emit(held_start, held_end);
         }
+        held = true;
+        held_delimiter = delimiter;
+        held_start = s;
+        held_end = e;
+      });
+  if (held) {
+    emit(held_start, held_end);
+  }
+}
 
-        last_end = match.end;
+CharDelimiterSplitPreTokenizer::CharDelimiterSplitPreTokenizer(
+    const std::string& delimiter)
+    : delimiter_(single_codepoint(delimiter)) {}
+
+void CharDelimiterSplitPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  size_t run_start = start;
+  size_t length = 0;
+  for (size_t pos = start; pos < end; pos += length) {
+    if (CodepointTable::decode(text, pos, end, length) == delimiter_) {
+      if (pos > run_start) {
+        emit(run_start, pos);
       }
+      run_start = pos + length;
+    }
+  }
+  if (end > run_start) {
+    emit(run_start, end);
+  }
+}
 
-      // Add remaining text after the last match (if any)
-      if (last_end < input.length()) {
-        results.push_back(input.substr(last_end));
+void UnicodeScriptsPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  const CodepointTable& table = CodepointTable::get();
+  // A piece starts at each character whose script differs from the last
+  // script seen, so the characters of any script before the first one are
+  // dropped.
+  bool started = false;
+  size_t piece_start = start;
+  uint8_t last_script = CodepointClass::kAnyScript;
+  size_t length = 0;
+  for (size_t pos = start; pos < end; pos += length) {
+    const uint8_t script = table.classify(text, pos, end, length).script;
+    if (script == CodepointClass::kAnyScript) {
+      continue;
+    }
+    if (!started || script != last_script) {
+      if (started) {
+        emit(piece_start, pos);
       }
-    } else if (behavior_ == "Isolated") {
-      // Isolated: Keep delimiters as separate tokens
-      // Example: "the-final--countdown" with delimiter "-"
-      // -> ["the", "-", "final", "-", "-", "countdown"]
-      size_t last_end = 0;
-      for (const auto& match : matches) {
-        // Add text before the match (if any)
-        if (match.start > last_end) {
-          results.push_back(input.substr(last_end, match.start - last_end));
-        }
+      started = true;
+      piece_start = pos;
+    }
+    last_script = script;
+  }
+  if (started) {
+    emit(piece_start, end);
+  }
+}
 
-        // Add the delimiter itself as a separate token
-        std::string delimiter =
-            input.substr(match.start, match.end - match.start);
-        results.push_back(delimiter);
+void BertPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& /*buffers*/,
+    const RangeCallback& emit) const {
+  split_runs(
+      text,
+      start,
+      end,
+      [](CodepointClass c) {
+        return c.is(CodepointClass::kWhitespace) ? CharRole::Drop
+            : c.is(CodepointClass::kPunctuation) ? CharRole::Isolate
+                                                 : CharRole::JoinA;
+      },
+      emit);
+}
 
-        last_end = match.end;
-      }
+// MetaspacePreTokenizer ///////////////////////////////////////////////////////
+
+PrependScheme parse_prepend_scheme(const std::string& name) {
+  if (name == "always") {
+    return PrependScheme::Always;
+  }
+  if (name == "first") {
+    return PrependScheme::First;
+  }
+  if (name == "never") {
+    return PrependScheme::Never;
+  }
+  throw std::runtime_error("Unsupported prepend_scheme: " + name);
+}
+
+MetaspacePreTokenizer::MetaspacePreTokenizer(
+    const std::string& replacement,
+    const std::string& prepend_scheme,
+    bool split)
+    : replacement_(replacement),
+      prepend_scheme_(parse_prepend_scheme(prepend_scheme)),
+      split_(split) {
+  // Throws unless the replacement is one character.
+  single_codepoint(replacement_);
+}
+
+std::vector<std::string> MetaspacePreTokenizer::pre_tokenize(
+    const std::string& input) const {
+  PreTokenizedString pieces(input);
+  pre_tokenize_spans(pieces);
+  return pieces.to_strings();
+}
 
-      // Add remaining text after the last match (if any)
-      if (last_end < input.length()) {
-        results.push_back(input.substr(last_end));
+void MetaspacePreTokenizer::pre_tokenize_spans(
+    PreTokenizedString& pieces) const {
+  const std::string& source = pieces.text();
+  std::string& text = pieces.begin_rewrite();
+  const char lead = replacement_[0];
+  const size_t length = replacement_.size();
+  for (const auto& range : pieces.ranges()) {
+    // Empty pieces have nothing to prepend to, so they go away.
+    if (range.end == range.start) {
+      continue;
+    }
+    const std::string_view piece(
+        source.data() + range.start, range.end - range.start);
+    size_t piece_start = text.size();
+    const bool prepend = prepend_scheme_ == PrependScheme::Always ||
+        (prepend_scheme_ == PrependScheme::First && range.start == 0);
+    if (prepend && piece[0] != ' ' &&
+        piece.compare(0, length, replacement_) != 0) {
+      text += replacement_;
+    }
+    // Copy the text between replacements in runs. Each space or replacement
+    // character starts a new piece, so that it is merged with the text after
+    // it.
+    size_t copied = 0;
+    for (size_t pos = 0; pos < piece.size(); ++pos) {
+      const char c = piece[pos];
+      if (c != ' ' &&
+          (c != lead || piece.compare(pos, length, replacement_) != 0)) {
+        continue;
       }
-    } else if (behavior_ == "Removed" || behavior_.empty()) {
-      // Default delimiter behavior (split on delimiters, remove delimiters)
-      size_t last_end = 0;
-      for (const auto& match : matches) {
-        // Add text before the match (if any)
-        if (match.start > last_end) {
-          results.push_back(input.substr(last_end, match.start - last_end));
-        }
-        last_end = match.end;
+      text.append(piece.data() + copied, pos - copied);
+      if (split_ && text.size() > piece_start) {
+        pieces.add_piece(piece_start, text.size());
+        piece_start = text.size();
       }
-
-      // Add remaining text after the last match (if any)
-      if (last_end < input.length()) {
-        results.push_back(input.substr(last_end));
+      text += replacement_;
+      if (c != ' ') {
+        pos += length - 1;
       }
+      copied = pos + 1;
     }
+    text.append(piece.data() + copied, piece.size() - copied);
+    pieces.add_piece(piece_start, text.size());
   }
-  return results;
+  pieces.commit();
 }
 
 // ByteLevelPreTokenizer ///////////////////////////////////////////////////////
@@ -252,6 +805,46 @@ namespace {
 constexpr char GPT2_EXPR[] =
     R"('s|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+)";
 
+// The UTF-8 encoding of the character that each byte is mapped to, which is
+// one or two bytes long.
+struct ByteLevelTable {
+  std::array<std::array<char, 2>, 256> chars;
+  std::array<uint8_t, 256> lengths;
+};
+
+// Calls add with the start and end of each match and of the text between
+// them, skipping empty ones.
+template <typename TAdd>
+void for_each_split(const std::vector<Match>& matches, size_t size, TAdd add) {
+  size_t last_end = 0;
+  for (const auto& match : matches) {
+    if (match.start > last_end) {
+      add(last_end, match.start);
+    }
+    if (match.end > match.start) {
+      add(match.start, match.end);
+    }
+    last_end = match.end;
+  }
+  if (last_end < size) {
+    add(last_end, size);
+  }
+}
+
+const ByteLevelTable& byte_level_table() {
+  static const ByteLevelTable table = [] {
+    ByteLevelTable result{};
+    for (int byte = 0; byte < 256; ++byte) {
+      const auto utf8 = unicode_byte_to_utf8(static_cast<uint8_t>(byte));
+      assert(!utf8.empty() && utf8.size() <= 2);
+      std::copy(utf8.begin(), utf8.end(), result.chars[byte].begin());
+      result.lengths[byte] = static_cast<uint8_t>(utf8.size());
+    }
+    return result;
+  }();
+  return table;
+}
+
 } // namespace
 
 //////////////////
@@ -260,20 +853,88 @@ constexpr char GPT2_EXPR[] =
 
 ByteLevelPreTokenizer::ByteLevelPreTokenizer(
     bool add_prefix_space,
-    const std::string& pattern)
+    const std::string& pattern,
+    bool map_bytes)
     : pattern_(pattern.empty() ? GPT2_EXPR : pattern),
-      add_prefix_space_(add_prefix_space) {}
+      add_prefix_space_(add_prefix_space),
+      map_bytes_(map_bytes),
+      regex_(TK_UNWRAP_THROW(get_shared_regex(pattern_))) {}
 
 std::vector<std::string> ByteLevelPreTokenizer::pre_tokenize(
     const std::string& input) const {
-  // Add the prefix space if configured to do so.
-  std::string formatted_input = input;
-  if (add_prefix_space_ && !formatted_input.empty() &&
-      formatted_input[0] != ' ') {
-    formatted_input.insert(formatted_input.begin(), ' ');
+  PreTokenizedString pieces(input);
+  pre_tokenize_spans(pieces);
+  return pieces.to_strings();
+}
+
+void ByteLevelPreTokenizer::pre_tokenize_spans(
+    PreTokenizedString& pieces) const {
+  if (splits_only()) {
+    pieces.begin_split();
+    SplitBuffers buffers;
+    const RangeCallback add = [&pieces](size_t start, size_t end) {
+      pieces.add_piece(start, end);
+    };
+    for (const auto& range : pieces.ranges()) {
+      split_range(pieces.text(), range.start, range.end, buffers, add);
+    }
+    pieces.commit();
+    return;
   }
 
-  return unicode_regex_split(formatted_input, {pattern_});
+  const ByteLevelTable& table = byte_level_table();
+  const std::string& source = pieces.text();
+  // The prefix space and the byte-level mapping rewrite the pieces, so they
+  // are copied to a new text.
+  std::string& text = pieces.begin_rewrite();
+  std::string formatted_input;
+  std::vector<Match> matches;
+  for (const auto& range : pieces.ranges()) {
+    // Add the prefix space if configured to do so. The regex needs the piece
+    // as a string of its own, unless it is the whole text.
+    const bool prefix = add_prefix_space_ && range.end > range.start &&
+        source[range.start] != ' ';
+    const std::string* input = &source;
+    if (prefix || range.start != 0 || range.end != source.size()) {
+      formatted_input.assign(prefix ? 1 : 0, ' ');
+      formatted_input.append(source, range.start, range.end - range.start);
+      input = &formatted_input;
+    }
+    regex_->find_all_into(*input, matches);
+    for_each_split(matches, input->size(), [&](size_t start, size_t end) {
+      const size_t text_start = text.size();
+      if (map_bytes_) {
+        for (size_t i = start; i < end; ++i) {
+          const uint8_t byte = static_cast<uint8_t>((*input)[i]);
+          text.append(table.chars[byte].data(), table.lengths[byte]);
+        }
+      } else {
+        text.append(*input, start, end - start);
+      }
+      pieces.add_piece(text_start, text.size());
+    });
+  }
+  pieces.commit();
+}
+
+void ByteLevelPreTokenizer::split_range(
+    const std::string& text,
+    size_t start,
+    size_t end,
+    SplitBuffers& buffers,
+    const RangeCallback& emit) const {
+  const std::string* input = &text;
+  if (start != 0 || end != text.size()) {
+    buffers.piece.assign(text, start, end - start);
+    input = &buffers.piece;
+  }
+  regex_->find_all_into(*input, buffers.matches);
+  for_each_split(
+      buffers.matches,
+      input->size(),
+      [&emit, start](size_t piece_start, size_t piece_end) {
+        emit(start + piece_start, start + piece_end);
+      });
 }
 
 // SequencePreTokenizer ////////////////////////////////////////////////////////
@@ -284,17 +945,60 @@ SequencePreTokenizer::SequencePreTokenizer(
 
 std::vector<std::string> SequencePreTokenizer::pre_tokenize(
     const std::string& input) const {
-  std::vector<std::string> pieces{std::string(input)};
+  PreTokenizedString pieces(input);
+  pre_tokenize_spans(pieces);
+  return pieces.to_strings();
+}
+
+std::vector<std::string> SequencePreTokenizer::regex_backends() const {
+  std::vector<std::string> backends;
   for (const auto& pre_tokenizer : pre_tokenizers_) {
-    std::vector<std::string> new_pieces;
-    for (const auto& piece : pieces) {
-      for (const auto& subpiece : pre_tokenizer->pre_tokenize(piece)) {
-        new_pieces.push_back(subpiece);
-      }
+    const auto names = pre_tokenizer->regex_backends();
+    backends.insert(backends.end(), names.begin(), names.end());
+  }
+  return backends;
+}
+
+void SequencePreTokenizer::pre_tokenize_spans(
+    PreTokenizedString& pieces) const {
+  const size_t count = pre_tokenizers_.size();
+  std::vector<SplitBuffers> buffers;
+  std::vector<PreTokenizer::RangeCallback> emit;
+  for (size_t first = 0; first < count;) {
+    size_t last = first;
+    while (last < count && pre_tokenizers_[last]->splits_only()) {
+      ++last;
+    }
+    if (last - first < 2) {
+      pre_tokenizers_[first]->pre_tokenize_spans(pieces);
+      ++first;
+      continue;
+    }
+
+    // Fuse pre_tokenizers_[first, last): each sub-piece that one of them
+    // finds is split by the next one right away, and the last one adds the
+    // pieces.
+    const size_t stages = last - first;
+    const std::string& text = pieces.text();
+    buffers.resize(stages);
+    emit.resize(stages);
+    emit[stages - 1] = [&pieces](size_t start, size_t end) {
+      pieces.add_piece(start, end);
+    };
+    for (size_t i = stages - 1; i-- > 0;) {
+      const PreTokenizer& next = *pre_tokenizers_[first + i + 1];
+      emit[i] = [&next, &text, &buffers, &emit, i](size_t start, size_t end) {
+        next.split_range(text, start, end, buffers[i + 1], emit[i + 1]);
+      };
+    }
+    pieces.begin_split();
+    for (const auto& range : pieces.ranges()) {
+      pre_tokenizers_[first]->split_range(
+          text, range.start, range.end, buffers[0], emit[0]);
     }
-    pieces = std::move(new_pieces);
+    pieces.commit();
+    first = last;
   }
-  return pieces;
 }
 
 } // namespace tokenizers
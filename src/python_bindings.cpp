@@ -59,6 +59,9 @@ T unwrap_result(const Result<T>& result) {
       case Error::RegexFailure:
         error_msg = "RegexFailure";
         break;
+      case Error::SaveFailure:
+        error_msg = "SaveFailure";
+        break;
       default:
         error_msg = "Unknown error";
         break;
@@ -82,7 +85,8 @@ PYBIND11_MODULE(pytorch_tokenizers_cpp, m) {
       .value("Base64DecodeFailure", Error::Base64DecodeFailure)
       .value("ParseFailure", Error::ParseFailure)
       .value("DecodeFailure", Error::DecodeFailure)
-      .value("RegexFailure", Error::RegexFailure);
+      .value("RegexFailure", Error::RegexFailure)
+      .value("SaveFailure", Error::SaveFailure);
 
   // Bind TokenIndex struct
   py::class_<TokenIndex>(m, "TokenIndex")
@@ -100,6 +104,15 @@ PYBIND11_MODULE(pytorch_tokenizers_cpp, m) {
             }
           },
           py::arg("tokenizer_path"))
+      .def(
+          "load_from_buffer",
+          [](Tokenizer& self, std::string_view data) {
+            Error error = self.load_from_buffer(data);
+            if (error != Error::Ok) {
+              throw std::runtime_error("Failed to load tokenizer from buffer");
+            }
+          },
+          py::arg("data"))
       .def(
           "encode",
           [](const Tokenizer& self,
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <pytorch/tokenizers/re2_lookahead_regex.h>
+
+// Standard
+#include <cstdint>
+#include <cstring>
+
+namespace tokenizers {
+
+namespace {
+
+// The characters of \s with PCRE2_UCP, as the contents of a class.
+const std::string kSpaces =
+    "\\t-\\r \\x{85}\\x{a0}\\x{1680}\\x{180e}\\x{2000}-\\x{200a}\\x{2028}"
+    "\\x{2029}\\x{202f}\\x{205f}\\x{3000}";
+
+constexpr char kIdiom[] = "\\s+(?!\\S)";
+constexpr char kWhitespace[] = "\\s+";
+
+// Returns the length of the \s character at pos, or 0 if there is none.
+std::size_t space_length(const std::string& text, std::size_t pos) {
+  const auto byte = [&](std::size_t i) -> uint32_t {
+    return pos + i < text.size() ? static_cast<uint8_t>(text[pos + i]) : 0;
+  };
+  const uint32_t lead = byte(0);
+  if (lead < 0x80) {
+    return (lead >= '\t' && lead <= '\r') || lead == ' ' ? 1 : 0;
+  }
+  if (lead == 0xc2) {
+    return byte(1) == 0x85 || byte(1) == 0xa0 ? 2 : 0;
+  }
+  if (lead != 0xe1 && lead != 0xe2 && lead != 0xe3) {
+    return 0;
+  }
+  if ((byte(1) & 0xc0) != 0x80 || (byte(2) & 0xc0) != 0x80) {
+    return 0;
+  }
+  const uint32_t cp =
+      ((lead & 0x0f) << 12) | ((byte(1) & 0x3f) << 6) | (byte(2) & 0x3f);
+  const bool space = cp == 0x1680 || cp == 0x180e ||
+      (cp >= 0x2000 && cp <= 0x200a) || cp == 0x2028 || cp == 0x2029 ||
+      cp == 0x202f || cp == 0x205f || cp == 0x3000;
+  return space ? 3 : 0;
+}
+
+// Splits a pattern at the | of its top-level alternation.
+std::vector<std::string> split_alternatives(const std::string& pattern) {
+  std::vector<std::string> alternatives;
+  std::string current;
+  int depth = 0;
+  bool in_class = false;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    const char c = pattern[i];
+    if (c == '\\' && i + 1 < pattern.size()) {
+      current += c;
+      current += pattern[++i];
+      continue;
+    }
+    if (in_class) {
+      in_class = c != ']';
+    } else if (c == '[') {
+      in_class = true;
+      // A ] right after [ or [^ is a literal.
+      current += c;
+      if (i + 1 < pattern.size() && pattern[i + 1] == '^') {
+        current += pattern[++i];
+      }
+      if (i + 1 < pattern.size() && pattern[i + 1] == ']') {
+        current += pattern[++i];
+      }
+      continue;
+    } else if (c == '(') {
+      ++depth;
+    } else if (c == ')') {
+      --depth;
+    } else if (c == '|' && depth == 0) {
+      alternatives.push_back(std::move(current));
+      current.clear();
+      continue;
+    }
+    current += c;
+  }
+  alternatives.push_back(std::move(current));
+  return alternatives;
+}
+
+} // namespace
+
+std::optional<std::string> Re2LookaheadRegex::translate(
+    const std::string& pattern) {
+  std::string result;
+  bool in_class = false;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    const char c = pattern[i];
+    if (c == '\\') {
+      if (i + 1 == pattern.size()) {
+        return std::nullopt;
+      }
+      const char escape = pattern[++i];
+      switch (escape) {
+        case 's':
+          result += in_class ? kSpaces : "[" + kSpaces + "]";
+          break;
+        case 'S':
+          // RE2 cannot subtract a class inside another one.
+          if (in_class) {
+            return std::nullopt;
+          }
+          result += "[^" + kSpaces + "]";
+          break;
+        case 'd':
+          result += "\\p{Nd}";
+          break;
+        case 'D':
+          result += "\\P{Nd}";
+          break;
+        default:
+          // Classes and assertions that RE2 reads differently or not at all,
+          // backreferences, and quoting, which hides the syntax.
+          if ((escape >= '0' && escape <= '9') ||
+              std::strchr("bBhHvVwWRXNKGZCQ", escape)) {
+            return std::nullopt;
+          }
+          result += c;
+          result += escape;
+      }
+      continue;
+    }
+    if (in_class) {
+      // POSIX classes are Unicode classes with PCRE2_UCP.
+      if (c == '[' && i + 1 < pattern.size() && pattern[i + 1] == ':') {
+        return std::nullopt;
+      }
+      in_class = c != ']';
+    } else if (c == '[') {
+      in_class = true;
+      result += c;
+      if (i + 1 < pattern.size() && pattern[i + 1] == '^') {
+        result += pattern[++i];
+      }
+      if (i + 1 < pattern.size() && pattern[i + 1] == ']') {
+        result += pattern[++i];
+      }
+      continue;
+    } else if (c == '$') {
+      // PCRE2 also matches $ before a final newline.
+      return std::nullopt;
+    } else if (
+        pattern.compare(i, 3, "(?=") == 0 ||
+        pattern.compare(i, 3, "(?!") == 0 ||
+        pattern.compare(i, 4, "(?<=") == 0 ||
+        pattern.compare(i, 4, "(?<!") == 0) {
+      return std::nullopt;
+    }
+    result += c;
+  }
+  if (in_class) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+Error Re2LookaheadRegex::compile(const std::string& pattern) {
+  regex_.reset();
+  prefix_.reset();
+
+  auto alternatives = split_alternatives(pattern);
+  const std::size_t count = alternatives.size();
+  std::size_t idiom = count;
+  if (alternatives.back() == kIdiom) {
+    idiom = count - 1;
+    whitespace_fallback_ = false;
+  } else if (
+      count >= 2 && alternatives[count - 2] == kIdiom &&
+      alternatives.back() == kWhitespace) {
+    idiom = count - 2;
+    whitespace_fallback_ = true;
+  } else {
+    TK_LOG(
+        Info,
+        "Pattern does not end in \\s+(?!\\S) or \\s+(?!\\S)|\\s+: %s",
+        pattern.c_str());
+    return Error::RegexFailure;
+  }
+
+  std::string prefix;
+  for (std::size_t i = 0; i < idiom; ++i) {
+    prefix += (i == 0 ? "" : "|") + alternatives[i];
+  }
+  const auto translated = translate(prefix);
+  if (!translated) {
+    TK_LOG(Info, "Pattern has syntax RE2 cannot emulate: %s", pattern.c_str());
+    return Error::RegexFailure;
+  }
+
+  Re2Regex::Options options = options_;
+  options.log_errors = false;
+  const std::string whitespace = "[" + kSpaces + "]+";
+  auto regex = std::make_unique<Re2Regex>(options);
+  if (regex->compile(
+          translated->empty() ? whitespace
+                              : "(?:" + *translated + ")|" + whitespace) !=
+      Error::Ok) {
+    TK_LOG(Info, "Failed to compile regex: %s", pattern.c_str());
+    return Error::RegexFailure;
+  }
+  if (!translated->empty()) {
+    prefix_ = std::make_unique<Re2Regex>(options);
+    TK_CHECK_OK_OR_RETURN_ERROR(prefix_->compile(*translated));
+  }
+  regex_ = std::move(regex);
+  return Error::Ok;
+}
+
+std::vector<Match> Re2LookaheadRegex::find_all(const std::string& text) const {
+  std::vector<Match> result;
+  find_all_into(text, result);
+  return result;
+}
+
+void Re2LookaheadRegex::find_all_into(
+    const std::string& text,
+    std::vector<Match>& matches) const {
+  matches.clear();
+  if (!regex_) {
+    TK_LOG(Error, "Regex is not compiled or invalid, run compile() first");
+    return;
+  }
+  const re2::RE2& regex = regex_->thread_regex();
+  const re2::RE2* prefix = prefix_ ? &prefix_->thread_regex() : nullptr;
+  const std::size_t size = text.size();
+  re2::StringPiece piece;
+  std::size_t pos = 0;
+  while (pos < size &&
+         regex.Match(text, pos, size, re2::RE2::UNANCHORED, &piece, 1)) {
+    const std::size_t start = piece.data() - text.data();
+    std::size_t end = start + piece.size();
+    if (end < size && end > start && space_length(text, start) > 0) {
+      std::size_t last = end - 1;
+      while (last > start &&
+             (static_cast<uint8_t>(text[last]) & 0xc0) == 0x80) {
+        --last;
+      }
+      // A whitespace match that P does not make came from \s+, which took
+      // the whole run, so \s+(?!\S) would have left out its last character.
+      if (space_length(text, last) > 0 &&
+          (!prefix ||
+           !prefix->Match(
+               text, start, size, re2::RE2::ANCHOR_START, nullptr, 0))) {
+        if (last > start) {
+          end = last;
+        } else if (!whitespace_fallback_) {
+          pos = start + space_length(text, start);
+          continue;
+        }
+      }
+    }
+    matches.push_back({start, end});
+    // Move past empty matches to avoid an infinite loop.
+    pos = end > start ? end : end + 1;
+  }
+}
+
+} // namespace tokenizers
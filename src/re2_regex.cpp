@@ -8,43 +8,144 @@
 
 #include <pytorch/tokenizers/re2_regex.h>
 
+// Standard
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
 namespace tokenizers {
 
+namespace {
+
+std::mutex& default_options_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+Re2Regex::Options& default_options_storage() {
+  static Re2Regex::Options options;
+  return options;
+}
+
+// A small number that tells threads apart, handed out in the order in which
+// threads first match with a per-thread Re2Regex.
+std::size_t thread_index() {
+  static std::atomic<std::size_t> next_index{0};
+  thread_local const std::size_t index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+re2::RE2::Options re2_options(const Re2Regex::Options& options) {
+  re2::RE2::Options result;
+  if (options.max_mem > 0) {
+    result.set_max_mem(options.max_mem);
+  }
+  result.set_log_errors(options.log_errors);
+  return result;
+}
+
+} // namespace
+
+Re2Regex::~Re2Regex() {
+  clear_copies();
+}
+
+void Re2Regex::set_default_options(const Options& options) {
+  std::lock_guard<std::mutex> lock(default_options_mutex());
+  default_options_storage() = options;
+}
+
+Re2Regex::Options Re2Regex::default_options() {
+  std::lock_guard<std::mutex> lock(default_options_mutex());
+  return default_options_storage();
+}
+
+void Re2Regex::clear_copies() {
+  for (std::size_t i = 0; i < copy_count_; ++i) {
+    delete copies_[i].load(std::memory_order_relaxed);
+  }
+  copies_.reset();
+  copy_count_ = 0;
+}
+
 Error Re2Regex::compile(const std::string& pattern) {
-  regex_ = std::make_unique<re2::RE2>(pattern);
+  clear_copies();
+  regex_ = std::make_unique<re2::RE2>(pattern, re2_options(options_));
   // Warmup re2 as it is slow on the first run, void the return value as it's
   // not needed Refer to
   // https://github.com/google/re2/blob/6dcd83d60f7944926bfd308cc13979fc53dd69ca/re2/fuzzing/re2_fuzzer.cc#L136-L141
   (void)regex_->ReverseProgramSize();
   if (regex_->ok()) {
+    if (options_.per_thread) {
+      copy_count_ = options_.max_copies > 0
+          ? options_.max_copies
+          : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+      copies_ = std::make_unique<std::atomic<re2::RE2*>[]>(copy_count_);
+      for (std::size_t i = 0; i < copy_count_; ++i) {
+        copies_[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
     return Error::Ok;
   } else {
-    TK_LOG(
-        Error,
-        "Failed to compile regex: %s, error: %s",
-        pattern.c_str(),
-        regex_->error().c_str());
+    if (options_.log_errors) {
+      TK_LOG(
+          Error,
+          "Failed to compile regex: %s, error: %s",
+          pattern.c_str(),
+          regex_->error().c_str());
+    }
     return Error::RegexFailure;
   }
 }
 
+const re2::RE2& Re2Regex::thread_regex() const {
+  if (copy_count_ == 0) {
+    return *regex_;
+  }
+  std::atomic<re2::RE2*>& slot = copies_[thread_index() % copy_count_];
+  re2::RE2* copy = slot.load(std::memory_order_acquire);
+  if (copy == nullptr) {
+    // Compiling the pattern again gives the copy its own DFA cache. Threads
+    // that race here keep whichever copy was stored first.
+    auto fresh =
+        std::make_unique<re2::RE2>(regex_->pattern(), regex_->options());
+    if (slot.compare_exchange_strong(
+            copy, fresh.get(), std::memory_order_acq_rel)) {
+      copy = fresh.release();
+    }
+  }
+  return *copy;
+}
+
 std::vector<Match> Re2Regex::find_all(const std::string& text) const {
+  std::vector<Match> result;
+  find_all_into(text, result);
+  return result;
+}
+
+void Re2Regex::find_all_into(
+    const std::string& text,
+    std::vector<Match>& matches) const {
+  matches.clear();
   if (!regex_ || !regex_->ok()) {
     TK_LOG(Error, "Regex is not compiled or invalid, run compile() first");
-    return std::vector<Match>{};
+    return;
   }
-  std::vector<Match> result;
-  re2::StringPiece input(text);
+  // Only asking for the overall match lets RE2 find it with its DFAs alone,
+  // while extracting a capture group needs one of its slower engines.
+  const re2::RE2& regex = thread_regex();
   re2::StringPiece piece;
-
-  const char* base = input.data();
-
-  while (RE2::FindAndConsume(&input, *regex_, &piece)) {
-    size_t start = piece.data() - base;
-    result.push_back({start, start + piece.size()});
+  std::size_t pos = 0;
+  while (pos < text.size() &&
+         regex.Match(
+             text, pos, text.size(), re2::RE2::UNANCHORED, &piece, 1)) {
+    const std::size_t start = piece.data() - text.data();
+    const std::size_t end = start + piece.size();
+    matches.push_back({start, end});
+    // Move past empty matches to avoid an infinite loop.
+    pos = end > start ? end : end + 1;
   }
-
-  return result;
 }
 
 } // namespace tokenizers
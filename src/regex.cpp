@@ -5,13 +5,26 @@
  * This source code is licensed under the BSD-style license found in the
  * LICENSE file in the root directory of this source tree.
  */
-// Default implementation for create_regex, only using RE2 regex library.
-// regex_lookahead.cpp has the implementation of create_regex with lookahead
-// support, backed by PCRE2 and std::regex.
+// Default implementation for create_regex. It picks the first of the native
+// scanners, the RE2 lookahead emulation and RE2 that accepts the pattern, or
+// the fastest of those and the DFA backend when benchmarking is enabled.
+// regex_lookahead.cpp registers the fallback for other lookahead patterns,
+// backed by PCRE2 and std::regex.
 
+#include <pytorch/tokenizers/dfa_regex.h>
+#include <pytorch/tokenizers/native_regex.h>
+#include <pytorch/tokenizers/re2_lookahead_regex.h>
 #include <pytorch/tokenizers/re2_regex.h>
 #include <pytorch/tokenizers/regex.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
 namespace tokenizers {
 
 // Default implementation that returns failure
@@ -33,6 +46,12 @@ FallbackRegexFn get_fallback_regex() {
   return fallback_regex;
 }
 
+void IRegex::find_all_into(
+    const std::string& text,
+    std::vector<Match>& matches) const {
+  matches = find_all(text);
+}
+
 std::string IRegex::escape(const std::string& input) {
   std::string result;
   result.reserve(input.size() * 2); // Reserve space for potential escaping
@@ -50,10 +69,142 @@ std::string IRegex::escape(const std::string& input) {
   return result;
 }
 
-Result<std::unique_ptr<IRegex>> create_regex(const std::string& pattern) {
+namespace {
+
+std::mutex benchmark_mutex;
+bool benchmark_enabled = false;
+std::string benchmark_sample;
+
+// Mostly ASCII prose, code and numbers, like most of what tokenizers see, so
+// that the fastest backend on it is the fastest in practice. A line of the
+// non-ASCII letters, digits and whitespace on which the engines are most
+// likely to disagree makes up a few percent of it.
+const std::string& default_sample() {
+  static const std::string sample = [] {
+    const std::string prose =
+        "The quick brown fox doesn't jump over 12345 lazy dogs; it's 3.14 "
+        "times\n  faster (really!) than you'd THINK. Most of the text that "
+        "a tokenizer\nsees looks like this, with dates like 2024-06-01, "
+        "amounts like $1,000.50 and\nlinks like https://example.com/a?b=c."
+        "\n\n";
+    const std::string code =
+        "    def foo(x):\n        return x * 2  # code\t\r\n"
+        "    if (count >= 10 && name != \"\") { total += count; }\n\n";
+    const std::string other_scripts =
+        "Caf\u00e9 na\u00efve r\u00e9sum\u00e9 \u2014 \u4e2d\u6587 "
+        "\u3053\u3093\u306b\u3061\u306f \U0001f642\u00a0\u0663\u0664 "
+        "\u212a\u017f \u0435\u0301  \v\u3000end   \n";
+    std::string result;
+    while (result.size() < 16 * 1024) {
+      for (int i = 0; i < 4; ++i) {
+        result += prose;
+        result += code;
+      }
+      result += other_scripts;
+    }
+    return result;
+  }();
+  return sample;
+}
+
+// Returns the best time of a few runs of find_all() on the text.
+std::chrono::nanoseconds time_find_all(
+    const IRegex& regex,
+    const std::string& text,
+    std::vector<Match>& matches) {
+  constexpr int kRuns = 3;
+  auto best = std::chrono::nanoseconds::max();
+  for (int run = 0; run < kRuns; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    regex.find_all_into(text, matches);
+    best = std::min(
+        best,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start));
+  }
+  return best;
+}
+
+bool same_matches(const std::vector<Match>& a, const std::vector<Match>& b) {
+  return std::equal(
+      a.begin(),
+      a.end(),
+      b.begin(),
+      b.end(),
+      [](const Match& lhs, const Match& rhs) {
+        return lhs.start == rhs.start && lhs.end == rhs.end;
+      });
+}
+
+// Everything that decides which regex create_regex() returns for a pattern:
+// the fallback and the benchmarking settings pick the backend, and the
+// default options of Re2Regex set it up.
+struct SharedRegexKey {
+  std::string pattern;
+  std::uintptr_t fallback;
+  // The benchmark sample, if create_regex() benchmarks the backends.
+  std::optional<std::string> sample;
+  int64_t re2_max_mem;
+  bool re2_per_thread;
+  std::size_t re2_max_copies;
+
+  auto tie() const {
+    return std::tie(
+        pattern,
+        fallback,
+        sample,
+        re2_max_mem,
+        re2_per_thread,
+        re2_max_copies);
+  }
+};
+
+bool operator<(const SharedRegexKey& a, const SharedRegexKey& b) {
+  return a.tie() < b.tie();
+}
+
+SharedRegexKey shared_regex_key(const std::string& pattern) {
+  const auto re2_options = Re2Regex::default_options();
+  std::optional<std::string> sample;
+  {
+    std::lock_guard<std::mutex> lock(benchmark_mutex);
+    if (benchmark_enabled) {
+      sample = benchmark_sample;
+    }
+  }
+  return {
+      pattern,
+      reinterpret_cast<std::uintptr_t>(get_fallback_regex()),
+      std::move(sample),
+      re2_options.max_mem,
+      re2_options.per_thread,
+      re2_options.max_copies};
+}
+
+// The first backend that supports the pattern.
+Result<std::unique_ptr<IRegex>> create_default_regex(
+    const std::string& pattern) {
+#if TK_ENABLE_NATIVE_REGEX
+  // Well-known pre-tokenizer patterns have hand-written scanners.
+  if (NativeRegex::recognize(pattern)) {
+    auto native = std::make_unique<NativeRegex>();
+    if (native->compile(pattern) == Error::Ok) {
+      return static_cast<std::unique_ptr<IRegex>>(std::move(native));
+    }
+  }
+#endif // TK_ENABLE_NATIVE_REGEX
+
+  // RE2 has no lookahead, but the \s+(?!\S) idiom can be emulated on it.
+  if (pattern.find("(?!") != std::string::npos) {
+    auto lookahead = std::make_unique<Re2LookaheadRegex>();
+    if (lookahead->compile(pattern) == Error::Ok) {
+      return static_cast<std::unique_ptr<IRegex>>(std::move(lookahead));
+    }
+  }
+
   // Try RE2 first
   auto re2 = std::make_unique<Re2Regex>();
-  auto err = re2->compile("(" + pattern + ")");
+  auto err = re2->compile(pattern);
 
   if (err == Error::Ok) {
     return static_cast<std::unique_ptr<IRegex>>(std::move(re2));
@@ -70,4 +221,116 @@ Result<std::unique_ptr<IRegex>> create_regex(const std::string& pattern) {
 
   return tokenizers::Error::RegexFailure;
 }
+
+} // namespace
+
+Result<std::unique_ptr<IRegex>> create_regex(const std::string& pattern) {
+  std::string sample;
+  {
+    std::lock_guard<std::mutex> lock(benchmark_mutex);
+    if (!benchmark_enabled) {
+      return create_default_regex(pattern);
+    }
+    sample = benchmark_sample;
+  }
+  return create_fastest_regex(pattern, sample);
+}
+
+void set_regex_benchmarking(bool enabled, const std::string& sample) {
+  std::lock_guard<std::mutex> lock(benchmark_mutex);
+  benchmark_enabled = enabled;
+  benchmark_sample = sample;
+}
+
+Result<std::unique_ptr<IRegex>> create_fastest_regex(
+    const std::string& pattern,
+    const std::string& sample) {
+  auto best = TK_UNWRAP(create_default_regex(pattern));
+  const std::string& text = sample.empty() ? default_sample() : sample;
+  std::vector<Match> expected;
+  auto best_time = time_find_all(*best, text, expected);
+  const std::string default_name = best->backend_name();
+
+  // Every other backend that compiles the pattern.
+  std::vector<std::unique_ptr<IRegex>> candidates;
+  const auto add = [&](std::unique_ptr<IRegex> regex) {
+    if (regex->backend_name() != default_name &&
+        regex->compile(pattern) == Error::Ok) {
+      candidates.push_back(std::move(regex));
+    }
+  };
+#if TK_ENABLE_NATIVE_REGEX
+  if (NativeRegex::recognize(pattern)) {
+    add(std::make_unique<NativeRegex>());
+  }
+#endif // TK_ENABLE_NATIVE_REGEX
+  if (pattern.find("(?!") != std::string::npos) {
+    add(std::make_unique<Re2LookaheadRegex>());
+  }
+  // Re2Regex logs an error for the patterns RE2 rejects, so ask RE2 first.
+  if (re2::RE2(pattern, re2::RE2::Quiet).ok()) {
+    add(std::make_unique<Re2Regex>());
+  }
+  add(std::make_unique<DfaRegex>());
+  auto fallback = get_fallback_regex()(pattern);
+  if (fallback.ok() && fallback.get()->backend_name() != default_name) {
+    candidates.push_back(std::move(fallback.get()));
+  }
+
+  std::vector<Match> matches;
+  for (auto& candidate : candidates) {
+    const auto time = time_find_all(*candidate, text, matches);
+    if (!same_matches(matches, expected)) {
+      TK_LOG(
+          Info,
+          "Regex backend %s disagrees with %s on the sample, skipping it",
+          candidate->backend_name(),
+          default_name.c_str());
+      continue;
+    }
+    if (time < best_time) {
+      best = std::move(candidate);
+      best_time = time;
+    }
+  }
+  TK_LOG(
+      Info,
+      "Picked regex backend %s for %s: %.1f us on %zu bytes",
+      best->backend_name(),
+      pattern.c_str(),
+      best_time.count() / 1000.0,
+      text.size());
+  return best;
+}
+
+Result<std::shared_ptr<const IRegex>> get_shared_regex(
+    const std::string& pattern) {
+  static std::mutex mutex;
+  static std::map<SharedRegexKey, std::weak_ptr<const IRegex>> cache;
+
+  SharedRegexKey key = shared_regex_key(pattern);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = cache.find(key);
+    if (it != cache.end()) {
+      if (auto regex = it->second.lock()) {
+        return regex;
+      }
+    }
+  }
+
+  // Compile without the lock so that other patterns are not held up. If
+  // another thread compiles the same pattern meanwhile, its regex wins.
+  std::shared_ptr<const IRegex> regex = TK_UNWRAP(create_regex(pattern));
+  std::lock_guard<std::mutex> lock(mutex);
+  std::weak_ptr<const IRegex>& entry = cache[std::move(key)];
+  if (auto existing = entry.lock()) {
+    return existing;
+  }
+  entry = regex;
+  for (auto it = cache.begin(); it != cache.end();) {
+    it = it->second.expired() ? cache.erase(it) : std::next(it);
+  }
+  return regex;
+}
 } // namespace tokenizers
@@ -54,6 +54,30 @@ Error SPTokenizer::load(const std::string& tokenizer_path) {
   return Error::Ok;
 }
 
+Error SPTokenizer::load_from_buffer(std::string_view data) {
+  if (initialized_) {
+    fprintf(stderr, "Tokenizer already initialized.\n");
+    return Error::Ok;
+  }
+  // sentencepiece parses the proto straight from the buffer
+  const auto status = _processor->LoadFromSerializedProto(
+      absl::string_view(data.data(), data.size()));
+  if (!status.ok()) {
+    fprintf(
+        stderr,
+        "couldn't load the tokenizer from a buffer. \nError message: \n%s\n"
+        "It is likely that the tokenizer artifact is "
+        "broken or of a different format.",
+        status.error_message());
+    return Error::LoadFailure;
+  }
+  vocab_size_ = _processor->GetPieceSize();
+  bos_tok_ = _processor->bos_id();
+  eos_tok_ = _processor->eos_id();
+  initialized_ = true;
+  return Error::Ok;
+}
+
 SPTokenizer::~SPTokenizer() {}
 
 /**
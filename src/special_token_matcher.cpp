@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <pytorch/tokenizers/special_token_matcher.h>
+
+// Standard
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+
+/*
+ * The prefilter uses SSSE3 or NEON where available. The x86 kernel is
+ * compiled for its target with a function attribute and picked at runtime.
+ * Define TK_ENABLE_SIMD_SPECIAL_TOKENS=0 to always use the scalar prefilter.
+ */
+#ifndef TK_ENABLE_SIMD_SPECIAL_TOKENS
+#define TK_ENABLE_SIMD_SPECIAL_TOKENS 1
+#endif // !defined(TK_ENABLE_SIMD_SPECIAL_TOKENS)
+
+#if TK_ENABLE_SIMD_SPECIAL_TOKENS && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TK_SPECIAL_TOKENS_SIMD_X86 1
+#else
+#define TK_SPECIAL_TOKENS_SIMD_X86 0
+#endif
+
+#if TK_ENABLE_SIMD_SPECIAL_TOKENS && defined(__aarch64__) && \
+    defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TK_SPECIAL_TOKENS_SIMD_NEON 1
+#else
+#define TK_SPECIAL_TOKENS_SIMD_NEON 0
+#endif
+
+namespace tokenizers {
+namespace detail {
+
+namespace {
+
+// Returns the offset of the first 16 byte block position in [0, size) whose
+// byte passes the nibble test, or the start of the unscanned tail, which is
+// left to the scalar loop.
+using BlockScanner = std::size_t (*)(
+    const char* data,
+    std::size_t size,
+    const uint8_t* low_nibbles,
+    const uint8_t* high_nibbles);
+
+#if TK_SPECIAL_TOKENS_SIMD_X86
+
+__attribute__((target("ssse3"))) std::size_t scan_blocks_ssse3(
+    const char* data,
+    std::size_t size,
+    const uint8_t* low_nibbles,
+    const uint8_t* high_nibbles) {
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(low_nibbles));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(high_nibbles));
+  const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t offset = 0;
+  for (; offset + 16 <= size; offset += 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+    const __m128i low = _mm_and_si128(in, nibble_mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(in, 4), nibble_mask);
+    const __m128i buckets = _mm_and_si128(
+        _mm_shuffle_epi8(low_table, low), _mm_shuffle_epi8(high_table, high));
+    const int misses = _mm_movemask_epi8(_mm_cmpeq_epi8(buckets, zero));
+    if (misses != 0xffff) {
+      return offset + __builtin_ctz(~misses & 0xffff);
+    }
+  }
+  return offset;
+}
+
+#elif TK_SPECIAL_TOKENS_SIMD_NEON
+
+std::size_t scan_blocks_neon(
+    const char* data,
+    std::size_t size,
+    const uint8_t* low_nibbles,
+    const uint8_t* high_nibbles) {
+  const uint8x16_t low_table = vld1q_u8(low_nibbles);
+  const uint8x16_t high_table = vld1q_u8(high_nibbles);
+  const uint8x16_t nibble_mask = vdupq_n_u8(0x0f);
+  std::size_t offset = 0;
+  for (; offset + 16 <= size; offset += 16) {
+    const uint8x16_t in =
+        vld1q_u8(reinterpret_cast<const uint8_t*>(data + offset));
+    const uint8x16_t buckets = vandq_u8(
+        vqtbl1q_u8(low_table, vandq_u8(in, nibble_mask)),
+        vqtbl1q_u8(high_table, vshrq_n_u8(in, 4)));
+    if (vmaxvq_u8(buckets) != 0) {
+      for (std::size_t i = 0; i < 16; ++i) {
+        const auto byte = static_cast<uint8_t>(data[offset + i]);
+        if (low_nibbles[byte & 0xf] & high_nibbles[byte >> 4]) {
+          return offset + i;
+        }
+      }
+    }
+  }
+  return offset;
+}
+
+#endif
+
+BlockScanner select_block_scanner() {
+#if TK_SPECIAL_TOKENS_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3")) {
+    return scan_blocks_ssse3;
+  }
+#elif TK_SPECIAL_TOKENS_SIMD_NEON
+  return scan_blocks_neon;
+#endif
+  return nullptr;
+}
+
+std::atomic<bool> scalar_prefilter{false};
+
+BlockScanner block_scanner() {
+  static const BlockScanner scanner = select_block_scanner();
+  return scalar_prefilter.load(std::memory_order_relaxed) ? nullptr : scanner;
+}
+
+} // namespace
+
+SpecialTokenMatcher::SpecialTokenMatcher(
+    const std::vector<std::pair<std::string_view, uint64_t>>& tokens) {
+  // Build a pointer based trie first, then flatten it so the children of
+  // every node are contiguous and sorted.
+  std::vector<std::map<uint8_t, uint32_t>> children(1);
+  std::vector<std::optional<uint64_t>> ids(1);
+  for (const auto& [token, id] : tokens) {
+    if (token.empty()) {
+      continue;
+    }
+    uint32_t node = 0;
+    for (const char c : token) {
+      const auto byte = static_cast<uint8_t>(c);
+      auto it = children[node].find(byte);
+      if (it == children[node].end()) {
+        const auto child = static_cast<uint32_t>(children.size());
+        it = children[node].emplace(byte, child).first;
+        children.emplace_back();
+        ids.emplace_back();
+      }
+      node = it->second;
+    }
+    ids[node] = id;
+  }
+
+  nodes_.resize(children.size());
+  for (std::size_t node = 0; node < children.size(); ++node) {
+    nodes_[node].id = ids[node];
+    nodes_[node].edges_begin = static_cast<uint32_t>(edge_bytes_.size());
+    for (const auto& [byte, child] : children[node]) {
+      edge_bytes_.push_back(byte);
+      edge_targets_.push_back(child);
+    }
+    nodes_[node].edges_end = static_cast<uint32_t>(edge_bytes_.size());
+  }
+
+  // Spread the first bytes over 8 buckets of the nibble tables.
+  for (const auto& [byte, child] : children[0]) {
+    root_children_[byte] = child;
+    const auto bucket =
+        static_cast<uint8_t>(1u << (first_bytes_.size() % 8));
+    low_nibbles_[byte & 0xf] |= bucket;
+    high_nibbles_[byte >> 4] |= bucket;
+    first_bytes_.push_back(byte);
+  }
+}
+
+bool SpecialTokenMatcher::force_scalar_prefilter(bool force) {
+  return scalar_prefilter.exchange(force);
+}
+
+std::size_t SpecialTokenMatcher::next_candidate(
+    std::string_view text,
+    std::size_t offset) const {
+  const char* data = text.data() + offset;
+  const std::size_t size = text.size() - offset;
+  if (first_bytes_.size() == 1) {
+    const void* found = std::memchr(data, first_bytes_[0], size);
+    return found ? static_cast<const char*>(found) - text.data()
+                 : text.size();
+  }
+
+  std::size_t scanned = 0;
+  if (const auto scanner = block_scanner()) {
+    scanned = scanner(data, size, low_nibbles_.data(), high_nibbles_.data());
+  }
+  for (; scanned < size; ++scanned) {
+    const auto byte = static_cast<uint8_t>(data[scanned]);
+    if (low_nibbles_[byte & 0xf] & high_nibbles_[byte >> 4]) {
+      break;
+    }
+  }
+  return offset + scanned;
+}
+
+} // namespace detail
+} // namespace tokenizers
@@ -25,12 +25,14 @@
    limitations under the License.
  *************************************************************************/
 
+#include <pytorch/tokenizers/artifact.h>
 #include <pytorch/tokenizers/base64.h>
+#include <pytorch/tokenizers/mapped_file.h>
 #include <pytorch/tokenizers/tiktoken.h>
 #include <algorithm>
 #include <cinttypes>
-#include <fstream>
 #include <limits>
+#include <string_view>
 #include <unordered_set>
 
 namespace tokenizers {
@@ -40,54 +42,92 @@ using namespace detail;
 // ------------------------------Util start------------------------------------
 namespace {
 
-static Result<std::unique_ptr<IRegex>> _create_regex(
+static Result<std::shared_ptr<const IRegex>> _create_regex(
     const std::string& pattern) {
   assert(!pattern.empty());
-  return create_regex(pattern);
+  return get_shared_regex(pattern);
 }
 
-static Result<std::pair<std::string, uint64_t>> _parse(
-    const std::string& line) {
-  // Tiktoken format
-  // https://github.com/openai/tiktoken/blob/main/tiktoken/load.py#L140 <base64
-  // encoded token str> <rank>
-  auto pos = line.find(" ");
+static Result<uint64_t> _parse_rank(
+    std::string_view text,
+    std::string_view line) {
+  // Accept trailing whitespace such as the '\r' of CRLF line endings.
+  while (!text.empty() &&
+         (text.back() == '\r' || text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
   TK_CHECK_OR_RETURN_ERROR(
-      pos != std::string::npos,
-      ParseFailure,
-      "invalid tiktoken line: %s",
-      line.c_str());
+      !text.empty(),
+      EncodeFailure,
+      "invalid encoder rank: %s",
+      std::string(line).c_str());
 
-  auto token = TK_UNWRAP(base64::decode({line.data(), pos}));
   uint64_t rank = 0;
-  try {
-    rank = std::stoul(line.substr(pos + 1));
-  } catch (const std::exception&) {
+  for (const char c : text) {
+    const auto digit = static_cast<uint64_t>(c - '0');
     TK_CHECK_OR_RETURN_ERROR(
-        false, EncodeFailure, "invalid encoder rank: %s", line.c_str());
+        digit <= 9 &&
+            rank <= (std::numeric_limits<uint64_t>::max() - digit) / 10,
+        EncodeFailure,
+        "invalid encoder rank: %s",
+        std::string(line).c_str());
+    rank = rank * 10 + digit;
   }
-
-  return std::pair{std::move(token), rank};
+  return rank;
 }
 
-static Result<TokenMap> _load_token_map(const std::string& path) {
-  std::ifstream file(path);
-  TK_CHECK_OR_RETURN_ERROR(
-      file, LoadFailure, "failed to open encoder file: %s", path.c_str());
+static Result<TokenMap> _load_token_map_from_buffer(std::string_view data) {
+  // Tiktoken format
+  // https://github.com/openai/tiktoken/blob/main/tiktoken/load.py#L140 <base64
+  // encoded token str> <rank>
+  //
+  // The whole file is split and the ranks are parsed in a single pass, then
+  // all tokens are decoded in bulk into one arena and the TokenMap is built
+  // from string_views into it.
+  const auto line_count = std::count(data.begin(), data.end(), '\n') + 1;
+  std::vector<std::string_view> encoded_tokens;
+  std::vector<uint64_t> ranks;
+  encoded_tokens.reserve(line_count);
+  ranks.reserve(line_count);
+
+  while (!data.empty()) {
+    auto eol = data.find('\n');
+    if (eol == std::string_view::npos) {
+      eol = data.size();
+    }
+    const auto line = data.substr(0, eol);
+    data.remove_prefix(std::min(eol + 1, data.size()));
+    if (line.empty() || line == "\r") {
+      continue;
+    }
+
+    const auto pos = line.find(' ');
+    TK_CHECK_OR_RETURN_ERROR(
+        pos != std::string_view::npos,
+        ParseFailure,
+        "invalid tiktoken line: %s",
+        std::string(line).c_str());
+
+    encoded_tokens.push_back(line.substr(0, pos));
+    ranks.push_back(TK_UNWRAP(_parse_rank(line.substr(pos + 1), line)));
+  }
+
+  std::string arena;
+  std::vector<std::string_view> tokens;
+  TK_CHECK_OK_OR_RETURN_ERROR(
+      base64::decode_many(encoded_tokens, arena, tokens));
 
   // Instead of generating couple of large unordered_maps here to only process
   // them linearly in the TokenMap, just place them in a vector of pairs and
   // sort them twice, looking for duplicates.  It's still O(n log n) but avoids
   // the overhead of the unordered_maps.
-
-  std::vector<std::pair<std::string, uint64_t>> pairs;
-  std::string line;
-  while (std::getline(file, line)) {
-    auto [token, rank] = TK_UNWRAP(_parse(line));
-    pairs.emplace_back(std::move(token), rank);
+  std::vector<std::pair<std::string_view, uint64_t>> pairs;
+  pairs.reserve(tokens.size());
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    pairs.emplace_back(tokens[i], ranks[i]);
   }
 
-  return build_token_map(pairs);
+  return build_token_map(std::move(pairs));
 }
 
 } // namespace
@@ -121,11 +161,68 @@ void Tiktoken::_decode(const std::string& input, std::string& ret) const {
   ret += input;
 }
 
+Error Tiktoken::_load_artifact(const ArtifactReader& reader) {
+  TK_CHECK_OR_RETURN_ERROR(
+      reader.kind() == ArtifactKind::Tiktoken,
+      LoadFailure,
+      "not a tiktoken artifact");
+  TK_CHECK_OK_OR_RETURN_ERROR(load_token_maps_(reader));
+
+  const auto metadata = TK_UNWRAP(reader.integers(ArtifactSection::Metadata));
+  const auto special_tokens =
+      TK_UNWRAP(reader.strings(ArtifactSection::SpecialTokens));
+  TK_CHECK_OR_RETURN_ERROR(
+      metadata.size() >= 2 && metadata[0] < special_tokens.size() &&
+          metadata[1] < special_tokens.size(),
+      LoadFailure,
+      "invalid tiktoken artifact metadata");
+
+  // The artifact replaces the pattern and special tokens given at
+  // construction, it holds the state of the tokenizer it was saved from.
+  _pattern = std::string(TK_UNWRAP(reader.section(ArtifactSection::Pattern)));
+  _special_tokens = std::make_unique<std::vector<std::string>>(
+      special_tokens.begin(), special_tokens.end());
+  _bos_token_index = metadata[0];
+  _eos_token_index = metadata[1];
+
+  const auto bos =
+      special_token_map_->tryGetInteger(_special_tokens->at(_bos_token_index));
+  const auto eos =
+      special_token_map_->tryGetInteger(_special_tokens->at(_eos_token_index));
+  TK_CHECK_OR_RETURN_ERROR(
+      bos && eos,
+      LoadFailure,
+      "BOS or EOS token missing from tiktoken artifact");
+
+  vocab_size_ = token_map_->size() + special_token_map_->size();
+  bos_tok_ = *bos;
+  eos_tok_ = *eos;
+
+  _regex = TK_UNWRAP(_create_regex(_pattern));
+  initialized_ = true;
+  return Error::Ok;
+}
+
 // -------------------------private method end-------------------------------
 // -------------------------public method start-------------------------------
 
 Error Tiktoken::load(const std::string& path) {
-  token_map_.emplace(TK_UNWRAP(_load_token_map(path)));
+  auto file = TK_UNWRAP(MappedFile::open(path));
+  if (has_artifact_magic(file.view())) {
+    reset_lazy_init_();
+    return _load_artifact(
+        TK_UNWRAP(ArtifactReader::from_file(std::move(file))));
+  }
+  return load_from_buffer(file.view());
+}
+
+Error Tiktoken::load_from_buffer(std::string_view data) {
+  reset_lazy_init_();
+  if (has_artifact_magic(data)) {
+    return _load_artifact(TK_UNWRAP(ArtifactReader::from_buffer(data)));
+  }
+
+  token_map_.emplace(TK_UNWRAP(_load_token_map_from_buffer(data)));
 
   std::vector<std::pair<std::string, uint64_t>> special_token_map;
   for (std::size_t i = 0; i < _special_tokens->size(); ++i) {
@@ -135,10 +232,6 @@ Error Tiktoken::load(const std::string& path) {
 
   special_token_map_.emplace(TokenMap(special_token_map));
 
-  _regex = TK_UNWRAP(_create_regex(_pattern));
-  special_token_regex_ =
-      TK_UNWRAP(detail::build_special_token_regex(TokenMap(special_token_map)));
-
   // initialize vocab_size, bos_tok, eos_tok
   vocab_size_ = token_map_->size() + special_token_map_->size();
   bos_tok_ =
@@ -146,10 +239,28 @@ Error Tiktoken::load(const std::string& path) {
   eos_tok_ =
       *special_token_map_->tryGetInteger(_special_tokens->at(_eos_token_index));
 
+  // Compiled here rather than on first use, so that an invalid pattern fails
+  // load().
+  _regex = TK_UNWRAP(_create_regex(_pattern));
   initialized_ = true;
   return Error::Ok;
 }
 
+Error Tiktoken::save(const std::string& path) const {
+  TK_CHECK_OR_RETURN_ERROR(
+      initialized_, Uninitialized, "cannot save an unloaded tokenizer");
+  ArtifactWriter writer(ArtifactKind::Tiktoken);
+  save_token_maps_(writer);
+  writer.add(ArtifactSection::Pattern, _pattern);
+  writer.add_strings(
+      ArtifactSection::SpecialTokens,
+      std::vector<std::string_view>(
+          _special_tokens->begin(), _special_tokens->end()));
+  writer.add_integers(
+      ArtifactSection::Metadata, {_bos_token_index, _eos_token_index});
+  return writer.save(path);
+}
+
 // -------------------------public method end-------------------------------
 
 } // namespace tokenizers
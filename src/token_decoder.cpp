@@ -16,6 +16,7 @@
 #include <nlohmann/json.hpp>
 
 // Local
+#include <pytorch/tokenizers/pre_tokenizer.h>
 #include <unicode.h>
 
 using json = nlohmann::json;
@@ -41,6 +42,9 @@ TokenDecoder::Ptr TokenDecoderConfig::create() const {
     return TokenDecoder::Ptr(new ByteFallbackTokenDecoder());
   } else if (type == "Fuse") {
     return TokenDecoder::Ptr(new FuseTokenDecoder());
+  } else if (type == "Metaspace") {
+    return TokenDecoder::Ptr(new MetaspaceTokenDecoder(
+        metaspace_replacement, metaspace_prepend_scheme));
   } else if (type == "Sequence") {
     // Parse the decoders array from JSON and create sub-decoders
     std::vector<TokenDecoder::Ptr> decoders;
@@ -70,6 +74,18 @@ TokenDecoderConfig& TokenDecoderConfig::parse_json(const json& json_config) {
     // No parameters to parse
   } else if (type == "Fuse") {
     // No parameters to parse
+  } else if (type == "Metaspace") {
+    if (json_config.contains("replacement")) {
+      metaspace_replacement = json_config["replacement"];
+    }
+    if (json_config.contains("prepend_scheme")) {
+      metaspace_prepend_scheme = json_config["prepend_scheme"];
+    } else if (
+        json_config.contains("add_prefix_space") &&
+        !json_config["add_prefix_space"].get<bool>()) {
+      // Configs from before prepend_scheme
+      metaspace_prepend_scheme = "never";
+    }
   } else if (type == "Sequence") {
     // Parse decoders array for Sequence decoder
     if (json_config.contains("decoders")) {
@@ -180,6 +196,50 @@ std::string FuseTokenDecoder::decode(const std::string& token) const {
   return token;
 }
 
+// MetaspaceTokenDecoder //////////////////////////////////////////////////////
+
+namespace {
+
+// Copies the token with each occurrence of from replaced by to.
+std::string replace_all(
+    const std::string& token,
+    const std::string& from,
+    const std::string& to) {
+  std::string result;
+  result.reserve(token.size());
+  size_t copied = 0;
+  size_t pos = 0;
+  while ((pos = token.find(from, copied)) != std::string::npos) {
+    result.append(token, copied, pos - copied);
+    result += to;
+    copied = pos + from.size();
+  }
+  result.append(token, copied, std::string::npos);
+  return result;
+}
+
+} // namespace
+
+MetaspaceTokenDecoder::MetaspaceTokenDecoder(
+    const std::string& replacement,
+    const std::string& prepend_scheme)
+    : replacement_(replacement),
+      strip_first_(
+          parse_prepend_scheme(prepend_scheme) != PrependScheme::Never) {
+  if (replacement_.empty()) {
+    throw std::runtime_error("Metaspace replacement must not be empty");
+  }
+}
+
+std::string MetaspaceTokenDecoder::decode(const std::string& token) const {
+  return replace_all(token, replacement_, " ");
+}
+
+std::string MetaspaceTokenDecoder::decode_first(
+    const std::string& token) const {
+  return replace_all(token, replacement_, strip_first_ ? "" : " ");
+}
+
 // SequenceTokenDecoder ///////////////////////////////////////////////////////
 
 SequenceTokenDecoder::SequenceTokenDecoder(
@@ -194,4 +254,12 @@ std::string SequenceTokenDecoder::decode(const std::string& token) const {
   return result;
 }
 
+std::string SequenceTokenDecoder::decode_first(const std::string& token) const {
+  std::string result = token;
+  for (const auto& decoder : decoders_) {
+    result = decoder->decode_first(result);
+  }
+  return result;
+}
+
 } // end  namespace tokenizers
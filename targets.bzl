@@ -26,6 +26,9 @@ def define_common_targets():
     runtime.cxx_library(
         name = "regex",
         srcs = [
+            "src/dfa_regex.cpp",
+            "src/native_regex.cpp",
+            "src/re2_lookahead_regex.cpp",
             "src/re2_regex.cpp",
             "src/regex.cpp",
         ],
@@ -69,12 +72,28 @@ def define_common_targets():
         platforms = PLATFORMS,
     )
 
+    runtime.cxx_library(
+        name = "artifact",
+        srcs = [
+            "src/artifact.cpp",
+        ],
+        exported_deps = [
+            ":headers",
+        ],
+        visibility = [
+            "//pytorch/tokenizers/...",
+        ],
+        platforms = PLATFORMS,
+    )
+
     runtime.cxx_library(
         name = "bpe_tokenizer_base",
         srcs = [
             "src/bpe_tokenizer_base.cpp",
+            "src/special_token_matcher.cpp",
         ],
         exported_deps = [
+            ":artifact",
             ":headers",
         ],
         exported_external_deps = [
@@ -133,6 +152,7 @@ def define_common_targets():
     runtime.cxx_library(
         name = "hf_tokenizer",
         srcs = [
+            "src/codepoint_table.cpp",
             "src/hf_tokenizer.cpp",
             "src/pre_tokenizer.cpp",
             "src/token_decoder.cpp",
@@ -163,6 +183,7 @@ def define_common_targets():
             "src/llama2c_tokenizer.cpp",
         ],
         exported_deps = [
+            ":artifact",
             ":headers",
         ],
         visibility = [
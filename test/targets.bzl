@@ -44,6 +44,10 @@ def define_common_targets():
             "//pytorch/tokenizers:headers",
             "//pytorch/tokenizers:hf_tokenizer",
         ],
+        env = {
+            "RESOURCES_PATH": "$(location :resources)/resources",
+        },
+        platforms = [CXX, ANDROID],  # Cannot bundle resources on Apple platform.
     )
 
     runtime.cxx_test(
@@ -62,6 +66,16 @@ def define_common_targets():
         platforms = [CXX, ANDROID],  # Cannot bundle resources on Apple platform.
     )
 
+    runtime.cxx_test(
+        name = "test_special_token_matcher",
+        srcs = [
+            "test_special_token_matcher.cpp",
+        ],
+        deps = [
+            "//pytorch/tokenizers:bpe_tokenizer_base",
+        ],
+    )
+
     runtime.cxx_test(
         name = "test_string_integer_map",
         srcs = [
@@ -7,6 +7,9 @@
  */
 
 #include <pytorch/tokenizers/base64.h>
+#include <random>
+#include <string>
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace tokenizers {
@@ -32,4 +35,128 @@ TEST(Base64Test, TestInvalidStringDecodeReturnsError) {
   EXPECT_EQ(result.error(), Error::Base64DecodeFailure);
 }
 
+TEST(Base64Test, TestDecodeAppendsToOutput) {
+  std::string output = "hi ";
+  EXPECT_EQ(base64::decode("bGxhbWE=", output), Error::Ok);
+  EXPECT_EQ(base64::decode("IQ==", output), Error::Ok);
+  EXPECT_EQ(output, "hi llama!");
+}
+
+namespace {
+
+std::string encode_for_test(const std::string& input) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string output;
+  std::size_t i = 0;
+  for (; i + 3 <= input.size(); i += 3) {
+    const uint32_t val = (static_cast<uint8_t>(input[i]) << 16) |
+        (static_cast<uint8_t>(input[i + 1]) << 8) |
+        static_cast<uint8_t>(input[i + 2]);
+    output += kAlphabet[(val >> 18) & 63];
+    output += kAlphabet[(val >> 12) & 63];
+    output += kAlphabet[(val >> 6) & 63];
+    output += kAlphabet[val & 63];
+  }
+  if (input.size() - i == 1) {
+    const uint32_t val = static_cast<uint8_t>(input[i]) << 16;
+    output += kAlphabet[(val >> 18) & 63];
+    output += kAlphabet[(val >> 12) & 63];
+    output += "==";
+  } else if (input.size() - i == 2) {
+    const uint32_t val = (static_cast<uint8_t>(input[i]) << 16) |
+        (static_cast<uint8_t>(input[i + 1]) << 8);
+    output += kAlphabet[(val >> 18) & 63];
+    output += kAlphabet[(val >> 12) & 63];
+    output += kAlphabet[(val >> 6) & 63];
+    output += '=';
+  }
+  return output;
+}
+
+std::string random_bytes(std::mt19937& rng, std::size_t size) {
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::string output(size, '\0');
+  for (auto& c : output) {
+    c = static_cast<char>(byte(rng));
+  }
+  return output;
+}
+
+} // namespace
+
+TEST(Base64Test, TestDecodeLongInputsMatchReference) {
+  // Cover every block width and tail length of the SIMD decoders.
+  std::mt19937 rng(0);
+  for (std::size_t size = 1; size < 300; ++size) {
+    const auto bytes = random_bytes(rng, size);
+    auto result = base64::decode(encode_for_test(bytes));
+    ASSERT_TRUE(result.ok()) << size;
+    EXPECT_EQ(result.get(), bytes) << size;
+  }
+}
+
+TEST(Base64Test, TestDecodeLongInputWithInvalidCharReturnsError) {
+  std::mt19937 rng(1);
+  const auto encoded = encode_for_test(random_bytes(rng, 150));
+  for (std::size_t pos = 0; pos < encoded.size(); ++pos) {
+    for (const char invalid : {'-', '\x80', '\xff', '\0', '='}) {
+      if (invalid == '=' && pos + 2 >= encoded.size()) {
+        continue;
+      }
+      auto corrupted = encoded;
+      corrupted[pos] = invalid;
+      auto result = base64::decode(corrupted);
+      EXPECT_FALSE(result.ok()) << pos;
+      EXPECT_EQ(result.error(), Error::Base64DecodeFailure) << pos;
+    }
+  }
+}
+
+TEST(Base64Test, TestEveryBlockDecoderMatchesReference) {
+  // The CPU only picks its widest kernel, so force each one it supports in
+  // turn, including the scalar path.
+  for (const auto decoder : base64::detail::supported_block_decoders()) {
+    const auto previous = base64::detail::set_block_decoder(decoder);
+    std::mt19937 rng(2);
+    for (std::size_t size = 1; size < 300; ++size) {
+      const auto bytes = random_bytes(rng, size);
+      auto encoded = encode_for_test(bytes);
+      auto result = base64::decode(encoded);
+      ASSERT_TRUE(result.ok()) << size;
+      EXPECT_EQ(result.get(), bytes) << size;
+      encoded[encoded.size() / 2] = '-';
+      EXPECT_FALSE(base64::decode(encoded).ok()) << size;
+    }
+    base64::detail::set_block_decoder(previous);
+  }
+}
+
+TEST(Base64Test, TestDecodeToCallerBuffer) {
+  const std::string text =
+      "VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZw==";
+  std::vector<char> buffer(base64::decoded_size(text.size()));
+  auto result = base64::decode_to(text, buffer.data());
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(
+      std::string(buffer.data(), result.get()),
+      "The quick brown fox jumps over the lazy dog");
+}
+
+TEST(Base64Test, TestDecodeMany) {
+  const std::vector<std::string_view> inputs = {"bGxhbWE=", "IQ==", "YWJj"};
+  std::string arena;
+  std::vector<std::string_view> decoded;
+  EXPECT_EQ(base64::decode_many(inputs, arena, decoded), Error::Ok);
+  EXPECT_EQ(arena, "llama!abc");
+  ASSERT_EQ(decoded.size(), 3);
+  EXPECT_EQ(decoded[0], "llama");
+  EXPECT_EQ(decoded[1], "!");
+  EXPECT_EQ(decoded[2], "abc");
+
+  EXPECT_EQ(
+      base64::decode_many({"bGxhbWE=", "tet"}, arena, decoded),
+      Error::Base64DecodeFailure);
+}
+
 } // namespace tokenizers
@@ -9,6 +9,14 @@
 
 #include <gtest/gtest.h>
 #include <pytorch/tokenizers/hf_tokenizer.h>
+#include <pytorch/tokenizers/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
 
 namespace tokenizers {
 
@@ -16,6 +24,29 @@ namespace {
 static inline std::string _get_resource_path(const std::string& name) {
   return std::getenv("RESOURCES_PATH") + std::string("/") + name;
 }
+
+static inline std::string _write_tokenizer_json(
+    const std::string& name,
+    const std::string& merges) {
+  const auto path = ::testing::TempDir() + name;
+  std::ofstream file(path);
+  file << R"({
+    "added_tokens": [{"id": 0, "content": "<unk>"}],
+    "normalizer": null,
+    "pre_tokenizer": {"type": "ByteLevel", "add_prefix_space": false},
+    "model": {
+      "type": "BPE",
+      "vocab": {"<unk>": 0, "a": 1, "b": 2, "c": 3, "ab": 4},
+      "merges": )"
+       << merges << "}}";
+  return path;
+}
+
+static inline std::string _read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
 } // namespace
 
 TEST(HFTokenizerTest, TestEncodeWithoutLoad) {
@@ -38,12 +69,74 @@ TEST(HFTokenizerTest, TestLoad) {
   EXPECT_EQ(error, Error::Ok);
 }
 
+TEST(HFTokenizerTest, TestRegexBackends) {
+  HFTokenizer tokenizer;
+  EXPECT_TRUE(tokenizer.regex_backends().empty());
+  ASSERT_EQ(
+      tokenizer.load(_get_resource_path("test_hf_tokenizer.json")), Error::Ok);
+  // The Split and ByteLevel pre-tokenizers each split with a regex.
+  const auto backends = tokenizer.regex_backends();
+  ASSERT_EQ(backends.size(), 2);
+  for (const auto& backend : backends) {
+    EXPECT_FALSE(backend.empty());
+  }
+}
+
 TEST(HFTokenizerTest, TestLoadInvalidPath) {
   HFTokenizer tokenizer;
   auto error = tokenizer.load("invalid_path");
   EXPECT_EQ(error, Error::LoadFailure);
 }
 
+TEST(HFTokenizerTest, TestRunTasksOnBoundedWorkers) {
+  // Force the parallel path, whatever the number of cores.
+  constexpr std::size_t kWorkers = 3;
+  std::vector<int> done(16, 0);
+  std::atomic<std::size_t> running{0};
+  std::atomic<std::size_t> most_running{0};
+  std::vector<detail::Task> tasks;
+  for (std::size_t i = 0; i < done.size(); ++i) {
+    tasks.push_back([&, i]() {
+      const auto now = ++running;
+      auto most = most_running.load();
+      while (now > most && !most_running.compare_exchange_weak(most, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      done[i] = 1;
+      --running;
+      return Error::Ok;
+    });
+  }
+  EXPECT_EQ(detail::run_tasks(tasks, kWorkers), Error::Ok);
+  EXPECT_EQ(std::count(done.begin(), done.end(), 1), 16);
+  EXPECT_LE(most_running.load(), kWorkers);
+
+  // Errors and exceptions are reported in list order on the parallel path
+  // too, and an earlier error wins over a later exception.
+  const auto fail = [](Error error) {
+    return [error]() { return error; };
+  };
+  const auto raise = [](const char* what) {
+    return [what]() -> Error { throw std::runtime_error(what); };
+  };
+  EXPECT_EQ(
+      detail::run_tasks(
+          {fail(Error::Ok),
+           fail(Error::ParseFailure),
+           raise("later"),
+           fail(Error::LoadFailure)},
+          kWorkers),
+      Error::ParseFailure);
+  try {
+    detail::run_tasks(
+        {fail(Error::Ok), raise("first"), raise("second"), fail(Error::Ok)},
+        kWorkers);
+    FAIL() << "expected an exception";
+  } catch (const std::runtime_error& e) {
+    EXPECT_STREQ(e.what(), "first");
+  }
+}
+
 TEST(HFTokenizerTest, TestEncode) {
   HFTokenizer tokenizer;
   auto path = _get_resource_path("test_hf_tokenizer.json");
@@ -59,6 +152,20 @@ TEST(HFTokenizerTest, TestEncode) {
   EXPECT_EQ(result.get()[0], 0); // BOS token (default BOS ID)
 }
 
+TEST(HFTokenizerTest, TestEncodeReusesPiecesAcrossCalls) {
+  HFTokenizer tokenizer;
+  ASSERT_EQ(
+      tokenizer.load(_get_resource_path("test_hf_tokenizer.json")), Error::Ok);
+  // The pieces of a longer text must not leak into the next one.
+  const std::string long_text = "Hello world! Hello world! Hello world!";
+  const std::string short_text = "Hello world!";
+  const auto expected = TK_UNWRAP_THROW(tokenizer.encode(short_text, 0, 0));
+  TK_UNWRAP_THROW(tokenizer.encode(long_text, 0, 0));
+  EXPECT_EQ(TK_UNWRAP_THROW(tokenizer.encode(short_text, 0, 0)), expected);
+  TK_UNWRAP_THROW(tokenizer.encode("", 0, 0));
+  EXPECT_EQ(TK_UNWRAP_THROW(tokenizer.encode(short_text, 0, 0)), expected);
+}
+
 TEST(HFTokenizerTest, TestDecode) {
   HFTokenizer tokenizer;
   auto path = _get_resource_path("test_hf_tokenizer.json");
@@ -74,4 +181,274 @@ TEST(HFTokenizerTest, TestDecode) {
   }
 }
 
+TEST(HFTokenizerTest, TestDecodeBeforeEncode) {
+  // Decoding does not depend on the lazily built encoder state.
+  auto path = _get_resource_path("test_hf_tokenizer.json");
+  HFTokenizer tokenizer;
+  ASSERT_EQ(tokenizer.load(path), Error::Ok);
+  HFTokenizer reference;
+  ASSERT_EQ(reference.load(path), Error::Ok);
+  EXPECT_TRUE(reference.encode("Hello world!", 0, 0).ok());
+  for (uint64_t token = 0; token < 10; ++token) {
+    auto decoded = tokenizer.decode(0, token);
+    ASSERT_TRUE(decoded.ok());
+    EXPECT_EQ(decoded.get(), reference.decode(0, token).get());
+  }
+  EXPECT_EQ(
+      tokenizer.encode("Hello world!", 0, 0).get(),
+      reference.encode("Hello world!", 0, 0).get());
+}
+
+TEST(HFTokenizerTest, TestLoadMergeFormats) {
+  // Merges are stored either as "first second" strings or as pairs.
+  for (const auto& [name, merges] :
+       {std::pair<std::string, std::string>{
+            "string_merges.json", R"(["a b", "b c"])"},
+        std::pair<std::string, std::string>{
+            "pair_merges.json", R"([["a", "b"], ["b", "c"]])"}}) {
+    HFTokenizer tokenizer;
+    EXPECT_EQ(tokenizer.load(_write_tokenizer_json(name, merges)), Error::Ok)
+        << name;
+    auto result = tokenizer.encode("abc", /*bos*/ 0, /*eos*/ 0);
+    ASSERT_TRUE(result.ok()) << name;
+    EXPECT_EQ(result.get(), std::vector<uint64_t>({4, 3})) << name;
+  }
+}
+
+TEST(HFTokenizerTest, TestLoadMissingMerges) {
+  HFTokenizer tokenizer;
+  auto path = ::testing::TempDir() + "missing_merges.json";
+  {
+    std::ofstream file(path);
+    file << R"({
+      "added_tokens": [],
+      "pre_tokenizer": {"type": "ByteLevel", "add_prefix_space": false},
+      "model": {"vocab": {"a": 1}}
+    })";
+  }
+  EXPECT_EQ(tokenizer.load(path), Error::LoadFailure);
+}
+
+TEST(HFTokenizerTest, TestSaveAndLoadArtifact) {
+  HFTokenizer tokenizer;
+  ASSERT_EQ(
+      tokenizer.load(_get_resource_path("test_hf_tokenizer.json")), Error::Ok);
+  const auto artifact_path = ::testing::TempDir() + "hf_tokenizer.artifact";
+  ASSERT_EQ(tokenizer.save(artifact_path), Error::Ok);
+
+  HFTokenizer loaded;
+  ASSERT_EQ(loaded.load(artifact_path), Error::Ok);
+  EXPECT_EQ(loaded.vocab_size(), tokenizer.vocab_size());
+  EXPECT_EQ(loaded.bos_tok(), tokenizer.bos_tok());
+  EXPECT_EQ(loaded.eos_tok(), tokenizer.eos_tok());
+
+  const std::string text = "Hello world!";
+  auto expected = tokenizer.encode(text, 1, 0);
+  auto actual = loaded.encode(text, 1, 0);
+  ASSERT_TRUE(actual.ok());
+  EXPECT_EQ(actual.get(), expected.get());
+  for (const auto token : actual.get()) {
+    EXPECT_EQ(loaded.decode(0, token).get(), tokenizer.decode(0, token).get());
+  }
+}
+
+TEST(HFTokenizerTest, TestSaveAndLoadArtifactMerges) {
+  HFTokenizer tokenizer;
+  ASSERT_EQ(
+      tokenizer.load(_write_tokenizer_json("merges.json", R"(["a b"])")),
+      Error::Ok);
+  const auto artifact_path = ::testing::TempDir() + "hf_merges.artifact";
+  ASSERT_EQ(tokenizer.save(artifact_path), Error::Ok);
+
+  HFTokenizer loaded;
+  ASSERT_EQ(loaded.load(artifact_path), Error::Ok);
+  EXPECT_EQ(loaded.encode("abc", 0, 0).get(), std::vector<uint64_t>({4, 3}));
+}
+
+TEST(HFTokenizerTest, TestByteLevelVocabIsRekeyedToBytes) {
+  const auto tokenizer_json = [](const std::string& decoder) {
+    return R"({
+      "added_tokens": [{"id": 0, "content": "<|end|>"}],
+      "normalizer": null,
+      "pre_tokenizer": {"type": "ByteLevel", "add_prefix_space": false},
+      )" +
+        decoder + R"(
+      "model": {
+        "type": "BPE",
+        "vocab": {
+          "<|end|>": 0, "h": 1, "e": 2, "l": 3, "o": 4, "\u0120": 5, "w": 6,
+          "r": 7, "d": 8, "\u00c3": 9, "\u00a9": 10, "he": 11, "ll": 12,
+          "hell": 13, "hello": 14, "\u0120w": 15, "\u00c3\u00a9": 16
+        },
+        "merges": [
+          "h e", "l l", "he ll", "hell o", "\u0120 w", "\u00c3 \u00a9"
+        ]
+      }
+    })";
+  };
+  // Only a ByteLevel decoder lets the vocab be re-keyed.
+  HFTokenizer raw;
+  ASSERT_EQ(
+      raw.load_from_buffer(
+          tokenizer_json(R"("decoder": {"type": "ByteLevel"},)")),
+      Error::Ok);
+  HFTokenizer mapped;
+  ASSERT_EQ(mapped.load_from_buffer(tokenizer_json("")), Error::Ok);
+
+  const std::string text = "hello world \u00e9<|end|>";
+  const std::vector<uint64_t> expected = {14, 15, 4, 7, 3, 8, 5, 16, 0};
+  EXPECT_EQ(raw.encode(text, 0, 0).get(), expected);
+  EXPECT_EQ(mapped.encode(text, 0, 0).get(), expected);
+  EXPECT_EQ(raw.decode(0, 15).get(), " w");
+  EXPECT_EQ(mapped.decode(0, 15).get(), "\u0120w");
+
+  const auto artifact_path = ::testing::TempDir() + "hf_raw_bytes.artifact";
+  ASSERT_EQ(raw.save(artifact_path), Error::Ok);
+  HFTokenizer loaded;
+  ASSERT_EQ(loaded.load(artifact_path), Error::Ok);
+  EXPECT_EQ(loaded.encode(text, 0, 0).get(), expected);
+  std::string decoded;
+  for (const auto token : expected) {
+    decoded += loaded.decode(0, token).get();
+  }
+  EXPECT_EQ(decoded, text);
+}
+
+TEST(HFTokenizerTest, TestMetaspace) {
+  const std::string json = R"({
+    "added_tokens": [
+      {"id": 0, "content": "<s>"}, {"id": 1, "content": "</s>"}
+    ],
+    "normalizer": null,
+    "pre_tokenizer": {
+      "type": "Metaspace", "replacement": "▁",
+      "prepend_scheme": "first", "split": false
+    },
+    "decoder": {
+      "type": "Metaspace", "replacement": "▁", "prepend_scheme": "first"
+    },
+    "model": {
+      "type": "BPE",
+      "vocab": {
+        "<s>": 0, "</s>": 1, "▁": 2, "h": 3, "i": 4, "▁h": 5,
+        "▁hi": 6
+      },
+      "merges": ["▁ h", "▁h i"]
+    }
+  })";
+  HFTokenizer tokenizer;
+  ASSERT_EQ(
+      tokenizer.load_from_buffer(
+          json, R"({"bos_token": "<s>", "eos_token": "</s>"})"),
+      Error::Ok);
+  EXPECT_EQ(
+      tokenizer.encode("hi hi", 1, 0).get(),
+      std::vector<uint64_t>({0, 6, 6}));
+  // The space of the token after BOS is dropped.
+  EXPECT_EQ(tokenizer.decode(0, 6).get(), "hi");
+  EXPECT_EQ(tokenizer.decode(6, 6).get(), " hi");
+}
+
+TEST(HFTokenizerTest, TestLoadFromBuffer) {
+  const auto path = _get_resource_path("test_hf_tokenizer.json");
+  HFTokenizer reference;
+  ASSERT_EQ(reference.load(path), Error::Ok);
+
+  HFTokenizer tokenizer;
+  ASSERT_EQ(tokenizer.load_from_buffer(_read_file(path)), Error::Ok);
+  EXPECT_EQ(tokenizer.vocab_size(), reference.vocab_size());
+  const std::string text = "Hello world!";
+  const auto expected = reference.encode(text, 1, 0);
+  EXPECT_EQ(tokenizer.encode(text, 1, 0).get(), expected.get());
+
+  // Artifacts are recognized in memory too.
+  const auto artifact_path = ::testing::TempDir() + "hf_buffer.artifact";
+  ASSERT_EQ(reference.save(artifact_path), Error::Ok);
+  HFTokenizer loaded;
+  ASSERT_EQ(loaded.load_from_buffer(_read_file(artifact_path)), Error::Ok);
+  EXPECT_EQ(loaded.encode(text, 1, 0).get(), expected.get());
+
+  EXPECT_EQ(HFTokenizer().load_from_buffer("{"), Error::LoadFailure);
+}
+
+TEST(HFTokenizerTest, TestFailedReloadLeavesTokenizerUnloaded) {
+  HFTokenizer tokenizer;
+  ASSERT_EQ(
+      tokenizer.load(_get_resource_path("test_hf_tokenizer.json")), Error::Ok);
+  ASSERT_TRUE(tokenizer.encode("Hello world!", 0, 0).ok());
+
+  EXPECT_EQ(tokenizer.load_from_buffer("{\"model\": 3"), Error::LoadFailure);
+  EXPECT_FALSE(tokenizer.is_loaded());
+  EXPECT_EQ(tokenizer.vocab_size(), 0);
+  EXPECT_EQ(
+      tokenizer.encode("hello world", 0, 0).error(), Error::Uninitialized);
+  EXPECT_EQ(tokenizer.decode(0, 1).error(), Error::Uninitialized);
+}
+
+TEST(HFTokenizerTest, TestLoadFromBufferWithConfig) {
+  const auto json = _read_file(_write_tokenizer_json("config.json", "[]"));
+  HFTokenizer tokenizer;
+  ASSERT_EQ(
+      tokenizer.load_from_buffer(
+          json, R"({"bos_token": "<unk>", "eos_token": "<unk>"})"),
+      Error::Ok);
+  EXPECT_EQ(tokenizer.bos_tok(), 0);
+  EXPECT_EQ(tokenizer.eos_tok(), 0);
+  EXPECT_EQ(
+      tokenizer.load_from_buffer(json, R"({"bos_token": "<s>"})"),
+      Error::LoadFailure);
+}
+
+TEST(HFTokenizerTest, TestLoadRejectsInvalidRegex) {
+  // The component regexes are compiled by load(), not by the first encode().
+  const std::string vocab = R"(
+    "added_tokens": [],
+    "model": {"type": "BPE", "vocab": {"a": 0}, "merges": []})";
+  const std::string split = R"(
+    "pre_tokenizer": {"type": "Split", "pattern": {"Regex": "%s"},
+                      "behavior": "Isolated", "invert": false},)";
+  const auto tokenizer_json = [&](const std::string& normalizer,
+                                  const std::string& pattern) {
+    auto pre_tokenizer = split;
+    pre_tokenizer.replace(pre_tokenizer.find("%s"), 2, pattern);
+    return "{\"normalizer\": " + normalizer + "," + pre_tokenizer + vocab + "}";
+  };
+
+  HFTokenizer tokenizer;
+  EXPECT_EQ(
+      tokenizer.load_from_buffer(tokenizer_json("null", "a")), Error::Ok);
+  EXPECT_EQ(
+      tokenizer.load_from_buffer(tokenizer_json("null", "(a")),
+      Error::LoadFailure);
+  EXPECT_EQ(
+      tokenizer.load_from_buffer(tokenizer_json(
+          R"({"type": "Replace", "pattern": {"Regex": "[a"}, "content": ""})",
+          "a")),
+      Error::LoadFailure);
+}
+
+TEST(HFTokenizerTest, TestLoadErrorsAreDeterministic) {
+  // Every stage of this file is broken; the first one in load order wins.
+  auto path = ::testing::TempDir() + "all_broken.json";
+  {
+    std::ofstream file(path);
+    file << R"({"model": {}})";
+  }
+  for (int i = 0; i < 8; ++i) {
+    HFTokenizer tokenizer;
+    EXPECT_EQ(tokenizer.load(path), Error::LoadFailure);
+  }
+
+  // A slow failing task is reported over a fast failing later one.
+  const auto error = detail::run_tasks({
+      []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return Error::LoadFailure;
+      },
+      []() { return Error::ParseFailure; },
+      []() { return Error::Ok; },
+  });
+  EXPECT_EQ(error, Error::LoadFailure);
+}
+
 } // namespace tokenizers
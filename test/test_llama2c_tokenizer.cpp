@@ -6,6 +6,8 @@
 #include <gtest/gtest.h>
 #include <pytorch/tokenizers/llama2c_tokenizer.h>
 
+#include <fstream>
+
 using namespace ::testing;
 
 namespace tokenizers {
@@ -21,6 +23,31 @@ static inline std::string _get_resource_path(const std::string& name) {
 #endif
 }
 
+// Writes a small llama2.c tokenizer where " ab" is reached by merges.
+static inline std::string _write_tokenizer_bin(const std::string& name) {
+  const auto path = ::testing::TempDir() + name;
+  std::ofstream file(path, std::ios::binary);
+  const std::vector<std::pair<std::string, float>> vocab = {
+      {"<unk>", 0.0f},
+      {"<s>", 0.0f},
+      {"</s>", 0.0f},
+      {" ", -1.0f},
+      {"a", -2.0f},
+      {"b", -3.0f},
+      {"ab", -4.0f},
+      {" ab", -5.0f},
+  };
+  const int32_t metadata[4] = {static_cast<int32_t>(vocab.size()), 1, 2, 3};
+  file.write(reinterpret_cast<const char*>(metadata), sizeof(metadata));
+  for (const auto& [token, score] : vocab) {
+    const int32_t len = static_cast<int32_t>(token.size());
+    file.write(reinterpret_cast<const char*>(&score), sizeof(score));
+    file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    file.write(token.data(), len);
+  }
+  return path;
+}
+
 } // namespace
 
 class Llama2cTokenizerTest : public Test {
@@ -71,4 +98,45 @@ TEST_F(Llama2cTokenizerTest, SafeToDestruct) {
   tokenizer_.reset();
 }
 
+TEST_F(Llama2cTokenizerTest, LoadFromBuffer) {
+  const auto path = _write_tokenizer_bin("llama2c_buffer.bin");
+  std::ifstream file(path, std::ios::binary);
+  const std::string data(
+      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  Llama2cTokenizer tokenizer;
+  ASSERT_EQ(tokenizer.load_from_buffer(data), Error::Ok);
+  EXPECT_EQ(
+      tokenizer.encode("ab ba", 1, 1).get(),
+      std::vector<uint64_t>({1, 7, 3, 5, 4, 2}));
+
+  // A word running past the end of the data is rejected.
+  EXPECT_EQ(
+      Llama2cTokenizer().load_from_buffer(data.substr(0, data.size() - 1)),
+      Error::ParseFailure);
+}
+
+TEST_F(Llama2cTokenizerTest, SaveAndLoadArtifact) {
+  Llama2cTokenizer tokenizer;
+  ASSERT_EQ(tokenizer.load(_write_tokenizer_bin("llama2c.bin")), Error::Ok);
+  auto expected = tokenizer.encode("ab ba", 1, 1);
+  ASSERT_EQ(expected.error(), Error::Ok);
+  EXPECT_EQ(expected.get(), std::vector<uint64_t>({1, 7, 3, 5, 4, 2}));
+
+  const auto artifact_path = ::testing::TempDir() + "llama2c.artifact";
+  ASSERT_EQ(tokenizer.save(artifact_path), Error::Ok);
+  Llama2cTokenizer loaded;
+  ASSERT_EQ(loaded.load(artifact_path), Error::Ok);
+  EXPECT_EQ(loaded.vocab_size(), tokenizer.vocab_size());
+  EXPECT_EQ(loaded.bos_tok(), tokenizer.bos_tok());
+  EXPECT_EQ(loaded.eos_tok(), tokenizer.eos_tok());
+
+  auto actual = loaded.encode("ab ba", 1, 1);
+  ASSERT_EQ(actual.error(), Error::Ok);
+  EXPECT_EQ(actual.get(), expected.get());
+  for (uint64_t token = 0; token < loaded.vocab_size(); ++token) {
+    EXPECT_EQ(loaded.decode(0, token).get(), tokenizer.decode(0, token).get());
+  }
+}
+
 } // namespace tokenizers
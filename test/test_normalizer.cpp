@@ -39,6 +39,24 @@ TEST(NormalizerTest, ReplaceNormalizerMultipleMatches) {
   EXPECT_EQ(result, expected);
 }
 
+TEST(NormalizerTest, ReplaceNormalizerLiteral) {
+  // Matches do not overlap, and the replacement may be longer or shorter
+  ReplaceNormalizer grow("aa", "▁▁");
+  EXPECT_EQ(grow.normalize("aaaba"), "▁▁aba");
+  ReplaceNormalizer shrink("▁", "");
+  EXPECT_EQ(shrink.normalize("▁a▁▁b▁"), "ab");
+  EXPECT_EQ(shrink.normalize(""), "");
+  // An escaped pattern matches its characters literally
+  ReplaceNormalizer escaped("a\\.b", "_");
+  EXPECT_EQ(escaped.normalize("a.b axb a.b"), "_ axb _");
+}
+
+TEST(NormalizerTest, ReplaceNormalizerRegex) {
+  ReplaceNormalizer normalizer("[0-9]+", "#");
+  EXPECT_EQ(normalizer.normalize("a1 b22 c333"), "a# b# c#");
+  EXPECT_EQ(normalizer.normalize("42"), "#");
+}
+
 TEST(NormalizerTest, NormalizerConfigFromJson) {
   // Test JSON parsing for Replace normalizer
   nlohmann::json config = {
@@ -69,6 +87,18 @@ TEST(NormalizerTest, NormalizerConfigFromJsonRegex) {
   EXPECT_EQ(result, expected);
 }
 
+TEST(NormalizerTest, NormalizerConfigFromJsonSpecialString) {
+  // A String pattern with regex syntax in it is still a literal string
+  nlohmann::json config = {
+      {"type", "Replace"}, {"pattern", {{"String", "(.+)"}}}, {"content", "*"}};
+
+  NormalizerConfig norm_config;
+  norm_config.parse_json(config);
+  auto normalizer = norm_config.create();
+
+  EXPECT_EQ(normalizer->normalize("f(.+) g(x) (.+)"), "f* g(x) *");
+}
+
 TEST(NormalizerTest, SequenceNormalizer) {
   // Test sequence of normalizers
   std::vector<Normalizer::Ptr> normalizers;
@@ -12,13 +12,24 @@
 #include <re2/re2.h>
 
 // Local
+#include <pytorch/tokenizers/codepoint_table.h>
 #include <pytorch/tokenizers/pre_tokenizer.h>
+#include <pytorch/tokenizers/token_decoder.h>
+
+// Standard
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 
 using json = nlohmann::json;
 using namespace tokenizers;
 
 // Helpers /////////////////////////////////////////////////////////////////////
 
+static inline std::string _get_resource_path(const std::string& name) {
+  return std::getenv("RESOURCES_PATH") + std::string("/") + name;
+}
+
 static void assert_split_match(
     const PreTokenizer& ptok,
     const std::string& prompt,
@@ -67,6 +78,171 @@ TEST_F(DigitsPreTokenizerTest, ContiguousDigits) {
       {"The number ", "1", " then ", "234", " then ", "5", "."});
 }
 
+// Test that scanning for digits splits like the \p{N} regex
+TEST_F(DigitsPreTokenizerTest, MatchesRegex) {
+  const std::string prompt =
+      "x\u0663\u0664y \u00b2\u00b3 \u216b12\u00e9 \u4e00\u3007 9";
+  for (const bool individual : {true, false}) {
+    RegexPreTokenizer regex(
+        individual ? R"([^\p{N}]+|\p{N})" : R"([^\p{N}]+|[\p{N}]+)");
+    assert_split_match(
+        DigitsPreTokenizer(individual), prompt, regex.pre_tokenize(prompt));
+  }
+}
+
+// Whitespace and WhitespaceSplit /////////////////////////////////////////////
+class WhitespacePreTokenizerTest : public ::testing::Test {};
+
+// Test that words and runs of other characters are split apart
+TEST_F(WhitespacePreTokenizerTest, WordsAndPunctuation) {
+  assert_split_match(
+      WhitespacePreTokenizer(),
+      "Hey man!  How's it going?\nété—дом 3.5",
+      {"Hey",
+       "man",
+       "!",
+       "How",
+       "'",
+       "s",
+       "it",
+       "going",
+       "?",
+       "été",
+       "—",
+       "дом",
+       "3",
+       ".",
+       "5"});
+}
+
+// Test splitting on whitespace only, including non-ASCII whitespace
+TEST_F(WhitespacePreTokenizerTest, WhitespaceSplit) {
+  assert_split_match(
+      WhitespaceSplitPreTokenizer(),
+      "  Hey man!\tHow's　it going?  ",
+      {"Hey", "man!", "How's", "it", "going?"});
+}
+
+// PunctuationPreTokenizer /////////////////////////////////////////////////////
+class PunctuationPreTokenizerTest : public ::testing::Test {};
+
+// Test every delimiter behavior
+TEST_F(PunctuationPreTokenizerTest, Behaviors) {
+  const std::string prompt = "the-final--countdown";
+  assert_split_match(
+      PunctuationPreTokenizer(),
+      prompt,
+      {"the", "-", "final", "-", "-", "countdown"});
+  assert_split_match(
+      PunctuationPreTokenizer("Removed"),
+      prompt,
+      {"the", "final", "countdown"});
+  assert_split_match(
+      PunctuationPreTokenizer("MergedWithPrevious"),
+      prompt,
+      {"the-", "final-", "-", "countdown"});
+  assert_split_match(
+      PunctuationPreTokenizer("MergedWithNext"),
+      prompt,
+      {"the", "-final", "-", "-countdown"});
+  assert_split_match(
+      PunctuationPreTokenizer("Contiguous"),
+      prompt,
+      {"the", "-", "final", "--", "countdown"});
+  EXPECT_THROW(PunctuationPreTokenizer("Unknown"), std::runtime_error);
+}
+
+// Test that punctuation outside ASCII is split on, but symbols are not unless
+// they are ASCII
+TEST_F(PunctuationPreTokenizerTest, UnicodePunctuation) {
+  assert_split_match(
+      PunctuationPreTokenizer(),
+      "¿Qué?。a+b©",
+      {"¿", "Qué", "?", "。", "a", "+", "b©"});
+}
+
+// CharDelimiterSplitPreTokenizer //////////////////////////////////////////////
+class CharDelimiterSplitPreTokenizerTest : public ::testing::Test {};
+
+// Test splitting on an ASCII and a multi-byte delimiter
+TEST_F(CharDelimiterSplitPreTokenizerTest, Split) {
+  assert_split_match(
+      CharDelimiterSplitPreTokenizer(","),
+      ",the,final,,countdown,",
+      {"the", "final", "countdown"});
+  assert_split_match(
+      CharDelimiterSplitPreTokenizer("é"),
+      "café déjà",
+      {"caf", " d", "jà"});
+  EXPECT_THROW(CharDelimiterSplitPreTokenizer(""), std::runtime_error);
+  EXPECT_THROW(CharDelimiterSplitPreTokenizer("ab"), std::runtime_error);
+}
+
+// UnicodeScriptsPreTokenizer //////////////////////////////////////////////////
+class UnicodeScriptsPreTokenizerTest : public ::testing::Test {};
+
+// Test splitting where the script changes, as the tokenizers tests do
+TEST_F(UnicodeScriptsPreTokenizerTest, Scripts) {
+  const UnicodeScriptsPreTokenizer ptok;
+  // Hiragana and Katakana go with Han, and CJK punctuation is Common.
+  assert_split_match(
+      ptok,
+      "どこで生れ。Yes",
+      {"どこで生れ", "。", "Yes"});
+  // Spaces go with the script before them, and leading ones are dropped.
+  assert_split_match(
+      ptok,
+      "  关注公众号 ftdlyc",
+      {"关注公众号 ", "ftdlyc"});
+  assert_split_match(ptok, "Hello 123, world", {"Hello ", "123, ", "world"});
+  assert_split_match(ptok, "   ", {});
+}
+
+// BertPreTokenizer ////////////////////////////////////////////////////////////
+class BertPreTokenizerTest : public ::testing::Test {};
+
+// Test splitting on whitespace and isolating punctuation
+TEST_F(BertPreTokenizerTest, Split) {
+  assert_split_match(
+      BertPreTokenizer(),
+      "Hey friend!     How are you?!?",
+      {"Hey", "friend", "!", "How", "are", "you", "?", "!", "?"});
+  assert_split_match(
+      BertPreTokenizer(),
+      "¿Qué tal?　Sí.",
+      {"¿", "Qué", "tal", "?", "Sí", "."});
+}
+
+// MetaspacePreTokenizer ///////////////////////////////////////////////////////
+class MetaspacePreTokenizerTest : public ::testing::Test {};
+
+// Test that spaces are replaced and each replacement starts a piece
+TEST_F(MetaspacePreTokenizerTest, ReplaceAndSplit) {
+  assert_split_match(
+      MetaspacePreTokenizer(),
+      "Hey  friend! ▁x ",
+      {"▁Hey", "▁", "▁friend!", "▁", "▁x", "▁"});
+  assert_split_match(
+      MetaspacePreTokenizer("▁", "always", false),
+      " Hey friend",
+      {"▁Hey▁friend"});
+  assert_split_match(MetaspacePreTokenizer(), "", {});
+}
+
+// Test which pieces the replacement is prepended to
+TEST_F(MetaspacePreTokenizerTest, PrependScheme) {
+  const auto split_then = [](const std::string& scheme) {
+    return SequencePreTokenizer(
+        {std::make_shared<WhitespaceSplitPreTokenizer>(),
+         std::make_shared<MetaspacePreTokenizer>("▁", scheme)});
+  };
+  assert_split_match(split_then("always"), "a b c", {"▁a", "▁b", "▁c"});
+  assert_split_match(split_then("first"), "a b c", {"▁a", "b", "c"});
+  assert_split_match(split_then("never"), "a b c", {"a", "b", "c"});
+  EXPECT_THROW(MetaspacePreTokenizer("▁", "sometimes"), std::runtime_error);
+  EXPECT_THROW(MetaspacePreTokenizer("__"), std::runtime_error);
+}
+
 // ByteLevelPreTokenizer ///////////////////////////////////////////////////////
 class ByteLevelPreTokenizerTest : public ::testing::Test {};
 
@@ -89,6 +265,25 @@ TEST_F(ByteLevelPreTokenizerTest, PreTokenizeCustomRegex) {
   assert_split_match(ptok, "Hello World", {"Hell", "o", "ĠW", "o", "rld"});
 }
 
+// Test that every byte is mapped to the character the decoder maps back
+TEST_F(ByteLevelPreTokenizerTest, MapsEveryByte) {
+  std::string prompt;
+  for (int byte = 0; byte < 256; ++byte) {
+    prompt += static_cast<char>(byte);
+  }
+  ByteLevelPreTokenizer ptok(false, "x");
+  const auto pieces = ptok.pre_tokenize(prompt);
+  ASSERT_EQ(pieces.size(), 3);
+  EXPECT_EQ(pieces[1], "x");
+  EXPECT_EQ(pieces[0].substr(0, 2), "Ā");
+  EXPECT_EQ(pieces[0].substr(64, 2), "Ġ");
+  std::string decoded;
+  for (const auto& piece : pieces) {
+    decoded += ByteLevelTokenDecoder().decode(piece);
+  }
+  EXPECT_EQ(decoded, prompt);
+}
+
 // SequencePreTokenizer ////////////////////////////////////////////////////////
 class SequencePreTokenizerTest : public ::testing::Test {};
 
@@ -114,6 +309,190 @@ TEST_F(SequencePreTokenizerTest, PreTokenizeDigitAndByteLevel) {
        "."});
 }
 
+TEST_F(SequencePreTokenizerTest, FusedSplitStages) {
+  PreTokenizer::Ptr sptok(new RegexPreTokenizer(R"( ?[^ ]+| +)"));
+  PreTokenizer::Ptr dptok(new DigitsPreTokenizer(false));
+  PreTokenizer::Ptr delim(new RegexPreTokenizer("-", true, "Isolated"));
+  SequencePreTokenizer ptok({sptok, dptok, delim});
+  assert_split_match(
+      ptok,
+      "ab12-cd  34x-",
+      {"ab", "12", "-", "cd", "  ", "34", "x", "-"});
+}
+
+TEST_F(SequencePreTokenizerTest, SpansReferToInputUntilRewritten) {
+  PreTokenizer::Ptr wptok(new RegexPreTokenizer(R"(\S+)"));
+  PreTokenizer::Ptr dptok(new DigitsPreTokenizer(true));
+  const std::string input = "The number 12 then 3.";
+  PreTokenizedString pieces(input);
+  SequencePreTokenizer({wptok, dptok}).pre_tokenize_spans(pieces);
+  EXPECT_EQ(&pieces.text(), &input);
+  const std::vector<std::string> expected = {
+      "The", "number", "1", "2", "then", "3", "."};
+  ASSERT_EQ(pieces.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(pieces[i], expected[i]);
+  }
+
+  // Rewriting moves the pieces to a buffer, which the next input reuses.
+  PreTokenizer::Ptr bptok(new ByteLevelPreTokenizer(false));
+  SequencePreTokenizer ptok({dptok, bptok});
+  for (const std::string prompt : {"The number 1 then 234", "x 5 y"}) {
+    pieces.reset(prompt);
+    ptok.pre_tokenize_spans(pieces);
+    EXPECT_NE(&pieces.text(), &prompt);
+    EXPECT_EQ(pieces.to_strings(), ptok.pre_tokenize(prompt));
+  }
+}
+
+namespace {
+
+// Splits after each comma, without implementing split_range()
+class CommaPreTokenizer : public PreTokenizer {
+ public:
+  std::vector<std::string> pre_tokenize(
+      const std::string& input) const override {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (start < input.size()) {
+      const size_t comma = input.find(',', start);
+      const size_t end = comma == std::string::npos ? input.size() : comma + 1;
+      result.push_back(input.substr(start, end - start));
+      start = end;
+    }
+    return result;
+  }
+
+  bool splits_only() const override {
+    return true;
+  }
+};
+
+// Claims to only split, but returns its first piece twice
+class RepeatingPreTokenizer : public CommaPreTokenizer {
+ public:
+  std::vector<std::string> pre_tokenize(
+      const std::string& input) const override {
+    auto result = CommaPreTokenizer::pre_tokenize(input);
+    if (!result.empty()) {
+      result.insert(result.begin() + 1, result.front());
+    }
+    return result;
+  }
+};
+
+} // namespace
+
+TEST_F(SequencePreTokenizerTest, DefaultSplitRangeKeepsUnmatchedText) {
+  PreTokenizer::Ptr wptok(new RegexPreTokenizer(R"(\S+)"));
+  PreTokenizer::Ptr rptok(new RepeatingPreTokenizer());
+  PreTokenizer::Ptr dptok(new DigitsPreTokenizer(false));
+  SequencePreTokenizer ptok({wptok, rptok, dptok});
+  assert_split_match(ptok, "a,b 12,c3", {"a,", "b", "12", ",", "c", "3"});
+}
+
+TEST_F(SequencePreTokenizerTest, DefaultSplitRangeUsesPreTokenize) {
+  PreTokenizer::Ptr wptok(new RegexPreTokenizer(R"(\S+)"));
+  PreTokenizer::Ptr cptok(new CommaPreTokenizer());
+  PreTokenizer::Ptr dptok(new DigitsPreTokenizer(false));
+  SequencePreTokenizer ptok({wptok, cptok, dptok});
+  assert_split_match(
+      ptok, "a,b 12,c3 ,", {"a,", "b", "12", ",", "c", "3", ","});
+}
+
+TEST_F(SequencePreTokenizerTest, ShrinkFreesLargeBuffers) {
+  PreTokenizer::Ptr wptok(new RegexPreTokenizer(R"(\S+)"));
+  PreTokenizer::Ptr bptok(new ByteLevelPreTokenizer(false));
+  SequencePreTokenizer ptok({wptok, bptok});
+  PreTokenizedString pieces;
+
+  const std::string small = "a b c";
+  pieces.reset(small);
+  ptok.pre_tokenize_spans(pieces);
+  const std::size_t kept = pieces.capacity_bytes();
+  pieces.shrink(kept);
+  EXPECT_EQ(pieces.size(), 0);
+  EXPECT_EQ(pieces.capacity_bytes(), kept);
+
+  std::string large;
+  for (int i = 0; i < 10000; ++i) {
+    large += "word ";
+  }
+  pieces.reset(large);
+  ptok.pre_tokenize_spans(pieces);
+  EXPECT_GT(pieces.capacity_bytes(), 2 * large.size());
+  pieces.shrink(large.size());
+  EXPECT_EQ(pieces.size(), 0);
+  EXPECT_LE(pieces.capacity_bytes(), kept);
+
+  // The pieces still work after being shrunk.
+  pieces.reset(small);
+  ptok.pre_tokenize_spans(pieces);
+  EXPECT_EQ(pieces.to_strings(), ptok.pre_tokenize(small));
+}
+
+// CodepointTable //////////////////////////////////////////////////////////////
+class CodepointTableTest : public ::testing::Test {};
+
+TEST_F(CodepointTableTest, KnownClasses) {
+  using detail::CodepointClass;
+  const auto& table = detail::CodepointTable::get();
+  EXPECT_TRUE(table[0x20].is(CodepointClass::kWhitespace));
+  EXPECT_TRUE(table[0xa0].is(CodepointClass::kWhitespace));
+  EXPECT_TRUE(table[0x3000].is(CodepointClass::kWhitespace));
+  EXPECT_TRUE(table[0x5f].is(CodepointClass::kWord));
+  EXPECT_TRUE(table[0x5f].is(CodepointClass::kPunctuation));
+  EXPECT_TRUE(table[0xe9].is(CodepointClass::kWord));
+  EXPECT_TRUE(table[0x2014].is(CodepointClass::kPunctuation));
+  EXPECT_TRUE(table[0x660].is(CodepointClass::kNumeric));
+  EXPECT_TRUE(table[0x660].is(CodepointClass::kWord));
+  // Superscript two is numeric, but not a decimal digit, so not \w.
+  EXPECT_TRUE(table[0xb2].is(CodepointClass::kNumeric));
+  EXPECT_FALSE(table[0xb2].is(CodepointClass::kWord));
+
+  // Hiragana, Katakana and the prolonged sound mark count as Han.
+  const uint8_t han = table[0x4e2d].script;
+  EXPECT_EQ(table[0x3042].script, han);
+  EXPECT_EQ(table[0x30a2].script, han);
+  EXPECT_EQ(table[0x30fc].script, han);
+  EXPECT_NE(table[0x61].script, table[0x3b1].script);
+  EXPECT_EQ(table[0x20].script, CodepointClass::kAnyScript);
+}
+
+TEST_F(CodepointTableTest, MatchesHFSample) {
+  // Each line is a codepoint, its flags as HF tokenizers sees them and a
+  // codepoint of the same script, or - for none, in hex. See
+  // tools/gen_codepoint_table.py.
+  std::ifstream file(_get_resource_path("hf_codepoint_sample.txt"));
+  ASSERT_TRUE(file);
+  const auto& table = detail::CodepointTable::get();
+  std::string line;
+  size_t checked = 0;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    uint32_t cp = 0, flags = 0;
+    std::string script;
+    ASSERT_TRUE(fields >> std::hex >> cp >> flags >> script) << line;
+    const auto got = table[cp];
+    EXPECT_EQ(got.flags, flags) << "U+" << std::hex << cp;
+    if (script == "-") {
+      EXPECT_EQ(got.script, detail::CodepointClass::kAnyScript)
+          << "U+" << std::hex << cp;
+    } else {
+      EXPECT_NE(got.script, detail::CodepointClass::kAnyScript)
+          << "U+" << std::hex << cp;
+      const uint32_t script_cp = std::stoul(script, nullptr, 16);
+      EXPECT_EQ(got.script, table[script_cp].script)
+          << "U+" << std::hex << cp;
+    }
+    ++checked;
+  }
+  EXPECT_GT(checked, 1000);
+}
+
 // PreTokenizerConfig //////////////////////////////////////////////////////////
 //
 // NOTE: When adding a new pre-tokenizer or changing arguments, add it to these
@@ -129,6 +508,23 @@ TEST_F(PreTokenizerConfigTest, AllTypesSuccess) {
   PreTokenizerConfig("Digits").set_individual_digits(true).create();
   PreTokenizerConfig("Digits").set_individual_digits(false).create();
 
+  // Native splitters
+  PreTokenizerConfig("Whitespace").create();
+  PreTokenizerConfig("WhitespaceSplit").create();
+  PreTokenizerConfig("Punctuation").create();
+  PreTokenizerConfig("Punctuation").set_behavior("Contiguous").create();
+  PreTokenizerConfig("CharDelimiterSplit").set_delimiter(" ").create();
+  PreTokenizerConfig("UnicodeScripts").create();
+  PreTokenizerConfig("BertPreTokenizer").create();
+
+  // Metaspace
+  PreTokenizerConfig("Metaspace").create();
+  PreTokenizerConfig("Metaspace")
+      .set_replacement("_")
+      .set_prepend_scheme("first")
+      .set_split(false)
+      .create();
+
   // ByteLevel
   PreTokenizerConfig("ByteLevel").create();
   PreTokenizerConfig("ByteLevel").set_pattern(R"(o)").create();
@@ -149,6 +545,21 @@ TEST_F(PreTokenizerConfigTest, AllTypesFailureCases) {
   // Regex
   EXPECT_THROW(PreTokenizerConfig("Split").create(), std::runtime_error);
 
+  // Native splitters
+  EXPECT_THROW(
+      PreTokenizerConfig("Punctuation").set_behavior("Unknown").create(),
+      std::runtime_error);
+  EXPECT_THROW(
+      PreTokenizerConfig("CharDelimiterSplit").create(), std::runtime_error);
+  EXPECT_THROW(
+      PreTokenizerConfig("CharDelimiterSplit").set_delimiter("--").create(),
+      std::runtime_error);
+
+  // Metaspace
+  EXPECT_THROW(
+      PreTokenizerConfig("Metaspace").set_prepend_scheme("sometimes").create(),
+      std::runtime_error);
+
   // Sequence
   EXPECT_THROW(PreTokenizerConfig("Sequence").create(), std::runtime_error);
   EXPECT_THROW(
@@ -213,6 +624,50 @@ TEST_F(PreTokenizerConfigTest, ParseJsonOptionalKey) {
       {"The number ", "1", " then ", "234", " then ", "5", "."});
 }
 
+TEST_F(PreTokenizerConfigTest, ParseJsonMetaspace) {
+  const auto ptok = PreTokenizerConfig()
+                        .parse_json(json{
+                            {"type", "Metaspace"},
+                            {"replacement", "_"},
+                            {"prepend_scheme", "first"},
+                            {"split", true},
+                        })
+                        .create();
+  assert_split_match(*ptok, "Hello world", {"_Hello", "_world"});
+
+  // Configs from before prepend_scheme
+  const auto legacy = PreTokenizerConfig()
+                          .parse_json(json{
+                              {"type", "Metaspace"},
+                              {"replacement", "_"},
+                              {"add_prefix_space", false},
+                          })
+                          .create();
+  assert_split_match(*legacy, "Hello world", {"Hello", "_world"});
+}
+
+TEST_F(PreTokenizerConfigTest, ParseJsonNativeSplitters) {
+  const auto ptok = PreTokenizerConfig()
+                        .parse_json(json{
+                            {"type", "Sequence"},
+                            {"pretokenizers",
+                             json{
+                                 json{
+                                     {"type", "CharDelimiterSplit"},
+                                     {"delimiter", "|"},
+                                 },
+                                 json{{"type", "WhitespaceSplit"}},
+                                 json{
+                                     {"type", "Punctuation"},
+                                     {"behavior", "MergedWithPrevious"},
+                                 },
+                             }},
+                        })
+                        .create();
+  assert_split_match(
+      *ptok, "Hello, world!|Bye.", {"Hello,", "world!", "Bye."});
+}
+
 TEST_F(PreTokenizerConfigTest, Split) {
   PreTokenizerConfig config;
   const auto ptok =
@@ -47,6 +47,7 @@ class TestPythonBindings(unittest.TestCase):
         self.assertTrue(hasattr(pytorch_tokenizers.Error, "ParseFailure"))
         self.assertTrue(hasattr(pytorch_tokenizers.Error, "DecodeFailure"))
         self.assertTrue(hasattr(pytorch_tokenizers.Error, "RegexFailure"))
+        self.assertTrue(hasattr(pytorch_tokenizers.Error, "SaveFailure"))
 
     def test_tokenizer_creation(self):
         """Test that tokenizers can be created"""
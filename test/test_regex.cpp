@@ -8,7 +8,13 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <thread>
+
+#include "pytorch/tokenizers/dfa_regex.h"
+#include "pytorch/tokenizers/native_regex.h"
 #include "pytorch/tokenizers/pcre2_regex.h"
+#include "pytorch/tokenizers/re2_lookahead_regex.h"
 #include "pytorch/tokenizers/re2_regex.h"
 #include "pytorch/tokenizers/regex.h"
 
@@ -35,6 +41,77 @@ TEST_F(RegexTest, BasicMatching) {
       "world");
 }
 
+TEST_F(RegexTest, SharedRegexIsCompiledOnce) {
+  auto first = TK_UNWRAP_THROW(get_shared_regex("[a-z]+"));
+  auto second = TK_UNWRAP_THROW(get_shared_regex("[a-z]+"));
+  auto other = TK_UNWRAP_THROW(get_shared_regex("[0-9]+"));
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_NE(first.get(), other.get());
+  EXPECT_EQ(first->find_all("ab 12").size(), 1);
+
+  // The cache does not keep released regexes alive.
+  std::weak_ptr<const IRegex> released = other;
+  other.reset();
+  EXPECT_TRUE(released.expired());
+  EXPECT_FALSE(get_shared_regex("(").ok());
+}
+
+TEST_F(RegexTest, SharedRegexFollowsSettings) {
+  auto regex = TK_UNWRAP_THROW(get_shared_regex("[a-z]+"));
+
+  const auto defaults = Re2Regex::default_options();
+  auto options = defaults;
+  options.per_thread = !defaults.per_thread;
+  Re2Regex::set_default_options(options);
+  auto other_options = TK_UNWRAP_THROW(get_shared_regex("[a-z]+"));
+  Re2Regex::set_default_options(defaults);
+  EXPECT_NE(other_options.get(), regex.get());
+
+  set_regex_benchmarking(true, "abc def");
+  auto benchmarked = TK_UNWRAP_THROW(get_shared_regex("[a-z]+"));
+  set_regex_benchmarking(false);
+  EXPECT_NE(benchmarked.get(), regex.get());
+  EXPECT_NE(benchmarked.get(), other_options.get());
+
+  EXPECT_EQ(TK_UNWRAP_THROW(get_shared_regex("[a-z]+")).get(), regex.get());
+}
+
+TEST_F(RegexTest, BackendNames) {
+  const std::string cl100k =
+      R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)";
+  EXPECT_STREQ(TK_UNWRAP_THROW(create_regex(cl100k))->backend_name(), "native");
+  // pcre2-jit, or pcre2 if PCRE2 is built without JIT support.
+  const std::string pcre2_name =
+      TK_UNWRAP_THROW(create_regex("\\w+|\\s+(?!\\S)"))->backend_name();
+  EXPECT_EQ(pcre2_name.rfind("pcre2", 0), 0) << pcre2_name;
+  EXPECT_STREQ(
+      TK_UNWRAP_THROW(create_regex("a+|\\s+(?!\\S)|\\s+"))->backend_name(),
+      "re2-lookahead");
+  EXPECT_STREQ(TK_UNWRAP_THROW(create_regex("a+"))->backend_name(), "re2");
+}
+
+TEST_F(RegexTest, FastestRegexAgreesWithDefault) {
+  const std::string sample = "Hello world's 123 \u00e9t\u00e9  \n\n  x";
+  for (const std::string pattern :
+       {"\\w+", "[a-z]+|\\d", "\\p{L}+|\\s+(?!\\S)|\\s+"}) {
+    auto regex = TK_UNWRAP_THROW(create_fastest_regex(pattern, sample));
+    auto reference = TK_UNWRAP_THROW(create_regex(pattern));
+    const auto matches = regex->find_all(sample);
+    const auto expected = reference->find_all(sample);
+    ASSERT_EQ(matches.size(), expected.size()) << regex->backend_name();
+    for (size_t i = 0; i < matches.size(); ++i) {
+      EXPECT_EQ(matches[i].start, expected[i].start);
+      EXPECT_EQ(matches[i].end, expected[i].end);
+    }
+  }
+
+  // create_regex() benchmarks the backends once enabled.
+  set_regex_benchmarking(true);
+  auto regex = TK_UNWRAP_THROW(create_regex("[a-z]+"));
+  set_regex_benchmarking(false);
+  EXPECT_EQ(regex->find_all("ab 12 cd").size(), 2);
+}
+
 // Test pattern that only PCRE2 supports (lookbehind)
 TEST_F(RegexTest, Pcre2Specific) {
   const std::string pattern = "(?<=@)\\w+";
@@ -53,16 +130,17 @@ TEST_F(RegexTest, Pcre2Specific) {
       "example");
 }
 
-// Test complex pattern with negative lookahead that should fall back to PCRE2.
-// This specific pattern is from the Qwen2.5 1.5B pretokenizer.
+// Test complex pattern with negative lookahead, which has a native scanner
+// backed by RE2 with the lookahead emulated. This specific pattern is from the
+// Qwen2.5 1.5B pretokenizer.
 // https://huggingface.co/Qwen/Qwen2.5-1.5B/raw/main/tokenizer.json
 TEST_F(RegexTest, ComplexPatternWithNegativeLookahead) {
   const std::string complex_pattern =
       "(?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\\r\\n\\p{L}\\p{N}]?\\p{L}+|\\p{N}| ?[^\\s\\p{L}\\p{N}]+[\\r\\n]*|\\s*[\\r\\n]+|\\s+(?!\\S)|\\s+";
 
-  // Now verify that the factory function fallsback on a PCRE2 regex
+  // Now verify that the factory function picks the native scanner
   auto regex = TK_UNWRAP_THROW(create_regex(complex_pattern));
-  EXPECT_NE(dynamic_cast<Pcre2Regex*>(regex.get()), nullptr);
+  EXPECT_NE(dynamic_cast<NativeRegex*>(regex.get()), nullptr);
 
   // Test the pattern with some sample text
   std::string text = "Hello's world\n  test";
@@ -105,3 +183,332 @@ TEST_F(RegexTest, ComplexPatternWithNegativeLookahead) {
       text.substr(matches[5].start, matches[5].end - matches[5].start),
       " test");
 }
+
+TEST_F(RegexTest, FindAllIntoReplacesMatches) {
+  auto regex = TK_UNWRAP_THROW(create_regex("\\w+"));
+  std::vector<Match> matches = {{7, 8}, {9, 10}, {11, 12}};
+  regex->find_all_into("Hello world", matches);
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0].start, 0);
+  EXPECT_EQ(matches[0].end, 5);
+  EXPECT_EQ(matches[1].start, 6);
+  EXPECT_EQ(matches[1].end, 11);
+  regex->find_all_into("", matches);
+  EXPECT_TRUE(matches.empty());
+}
+
+TEST_F(RegexTest, Re2SkipsPastEmptyMatches) {
+  Re2Regex regex;
+  ASSERT_EQ(regex.compile("a*"), Error::Ok);
+  const auto matches = regex.find_all("baac");
+  ASSERT_EQ(matches.size(), 3);
+  EXPECT_EQ(matches[0].start, 0);
+  EXPECT_EQ(matches[0].end, 0);
+  EXPECT_EQ(matches[1].start, 1);
+  EXPECT_EQ(matches[1].end, 3);
+  EXPECT_EQ(matches[2].start, 3);
+  EXPECT_EQ(matches[2].end, 3);
+}
+
+TEST_F(RegexTest, Re2PerThreadCopiesMatchSharedRegex) {
+  const std::string pattern = "[a-z]+|\\p{L}+|\\s+";
+  Re2Regex shared;
+  ASSERT_EQ(shared.compile(pattern), Error::Ok);
+  Re2Regex::Options options;
+  options.per_thread = true;
+  options.max_copies = 3;
+  options.max_mem = 1 << 20;
+  Re2Regex regex(options);
+  ASSERT_EQ(regex.compile(pattern), Error::Ok);
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "word  \u00e9t\u00e9\n\n ";
+  }
+  const auto expected = shared.find_all(text);
+  ASSERT_EQ(expected.size(), 4000);
+
+  // More threads than copies, so that some of them share one.
+  std::vector<std::vector<Match>> results(5);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&regex, &text, &result]() {
+      for (int round = 0; round < 20; ++round) {
+        regex.find_all_into(text, result);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_EQ(result[i].start, expected[i].start);
+      EXPECT_EQ(result[i].end, expected[i].end);
+    }
+  }
+}
+
+TEST_F(RegexTest, LookaheadEmulationUsesRe2Options) {
+  const std::string pattern =
+      "'s|'t|'re|'ve|'m|'ll|'d| ?\\p{L}+| ?\\p{N}+| ?[^\\s\\p{L}\\p{N}]+|"
+      "\\s+(?!\\S)|\\s+";
+  Re2LookaheadRegex shared;
+  ASSERT_EQ(shared.compile(pattern), Error::Ok);
+
+  // A memory budget too small for the program fails the compile.
+  Re2Regex::Options small;
+  small.max_mem = 1 << 10;
+  EXPECT_NE(Re2LookaheadRegex(small).compile(pattern), Error::Ok);
+
+  Re2Regex::Options options;
+  options.per_thread = true;
+  options.max_copies = 3;
+  Re2LookaheadRegex regex(options);
+  ASSERT_EQ(regex.compile(pattern), Error::Ok);
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "it's  \u00e9t\u00e9 42\n\n ";
+  }
+  const auto expected = shared.find_all(text);
+
+  std::vector<std::vector<Match>> results(5);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&regex, &text, &result]() {
+      for (int round = 0; round < 20; ++round) {
+        regex.find_all_into(text, result);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_EQ(result[i].start, expected[i].start);
+      EXPECT_EQ(result[i].end, expected[i].end);
+    }
+  }
+}
+
+TEST_F(RegexTest, Pcre2MatchesFromManyThreads) {
+  Pcre2Regex regex;
+  ASSERT_EQ(regex.compile("\\s+(?!\\S)|\\s+|\\S+"), Error::Ok);
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "word  \u00e9t\u00e9\n\n ";
+  }
+  // Six matches per repetition, except that the trailing whitespace is one.
+  const auto expected = regex.find_all(text);
+  ASSERT_EQ(expected.size(), 5999);
+
+  std::vector<std::vector<Match>> results(4);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&regex, &text, &result]() {
+      for (int round = 0; round < 20; ++round) {
+        regex.find_all_into(text, result);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_EQ(result[i].start, expected[i].start);
+      EXPECT_EQ(result[i].end, expected[i].end);
+    }
+  }
+}
+
+TEST_F(RegexTest, Pcre2HandlesLongWhitespaceRuns) {
+  // Backtracking through \s+ needs more than the default JIT stack.
+  Pcre2Regex regex;
+  ASSERT_EQ(regex.compile("\\s+(?!\\S)|\\s+"), Error::Ok);
+  const std::string text = std::string(1 << 20, ' ') + "x";
+  const auto matches = regex.find_all(text);
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0].end, text.size() - 2);
+  EXPECT_EQ(matches[1].end, text.size() - 1);
+}
+
+TEST_F(RegexTest, Pcre2SkipsEmptyMatchesByCharacter) {
+  Pcre2Regex regex;
+  ASSERT_EQ(regex.compile("a*"), Error::Ok);
+  const auto matches = regex.find_all("\u00e9a\u00e9");
+  ASSERT_EQ(matches.size(), 3);
+  EXPECT_EQ(matches[0].end, 0);
+  EXPECT_EQ(matches[1].start, 2);
+  EXPECT_EQ(matches[1].end, 3);
+  EXPECT_EQ(matches[2].start, 3);
+  EXPECT_EQ(matches[2].end, 3);
+}
+
+// The native scanners must match exactly what the regex engines match, on
+// ASCII text and on text that is partly handed to the engine.
+TEST_F(RegexTest, NativeScannersMatchRegexEngines) {
+  const std::vector<std::string> patterns = {
+      R"('s|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+)",
+      R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)",
+      R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+)",
+      R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)",
+      R"([^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+(?i:'s|'t|'re|'ve|'m|'ll|'d)?|[^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*(?i:'s|'t|'re|'ve|'m|'ll|'d)?|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+(?!\S)|\s+)",
+      R"([!"#$%&'()*+,\-./:;<=>?@\[\\\]^_`{|}~][A-Za-z]+|[^\r\n\p{L}\p{P}\p{S}]?[\p{L}\p{M}]+| ?[\p{P}\p{S}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)",
+  };
+  const std::vector<std::string> pieces = {
+      "a",  "Z",  "q",  "'",  "s",  "LL", "re", "VE", " ",  " ",  "  ",
+      "\t", "\n", "\r", "\f", "\v", "0",  "42", "!",  "/",  "-",  "\x01",
+      "\x7f", "é", "Ω", "中", "ſ", "\xcc\x81", "\xc2\xa0", "🙂"};
+
+  std::mt19937 rng(7);
+  for (const auto& pattern : patterns) {
+    auto native = TK_UNWRAP_THROW(create_regex(pattern));
+    ASSERT_NE(dynamic_cast<NativeRegex*>(native.get()), nullptr) << pattern;
+
+    std::unique_ptr<IRegex> reference;
+    if (pattern.find("(?!") == std::string::npos) {
+      reference = std::make_unique<Re2Regex>();
+      ASSERT_EQ(reference->compile("(" + pattern + ")"), Error::Ok);
+    } else {
+      reference = std::make_unique<Pcre2Regex>();
+      ASSERT_EQ(reference->compile(pattern), Error::Ok);
+    }
+
+    for (int round = 0; round < 300; ++round) {
+      // Every third text is ASCII only.
+      const size_t choices =
+          round % 3 == 0 ? pieces.size() - 7 : pieces.size();
+      std::string text;
+      const size_t size = rng() % 60;
+      for (size_t i = 0; i < size; ++i) {
+        text += pieces[rng() % choices];
+      }
+      const auto expected = reference->find_all(text);
+      const auto matches = native->find_all(text);
+      ASSERT_EQ(matches.size(), expected.size()) << pattern << "\n" << text;
+      for (size_t i = 0; i < matches.size(); ++i) {
+        EXPECT_EQ(matches[i].start, expected[i].start) << text;
+        EXPECT_EQ(matches[i].end, expected[i].end) << text;
+      }
+    }
+  }
+}
+
+TEST_F(RegexTest, NativeScannersRecognizeRawNewlines) {
+  // Some tokenizer.json files have \r and \n characters in the pattern.
+  EXPECT_EQ(
+      NativeRegex::recognize(
+          "[!\"#$%&'()*+,\\-./:;<=>?@\\[\\\\\\]^_`{|}~][A-Za-z]+|"
+          "[^\r\n\\p{L}\\p{P}\\p{S}]?[\\p{L}\\p{M}]+|"
+          " ?[\\p{P}\\p{S}]+[\r\n]*|\\s*[\r\n]+|\\s+(?!\\S)|\\s+"),
+      NativeRegex::Pattern::DeepSeekV3);
+  EXPECT_FALSE(NativeRegex::recognize("\\w+").has_value());
+}
+
+TEST_F(RegexTest, LookaheadEmulationMatchesPcre2) {
+  const std::vector<std::string> patterns = {
+      R"('s|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+)",
+      R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)",
+      R"([^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+(?i:'s|'t|'re|'ve|'m|'ll|'d)?|[^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*(?i:'s|'t|'re|'ve|'m|'ll|'d)?|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+(?!\S)|\s+)",
+      R"(\s+(?!\S)|\s+)",
+      R"( ?\p{L}+|\s+(?!\S))",
+      R"(\d+|\S|\s+(?!\S)|\s+)",
+  };
+  // Includes the whitespace that only PCRE2's \s matches.
+  const std::vector<std::string> pieces = {
+      "a",  "Z",  "k",  "'",    "s",  "LL", " ",    " ",    "  ",
+      "\t", "\n", "\r", "\v",   "0",  "42", "\u0663", "!",    "-",
+      "é",  "中", "ſ",  "🙂", "\u00a0", "\u0085", "\u3000", "\u2028", "\u180e"};
+
+  std::mt19937 rng(5);
+  for (const auto& pattern : patterns) {
+    Re2LookaheadRegex regex;
+    ASSERT_EQ(regex.compile(pattern), Error::Ok) << pattern;
+    Pcre2Regex reference;
+    ASSERT_EQ(reference.compile(pattern), Error::Ok);
+
+    for (int round = 0; round < 300; ++round) {
+      std::string text;
+      const size_t size = rng() % 60;
+      for (size_t i = 0; i < size; ++i) {
+        text += pieces[rng() % pieces.size()];
+      }
+      const auto expected = reference.find_all(text);
+      const auto matches = regex.find_all(text);
+      ASSERT_EQ(matches.size(), expected.size()) << pattern << "\n" << text;
+      for (size_t i = 0; i < matches.size(); ++i) {
+        EXPECT_EQ(matches[i].start, expected[i].start) << text;
+        EXPECT_EQ(matches[i].end, expected[i].end) << text;
+      }
+    }
+  }
+}
+
+TEST_F(RegexTest, LookaheadEmulationRejectsOtherPatterns) {
+  for (const std::string pattern :
+       {"a(?=b)|\\s+(?!\\S)|\\s+",
+        "\\s+(?!\\S)|\\S+",
+        "\\w+|\\s+(?!\\S)|\\s+",
+        "x$|\\s+(?!\\S)",
+        "[^\\S\\n]+|\\s+(?!\\S)"}) {
+    Re2LookaheadRegex regex;
+    EXPECT_NE(regex.compile(pattern), Error::Ok) << pattern;
+  }
+  auto regex = TK_UNWRAP_THROW(create_regex("\\p{L}+|\\s+(?!\\S)|\\s+"));
+  EXPECT_NE(dynamic_cast<Re2LookaheadRegex*>(regex.get()), nullptr);
+}
+
+TEST_F(RegexTest, DfaMatchesRe2) {
+  const std::vector<std::string> patterns = {
+      R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+)",
+      R"([^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+(?i:'s|'t|'re|'ve|'m|'ll|'d)?|[^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*(?i:'s|'t|'re|'ve|'m|'ll|'d)?|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+)",
+      R"([一-龥぀-ゟ゠-ヿ]+)",
+      R"(\w+|[^\w\s]+)",
+      R"((?i)ss|k+|É)",
+      R"(a|ab|[[:alpha:]][[:^digit:]])",
+      R"(a+?b|\d{2,3}?|s{2}\x{3a9}|\P{L}{3,})",
+      R"((?s:.)L|.r)",
+      // Matches that start after the first byte that could start one.
+      R"(a+b|a*!|b0|\s[^\s]*Z)",
+  };
+  // Includes the Kelvin sign and the long s, which fold to ASCII letters.
+  const std::vector<std::string> pieces = {
+      "a",  "b",  "Z",  "k",  "K",  "s",  "'",    "LL", " ",  "\t",
+      "\n", "\r", "\v", "0",  "42", "!",  "/",    "é",  "É",  "Ω",
+      "ω",  "中", "の", "ſ",  "\xe2\x84\xaa", "🙂", "\xcc\x81", "\xc2\xa0"};
+
+  std::mt19937 rng(11);
+  for (const auto& pattern : patterns) {
+    DfaRegex dfa;
+    ASSERT_EQ(dfa.compile(pattern), Error::Ok) << pattern;
+    Re2Regex reference;
+    ASSERT_EQ(reference.compile("(" + pattern + ")"), Error::Ok);
+
+    for (int round = 0; round < 300; ++round) {
+      std::string text;
+      const size_t size = rng() % 60;
+      for (size_t i = 0; i < size; ++i) {
+        text += pieces[rng() % pieces.size()];
+      }
+      const auto expected = reference.find_all(text);
+      const auto matches = dfa.find_all(text);
+      ASSERT_EQ(matches.size(), expected.size()) << pattern << "\n" << text;
+      for (size_t i = 0; i < matches.size(); ++i) {
+        EXPECT_EQ(matches[i].start, expected[i].start) << text;
+        EXPECT_EQ(matches[i].end, expected[i].end) << text;
+      }
+    }
+  }
+}
+
+TEST_F(RegexTest, DfaRejectsUnsupportedPatterns) {
+  for (const std::string pattern :
+       {"\\s+(?!\\S)", "^a", "a$", "\\bx", "(a)\\1", "a++", "(a", "[a"}) {
+    DfaRegex dfa;
+    EXPECT_NE(dfa.compile(pattern), Error::Ok) << pattern;
+  }
+}
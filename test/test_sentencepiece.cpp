@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include <pytorch/tokenizers/sentencepiece.h>
+#include <fstream>
 
 namespace tokenizers {
 
@@ -44,6 +45,18 @@ TEST(SPTokenizerTest, TestLoadInvalidPath) {
   EXPECT_EQ(error, Error::LoadFailure);
 }
 
+TEST(SPTokenizerTest, TestLoadFromBuffer) {
+  std::ifstream file(
+      _get_resource_path("test_sentencepiece.model"), std::ios::binary);
+  const std::string data(
+      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  SPTokenizer tokenizer;
+  ASSERT_EQ(tokenizer.load_from_buffer(data), Error::Ok);
+  auto result = tokenizer.encode("Hello world!", /*bos*/ 1, /*eos*/ 0);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(result.get(), std::vector<uint64_t>({1, 15043, 3186, 29991}));
+}
+
 TEST(SPTokenizerTest, TestEncode) {
   SPTokenizer tokenizer;
   auto path = _get_resource_path("test_sentencepiece.model");
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+// @lint-ignore-every LICENSELINT
+
+#include <gtest/gtest.h>
+#include <pytorch/tokenizers/special_token_matcher.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tokenizers {
+namespace detail {
+
+namespace {
+
+using Tokens = std::vector<std::pair<std::string_view, uint64_t>>;
+
+// All matches as (start, end, id), found by scanning from each match end.
+std::vector<std::tuple<size_t, size_t, uint64_t>> find_all(
+    const SpecialTokenMatcher& matcher,
+    std::string_view text) {
+  std::vector<std::tuple<size_t, size_t, uint64_t>> matches;
+  for (auto match = matcher.find(text); match;
+       match = matcher.find(text, match->end)) {
+    matches.emplace_back(match->start, match->end, match->id);
+  }
+  return matches;
+}
+
+// Reference leftmost-longest search.
+std::vector<std::tuple<size_t, size_t, uint64_t>> find_all_naive(
+    const Tokens& tokens,
+    std::string_view text) {
+  std::vector<std::tuple<size_t, size_t, uint64_t>> matches;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    const std::pair<std::string_view, uint64_t>* best = nullptr;
+    for (const auto& token : tokens) {
+      if (text.substr(pos, token.first.size()) == token.first &&
+          (!best || token.first.size() > best->first.size())) {
+        best = &token;
+      }
+    }
+    if (best) {
+      matches.emplace_back(pos, pos + best->first.size(), best->second);
+      pos += best->first.size();
+    } else {
+      ++pos;
+    }
+  }
+  return matches;
+}
+
+} // namespace
+
+TEST(SpecialTokenMatcherTest, EmptyMatchesNothing) {
+  SpecialTokenMatcher matcher;
+  EXPECT_TRUE(matcher.empty());
+  EXPECT_FALSE(matcher.find("<|eot|>").has_value());
+  EXPECT_TRUE(SpecialTokenMatcher(Tokens{{"", 1}}).empty());
+}
+
+TEST(SpecialTokenMatcherTest, FindsTokensInOrder) {
+  const SpecialTokenMatcher matcher(
+      Tokens{{"<|start|>", 10}, {"<|end|>", 11}, {"<|eot|>", 12}});
+  const std::string text = "<|start|>hi <|eot|> <|unknown|><|end|>";
+  const std::vector<std::tuple<size_t, size_t, uint64_t>> expected = {
+      {0, 9, 10}, {12, 19, 12}, {31, 38, 11}};
+  EXPECT_EQ(find_all(matcher, text), expected);
+  EXPECT_FALSE(matcher.find("<|start").has_value());
+  EXPECT_FALSE(matcher.find(text, text.size()).has_value());
+}
+
+TEST(SpecialTokenMatcherTest, PrefersLeftmostThenLongest) {
+  const SpecialTokenMatcher matcher(
+      Tokens{{"<a>", 1}, {"<a><b>", 2}, {"a><b", 3}, {"b>", 4}});
+  const std::vector<std::tuple<size_t, size_t, uint64_t>> expected = {
+      {1, 7, 2}, {8, 11, 1}};
+  EXPECT_EQ(find_all(matcher, "x<a><b>x<a>"), expected);
+}
+
+TEST(SpecialTokenMatcherTest, FindIfIgnoresRejectedTokens) {
+  const SpecialTokenMatcher matcher(
+      Tokens{{"<a>", 1}, {"<a><b>", 2}, {"<b>", 3}});
+  const auto not_two = [](uint64_t id) { return id != 2; };
+  // The rejected "<a><b>" neither matches nor hides the tokens inside it.
+  auto match = matcher.find_if("x<a><b>", 0, not_two);
+  ASSERT_TRUE(match.has_value());
+  EXPECT_EQ(match->id, 1);
+  match = matcher.find_if("x<a><b>", match->end, not_two);
+  ASSERT_TRUE(match.has_value());
+  EXPECT_EQ(match->start, 4);
+  EXPECT_EQ(match->id, 3);
+  EXPECT_FALSE(
+      matcher.find_if("x<a><b>", 0, [](uint64_t id) { return id == 4; }));
+}
+
+TEST(SpecialTokenMatcherTest, MatchesReferenceOnRandomText) {
+  // Many distinct first bytes, so the nibble prefilter has false positives
+  // that the trie walk must reject.
+  const Tokens tokens = {
+      {"<|im_start|>", 0},
+      {"<|im_end|>", 1},
+      {"[INST]", 2},
+      {"[/INST]", 3},
+      {"\xe2\x96\x81", 4},
+      {"{{", 5},
+      {"Q", 6},
+      {"\x7f\x80", 7},
+      {"qa", 8},
+      {"Z|", 9},
+  };
+  const SpecialTokenMatcher matcher(tokens);
+
+  std::string alphabet = "<|im_startend>[/INST]{Qaqz Z\x7f\x80\xe2\x96\x81";
+  // The SIMD prefilter is used where available, cover the scalar one too.
+  for (const bool scalar : {false, true}) {
+    const bool previous = SpecialTokenMatcher::force_scalar_prefilter(scalar);
+    std::mt19937 rng(42);
+    for (int round = 0; round < 200; ++round) {
+      std::string text;
+      const size_t size = rng() % 200;
+      for (size_t i = 0; i < size; ++i) {
+        if (rng() % 10 == 0) {
+          text += tokens[rng() % tokens.size()].first;
+        } else {
+          text += alphabet[rng() % alphabet.size()];
+        }
+      }
+      EXPECT_EQ(find_all(matcher, text), find_all_naive(tokens, text))
+          << scalar << " " << text;
+    }
+    SpecialTokenMatcher::force_scalar_prefilter(previous);
+  }
+}
+
+TEST(SpecialTokenMatcherTest, SkipsLongTextWithoutTokens) {
+  const SpecialTokenMatcher matcher(Tokens{{"<|a|>", 1}, {"[b]", 2}});
+  for (const bool scalar : {false, true}) {
+    const bool previous = SpecialTokenMatcher::force_scalar_prefilter(scalar);
+    std::string text(100000, 'x');
+    EXPECT_FALSE(matcher.find(text).has_value());
+    text.replace(70001, 3, "[b]");
+    const auto match = matcher.find(text);
+    ASSERT_TRUE(match.has_value());
+    EXPECT_EQ(match->start, 70001);
+    EXPECT_EQ(match->id, 2);
+    SpecialTokenMatcher::force_scalar_prefilter(previous);
+  }
+}
+
+} // namespace detail
+} // namespace tokenizers
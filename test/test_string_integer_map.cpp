@@ -3,8 +3,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <pytorch/tokenizers/base64.h>
+#include <pytorch/tokenizers/huge_page_allocator.h>
 #include <pytorch/tokenizers/string_integer_map.h>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <unordered_map>
@@ -26,6 +28,7 @@ using namespace ::testing;
 using ::base64::decode;
 using ::tokenizers::Error;
 using ::tokenizers::Result;
+using ::tokenizers::detail::HugePageAllocator;
 using ::tokenizers::detail::StringIntegerMap;
 using ::tokenizers::detail::StringIntegerMapTypeBuilder;
 using TokenizerMap = std::unordered_map<std::string, std::uint64_t>;
@@ -194,6 +197,124 @@ TEST_F(StringIntegerMapTest, CreateFromModel) {
   }
 }
 
+TEST_F(StringIntegerMapTest, CreateFromModelWithHugePageAllocator) {
+  const auto res = loadModel();
+  ASSERT_EQ(res.ok(), true);
+  const auto& model = res.get();
+  typename StringIntegerMapTypeBuilder<>::WithAllocator<
+      HugePageAllocator<std::uint8_t>>::Map map(model);
+
+  for (const auto& [model_key, model_value] : model) {
+    EXPECT_THAT(map.tryGetInteger(model_key), testing::Optional(model_value))
+        << model_key;
+    EXPECT_THAT(map.tryGetString(model_value), testing::Optional(model_key))
+        << model_value;
+  }
+  EXPECT_EQ(map.size(), model.size());
+}
+
+TEST_F(StringIntegerMapTest, SerializeAndView) {
+  const auto res = loadModel();
+  ASSERT_EQ(res.ok(), true);
+  const auto& model = res.get();
+  const StringIntegerMap source(model);
+
+  auto data = std::make_shared<std::string>();
+  source.serialize(*data);
+  auto map = StringIntegerMap<>::view(*data, data);
+  ASSERT_TRUE(map.has_value());
+  data.reset();
+
+  // A copy must keep viewing the same bytes.
+  const auto copy = *map;
+  map.reset();
+  for (const auto& [model_key, model_value] : model) {
+    EXPECT_THAT(copy.tryGetInteger(model_key), testing::Optional(model_value))
+        << model_key;
+    EXPECT_THAT(copy.tryGetString(model_value), testing::Optional(model_key))
+        << model_value;
+  }
+  EXPECT_EQ(copy.size(), model.size());
+}
+
+TEST(StringIntegerMapSerializeTest, ViewRejectsMalformedData) {
+  const StringIntegerMap map(TokenizerMap{{"a", 0}, {"b", 1}});
+  std::string data;
+  map.serialize(data);
+  EXPECT_FALSE(StringIntegerMap<>::view({}, nullptr));
+  EXPECT_FALSE(
+      StringIntegerMap<>::view(std::string_view(data).substr(0, 64), nullptr));
+  EXPECT_FALSE(StringIntegerMap<>::view(
+      std::string_view(data).substr(0, data.size() - 8), nullptr));
+  EXPECT_TRUE(StringIntegerMap<>::view(data, nullptr));
+}
+
+TEST(StringIntegerMapSerializeTest, ViewRejectsOutOfBoundsOffsets) {
+  // With three short strings every size and offset takes one byte, and
+  // setting any of them to 0xff points past the end of the string elements.
+  const StringIntegerMap map(TokenizerMap{{"a", 0}, {"bc", 1}, {"def", 2}});
+  std::string data;
+  map.serialize(data);
+  std::uint64_t header[12];
+  std::memcpy(header, data.data(), sizeof(header));
+  const auto padded = [](std::uint64_t size) { return (size + 7) / 8 * 8; };
+  const std::size_t integer_buckets = sizeof(header);
+  const std::size_t integer_elements = integer_buckets + padded(header[8]);
+  const std::size_t string_buckets = integer_elements + padded(header[9]);
+  const std::size_t string_elements = string_buckets + padded(header[10]);
+  ASSERT_EQ(header[4], 1u);
+  ASSERT_EQ(header[5], 1u);
+  ASSERT_EQ(header[6], 1u);
+  ASSERT_EQ(header[7], 1u);
+
+  std::vector<std::size_t> positions;
+  for (std::size_t bucket = 0; bucket <= header[2]; ++bucket) {
+    positions.push_back(integer_buckets + bucket);
+    positions.push_back(string_buckets + bucket);
+  }
+  for (std::size_t index = 0; index < header[3]; ++index) {
+    // The string size and the string offset of each integer element.
+    positions.push_back(integer_elements + (index * 3) + 1);
+    positions.push_back(integer_elements + (index * 3) + 2);
+  }
+  for (std::size_t offset = string_elements; offset < data.size() &&
+       offset < string_elements + header[11] - sizeof(std::uint64_t);
+       offset += 3 + static_cast<std::uint8_t>(data[offset + 1])) {
+    // The string size of each string element.
+    positions.push_back(offset + 1);
+  }
+
+  ASSERT_TRUE(StringIntegerMap<>::view(data, nullptr));
+  for (const auto position : positions) {
+    auto corrupted = data;
+    corrupted[position] = '\xff';
+    EXPECT_FALSE(StringIntegerMap<>::view(corrupted, nullptr)) << position;
+  }
+}
+
+TEST(HugePageAllocatorTest, LargeAndSmallAllocations) {
+  HugePageAllocator<std::uint8_t> allocator;
+  for (const std::size_t size :
+       {std::size_t(1),
+        std::size_t(4096),
+        HugePageAllocator<std::uint8_t>::kMinHugePageAllocation,
+        HugePageAllocator<std::uint8_t>::kMinHugePageAllocation * 3 + 17}) {
+    auto* data = allocator.allocate(size);
+    ASSERT_NE(data, nullptr);
+    std::memset(data, 0xAB, size);
+    EXPECT_EQ(data[0], 0xAB);
+    EXPECT_EQ(data[size - 1], 0xAB);
+    if (size >= HugePageAllocator<std::uint8_t>::kMinHugePageAllocation &&
+        TK_HUGE_PAGES_SUPPORTED) {
+      EXPECT_EQ(
+          reinterpret_cast<std::uintptr_t>(data) %
+              HugePageAllocator<std::uint8_t>::kHugePageSize,
+          0);
+    }
+    allocator.deallocate(data, size);
+  }
+}
+
 #if defined(TEST_MEMORY_COMPARISON) && TEST_MEMORY_COMPARISON
 
 TEST_F(StringIntegerMapTest, MemoryConsumptionComparison) {
@@ -322,3 +443,27 @@ TYPED_TEST(StringIntegerMapHashTest, HashCollisions) {
   EXPECT_FALSE(map.tryGetString(100));
   EXPECT_FALSE(map.tryGetString(1000));
 }
+
+TEST(StringIntegerMapSerializeTest, ViewWithDifferentHashRebuilds) {
+  const TokenizerMap source = {
+      {"a", 0},
+      {"bb", 10},
+      {"ccc", 100},
+      {"dddd", 1000},
+  };
+  const StringIntegerMap saved(source);
+  std::string data;
+  saved.serialize(data);
+
+  // The buckets were laid out with std::hash, so they are unusable with
+  // FixedHash and the map is rebuilt from the elements.
+  using Map = StringIntegerMapTypeBuilder<>::WithIntegerHash<FixedHash<1>>::
+      WithStringHash<FixedHash<1>>::Map;
+  const auto map = Map::view(data, nullptr);
+  ASSERT_TRUE(map.has_value());
+  for (const auto& [str, integer] : source) {
+    EXPECT_THAT(map->tryGetInteger(str), Optional(integer)) << str;
+    EXPECT_THAT(map->tryGetString(integer), Optional(std::string_view(str)))
+        << integer;
+  }
+}
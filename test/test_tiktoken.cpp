@@ -10,6 +10,8 @@
 #include <gtest/gtest.h>
 #include <pytorch/tokenizers/tiktoken.h>
 
+#include <thread>
+
 using namespace ::testing;
 
 namespace tokenizers {
@@ -47,6 +49,12 @@ static inline std::string _get_resource_path(const std::string& name) {
   return std::getenv("RESOURCES_PATH") + std::string("/") + name;
 }
 
+static inline std::string _read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
 } // namespace
 
 class TiktokenTest : public Test {
@@ -93,6 +101,74 @@ TEST_F(TiktokenTest, TestEncode) {
   EXPECT_EQ(out.get()[2], 1917);
 }
 
+TEST_F(TiktokenTest, TestEncodeSpecialTokenPolicy) {
+  Tiktoken tokenizer(kPattern, _get_special_tokens(), 0, 1);
+  ASSERT_EQ(tokenizer.load(modelPath_), Error::Ok);
+  const std::string text = "<|start_header_id|>hi<|eot_id|>";
+  const uint64_t start_header = 128006;
+  const uint64_t eot = 128009;
+
+  // The default matches encode() and recognizes every special token.
+  const auto all = tokenizer.encode(text, EncodeOptions()).get();
+  EXPECT_EQ(all, tokenizer.encode(text, 0, 0).get());
+  EXPECT_EQ(all.front(), start_header);
+  EXPECT_EQ(all.back(), eot);
+
+  // None treats them as text, like any other input.
+  EncodeOptions none;
+  none.special_tokens = EncodeOptions::SpecialTokens::None;
+  none.bos = 1;
+  const auto plain = tokenizer.encode(text, none).get();
+  EXPECT_EQ(plain.front(), tokenizer.bos_tok());
+  EXPECT_GT(plain.size(), all.size() + 1);
+  for (const auto token : plain) {
+    EXPECT_NE(token, start_header);
+    EXPECT_NE(token, eot);
+  }
+
+  // Only the allowed token is recognized, the other is encoded as text.
+  auto allowed = EncodeOptions().allow_special(eot);
+  const auto partial = tokenizer.encode(text, allowed).get();
+  EXPECT_EQ(partial.back(), eot);
+  EXPECT_NE(partial.front(), start_header);
+  none.bos = 0;
+  auto expected = tokenizer.encode("<|start_header_id|>hi", none).get();
+  expected.push_back(eot);
+  EXPECT_EQ(partial, expected);
+
+  allowed.reject_disallowed = true;
+  EXPECT_EQ(tokenizer.encode(text, allowed).error(), Error::EncodeFailure);
+  EXPECT_TRUE(tokenizer.encode("hi<|eot_id|>", allowed).ok());
+}
+
+TEST_F(TiktokenTest, TestEncodeAllowedSpecialTokenInsideDisallowed) {
+  // "<|b|>" is allowed and "<|a|><|b|>", which contains it, is not.
+  Tiktoken tokenizer(
+      kPattern,
+      std::make_unique<std::vector<std::string>>(std::vector<std::string>{
+          "<|begin_of_text|>", "<|end_of_text|>", "<|a|><|b|>", "<|b|>"}),
+      0,
+      1);
+  ASSERT_EQ(tokenizer.load(modelPath_), Error::Ok);
+  const uint64_t b = tokenizer.vocab_size() - 1;
+
+  // Like tiktoken, the allowed token is found among the allowed ones only.
+  auto allowed = EncodeOptions().allow_special(b);
+  EncodeOptions none;
+  none.special_tokens = EncodeOptions::SpecialTokens::None;
+  auto expected = tokenizer.encode("x<|a|>", none).get();
+  expected.push_back(b);
+  const auto tail = tokenizer.encode("y", none).get();
+  expected.insert(expected.end(), tail.begin(), tail.end());
+  EXPECT_EQ(tokenizer.encode("x<|a|><|b|>y", allowed).get(), expected);
+
+  // The disallowed token is still found when it is rejected.
+  allowed.reject_disallowed = true;
+  EXPECT_EQ(
+      tokenizer.encode("x<|a|><|b|>y", allowed).error(), Error::EncodeFailure);
+  EXPECT_TRUE(tokenizer.encode("x<|a|>y<|b|>", allowed).ok());
+}
+
 TEST_F(TiktokenTest, TestDecode) {
   Error res = tokenizer_->load(modelPath_.c_str());
   EXPECT_EQ(res, Error::Ok);
@@ -105,6 +181,25 @@ TEST_F(TiktokenTest, TestDecode) {
   }
 }
 
+TEST_F(TiktokenTest, TestConcurrentFirstEncode) {
+  // The encoder is set up by the first encode call, which may be concurrent.
+  Error res = tokenizer_->load(modelPath_.c_str());
+  EXPECT_EQ(res, Error::Ok);
+  std::vector<std::vector<uint64_t>> results(4);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([this, &result]() {
+      result = tokenizer_->encode("hello world", 1, 0).get();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    EXPECT_EQ(result, std::vector<uint64_t>({128000, 15339, 1917}));
+  }
+}
+
 TEST_F(TiktokenTest, TokenizerDecodeOutOfRangeFails) {
   Error res = tokenizer_->load(modelPath_.c_str());
   EXPECT_EQ(res, Error::Ok);
@@ -144,6 +239,25 @@ TEST_F(TiktokenTest, ConstructionWithInvalidEOSIndex) {
 #endif
 }
 
+TEST_F(TiktokenTest, TestLoadInvalidPattern) {
+  // The pattern is compiled by load(), not by the first encode().
+  Tiktoken tokenizer("(?:unclosed", _get_special_tokens(), 0, 1);
+  EXPECT_EQ(tokenizer.load(modelPath_), Error::RegexFailure);
+}
+
+TEST_F(TiktokenTest, TestRegexBackendIsPickedAtLoad) {
+  Tiktoken tokenizer(kPattern, _get_special_tokens(), 0, 1);
+  EXPECT_TRUE(tokenizer.regex_backends().empty());
+  set_regex_benchmarking(true);
+  const Error error = tokenizer.load(modelPath_);
+  set_regex_benchmarking(false);
+  ASSERT_EQ(error, Error::Ok);
+  // Known before the first encode().
+  const auto backends = tokenizer.regex_backends();
+  ASSERT_EQ(backends.size(), 1);
+  EXPECT_FALSE(backends[0].empty());
+}
+
 TEST_F(TiktokenTest, TestLoadInvalidPath) {
   Tiktoken tokenizer;
   auto error = tokenizer.load("invalid_path");
@@ -179,4 +293,64 @@ TEST_F(TiktokenTest, LoadTiktokenFileWithBPEFile) {
 
   EXPECT_EQ(res, Error::ParseFailure);
 }
+
+TEST_F(TiktokenTest, SaveAndLoadArtifact) {
+  Tiktoken tokenizer(kPattern, _get_special_tokens(), 0, 1);
+  ASSERT_EQ(tokenizer.load(modelPath_), Error::Ok);
+  const auto artifact_path = ::testing::TempDir() + "tiktoken.artifact";
+  ASSERT_EQ(tokenizer.save(artifact_path), Error::Ok);
+
+  // The artifact carries the pattern and special tokens, so a default
+  // constructed tokenizer loads the same state.
+  Tiktoken loaded;
+  ASSERT_EQ(loaded.load(artifact_path), Error::Ok);
+  EXPECT_EQ(loaded.vocab_size(), tokenizer.vocab_size());
+  EXPECT_EQ(loaded.bos_tok(), tokenizer.bos_tok());
+  EXPECT_EQ(loaded.eos_tok(), tokenizer.eos_tok());
+
+  const std::string text =
+      "hello world<|end_of_text|> It's 2024, isn't it?\n\n  done";
+  auto expected = tokenizer.encode(text, 1, 1);
+  auto actual = loaded.encode(text, 1, 1);
+  ASSERT_EQ(actual.error(), Error::Ok);
+  EXPECT_EQ(actual.get(), expected.get());
+  for (const auto token : actual.get()) {
+    EXPECT_EQ(loaded.decode(0, token).get(), tokenizer.decode(0, token).get());
+  }
+}
+
+TEST_F(TiktokenTest, LoadFromBuffer) {
+  Tiktoken tokenizer(kPattern, _get_special_tokens(), 0, 1);
+  ASSERT_EQ(tokenizer.load_from_buffer(_read_file(modelPath_)), Error::Ok);
+  ASSERT_EQ(tokenizer_->load(modelPath_), Error::Ok);
+  const std::string text = "hello world<|end_of_text|> It's 2024";
+  const auto expected = tokenizer_->encode(text, 1, 1);
+  EXPECT_EQ(tokenizer.vocab_size(), tokenizer_->vocab_size());
+  EXPECT_EQ(tokenizer.encode(text, 1, 1).get(), expected.get());
+
+  const auto artifact_path = ::testing::TempDir() + "tiktoken_buffer.artifact";
+  ASSERT_EQ(tokenizer.save(artifact_path), Error::Ok);
+  const auto artifact = _read_file(artifact_path);
+  Tiktoken loaded;
+  ASSERT_EQ(loaded.load_from_buffer(artifact), Error::Ok);
+  EXPECT_EQ(loaded.encode(text, 1, 1).get(), expected.get());
+
+  // A line without a rank.
+  EXPECT_EQ(Tiktoken().load_from_buffer("aGVsbG8=\n"), Error::ParseFailure);
+}
+
+TEST_F(TiktokenTest, SaveWithoutLoadFails) {
+  Tiktoken tokenizer;
+  EXPECT_EQ(
+      tokenizer.save(::testing::TempDir() + "unloaded.artifact"),
+      Error::Uninitialized);
+}
+
+TEST_F(TiktokenTest, SaveToUnwritablePathFails) {
+  Tiktoken tokenizer(kPattern, _get_special_tokens(), 0, 1);
+  ASSERT_EQ(tokenizer.load(modelPath_), Error::Ok);
+  EXPECT_EQ(
+      tokenizer.save(::testing::TempDir() + "missing/dir/tiktoken.artifact"),
+      Error::SaveFailure);
+}
 } // namespace tokenizers
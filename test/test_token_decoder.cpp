@@ -74,6 +74,35 @@ TEST(FuseTokenDecoderTest, TestPassthrough) {
   EXPECT_EQ(decoder.decode(""), "");
 }
 
+// Test MetaspaceTokenDecoder
+TEST(MetaspaceTokenDecoderTest, TestReplacement) {
+  MetaspaceTokenDecoder decoder;
+
+  EXPECT_EQ(decoder.decode("▁Hello▁world"), " Hello world");
+  EXPECT_EQ(decoder.decode("no_replacement"), "no_replacement");
+  // The replacements of the token at the start of the text are dropped.
+  EXPECT_EQ(decoder.decode_first("▁Hello▁world"), "Helloworld");
+  EXPECT_EQ(decoder.decode_first("▁"), "");
+}
+
+TEST(MetaspaceTokenDecoderTest, TestPrependScheme) {
+  EXPECT_EQ(MetaspaceTokenDecoder("▁", "first").decode_first("▁Hi"), "Hi");
+  EXPECT_EQ(MetaspaceTokenDecoder("▁", "never").decode_first("▁Hi"), " Hi");
+  EXPECT_EQ(MetaspaceTokenDecoder("_", "always").decode("_Hi_"), " Hi ");
+  EXPECT_THROW(MetaspaceTokenDecoder("▁", "sometimes"), std::runtime_error);
+}
+
+TEST(MetaspaceTokenDecoderTest, TestParseJson) {
+  const auto decoder = TokenDecoderConfig()
+                           .parse_json(nlohmann::json{
+                               {"type", "Metaspace"},
+                               {"replacement", "_"},
+                               {"add_prefix_space", false},
+                           })
+                           .create();
+  EXPECT_EQ(decoder->decode_first("_Hi_there"), " Hi there");
+}
+
 // Test SequenceTokenDecoder
 TEST(SequenceTokenDecoderTest, TestEmptySequence) {
   std::vector<TokenDecoder::Ptr> decoders;
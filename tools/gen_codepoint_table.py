@@ -0,0 +1,204 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+# @lint-ignore-every LICENSELINT
+
+
+# Script to generate the codepoint classes of src/codepoint_table.cpp by
+# probing the pre-tokenizers of HF tokenizers with every codepoint, so that the
+# native pre-tokenizers split exactly like the HF version it is run with:
+#
+#   pip install tokenizers==<version>
+#   python tools/gen_codepoint_table.py \
+#       --table src/codepoint_table.cpp \
+#       --sample test/resources/hf_codepoint_sample.txt
+#
+# --sample writes the codepoints that test_pre_tokenizer.cpp checks the table
+# against.
+
+import argparse
+import re
+import sys
+
+import tokenizers
+from tokenizers import pre_tokenizers
+
+# CodepointClass::Flags
+WHITESPACE = 1 << 0
+WORD = 1 << 1
+PUNCTUATION = 1 << 2
+NUMERIC = 1 << 3
+
+# One in this many codepoints is sampled, on top of the first 256 and both
+# sides of every run boundary.
+SAMPLE_STRIDE = 4093
+
+
+class Prober:
+    def __init__(self):
+        self.whitespace_split = pre_tokenizers.WhitespaceSplit()
+        self.whitespace = pre_tokenizers.Whitespace()
+        self.punctuation = pre_tokenizers.Punctuation("isolated")
+        self.digits = pre_tokenizers.Digits(True)
+        self.scripts = pre_tokenizers.UnicodeScripts()
+        # Script id -> a codepoint of that script, in order of first
+        # appearance. Id 0 is kAnyScript.
+        self.script_codepoints = [None]
+        self.last_script = None
+
+    @staticmethod
+    def count(pre_tokenizer, text):
+        return len(pre_tokenizer.pre_tokenize_str(text))
+
+    def flags(self, c):
+        flags = 0
+        if self.count(self.whitespace_split, "a" + c + "a") == 2:
+            flags |= WHITESPACE
+        # Whitespace splits on \w+|[^\w\s]+, so a word character stays with
+        # the "a" before it.
+        pieces = self.whitespace.pre_tokenize_str("a" + c)
+        if len(pieces) == 1 and pieces[0][0] == "a" + c:
+            flags |= WORD
+        if self.count(self.punctuation, "a" + c + "a") == 3:
+            flags |= PUNCTUATION
+        if self.count(self.digits, "a" + c + "a") == 3:
+            flags |= NUMERIC
+        return flags
+
+    def script(self, c):
+        # UnicodeScripts drops the codepoints it maps to no script.
+        if self.count(self.scripts, c) == 0:
+            return 0
+        # Two codepoints share a script if UnicodeScripts keeps them in one
+        # piece. The script of the previous codepoint is the likeliest.
+        order = list(range(1, len(self.script_codepoints)))
+        if self.last_script:
+            order.insert(0, self.last_script)
+        script = None
+        for i in order:
+            if self.count(self.scripts, chr(self.script_codepoints[i]) + c) == 1:
+                script = i
+                break
+        if script is None:
+            script = len(self.script_codepoints)
+            self.script_codepoints.append(ord(c))
+        self.last_script = script
+        return script
+
+    def value(self, cp):
+        c = chr(cp)
+        return self.flags(c) | self.script(c) << 4
+
+
+def probe_all():
+    """Returns the runs of equal values as (start, value) pairs, and the
+    codepoint each script id was first seen at"""
+    prober = Prober()
+    runs = []
+    previous = None
+    for cp in range(0x110000):
+        # Surrogates are not characters, so they continue the run before them.
+        if 0xD800 <= cp <= 0xDFFF:
+            continue
+        value = prober.value(cp)
+        if value != previous:
+            runs.append((cp, value))
+            previous = value
+    return runs, prober.script_codepoints
+
+
+def format_runs(runs):
+    lines = []
+    for i in range(0, len(runs), 5):
+        lines.append(
+            "    "
+            + " ".join("{0x%x, 0x%x}," % run for run in runs[i : i + 5])
+        )
+    return "\n".join(lines)
+
+
+def write_table(path, runs):
+    with open(path) as f:
+        source = f.read()
+    begin = "constexpr Run kRuns[] = {\n"
+    end = "\n};\n// clang-format on"
+    start = source.index(begin) + len(begin)
+    source = source[:start] + format_runs(runs) + source[source.index(end) :]
+    source = re.sub(
+        r"HF tokenizers \d+\.\d+\.\d+",
+        "HF tokenizers " + tokenizers.__version__,
+        source,
+    )
+    with open(path, "w") as f:
+        f.write(source)
+
+
+def write_sample(path, runs, script_codepoints):
+    """Writes "codepoint flags script" lines, where script is a codepoint that
+    UnicodeScripts keeps in one piece with this one, or - for none"""
+    values = {}
+    for i, (start, value) in enumerate(runs):
+        values[start] = value
+        if i > 0 and not 0xD800 <= start - 1 <= 0xDFFF:
+            values[start - 1] = runs[i - 1][1]
+    for cp in list(range(256)) + list(range(0, 0x110000, SAMPLE_STRIDE)):
+        if not 0xD800 <= cp <= 0xDFFF:
+            values[cp] = None
+    starts = [start for start, _ in runs]
+    with open(path, "w") as f:
+        f.write(
+            "# Generated by tools/gen_codepoint_table.py with HF tokenizers "
+            + tokenizers.__version__
+            + "\n"
+        )
+        for cp in sorted(values):
+            value = values[cp]
+            if value is None:
+                lo, hi = 0, len(starts)
+                while hi - lo > 1:
+                    mid = (lo + hi) // 2
+                    if starts[mid] <= cp:
+                        lo = mid
+                    else:
+                        hi = mid
+                value = runs[lo][1]
+            script = value >> 4
+            f.write(
+                "%x %x %s\n"
+                % (
+                    cp,
+                    value & 0xF,
+                    "%x" % script_codepoints[script] if script else "-",
+                )
+            )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "--table",
+        type=str,
+        default=None,
+        help="path to codepoint_table.cpp, whose kRuns are replaced",
+    )
+    parser.add_argument(
+        "--sample",
+        type=str,
+        default=None,
+        help="path to write a sample of the codepoints and their classes to",
+    )
+    args = parser.parse_args()
+
+    runs, script_codepoints = probe_all()
+    print(
+        "%d runs, %d scripts" % (len(runs), len(script_codepoints) - 1),
+        file=sys.stderr,
+    )
+    if args.table:
+        write_table(args.table, runs)
+    if args.sample:
+        write_sample(args.sample, runs, script_codepoints)
+    if not args.table and not args.sample:
+        print(format_runs(runs))